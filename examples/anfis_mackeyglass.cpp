@@ -53,9 +53,11 @@
 #include <fl/anfis.h>
 #include <fl/dataset.h>
 #include <fl/Headers.h>
+#include <fl/time_series_dataset.h>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -153,8 +155,11 @@ void MakeTrainAndTestSets(fl::DataSet<>& trainingSet, fl::DataSet<>& testSet)
 	// It is assumed that $x(0)= 1.2$, $\tau=17$, and $x(t)=0$ for $t<0$.
 	// The result was saved in the file 'data/mgdata.dat'.
 
+	// The time series stores samples only once, and presents the entries
+	// described below (with $D = 4$ and $\Delta = P = 6$) as views of them.
+	fl::TimeSeriesDataSet<fl::scalar> x(4, 6, 6);
+
 	std::ifstream ifs("data/mgdata.dat");
-	std::vector<fl::scalar> x;
 	for (std::string line; std::getline(ifs, line); )
 	{
 		std::istringstream iss(line);
@@ -162,7 +167,7 @@ void MakeTrainAndTestSets(fl::DataSet<>& trainingSet, fl::DataSet<>& testSet)
 		iss >> t;
 		fl::scalar v = 0;
 		iss >> v;
-		x.push_back(v);
+		x.append(v);
 	}
 	ifs.close();
 
@@ -191,28 +196,15 @@ void MakeTrainAndTestSets(fl::DataSet<>& trainingSet, fl::DataSet<>& testSet)
 	// You use the first 500 data values for the anfis training (these become
 	// the training data set), while the others are used as checking data for
 	// validating the identified fuzzy model.
-	for (std::size_t t = 117; t < 1117; ++t)
+	// The entry at time $t$ is the $(t-18)$-th one of the time series, and
+	// the views keep the samples alive.
+	const fl::DataSet<fl::scalar> entries = x.dataSet();
+	if (entries.size() < 1117-18)
 	{
-		// Setup the input
-		std::vector<fl::scalar> xx;
-		xx.push_back(x[t-18]);
-		xx.push_back(x[t-12]);
-		xx.push_back(x[t-6]);
-		xx.push_back(x[t]);
-		// Setup the output
-		std::vector<fl::scalar> yy;
-		yy.push_back(x[t+6]);
-		// Build the entry
-		fl::DataSetEntry<fl::scalar> entry(xx.begin(), xx.end(), yy.begin(), yy.end());
-		if (trainingSet.size() < 500)
-		{
-			trainingSet.add(entry);
-		}
-		else
-		{
-			testSet.add(entry);
-		}
+		FL_THROW2(std::runtime_error, "Not enough samples in 'data/mgdata.dat'");
 	}
+	trainingSet = entries.slice(117-18, 617-18);
+	testSet = entries.slice(617-18, 1117-18);
 }
 
 FL_unique_ptr<fl::anfis::Engine> BuildAnfis(const fl::DataSet<>& trainingSet)
@@ -0,0 +1,197 @@
+/**
+ * \file cluster_subtractive_scaling.cpp
+ *
+ * Measures how the running time of subtractive clustering scales with the
+ * number of data points and with the number of threads.
+ *
+ * Data points are drawn from a mixture of Gaussian blobs in the unit
+ * hypercube.
+ * For each data size, the clustering is run with an increasing number of
+ * threads (when the library is built with OpenMP support) and the centers
+ * found are compared with the ones of the single-threaded run.
+ *
+ * Usage:
+ *   cluster_subtractive_scaling [<dim> [<n_1> <n_2> ...]]
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <fl/cluster/subtractive.h>
+#include <fl/fuzzylite.h>
+#include <iostream>
+#include <vector>
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# include <omp.h>
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+
+namespace /*<unnamed>*/ {
+
+const std::size_t NumOfBlobs = 10;
+
+double WallTime()
+{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	return omp_get_wtime();
+#else
+	return static_cast<double>(std::clock())/CLOCKS_PER_SEC;
+#endif // FLX_CONFIG_HAVE_OPENMP
+}
+
+double Uniform()
+{
+	return (std::rand()+0.5)/(RAND_MAX+1.0);
+}
+
+double Normal()
+{
+	// Box-Muller transform
+	return std::sqrt(-2.0*std::log(Uniform()))*std::cos(2.0*3.14159265358979323846*Uniform());
+}
+
+std::vector< std::vector<fl::scalar> > MakeData(std::size_t n, std::size_t dim)
+{
+	std::vector< std::vector<fl::scalar> > means(NumOfBlobs, std::vector<fl::scalar>(dim));
+	for (std::size_t k = 0; k < NumOfBlobs; ++k)
+	{
+		for (std::size_t j = 0; j < dim; ++j)
+		{
+			means[k][j] = Uniform();
+		}
+	}
+
+	std::vector< std::vector<fl::scalar> > data(n, std::vector<fl::scalar>(dim));
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		const std::size_t k = i % NumOfBlobs;
+		for (std::size_t j = 0; j < dim; ++j)
+		{
+			data[i][j] = means[k][j] + 0.05*Normal();
+		}
+	}
+
+	return data;
+}
+
+fl::scalar MaxAbsDiff(const std::vector< std::vector<fl::scalar> >& a,
+					  const std::vector< std::vector<fl::scalar> >& b)
+{
+	if (a.size() != b.size())
+	{
+		return fl::inf;
+	}
+
+	fl::scalar res = 0;
+	for (std::size_t i = 0,
+					 ni = a.size();
+		 i < ni;
+		 ++i)
+	{
+		for (std::size_t j = 0,
+						 nj = a[i].size();
+			 j < nj;
+			 ++j)
+		{
+			res = std::max(res, std::abs(a[i][j]-b[i][j]));
+		}
+	}
+
+	return res;
+}
+
+} // Namespace <unnamed>
+
+int main(int argc, char* argv[])
+{
+	std::size_t dim = 4;
+	std::vector<std::size_t> sizes;
+
+	if (argc > 1)
+	{
+		dim = static_cast<std::size_t>(std::atol(argv[1]));
+	}
+	for (int i = 2; i < argc; ++i)
+	{
+		sizes.push_back(static_cast<std::size_t>(std::atol(argv[i])));
+	}
+	if (sizes.empty())
+	{
+		sizes.push_back(1000);
+		sizes.push_back(2000);
+		sizes.push_back(5000);
+		sizes.push_back(10000);
+		sizes.push_back(20000);
+	}
+
+	std::vector<int> threads;
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	const int maxThreads = omp_get_max_threads();
+	for (int t = 1; t < maxThreads; t *= 2)
+	{
+		threads.push_back(t);
+	}
+	threads.push_back(maxThreads);
+#else
+	threads.push_back(1);
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+	std::cout << "n\tthreads\ttime (s)\tspeedup\tclusters\tmax |c-c_1|" << std::endl;
+	for (std::size_t s = 0; s < sizes.size(); ++s)
+	{
+		std::srand(5489);
+		const std::vector< std::vector<fl::scalar> > data = MakeData(sizes[s], dim);
+
+		std::vector< std::vector<fl::scalar> > refCenters;
+		double refTime = 0;
+		for (std::size_t t = 0; t < threads.size(); ++t)
+		{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+			omp_set_num_threads(threads[t]);
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+			fl::cluster::SubtractiveClustering subclust;
+			subclust.setRadii(0.2, dim);
+
+			const double start = WallTime();
+			subclust.cluster(data);
+			const double time = WallTime()-start;
+
+			const std::vector< std::vector<fl::scalar> > centers = subclust.centers();
+			if (t == 0)
+			{
+				refCenters = centers;
+				refTime = time;
+			}
+
+			std::cout << sizes[s]
+					  << "\t" << threads[t]
+					  << "\t" << time
+					  << "\t" << (time > 0 ? refTime/time : fl::nan)
+					  << "\t" << centers.size()
+					  << "\t" << MaxAbsDiff(centers, refCenters)
+					  << std::endl;
+		}
+	}
+}
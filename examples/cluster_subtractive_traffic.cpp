@@ -49,11 +49,11 @@
 #include <cstddef>
 #include <fl/cluster/subtractive.h>
 #include <fl/dataset.h>
+#include <fl/dataset_reader.h>
 #include <fl/fis_builder/subtractive_clustering.h>
 #include <fl/fuzzylite.h>
 #include <fl/Engine.h>
 #include <fl/macro.h>
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -80,35 +80,12 @@ void MakeDataSet(fl::DataSet<>& data)
 
 	FL_DEBUG_ASSERT( labels.size() == (ni+no) );
 
-	std::ifstream ifs("data/tripdata.dat");
+	// The first column is the output (the number of trips) and the other
+	// ones are the inputs
+	fl::DataSetReader reader;
+	reader.setOutputColumns(std::vector<std::size_t>(1, 0));
+	reader.read("data/tripdata.dat", data);
 	data.setLabels(labels.begin(), labels.end());
-	for (std::string line; std::getline(ifs, line); )
-	{
-		std::vector<fl::scalar> in;
-		std::vector<fl::scalar> out;
-
-		std::istringstream iss(line);
-		for (std::size_t i = 0; iss.good() && i < no; ++i)
-		{
-			fl::scalar x;
-			iss >> x;
-			out.push_back(x);
-//std::cerr << "OUT #" << i << " -> " << x << std::endl;
-		}
-		for (std::size_t i = 0; iss.good() && i < ni; ++i)
-		{
-			fl::scalar x;
-			iss >> x;
-			in.push_back(x);
-//std::cerr << "IN #" << i << " -> " << x << std::endl;
-		}
-
-		FL_DEBUG_ASSERT( in.size() == ni );
-		FL_DEBUG_ASSERT( out.size() == no );
-
-		fl::DataSetEntry<fl::scalar> entry(in.begin(), in.end(), out.begin(), out.end());
-		data.add(entry);
-	}
 }
 
 } // Namespace <unnamed>
@@ -120,7 +97,7 @@ int main()
 	MakeDataSet(dataset);
 
 	fl::cluster::SubtractiveClustering subclust;
-	subclust.cluster(dataset.data());
+	subclust.cluster(dataset.matrix());
 	const std::vector< std::vector<fl::scalar> > centers = subclust.centers();
 	const std::vector<fl::scalar> sigma = subclust.rangeOfInfluence();
 
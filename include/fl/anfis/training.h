@@ -26,6 +26,7 @@
 #define FL_ANFIS_TRAINING_H
 
 
+#include <fl/anfis/training/evolving_ts.h>
 #include <fl/anfis/training/gradient_descent.h>
 #include <fl/anfis/training/jang1993_hybrid.h>
 #include <fl/anfis/training/least_squares.h>
@@ -0,0 +1,290 @@
+/**
+ * \file fl/anfis/training/evolving_ts.h
+ *
+ * \brief Evolving Takagi-Sugeno (eTS) learning algorithm.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_ANFIS_TRAINING_EVOLVING_TS_H
+#define FL_ANFIS_TRAINING_EVOLVING_TS_H
+
+
+#include <cstddef>
+#include <fl/anfis/engine.h>
+#include <fl/anfis/training/training_algorithm.h>
+#include <fl/dataset.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl { namespace anfis {
+
+/**
+ * Evolving Takagi-Sugeno (eTS) learning algorithm
+ *
+ * The eTS learning algorithm [Angelov2004] adapts both the structure and the
+ * parameters of a first-order Takagi-Sugeno fuzzy inference system, one
+ * sample at a time, so that it can run inline with inference on a stream of
+ * data coming from a drifting process.
+ *
+ * For each incoming sample \f$z_k=[x_k;y_k]\f$:
+ * -# the potential of \f$z_k\f$ and the potentials of the rule centers are
+ *  updated recursively, by means of running sums over the samples seen so
+ *  far;
+ * -# if \f$z_k\f$ has a higher potential than all the rule centers, it
+ *  replaces (<em>moves</em>) the center of the rule it belongs to, or
+ *  becomes the center of a new rule if no rule covers it; if \f$z_k\f$ has a
+ *  lower potential than all the rule centers and no rule covers it, it also
+ *  becomes the center of a new rule (this is the eTS+ criterion to follow
+ *  the data into unexplored regions [Angelov2010]);
+ * -# a rule whose center has been moved or added is <em>merged</em> with
+ *  any other rule whose center is too similar, that is such that the
+ *  membership degree of one center to the other rule is greater than a
+ *  given threshold;
+ * -# the consequent parameters of each rule are updated by a local
+ *  (fuzzily weighted) recursive least-squares estimator.
+ * .
+ * A sample \f$x\f$ is covered by a rule if its membership degree to each
+ * antecedent term of the rule is greater than \f$e^{-1}\f$.
+ *
+ * The cost of a sample is proportional to the number of rules (and does not
+ * depend on the number of samples seen so far), which can be bounded by means
+ * of setMaxNumberOfRules().
+ *
+ * The ANFIS model must have its input and output variables defined; their
+ * ranges (if finite) are used to scale the data when computing potentials.
+ * Existing rules are kept, provided that the model has the structure built by
+ * fl::SubtractiveClusteringFisBuilder (i.e., the \f$r\f$-th rule
+ * uses the \f$r\f$-th Gaussian term of each input variable and the
+ * \f$r\f$-th linear term of each output variable), so that a model
+ * identified offline can be adapted online.
+ * Whenever a rule is added or merged, the terms and rules of the model are
+ * regenerated and the ANFIS network is rebuilt; otherwise, only the
+ * parameters of the terms are updated.
+ *
+ * References:
+ * -# [Angelov2004] P.P. Angelov and D.P. Filev, "An approach to online identification of Takagi-Sugeno fuzzy models," IEEE Transactions on Systems, Man, and Cybernetics, Part B, 34:1(484-498), 2004.
+ * -# [Angelov2010] P. Angelov, "Evolving Takagi-Sugeno fuzzy systems from streaming data (eTS+)," in Evolving Intelligent Systems: Methodology and Applications, Wiley, 2010.
+ * .
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class FL_API EvolvingTakagiSugenoLearningAlgorithm: public TrainingAlgorithm
+{
+private:
+    typedef TrainingAlgorithm BaseType;
+
+
+public:
+    /**
+     * Constructor
+     *
+     * \param p_anfis Pointer to the ANFIS model to be trained
+     * \param radius The radius of influence of rules, as a fraction of the
+     *  range of input variables
+     * \param ff The forgetting factor used by the local recursive least
+     *  squares estimators
+     */
+    explicit EvolvingTakagiSugenoLearningAlgorithm(Engine* p_anfis = fl::null,
+                                                   fl::scalar radius = 0.3,
+                                                   fl::scalar ff = 1);
+
+    /// Sets the radius of influence of rules, as a fraction of the range of input variables
+    void setRadius(fl::scalar value);
+
+    /// Gets the radius of influence of rules, as a fraction of the range of input variables
+    fl::scalar getRadius() const;
+
+    /// Sets the forgetting factor of the local recursive least squares estimators
+    void setForgettingFactor(fl::scalar value);
+
+    /// Gets the forgetting factor of the local recursive least squares estimators
+    fl::scalar getForgettingFactor() const;
+
+    /// Sets the initial value of the diagonal of the covariance matrix of the local estimators of new rules
+    void setInitialCovariance(fl::scalar value);
+
+    /// Gets the initial value of the diagonal of the covariance matrix of the local estimators of new rules
+    fl::scalar getInitialCovariance() const;
+
+    /// Sets the membership degree above which the center of a rule is merged with the center of another rule
+    void setMergeThreshold(fl::scalar value);
+
+    /// Gets the membership degree above which the center of a rule is merged with the center of another rule
+    fl::scalar getMergeThreshold() const;
+
+    /**
+     * Sets the maximum number of rules.
+     *
+     * When the rule base is full, a sample that would create a new rule moves
+     * the center of the nearest rule instead.
+     * A value of zero (the default) means no limit.
+     */
+    void setMaxNumberOfRules(std::size_t value);
+
+    /// Gets the maximum number of rules
+    std::size_t getMaxNumberOfRules() const;
+
+    /// Gets the current number of rules
+    std::size_t numberOfRules() const;
+
+    /// Gets the number of samples learned so far
+    std::size_t numberOfSamples() const;
+
+    /**
+     * Learns from a single sample and returns the output the model
+     * predicted for it before being updated.
+     *
+     * \param inFirst The iterator to the beginning of the sample inputs
+     * \param inLast The iterator to the ending of the sample inputs
+     * \param outFirst The iterator to the beginning of the sample outputs
+     * \param outLast The iterator to the ending of the sample outputs
+     *
+     * The sample is copied into internal buffers, and the returned
+     * reference is valid until the next sample is learned, so that no memory
+     * is allocated per sample unless the rule base changes.
+     */
+    template <typename InIterT, typename OutIterT>
+    const std::vector<fl::scalar>& learn(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast);
+
+    /// Learns from a single sample and returns the output the model predicted for it before being updated (see learn(InIterT,InIterT,OutIterT,OutIterT))
+    const std::vector<fl::scalar>& learn(const std::vector<fl::scalar>& inputs, const std::vector<fl::scalar>& outputs);
+
+private:
+    /// A rule of the evolving model
+    struct RuleState
+    {
+        std::vector<fl::scalar> center; ///< The (scaled) center in the joint input-output space
+        fl::scalar potential; ///< The potential of the center
+        std::size_t support; ///< The number of samples for which this rule was the most active
+        std::vector<fl::scalar> theta; ///< The consequent parameters ((numInputs+1) per output, bias last)
+        std::vector<fl::scalar> cov; ///< The covariance matrix of the local estimator (row-major)
+    };
+
+
+    /// Checks the correctness of the parameters of the training algorithm
+    void check() const;
+
+    /// Initializes the state of the algorithm from the ANFIS model
+    void init();
+
+    /// Learns from the sample stored in the input and output buffers and returns the output predicted for it
+    const std::vector<fl::scalar>& learnSample();
+
+    /// Returns the squared distance between the scaled inputs \a x and the antecedent of rule \a r, in units of its spread
+    fl::scalar inputDistanceSq(const fl::scalar* x, const RuleState& rule) const;
+
+    /// Computes the normalized firing strengths of rules for the scaled inputs \a x and returns the most active rule
+    std::size_t computeFiringStrengths(const fl::scalar* x, std::vector<fl::scalar>& lambda) const;
+
+    /// Computes the output of the model for the extended inputs \a xe and the normalized firing strengths \a lambda
+    void computeOutputs(const std::vector<fl::scalar>& xe, const std::vector<fl::scalar>& lambda, std::vector<fl::scalar>& y) const;
+
+    /// Evolves the structure of the rule base for the scaled sample \a z and returns \c true if the rule base has changed its size
+    bool evolve(const std::vector<fl::scalar>& z);
+
+    /// Adds a new rule centered in \a z with potential \a potential
+    void addRule(const std::vector<fl::scalar>& z, fl::scalar potential);
+
+    /// Merges rule \a r with the rules whose centers are too similar, and returns \c true if any rule was merged
+    bool mergeRule(std::size_t r);
+
+    /// Updates the local estimator of rule \a r
+    void updateConsequents(std::size_t r, const std::vector<fl::scalar>& xe, const std::vector<fl::scalar>& y, fl::scalar lambda);
+
+    /// Regenerates the terms and the rules of the ANFIS model and rebuilds it
+    void rebuildEngine();
+
+    /// Copies the parameters of rules into the terms of the ANFIS model
+    void updateEngineParameters();
+
+    /// Trains the ANFIS model for a single epoch only using the given training set \a trainData
+    fl::scalar doTrainSingleEpoch(const fl::DataSet<fl::scalar>& trainData);
+
+    /// Resets the state of the learning algorithm
+    void doReset();
+
+
+private:
+    fl::scalar radius_; ///< The radius of influence of rules
+    fl::scalar ff_; ///< The forgetting factor of local estimators
+    fl::scalar omega_; ///< The initial covariance of local estimators
+    fl::scalar mergeThr_; ///< The similarity threshold for merging rules
+    std::size_t maxRules_; ///< The maximum number of rules (0 means no limit)
+    bool initialized_; ///< \c true if the state has been initialized from the ANFIS model
+    std::size_t ni_; ///< The number of inputs
+    std::size_t no_; ///< The number of outputs
+    std::vector<fl::scalar> offset_; ///< The offset used to scale each input and output
+    std::vector<fl::scalar> scale_; ///< The factor used to scale each input and output
+    std::vector<fl::scalar> sigma_; ///< The spread of the Gaussian antecedents for each (scaled) input
+    std::size_t k_; ///< The number of samples seen so far
+    std::vector<fl::scalar> sumZ_; ///< The sum of past (scaled) samples, per dimension
+    fl::scalar sumZSq_; ///< The sum of squared norms of past (scaled) samples
+    std::vector<RuleState> rules_; ///< The rules of the model
+    std::vector<fl::scalar> lambda_; ///< Buffer for normalized firing strengths
+    std::vector<fl::scalar> xe_; ///< Buffer for the extended (with bias) inputs
+    std::vector<fl::scalar> z_; ///< Buffer for the scaled sample
+    std::vector<fl::scalar> y_; ///< Buffer for the sample outputs
+    std::vector<fl::scalar> yhat_; ///< Buffer for the predicted outputs
+    std::vector<fl::scalar> cx_; ///< Buffer for the product of the covariance matrix of a local estimator and the extended inputs
+}; // EvolvingTakagiSugenoLearningAlgorithm
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+template <typename InIterT, typename OutIterT>
+const std::vector<fl::scalar>& EvolvingTakagiSugenoLearningAlgorithm::learn(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast)
+{
+    if (!initialized_)
+    {
+        this->init();
+    }
+
+    // The extended inputs and the outputs are the unscaled sample
+    std::size_t n = 0;
+    for (; inFirst != inLast && n < ni_; ++inFirst)
+    {
+        xe_[n++] = *inFirst;
+    }
+    if (inFirst != inLast || n != ni_)
+    {
+        FL_THROW2(std::invalid_argument, "Incorrect input dimension");
+    }
+    n = 0;
+    for (; outFirst != outLast && n < no_; ++outFirst)
+    {
+        y_[n++] = *outFirst;
+    }
+    if (outFirst != outLast || n != no_)
+    {
+        FL_THROW2(std::invalid_argument, "Incorrect output dimension");
+    }
+
+    return this->learnSample();
+}
+
+}} // Namespace fl::anfis
+
+#endif // FL_ANFIS_TRAINING_EVOLVING_TS_H
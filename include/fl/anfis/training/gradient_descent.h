@@ -114,11 +114,11 @@ private:
     /// Checks the correctness of the parameters of the training algorithm
     void check() const;
 
-    /// Trains ANFIS for a signle epoch in offline (batch) mode
-    fl::scalar trainSingleEpochOffline(const fl::DataSet<fl::scalar>& trainData);
+    /// Trains ANFIS with the given entries of an epoch in offline (batch) mode
+    fl::scalar trainEntriesOffline(const fl::DataSet<fl::scalar>& trainData);
 
-    /// Trains ANFIS for a signle epoch in online mode
-    fl::scalar trainSingleEpochOnline(const fl::DataSet<fl::scalar>& trainData);
+    /// Trains ANFIS with the given entries of an epoch in online mode
+    fl::scalar trainEntriesOnline(const fl::DataSet<fl::scalar>& trainData);
 
     /// Updates parameters of input terms
     void updateInputParameters();
@@ -129,6 +129,15 @@ private:
     /// Trains the ANFIS model for a single epoch only using the given training set \a data
     fl::scalar doTrainSingleEpoch(const fl::DataSet<fl::scalar>& trainData);
 
+    /// Starts an epoch, resetting the error derivatives
+    void doBeginChunkedEpoch();
+
+    /// Trains the ANFIS model with a chunk of the entries of an epoch
+    fl::scalar doTrainChunk(const fl::DataSet<fl::scalar>& chunk);
+
+    /// Ends an epoch, updating the parameters of input terms (offline mode)
+    void doEndChunkedEpoch(fl::scalar rmse);
+
     /// Updates parameters of input terms
     virtual void doUpdateInputParameters() = 0;
 
@@ -31,8 +31,9 @@
 #include <fl/anfis/engine.h>
 #include <fl/anfis/training/training_algorithm.h>
 #include <fl/dataset.h>
-//#include <fl/detail/kalman.h>
+#include <fl/detail/kalman.h>
 #include <fl/detail/rls.h>
+#include <fl/detail/sparse.h>
 #include <fl/fuzzylite.h>
 #include <map>
 #include <vector>
@@ -123,6 +124,15 @@ private:
 
 
 public:
+    /// The estimators that can be used to identify the consequent parameters
+    enum EstimatorType
+    {
+        RecursiveLeastSquaresEstimation, ///< Recursive least-squares estimator
+        KalmanFilterEstimation, ///< Kalman filter
+        NormalEquationsEstimation ///< Batch least squares through the normal equations (offline mode only)
+    };
+
+
     /**
      * Constructor
      *
@@ -175,6 +185,30 @@ public:
     /// Gets the online/offline mode of the learning algorithm
     bool isOnline() const;
 
+    /// Sets the estimator used to identify the consequent parameters
+    void setEstimator(EstimatorType value);
+
+    /// Gets the estimator used to identify the consequent parameters
+    EstimatorType getEstimator() const;
+
+    /**
+     * Sets the threshold below which normalized rule firing strengths are
+     * treated as zero.
+     *
+     * The parameters of the rules whose normalized firing strength is not
+     * greater than this threshold are left out of the regressor of the
+     * current sample, which is thus sparse.
+     * The Kalman filter and the normal-equations estimators exploit sparse
+     * regressors, so that their per-sample cost only depends on the
+     * parameters of the rules that are actually fired.
+     * The default threshold is zero, which only drops the rules that are not
+     * fired at all and thus does not alter the estimates.
+     */
+    void setSparsityThreshold(fl::scalar value);
+
+    /// Gets the threshold below which normalized rule firing strengths are treated as zero
+    fl::scalar getSparsityThreshold() const;
+
 private:
     /// Initializes the training algorithm
     void init();
@@ -182,11 +216,11 @@ private:
     /// Checks the correctness of the parameters of the training algorithm
     void check() const;
 
-    /// Trains ANFIS for a signle epoch in offline (batch) mode
-    fl::scalar trainSingleEpochOffline(const fl::DataSet<fl::scalar>& trainData);
+    /// Trains ANFIS with the given entries of an epoch in offline (batch) mode
+    fl::scalar trainEntriesOffline(const fl::DataSet<fl::scalar>& trainData);
 
-    /// Trains ANFIS for a signle epoch in online mode
-    fl::scalar trainSingleEpochOnline(const fl::DataSet<fl::scalar>& trainData);
+    /// Trains ANFIS with the given entries of an epoch in online mode
+    fl::scalar trainEntriesOnline(const fl::DataSet<fl::scalar>& trainData);
 
     /// Updates parameters of input terms
     void updateInputParameters();
@@ -197,6 +231,15 @@ private:
     /// Resets state for single epoch training
     void resetSingleEpoch();
 
+    /// Resets the currently selected estimator
+    void resetEstimator();
+
+    /// Performs an iteration of the currently selected estimator and returns the estimated output
+    std::vector<fl::scalar> estimate(const fl::detail::SparseVector<fl::scalar>& regressor, const std::vector<fl::scalar>& target);
+
+    /// Gets the consequent parameters estimated so far by the currently selected estimator
+    std::vector< std::vector<fl::scalar> > estimatedParameters() const;
+
     /// Gets the number of parameters of each output term
     std::size_t numberOfOutputTermParameters() const;
 
@@ -206,6 +249,15 @@ private:
     /// Resets the state of the learning algorithm
     void doReset();
 
+    /// Starts an epoch, updating the input terms and the step size (offline mode) and resetting the estimator
+    void doBeginChunkedEpoch();
+
+    /// Trains the ANFIS model with a chunk of the entries of an epoch
+    fl::scalar doTrainChunk(const fl::DataSet<fl::scalar>& chunk);
+
+    /// Ends an epoch, remembering its RMSE for the step-size update strategy (offline mode)
+    void doEndChunkedEpoch(fl::scalar rmse);
+
 
 private:
     fl::scalar stepSizeInit_; ///< The initial value of the step size
@@ -217,8 +269,11 @@ private:
     std::size_t stepSizeIncrCounter_; ///< Counter used to check when to increase the step size
     std::size_t stepSizeDecrCounter_; ///< Counter used to check when to decrease the step size
     bool online_; ///< \c true in case of online learning; \c false if offline (batch) learning
+    EstimatorType estimator_; ///< The estimator used to identify the consequent parameters
     fl::detail::RecursiveLeastSquaresEstimator<fl::scalar> rls_; ///< The recursive least-squares estimator
-    //fl::detail::KalmanFilter<fl::scalar> rls_; ///< The recursive least-squares estimator
+    fl::detail::KalmanFilter<fl::scalar> kalman_; ///< The Kalman filter estimator
+    fl::detail::SparseNormalEquations<fl::scalar> normalEqs_; ///< The normal-equations estimator
+    fl::scalar sparsityThr_; ///< The threshold below which normalized rule firing strengths are treated as zero
     std::map< Node*, std::vector<fl::scalar> > dEdPs_; ///< Error derivatives wrt node parameters
     std::map< Node*, std::vector<fl::scalar> > oldDeltaPs_; ///< Old values of parameters changes (only for momentum learning)
 }; // Jang1993HybridLearningAlgorithm
@@ -28,6 +28,7 @@
 
 #include <cstddef>
 #include <fl/anfis/engine.h>
+#include <fl/data_source.h>
 #include <fl/dataset.h>
 #include <fl/fuzzylite.h>
 
@@ -41,6 +42,11 @@ namespace fl { namespace anfis {
  */
 class FL_API TrainingAlgorithm
 {
+public:
+    /// The default seed of the random number generator used to shuffle the training set
+    static const unsigned int DefaultSeed;
+
+
 public:
     /**
      * Constructor
@@ -59,6 +65,26 @@ public:
     /// Gets the ANFIS model to be trained
     Engine* getEngine() const;
 
+    /**
+     * Sets whether train() visits the entries of the training set in a
+     * different random order at each epoch.
+     *
+     * Each epoch is trained on a shuffled view of the training set (see
+     * fl::DataSet::shuffled), so no entry is copied.
+     * The sequence of orders is determined by the seed (see setSeed), so
+     * that trainings are reproducible.
+     */
+    void setIsShuffling(bool value);
+
+    /// Tells whether train() visits the entries of the training set in a different random order at each epoch
+    bool isShuffling() const;
+
+    /// Sets the seed of the random number generator used to shuffle the training set
+    void setSeed(unsigned int value);
+
+    /// Gets the seed of the random number generator used to shuffle the training set
+    unsigned int getSeed() const;
+
     /**
      * Trains the ANFIS model.
      *
@@ -91,9 +117,45 @@ public:
                      std::size_t maxEpochs = 10,
                      fl::scalar errorGoal = 0);
 
+    /**
+     * Trains the ANFIS model with the entries read from a data source.
+     *
+     * \param source The source of the training set
+     * \param maxEpochs The maximum number of epochs
+     * \param errorGoal The error to achieve
+     *
+     * The error measure is the Root Mean Squared Error (RMSE).
+     * The training set is never held in memory as a whole (see
+     * trainSingleEpoch(fl::DataSource<fl::scalar>&)), and it is not shuffled.
+     *
+     * \return The achieved error
+     */
+    fl::scalar train(fl::DataSource<fl::scalar>& source,
+                     std::size_t maxEpochs = 10,
+                     fl::scalar errorGoal = 0);
+
     /// Trains the ANFIS model for a single epoch only using the given training set \a data.
     fl::scalar trainSingleEpoch(const fl::DataSet<fl::scalar>& data);
 
+    /**
+     * Trains the ANFIS model for a single epoch only using the entries read
+     * from \a source.
+     *
+     * The entries are read and trained one chunk at a time, reading the next
+     * chunk while training the current one (see fl::VisitChunks), so memory
+     * is needed only for two chunks.
+     * The state of the epoch (e.g., estimators and step sizes) is reset and
+     * updated once per epoch, not once per chunk, so online algorithms train
+     * the same model as with the whole training set in memory.
+     * Offline algorithms still update the premise parameters once per epoch,
+     * while those estimating the consequent parameters by least squares
+     * measure the error of each chunk with the parameters estimated from the
+     * entries read so far.
+     *
+     * \return The RMSE over all the entries
+     */
+    fl::scalar trainSingleEpoch(fl::DataSource<fl::scalar>& source);
+
     /// Resets the state of the learning algorithm
     void reset();
 
@@ -104,9 +166,25 @@ private:
     /// Resets state for single epoch training
     virtual void doReset() = 0;
 
+    /// Starts an epoch whose entries are trained chunk by chunk
+    virtual void doBeginChunkedEpoch();
+
+    /// Trains the ANFIS model with a chunk of the entries of an epoch (by default, as if it were a whole epoch) and returns the RMSE over the chunk
+    virtual fl::scalar doTrainChunk(const fl::DataSet<fl::scalar>& chunk);
+
+    /// Ends an epoch whose entries have been trained chunk by chunk, given the RMSE over all the entries
+    virtual void doEndChunkedEpoch(fl::scalar rmse);
+
+    /// Trains the ANFIS model with each chunk of a data source, accumulating the squared errors
+    class ChunkTrainer;
+
+    friend class ChunkTrainer;
+
 
 private:
     Engine* p_anfis_; ///< The ANFIS model
+    bool shuffle_; ///< Whether to shuffle the training set at each epoch
+    unsigned int seed_; ///< The seed for shuffling the training set
 }; // TraningAlgorithm
 
 }} // Namespace fl::anfis
@@ -36,20 +36,30 @@ namespace fl { namespace ann {
 template <typename T> class Neuron;
 
 
+/**
+ * A weighted connection between two neurons.
+ *
+ * A connection either owns its weight or is a view of a weight stored
+ * elsewhere (see attach()); the latter is the case for the input connections
+ * of a fully connected layer, whose weights are stored in the weight matrix
+ * of the layer (see fl::ann::Layer::weightMatrix).
+ */
 template <typename ValueT>
 class Connection
 {
 	public: Connection()
 	: p_from_(fl::null),
 	  p_to_(fl::null),
-	  w_(0)
+	  w_(0),
+	  p_w_(fl::null)
 	{
 	}
 
 	public: Connection(Neuron<ValueT>* p_from, Neuron<ValueT>* p_to, ValueT weight = 0)
 	: p_from_(p_from),
 	  p_to_(p_to),
-	  w_(weight)
+	  w_(weight),
+	  p_w_(fl::null)
 	{
 	}
 
@@ -58,7 +68,7 @@ class Connection
 	/// Resets the weight of this connection
 	public: void reset()
 	{
-		w_ = 0;
+		this->setWeight(0);
 	}
 
 	/// Sets the neuron at the source
@@ -88,19 +98,46 @@ class Connection
 	/// Sets the weight
 	public: void setWeight(ValueT v)
 	{
-		w_ = v;
+		*(p_w_ ? p_w_ : &w_) = v;
 	}
 
 	/// Returns the weight
 	public: ValueT getWeight() const
 	{
-		return w_;
+		return p_w_ ? *p_w_ : w_;
+	}
+
+	/**
+	 * Makes this connection a view of the weight stored at \a p_weight,
+	 * which is set to the current weight.
+	 *
+	 * The weight must outlive the connection, or the connection must be
+	 * detached before the weight is destroyed.
+	 */
+	public: void attach(ValueT* p_weight)
+	{
+		*p_weight = this->getWeight();
+		p_w_ = p_weight;
+	}
+
+	/// Makes this connection own its weight again, with the value of the viewed one
+	public: void detach()
+	{
+		w_ = this->getWeight();
+		p_w_ = fl::null;
+	}
+
+	/// Tells if this connection is a view of a weight stored elsewhere
+	public: bool isView() const
+	{
+		return p_w_ != fl::null;
 	}
 
 
 	private: Neuron<ValueT>* p_from_; ///< A pointer to the neuron at the source
 	private: Neuron<ValueT>* p_to_; ///< A pointer to the neuron at the destination
-	private: ValueT w_; ///< The weight
+	private: ValueT w_; ///< The weight (unless this connection is a view)
+	private: ValueT* p_w_; ///< A pointer to the viewed weight (null if this connection owns its weight)
 }; // Connection
 
 }} // Namespace fl::ann
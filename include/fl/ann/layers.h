@@ -27,14 +27,43 @@
 
 
 #include <cstddef>
+#include <fl/ann/connection.h>
+#include <fl/ann/net_input_functions.h>
 #include <fl/ann/neurons.h>
+#include <fl/detail/array_view.h>
+#include <fl/detail/matrix_view.h>
 #include <fl/macro.h>
 #include <fl/fuzzylite.h>
 #include <stdexcept>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 
+namespace fl { namespace detail {
+
+/// Computes \f$y = A x\f$, where \f$A\f$ is the \a nr by \a nc matrix stored by rows at \a A
+template <typename ValueT>
+void Gemv(std::size_t nr, std::size_t nc, const ValueT* A, const ValueT* x, ValueT* y)
+{
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		const ValueT* Ai = A+i*nc;
+		ValueT sum = 0;
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd reduction(+:sum)
+#endif
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			sum += Ai[j]*x[j];
+		}
+		y[i] = sum;
+	}
+}
+
+}} // Namespace fl::detail
+
+
 namespace fl { namespace ann {
 
 template <typename T> class Network;
@@ -44,6 +73,14 @@ template <typename T> class Network;
  *
  * The Layer is essentially a container of neurons and it provides methods for manipulating neurons.
  *
+ * When a layer is fully connected from another layer (see
+ * isFullyConnected()), the weights of the input connections of its neurons
+ * are stored in a contiguous weight matrix, and their biases in a bias
+ * vector, so that the net inputs of all the neurons are computed by a single
+ * matrix-vector product.
+ * Connections and neurons keep working as before, as views of the elements
+ * of the matrix and of the vector.
+ *
  * \author Marco Guazzone (marco.guazzone@gmail.com)
  */
 template <typename ValueT>
@@ -57,7 +94,8 @@ class Layer
 	/// Default constructor
 	public: explicit Layer(Network<ValueT>* p_network = fl::null)
 	: p_network_(p_network),
-	  hasBias_(false)/*,
+	  hasBias_(false),
+	  p_srcLayer_(fl::null)/*,
 	  p_biasNeuron_(fl::null)*/
 	{
 	}
@@ -67,7 +105,8 @@ class Layer
 			Layer(IterT first, IterT last, Network<ValueT>* p_network = fl::null)
 	: neurons_(first, last),
 	  p_network_(p_network),
-	  hasBias_(false)/*,
+	  hasBias_(false),
+	  p_srcLayer_(fl::null)/*,
 	  p_biasNeuron_(fl::null)*/
 	{
 	}
@@ -109,6 +148,9 @@ class Layer
 			FL_THROW2(std::invalid_argument, "Neuron cannot be null!");
 		}
 
+		// The new neuron has no row in the weight matrix
+		this->detachConnections();
+
 		p_neuron->setLayer(this);
 		p_neuron->setHasBias(hasBias_);
 
@@ -122,6 +164,8 @@ class Layer
 		// check: null
 		FL_DEBUG_ASSERT( p_neuron );
 
+		this->detachConnections();
+
 		delete p_neuron;
 
 		return neurons_.erase(it);
@@ -134,6 +178,8 @@ class Layer
 		// check: null
 		FL_DEBUG_ASSERT( p_neuron );
 
+		this->detachConnections();
+
 		delete p_neuron;
 
 		return neurons_.erase(it);
@@ -161,6 +207,8 @@ class Layer
 //			neuronIt = this->eraseNeuron(neuronIt);
 //		}
 //		neurons_.clear();
+		this->detachConnections();
+
 		const std::size_t n = neurons_.size();
 		for (std::size_t i = 0; i < n; ++i)
 		{
@@ -205,11 +253,102 @@ class Layer
 		return hasBias_;
 	}
 
-	/// Performs calculaton for all the neurons inside this layer
+	/**
+	 * Tells if this layer is fully connected from a source layer, with the
+	 * weights of the input connections of its neurons stored in a weight
+	 * matrix (see weightMatrix()) and their biases in a bias vector (see
+	 * biasVector()).
+	 *
+	 * A layer becomes fully connected when it is connected to another layer
+	 * by Network::connect(Layer*,Layer*,ValueT) while its neurons have no
+	 * other input connection.
+	 * It stops being such as soon as its structure changes (i.e., when
+	 * neurons are added or removed, or when single input connections are
+	 * added or removed), and weights are then moved back to connections and
+	 * neurons.
+	 */
+	public: bool isFullyConnected() const
+	{
+		return p_srcLayer_ != fl::null;
+	}
+
+	/// Returns the layer this layer is fully connected from (null if it is not fully connected)
+	public: Layer<ValueT>* getSourceLayer() const
+	{
+		return p_srcLayer_;
+	}
+
+	/// Returns the number of inputs of each neuron, if this layer is fully connected (zero otherwise)
+	public: std::size_t numOfInputs() const
+	{
+		return srcNeurons_.size();
+	}
+
+	/// Returns the outputs of the neurons of the source layer (i.e., the inputs of each neuron), if this layer is fully connected
+	public: std::vector<ValueT> inputs() const
+	{
+		std::vector<ValueT> ins(srcNeurons_.size());
+		for (std::size_t j = 0,
+						 n = srcNeurons_.size();
+			 j < n;
+			 ++j)
+		{
+			ins[j] = srcNeurons_[j]->getOutput();
+		}
+
+		return ins;
+	}
+
+	/**
+	 * Returns the weight matrix, whose \a i-th row holds the weights of the
+	 * input connections of the \a i-th neuron, in the order of the neurons
+	 * of the source layer (an empty matrix if this layer is not fully
+	 * connected).
+	 *
+	 * Weights can be changed through the matrix, and the input connections
+	 * of the neurons see the changes.
+	 */
+	public: fl::detail::MatrixView<ValueT> weightMatrix()
+	{
+		const std::size_t nc = srcNeurons_.size();
+
+		return fl::detail::MatrixView<ValueT>(weights_.empty() ? 0 : &weights_[0], p_srcLayer_ ? neurons_.size() : 0, nc, nc);
+	}
+
+	/// Returns the weight matrix (see weightMatrix())
+	public: fl::detail::MatrixView<const ValueT> weightMatrix() const
+	{
+		return const_cast<Layer*>(this)->weightMatrix();
+	}
+
+	/// Returns the bias vector, holding the bias weight of each neuron (an empty vector if this layer is not fully connected)
+	public: fl::detail::ArrayView<ValueT> biasVector()
+	{
+		return fl::detail::ArrayView<ValueT>(biases_.empty() ? 0 : &biases_[0], biases_.size());
+	}
+
+	/// Returns the bias vector (see biasVector())
+	public: fl::detail::ArrayView<const ValueT> biasVector() const
+	{
+		return const_cast<Layer*>(this)->biasVector();
+	}
+
+	/**
+	 * Performs calculaton for all the neurons inside this layer.
+	 *
+	 * If this layer is fully connected and made of plain neurons with the
+	 * weighted-sum net input function, net inputs are computed by a single
+	 * matrix-vector product; otherwise, neurons are processed one by one.
+	 */
 	public: std::vector<ValueT> process()
 	{
 		this->handleBias();
 
+		if (this->canProcessAtOnce())
+		{
+			return this->processAtOnce();
+		}
+
 		std::vector<ValueT> outs;
 
 		for (NeuronIterator neuronIt = neurons_.begin(),
@@ -236,6 +375,143 @@ class Layer
 		return neurons_.empty();
 	}
 
+	/// Tells if the net inputs of all the neurons can be computed by a matrix-vector product
+	private: bool canProcessAtOnce() const
+	{
+		if (!p_srcLayer_)
+		{
+			return false;
+		}
+
+		for (std::size_t i = 0,
+						 n = neurons_.size();
+			 i < n;
+			 ++i)
+		{
+			const Neuron<ValueT>* p_neuron = neurons_[i];
+
+			// check: null
+			FL_DEBUG_ASSERT( p_neuron );
+
+			// Derived neurons may compute their output differently
+			if (typeid(*p_neuron) != typeid(Neuron<ValueT>)
+				|| typeid(*p_neuron->getNetInputFunction()) != typeid(WeightedSumNetInputFunction<ValueT>))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// Computes the net inputs of all the neurons by a matrix-vector product, and then their outputs
+	private: std::vector<ValueT> processAtOnce()
+	{
+		const std::size_t nr = neurons_.size();
+		const std::size_t nc = srcNeurons_.size();
+
+		ins_.resize(nc);
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			ins_[j] = srcNeurons_[j]->getOutput();
+		}
+
+		netIns_.assign(nr, 0);
+		if (nr > 0 && nc > 0)
+		{
+			fl::detail::Gemv(nr, nc, &weights_[0], &ins_[0], &netIns_[0]);
+		}
+
+		std::vector<ValueT> outs(nr);
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			const ValueT netIn = hasBias_ ? netIns_[i]+biases_[i] : netIns_[i];
+
+			outs[i] = neurons_[i]->activate(netIn);
+		}
+
+		return outs;
+	}
+
+	/**
+	 * Makes this layer fully connected from \a p_srcLayer, moving the
+	 * weights of the input connections (owned by \a p_network) and the
+	 * biases of the neurons to the weight matrix and to the bias vector.
+	 *
+	 * Each neuron of this layer must be connected to each neuron of
+	 * \a p_srcLayer.
+	 */
+	private: void attachConnections(Layer<ValueT>* p_srcLayer, const Network<ValueT>* p_network)
+	{
+		this->detachConnections();
+
+		const std::size_t nr = neurons_.size();
+		const std::size_t nc = p_srcLayer->numOfNeurons();
+
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			if (neurons_[i]->getLayer() != this)
+			{
+				// Neurons not added by addNeuron() cannot be views
+				return;
+			}
+		}
+
+		srcNeurons_.assign(p_srcLayer->neuronBegin(), p_srcLayer->neuronEnd());
+		weights_.assign(nr*nc, 0);
+		biases_.assign(nr, 0);
+		conns_.resize(nr*nc);
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			Neuron<ValueT>* p_neuron = neurons_[i];
+
+			biases_[i] = p_neuron->getBias();
+			p_neuron->row_ = i;
+
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				Connection<ValueT>* p_conn = p_network->getConnection(srcNeurons_[j], p_neuron);
+
+				// check: null
+				FL_DEBUG_ASSERT( p_conn );
+
+				p_conn->attach(&weights_[i*nc+j]);
+				conns_[i*nc+j] = p_conn;
+			}
+		}
+		p_srcLayer_ = p_srcLayer;
+	}
+
+	/// Moves the weights of the weight matrix and of the bias vector back to the input connections and to the neurons
+	private: void detachConnections()
+	{
+		if (!p_srcLayer_)
+		{
+			return;
+		}
+
+		p_srcLayer_ = fl::null;
+		for (std::size_t k = 0,
+						 n = conns_.size();
+			 k < n;
+			 ++k)
+		{
+			conns_[k]->detach();
+		}
+		for (std::size_t i = 0,
+						 n = neurons_.size();
+			 i < n;
+			 ++i)
+		{
+			neurons_[i]->setBias(biases_[i]);
+		}
+
+		srcNeurons_.clear();
+		weights_.clear();
+		biases_.clear();
+		conns_.clear();
+	}
+
 	/// Update bias connections
 	private: void handleBias()
 	{
@@ -257,6 +533,16 @@ class Layer
 	private: std::vector<Neuron<ValueT>*> neurons_; ///< The collection of neurons in this layer
     private: Network<ValueT>* p_network_; ///< Pointer to the neural network to which this layer belongs
 	private: bool hasBias_; ///< Tells if this layer has a bias unit or not
+	private: Layer<ValueT>* p_srcLayer_; ///< The layer this layer is fully connected from (null if it is not fully connected)
+	private: std::vector<Neuron<ValueT>*> srcNeurons_; ///< The neurons of the source layer, in the order of the columns of the weight matrix
+	private: std::vector<ValueT> weights_; ///< The weight matrix, stored by rows (one row per neuron)
+	private: std::vector<ValueT> biases_; ///< The bias vector
+	private: std::vector<Connection<ValueT>*> conns_; ///< The input connections, viewing the elements of the weight matrix (in the same order)
+	private: std::vector<ValueT> ins_; ///< The inputs of the last matrix-vector product
+	private: std::vector<ValueT> netIns_; ///< The net inputs computed by the last matrix-vector product
+
+	friend class Neuron<ValueT>;
+	friend class Network<ValueT>;
 }; // Layer
 
 }} // Namespace fl::ann
@@ -372,6 +372,12 @@ class Network
 
 		if (conns_.count(connId) == 0)
 		{
+			// The weight matrix of the layer of p_to has no room for the new connection
+			if (p_to->getLayer())
+			{
+				p_to->getLayer()->detachConnections();
+			}
+
 			Connection<ValueT>* p_conn = new Connection<ValueT>(p_from, p_to, weight);
 
 			// check: null
@@ -388,7 +394,14 @@ class Network
 		}
 	}
 
-	/// Fully connects \a p_from layer to \a p_to layer and assigns a weight of \a weight
+	/**
+	 * Fully connects \a p_from layer to \a p_to layer and assigns a weight of
+	 * \a weight.
+	 *
+	 * If the neurons of \a p_to had no input connection, \a p_to becomes
+	 * fully connected from \a p_from (see Layer::isFullyConnected), and
+	 * the weights of the new connections are stored in its weight matrix.
+	 */
 	public: void connect(Layer<ValueT>* p_from, Layer<ValueT>* p_to, ValueT weight)
 	{
 		// pre: p_from != null && p_to != null
@@ -401,6 +414,10 @@ class Network
 			FL_THROW2(std::invalid_argument, "The 'to' layer cannot be null in a connection");
 		}
 
+		// A layer connected to itself is not fully connected, since its
+		// neurons see the outputs of the neurons processed before them
+		const bool dense = p_from != p_to && !p_to->isFullyConnected() && !this->hasInputConnections(p_to);
+
 		for (typename Layer<ValueT>::NeuronIterator fromNeuronIt = p_from->neuronBegin(),
 													fromNeuronEndIt = p_from->neuronEnd();
 			 fromNeuronIt != fromNeuronEndIt;
@@ -424,6 +441,11 @@ class Network
 				this->connect(p_fromNeuron, p_toNeuron, weight);
 			}
 		}
+
+		if (dense)
+		{
+			p_to->attachConnections(p_from, this);
+		}
 	}
 
 	/// Removes the connection between \a p_from neuron and \a p_to neuron.
@@ -448,6 +470,12 @@ class Network
 			// check: null
 			FL_DEBUG_ASSERT( p_conn );
 
+			// The connection may be a view of an element of the weight matrix
+			if (p_to->getLayer())
+			{
+				p_to->getLayer()->detachConnections();
+			}
+
 			delete p_conn;
 
 			conns_.erase(connId);
@@ -695,6 +723,28 @@ class Network
 		return this->process();
 	}
 
+	/// Tells if some neuron of \a p_layer has input connections
+	private: bool hasInputConnections(const Layer<ValueT>* p_layer) const
+	{
+		for (ConstConnectionIterator connIt = conns_.begin(),
+									 connEndIt = conns_.end();
+			 connIt != connEndIt;
+			 ++connIt)
+		{
+			const Connection<ValueT>* p_conn = connIt->second;
+
+			// check: null
+			FL_DEBUG_ASSERT( p_conn );
+
+			if (p_conn->getToNeuron()->getLayer() == p_layer)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	private: static std::pair<const Neuron<ValueT>*,const Neuron<ValueT>*> MakeConnectionId(Neuron<ValueT>* p_from, Neuron<ValueT>* p_to)
 	{
 		return std::make_pair(static_cast<const Neuron<ValueT>*>(p_from), static_cast<const Neuron<ValueT>*>(p_to));
@@ -26,8 +26,10 @@
 #define FL_ANN_NEURONS_H
 
 
+#include <cstddef>
 #include <fl/ann/activation_functions.h>
 #include <fl/ann/net_input_functions.h>
+#include <fl/detail/array_view.h>
 #include <fl/macro.h>
 #include <fl/fuzzylite.h>
 #include <limits>
@@ -70,7 +72,8 @@ class Neuron
 	  out_(std::numeric_limits<ValueT>::quiet_NaN()),
 //	  err_(std::numeric_limits<ValueT>::quiet_NaN()),
 	  hasBias_(false),
-	  biasWeight_(0)
+	  biasWeight_(0),
+	  row_(0)
 	{
 //FL_DEBUG_TRACE("In Neuron's constructor (" << this << ")");//XXX
 	}
@@ -84,7 +87,8 @@ class Neuron
 	  out_(std::numeric_limits<ValueT>::quiet_NaN()),
 //	  err_(std::numeric_limits<ValueT>::quiet_NaN()),
 	  hasBias_(false),
-	  biasWeight_(0)
+	  biasWeight_(0),
+	  row_(0)
 	{
 //FL_DEBUG_TRACE("In Neuron's constructor (" << this << ")");//XXX
 		if (!p_inpFunc_.get())
@@ -125,7 +129,7 @@ class Neuron
 			   = std::numeric_limits<ValueT>::quiet_NaN();
 
 		hasBias_ = false;
-		biasWeight_ = 0;
+		this->setBias(0);
 
 		// Reset output connections
 		std::vector<Connection<ValueT>*> outConns = this->outputConnections();
@@ -204,6 +208,12 @@ class Neuron
 		FL_DEBUG_ASSERT( p_layer_ );
 		FL_DEBUG_ASSERT( p_layer_->getNetwork() );
 
+		if (this->isFullyConnected())
+		{
+			const std::size_t n = p_layer_->numOfInputs();
+			return std::vector<Connection<ValueT>*>(p_layer_->conns_.begin()+row_*n, p_layer_->conns_.begin()+(row_+1)*n);
+		}
+
 		return p_layer_->getNetwork()->inputConnections(this);
 	}
 
@@ -262,6 +272,11 @@ class Neuron
 	/// Returns the input values to this neuron
 	public: std::vector<ValueT> inputs() const
 	{
+		if (this->isFullyConnected())
+		{
+			return p_layer_->inputs();
+		}
+
 		std::vector<ValueT> ins;
 
 		const std::vector<Connection<ValueT>*> inConns = this->inputConnections();
@@ -285,6 +300,21 @@ class Neuron
 	public: template <typename IterT>
 			void weights(IterT weightFirst, IterT weightLast)
 	{
+		if (this->isFullyConnected())
+		{
+			fl::detail::ArrayView<ValueT> ws = p_layer_->weightMatrix()[row_];
+			for (std::size_t i = 0,
+							 n = ws.size();
+				 i < n && weightFirst != weightLast;
+				 ++i)
+			{
+				ws[i] = *weightFirst;
+
+				++weightFirst;
+			}
+			return;
+		}
+
 		const std::vector<Connection<ValueT>*> inConns = this->inputConnections();
 		for (typename std::vector<Connection<ValueT>*>::iterator connIt = inConns.begin(),
 																 connEndIt = inConns.end();
@@ -306,6 +336,12 @@ class Neuron
 	/// Returns the weight values to this neuron
 	public: std::vector<ValueT> weights() const
 	{
+		if (this->isFullyConnected())
+		{
+			const fl::detail::ArrayView<const ValueT> ws = static_cast<const Layer<ValueT>*>(p_layer_)->weightMatrix()[row_];
+			return std::vector<ValueT>(ws.begin(), ws.end());
+		}
+
 		std::vector<ValueT> ws;
 
 		const std::vector<Connection<ValueT>*> inConns = this->inputConnections();
@@ -367,6 +403,24 @@ class Neuron
 		return out_;
 	}
 
+	/**
+	 * Sets the net input of this neuron to \a v and computes its output by
+	 * means of the activation function.
+	 *
+	 * Used by layers that compute the net inputs of all their neurons at
+	 * once (see fl::ann::Layer::process).
+	 */
+	public: ValueT activate(ValueT v)
+	{
+		// check: null
+		FL_DEBUG_ASSERT( p_actFunc_.get() );
+
+		netIn_ = v;
+		out_ = p_actFunc_->eval(netIn_);
+
+		return out_;
+	}
+
 	public: ValueT getOutput() const
 	{
 		return out_;
@@ -399,12 +453,25 @@ class Neuron
 
 	public: void setBias(ValueT wb)
 	{
-		biasWeight_ = wb;
+		if (this->isFullyConnected())
+		{
+			p_layer_->biases_[row_] = wb;
+		}
+		else
+		{
+			biasWeight_ = wb;
+		}
 	}
 
 	public: ValueT getBias() const
 	{
-		return biasWeight_;
+		return this->isFullyConnected() ? p_layer_->biases_[row_] : biasWeight_;
+	}
+
+	/// Tells if the weights of this neuron are stored by its (fully connected) layer
+	private: bool isFullyConnected() const
+	{
+		return p_layer_ && p_layer_->isFullyConnected();
 	}
 
 
@@ -415,7 +482,10 @@ class Neuron
 	private: ValueT out_; ///< The output of this neuron
 //	private: ValueT err_; //< The error term
 	private: bool hasBias_; ///< Tells if this neuron has a bias connection
-	private: ValueT biasWeight_; ///< The weight associated to the bias connection
+	private: ValueT biasWeight_; ///< The weight associated to the bias connection (unless the layer is fully connected)
+	private: std::size_t row_; ///< The position of this neuron in its layer, when the layer is fully connected
+
+	friend class Layer<ValueT>;
 }; // Neuron
 
 
@@ -30,6 +30,7 @@
 #include <cstddef>
 #include <fl/ann/error_functions.h>
 #include <fl/ann/networks.h>
+#include <fl/data_source.h>
 #include <fl/dataset.h>
 #include <fl/detail/traits.h>
 #include <fl/detail/iterators.h>
@@ -125,6 +126,32 @@ class TrainingAlgorithm: boost::noncopyable
 		return p_errFunc_->getTotalError();
     }
 
+    /**
+     * Trains the network for a single epoch with the entries read from
+     * \a source, one chunk at a time, reading the next chunk while training
+     * the current one (see fl::VisitChunks).
+     */
+    public: ValueT trainSingleEpoch(DataSource<ValueT>& source)
+    {
+        if (!p_nnet_)
+        {
+            FL_THROW("Cannot train a null neural network");
+        }
+        if (!p_errFunc_.get())
+        {
+            FL_THROW("Cannot train with a null error function");
+        }
+
+		this->resetSingleEpoch();
+
+        ChunkTrainer trainer(this);
+        fl::VisitChunks(source, trainer);
+
+        this->doEndChunkedEpoch();
+
+		return p_errFunc_->getTotalError();
+    }
+
 	protected: void resetSingleEpoch()
 	{
 		p_errFunc_->reset();
@@ -135,6 +162,37 @@ class TrainingAlgorithm: boost::noncopyable
 
     private: virtual void doResetSingleEpoch() = 0;
 
+    /// Trains the network with a chunk of the entries of an epoch (by default, as if it were a whole epoch)
+    private: virtual void doTrainChunk(const DataSet<ValueT>& chunk)
+    {
+        this->doTrainSingleEpoch(chunk);
+    }
+
+    /// Ends an epoch whose entries have been trained chunk by chunk
+    private: virtual void doEndChunkedEpoch()
+    {
+        // empty
+    }
+
+
+    /// Trains the network with each chunk of a data source
+    private: class ChunkTrainer
+    {
+        public: explicit ChunkTrainer(TrainingAlgorithm* p_algo)
+        : p_algo_(p_algo)
+        {
+        }
+
+        public: void operator()(const DataSet<ValueT>& chunk)
+        {
+            p_algo_->doTrainChunk(chunk);
+        }
+
+        private: TrainingAlgorithm* p_algo_;
+    }; // ChunkTrainer
+
+    friend class ChunkTrainer;
+
 
     private: Network<ValueT>* p_nnet_;
     private: FL_unique_ptr< ErrorFunction<ValueT> > p_errFunc_;
@@ -305,6 +363,32 @@ class GradientDescentBackpropagationAlgorithm: public TrainingAlgorithm<ValueT>
 
     /// Training for a single epoch
     private: void doTrainSingleEpoch(const DataSet<ValueT>& data)
+    {
+        this->trainEntries(data);
+
+		if (!online_)
+		{
+			this->updateWeightsOffline();
+		}
+    }
+
+    /// Training with a chunk of the entries of an epoch
+    private: void doTrainChunk(const DataSet<ValueT>& chunk)
+    {
+        this->trainEntries(chunk);
+    }
+
+    /// Ends an epoch trained chunk by chunk (in batch mode, the weights are updated only once per epoch)
+    private: void doEndChunkedEpoch()
+    {
+		if (!online_)
+		{
+			this->updateWeightsOffline();
+		}
+    }
+
+    /// Feeds the network with each entry, updating the weights (online) or accumulating the error gradients (offline)
+    private: void trainEntries(const DataSet<ValueT>& data)
     {
 		Network<ValueT>* p_nnet = this->getNetwork();
 
@@ -388,11 +472,6 @@ std::cerr << std::endl;
 #endif // FL_DEBUG
 //[/XXX]
         }
-
-		if (!online_)
-		{
-			this->updateWeightsOffline();
-		}
     }
 
     private: void backpropagateErrors(const std::vector<ValueT>& targetOut, const std::vector<ValueT>& actualOut)
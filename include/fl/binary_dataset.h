@@ -0,0 +1,344 @@
+/**
+ * \file fl/binary_dataset.h
+ *
+ * \brief Reading and writing of datasets in binary format
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_BINARY_DATASET_H
+#define FL_BINARY_DATASET_H
+
+
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cstddef>
+#include <cstring>
+#include <fl/dataset.h>
+#include <fl/macro.h>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace fl {
+
+/**
+ * The binary format of datasets.
+ *
+ * A dataset file is made of:
+ * - a header of HeaderSize bytes, containing (in this order, and in the
+ *   byte order of the machine that wrote the file):
+ *   - the magic string "FLXDSET" (terminated by a null character),
+ *   - the format version (32-bit unsigned integer),
+ *   - the byte order mark, i.e., the number 0x01020304 (32-bit unsigned
+ *     integer),
+ *   - the type of values (32-bit unsigned integer, see ValueType),
+ *   - the size of a value, in bytes (32-bit unsigned integer),
+ *   - the number of inputs (64-bit unsigned integer),
+ *   - the number of outputs (64-bit unsigned integer),
+ *   - the number of entries (64-bit unsigned integer),
+ *   - the size of the labels block, in bytes (64-bit unsigned integer),
+ *   - the offset of the first value from the beginning of the file, in bytes
+ *     (64-bit unsigned integer);
+ *   .
+ * - the labels block, where each label is terminated by a null character;
+ * - padding up to the next multiple of Alignment bytes;
+ * - the values of all the entries, one entry after the other, each one made
+ *   of its inputs followed by its outputs.
+ * .
+ * Since values are stored exactly as in a fl::DataSet, a file can be
+ * memory-mapped and used without any parse step (see
+ * fl::BinaryDataSetReader).
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class BinaryDataSetFormat
+{
+public:
+    /// The types of values
+    enum ValueType
+    {
+        Float32ValueType = 1, ///< IEEE 754 single-precision values
+        Float64ValueType = 2 ///< IEEE 754 double-precision values
+    };
+
+    static const boost::uint32_t Version = 1; ///< The version of the format
+    static const boost::uint32_t ByteOrderMark = 0x01020304; ///< The byte order mark
+    static const std::size_t HeaderSize = 64; ///< The size of the header, in bytes
+    static const std::size_t Alignment = 64; ///< The alignment of values, in bytes
+
+    /// Returns the magic string that starts a dataset file
+    static const char* magic()
+    {
+        return "FLXDSET";
+    }
+}; // BinaryDataSetFormat
+
+
+namespace detail {
+
+/// Maps C++ types to the types of values of the binary dataset format
+template <typename ValueT>
+struct BinaryDataSetValueTypeTraits;
+
+template <>
+struct BinaryDataSetValueTypeTraits<float>
+{
+    static const BinaryDataSetFormat::ValueType value = BinaryDataSetFormat::Float32ValueType;
+};
+
+template <>
+struct BinaryDataSetValueTypeTraits<double>
+{
+    static const BinaryDataSetFormat::ValueType value = BinaryDataSetFormat::Float64ValueType;
+};
+
+/// Copies the bytes of \a x at \a p and returns the next position
+template <typename T>
+char* BinaryDataSetPut(char* p, const T& x)
+{
+    std::memcpy(p, &x, sizeof(T));
+    return p+sizeof(T);
+}
+
+/// Copies \a x from the bytes at \a p and returns the next position
+template <typename T>
+const char* BinaryDataSetGet(const char* p, T& x)
+{
+    std::memcpy(&x, p, sizeof(T));
+    return p+sizeof(T);
+}
+
+} // Namespace detail
+
+
+/**
+ * Writes datasets in binary format (see fl::BinaryDataSetFormat).
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class BinaryDataSetWriter
+{
+public:
+    /// Writes the dataset \a data to the output stream \a os (which should be opened in binary mode)
+    template <typename ValueT>
+    void write(const fl::DataSet<ValueT>& data, std::ostream& os) const;
+
+    /// Writes the dataset \a data to the file \a fname
+    template <typename ValueT>
+    void write(const fl::DataSet<ValueT>& data, const std::string& fname) const;
+}; // BinaryDataSetWriter
+
+
+/**
+ * Reads datasets in binary format (see fl::BinaryDataSetFormat).
+ *
+ * The file is memory-mapped and the resulting dataset is a view of the
+ * mapped values (see fl::DataSet::isView), so that reading takes a constant
+ * time and pages are loaded by the operating system only when accessed.
+ * The mapping is private: changes made to the values through the dataset are
+ * never written back to the file.
+ * The mapping is released when the dataset (and all its copies) are
+ * destroyed, or when they stop being views.
+ *
+ * The type of values stored in the file must match the type of values of the
+ * dataset.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class BinaryDataSetReader
+{
+public:
+    /// Reads the file \a fname into the dataset \a data
+    template <typename ValueT>
+    void read(const std::string& fname, fl::DataSet<ValueT>& data) const;
+}; // BinaryDataSetReader
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+template <typename ValueT>
+void BinaryDataSetWriter::write(const fl::DataSet<ValueT>& data, std::ostream& os) const
+{
+    const std::vector<std::string> labels = data.labels();
+
+    std::string labelsBlock;
+    for (std::size_t i = 0,
+                     n = labels.size();
+         i < n;
+         ++i)
+    {
+        labelsBlock += labels[i];
+        labelsBlock += '\0';
+    }
+
+    const std::size_t align = BinaryDataSetFormat::Alignment;
+    const boost::uint64_t offset = ((BinaryDataSetFormat::HeaderSize+labelsBlock.size()+align-1)/align)*align;
+
+    std::vector<char> header(offset, '\0');
+    char* p = &header[0];
+    std::memcpy(p, BinaryDataSetFormat::magic(), std::strlen(BinaryDataSetFormat::magic())+1);
+    p += 8;
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint32_t>(BinaryDataSetFormat::Version));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint32_t>(BinaryDataSetFormat::ByteOrderMark));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint32_t>(detail::BinaryDataSetValueTypeTraits<ValueT>::value));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint32_t>(sizeof(ValueT)));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint64_t>(data.numOfInputs()));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint64_t>(data.numOfOutputs()));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint64_t>(data.size()));
+    p = detail::BinaryDataSetPut(p, static_cast<boost::uint64_t>(labelsBlock.size()));
+    p = detail::BinaryDataSetPut(p, offset);
+    FL_DEBUG_ASSERT( p == &header[0]+BinaryDataSetFormat::HeaderSize );
+    labelsBlock.copy(&header[0]+BinaryDataSetFormat::HeaderSize, labelsBlock.size());
+
+    os.write(&header[0], header.size());
+    if (data.isContiguous())
+    {
+        if (!data.empty())
+        {
+            os.write(reinterpret_cast<const char*>(data.rawData()), data.size()*data.stride()*sizeof(ValueT));
+        }
+    }
+    else
+    {
+        // A view of scattered entries: write them one by one
+        const std::size_t inSize = data.numOfInputs()*sizeof(ValueT);
+        const std::size_t outSize = data.numOfOutputs()*sizeof(ValueT);
+        for (std::size_t i = 0,
+                         n = data.size();
+             i < n && os;
+             ++i)
+        {
+            os.write(reinterpret_cast<const char*>(data.inputs(i)), inSize);
+            os.write(reinterpret_cast<const char*>(data.outputs(i)), outSize);
+        }
+    }
+
+    if (!os)
+    {
+        FL_THROW2(std::runtime_error, "Unable to write the dataset");
+    }
+}
+
+template <typename ValueT>
+void BinaryDataSetWriter::write(const fl::DataSet<ValueT>& data, const std::string& fname) const
+{
+    std::ofstream ofs(fname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+        FL_THROW2(std::runtime_error, "Unable to open the file '" + fname + "'");
+    }
+
+    this->write(data, ofs);
+}
+
+template <typename ValueT>
+void BinaryDataSetReader::read(const std::string& fname, fl::DataSet<ValueT>& data) const
+{
+    namespace bip = boost::interprocess;
+
+    boost::shared_ptr<bip::mapped_region> p_region;
+    try
+    {
+        const bip::file_mapping mapping(fname.c_str(), bip::read_only);
+
+        p_region.reset(new bip::mapped_region(mapping, bip::copy_on_write));
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+        FL_THROW2(std::runtime_error, "Unable to map the file '" + fname + "': " + e.what());
+    }
+
+    const std::size_t size = p_region->get_size();
+    char* base = static_cast<char*>(p_region->get_address());
+
+    if (size < BinaryDataSetFormat::HeaderSize
+        || std::memcmp(base, BinaryDataSetFormat::magic(), std::strlen(BinaryDataSetFormat::magic())+1) != 0)
+    {
+        FL_THROW2(std::runtime_error, "The file '" + fname + "' is not a dataset file");
+    }
+
+    boost::uint32_t version = 0;
+    boost::uint32_t bom = 0;
+    boost::uint32_t valueType = 0;
+    boost::uint32_t valueSize = 0;
+    boost::uint64_t ni = 0;
+    boost::uint64_t no = 0;
+    boost::uint64_t n = 0;
+    boost::uint64_t labelsSize = 0;
+    boost::uint64_t offset = 0;
+
+    const char* p = base+8;
+    p = detail::BinaryDataSetGet(p, version);
+    p = detail::BinaryDataSetGet(p, bom);
+    p = detail::BinaryDataSetGet(p, valueType);
+    p = detail::BinaryDataSetGet(p, valueSize);
+    p = detail::BinaryDataSetGet(p, ni);
+    p = detail::BinaryDataSetGet(p, no);
+    p = detail::BinaryDataSetGet(p, n);
+    p = detail::BinaryDataSetGet(p, labelsSize);
+    p = detail::BinaryDataSetGet(p, offset);
+
+    if (version != BinaryDataSetFormat::Version)
+    {
+        FL_THROW2(std::runtime_error, "Unsupported version of the dataset file '" + fname + "'");
+    }
+    if (bom != BinaryDataSetFormat::ByteOrderMark)
+    {
+        FL_THROW2(std::runtime_error, "The dataset file '" + fname + "' has been written with a different byte order");
+    }
+    if (valueType != static_cast<boost::uint32_t>(detail::BinaryDataSetValueTypeTraits<ValueT>::value) || valueSize != sizeof(ValueT))
+    {
+        FL_THROW2(std::runtime_error, "The type of values of the dataset file '" + fname + "' does not match the type of values of the dataset");
+    }
+    if (offset % BinaryDataSetFormat::Alignment != 0
+        || offset < BinaryDataSetFormat::HeaderSize+labelsSize
+        || offset > size
+        || ((ni+no) > 0 && n > (size-offset)/((ni+no)*sizeof(ValueT))))
+    {
+        FL_THROW2(std::runtime_error, "The dataset file '" + fname + "' is truncated or corrupted");
+    }
+
+    std::vector<std::string> labels;
+    for (const char* q = base+BinaryDataSetFormat::HeaderSize,
+                   * qEnd = q+labelsSize;
+         q < qEnd;
+         q += labels.back().size()+1)
+    {
+        labels.push_back(std::string(q, std::find(q, qEnd, '\0')));
+    }
+
+    data = fl::DataSet<ValueT>(reinterpret_cast<ValueT*>(base+offset), n, ni, no, p_region);
+    data.setLabels(labels.begin(), labels.end());
+}
+
+} // Namespace fl
+
+#endif // FL_BINARY_DATASET_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,239 @@
+/**
+ * \file fl/cluster/fuzzy_cmeans.h
+ *
+ * \brief Fuzzy c-means clustering (Bezdek, 1981)
+ *
+ * References:
+ * -# J.C. Bezdek, "Pattern Recognition with Fuzzy Objective Function Algorithms," Plenum Press, 1981
+ * .
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_CLUSTER_FUZZY_CMEANS_H
+#define FL_CLUSTER_FUZZY_CMEANS_H
+
+
+#include <cstddef>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl { namespace cluster {
+
+/**
+ * \brief Partitions a set of data into a given number of fuzzy clusters by
+ *  means of the fuzzy c-means method (Bezdek, 1981).
+ *
+ * Fuzzy c-means looks for the cluster centers \f$c_k\f$ and the membership
+ * degrees \f$u_{ik}\f$ of each data point \f$x_i\f$ to each cluster that
+ * minimize the objective function:
+ * \f[
+ *  J = \sum_{i=1}^n \sum_{k=1}^c u_{ik}^m \|x_i-c_k\|^2
+ * \f]
+ * subject to \f$\sum_{k=1}^c u_{ik} = 1\f$, where \f$m > 1\f$ is the
+ * exponent controlling the amount of fuzzy overlap between clusters.
+ * The algorithm alternates the update of the membership degrees:
+ * \f[
+ *  u_{ik} = \left(\sum_{l=1}^c \left(\frac{\|x_i-c_k\|}{\|x_i-c_l\|}\right)^{\frac{2}{m-1}}\right)^{-1}
+ * \f]
+ * and the update of the cluster centers:
+ * \f[
+ *  c_k = \frac{\sum_{i=1}^n u_{ik}^m x_i}{\sum_{i=1}^n u_{ik}^m}
+ * \f]
+ * until the relative improvement of the objective function falls below the
+ * given tolerance or the maximum number of iterations is reached.
+ *
+ * The algorithm takes the following parameters:
+ * - <em>number of clusters</em>: the number \f$c\f$ of clusters to find.
+ * - <em>exponent</em>: the exponent \f$m\f$ for the membership degrees.
+ *   If not provided, 2 is used as default value.
+ * - <em>maximum number of iterations</em>: if not provided, 100 is used as
+ *   default value.
+ * - <em>tolerance</em>: the minimum relative improvement of the objective
+ *   function between two iterations.
+ *   If not provided, 1e-5 is used as default value.
+ * - <em>initial centers</em>: if not provided, the initial centers are drawn
+ *   from the data points by the k-means++ seeding (Arthur et al., 2007),
+ *   where each new center is a data point chosen with probability
+ *   proportional to its squared distance from the nearest center already
+ *   chosen.
+ *   The cluster centers found by SubtractiveClustering are a common
+ *   alternative.
+ * .
+ *
+ * Data points are stored dimension-major, so that distances, membership
+ * degrees and center updates are computed over contiguous memory, a block of
+ * data points at a time.
+ * When the library is built with \c FLX_CONFIG_HAVE_OPENMP, blocks are
+ * spread over multiple threads, each one accumulating its own partial
+ * sums; partial sums are then added in a fixed order, so that, for a given
+ * number of threads, results do not depend on scheduling.
+ *
+ * Besides the cluster centers, the algorithm computes the fuzzy spread of
+ * each cluster in each data dimension, that is the standard deviation of the
+ * data points weighted by \f$u_{ik}^m\f$, which can be used as the width of
+ * Gaussian membership functions.
+ *
+ * References:
+ * -# J.C. Bezdek, "Pattern Recognition with Fuzzy Objective Function Algorithms," Plenum Press, 1981
+ * -# D. Arthur and S. Vassilvitskii, "k-means++: The Advantages of Careful Seeding," Proc. of the 18th ACM-SIAM Symposium on Discrete Algorithms, 1027-1035, 2007
+ * .
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class FL_API FuzzyCMeansClustering
+{
+private:
+	static const fl::scalar DefaultExponent;
+	static const std::size_t DefaultMaxIterations;
+	static const fl::scalar DefaultTolerance;
+	static const unsigned int DefaultSeed;
+
+public:
+	/// Constructs a clustering algorithm looking for \a numClusters clusters
+	explicit FuzzyCMeansClustering(std::size_t numClusters = 2);
+
+	/// Sets the number of clusters to find
+	void setNumOfClusters(std::size_t value);
+
+	/// Returns the number of clusters to find
+	std::size_t getNumOfClusters() const;
+
+	/// Sets the exponent for the membership degrees (must be greater than 1)
+	void setExponent(fl::scalar value);
+
+	/// Returns the exponent for the membership degrees
+	fl::scalar getExponent() const;
+
+	/// Sets the maximum number of iterations
+	void setMaxIterations(std::size_t value);
+
+	/// Returns the maximum number of iterations
+	std::size_t getMaxIterations() const;
+
+	/// Sets the minimum relative improvement of the objective function between two iterations
+	void setTolerance(fl::scalar value);
+
+	/// Returns the minimum relative improvement of the objective function between two iterations
+	fl::scalar getTolerance() const;
+
+	/// Sets the seed of the random number generator used by the k-means++ seeding
+	void setSeed(unsigned int value);
+
+	/// Returns the seed of the random number generator used by the k-means++ seeding
+	unsigned int getSeed() const;
+
+	/**
+	 * Sets the initial cluster centers, which replace the k-means++ seeding.
+	 *
+	 * An empty matrix (the default) restores the k-means++ seeding.
+	 * Otherwise, the number of centers must match the number of clusters.
+	 */
+	void setInitialCenters(const std::vector< std::vector<fl::scalar> >& value);
+
+	/// Returns the initial cluster centers
+	std::vector< std::vector<fl::scalar> > initialCenters() const;
+
+	/// Resets the internal state of the clustering algorithm
+	void reset();
+
+	/// Applies the clustering algorithm to the given dataset
+	template <typename MatrixT>
+	void cluster(const MatrixT& data);
+
+	/// Returns the found cluster centers
+	std::vector< std::vector<fl::scalar> > centers() const;
+
+	/// Returns the number of found clusters
+	std::size_t numOfClusters() const;
+
+	/// Returns the fuzzy spread of each cluster in each of the data dimensions
+	std::vector< std::vector<fl::scalar> > spreads() const;
+
+	/// Returns the membership degree of each data point (by row) to each cluster (by column)
+	std::vector< std::vector<fl::scalar> > memberships() const;
+
+	/// Returns the value of the objective function at the last iteration
+	fl::scalar objective() const;
+
+	/// Returns the number of iterations performed by the last clustering
+	std::size_t numOfIterations() const;
+
+
+private:
+	/// Clusters the \a nr data points of \a nc components stored dimension-major in \a X
+	void estimate(const std::vector<fl::scalar>& X, std::size_t nr, std::size_t nc);
+
+	/// Chooses the initial centers (one after the other in \a C) by the k-means++ seeding
+	void seedCenters(const std::vector<fl::scalar>& X, std::size_t nr, std::size_t nc, std::vector<fl::scalar>& C) const;
+
+
+private:
+	std::size_t numClusters_; ///< The number of clusters to find
+	fl::scalar exponent_; ///< The exponent for the membership degrees
+	std::size_t maxIters_; ///< The maximum number of iterations
+	fl::scalar tol_; ///< The minimum relative improvement of the objective function
+	unsigned int seed_; ///< The seed for the k-means++ seeding
+	std::vector< std::vector<fl::scalar> > initCenters_; ///< The initial cluster centers (empty for k-means++ seeding)
+	std::vector< std::vector<fl::scalar> > centers_; ///< The found cluster centers
+	std::vector< std::vector<fl::scalar> > spreads_; ///< The fuzzy spread of each cluster in each data dimension
+	std::vector<fl::scalar> U_; ///< The membership degrees (cluster-major, i.e., u_{ik} is at position k*nr+i)
+	std::size_t nr_; ///< The number of clustered data points
+	fl::scalar obj_; ///< The value of the objective function at the last iteration
+	std::size_t numIters_; ///< The number of iterations performed by the last clustering
+}; // FuzzyCMeansClustering
+
+
+template <typename MatrixT>
+void FuzzyCMeansClustering::cluster(const MatrixT& data)
+{
+	const std::size_t nr = data.size(); // Number of data points
+	if (nr == 0)
+	{
+		FL_THROW("Data set must have at least one point");
+	}
+
+	const std::size_t nc = data[0].size(); // Number of data parameters
+
+	// Data points are stored dimension-major (i.e., the j-th component of the
+	// i-th point is at position j*nr+i)
+	std::vector<fl::scalar> X(nr*nc);
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		if (data[i].size() != nc)
+		{
+			FL_THROW("Data points must have the same dimension");
+		}
+
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			X[j*nr+i] = data[i][j];
+		}
+	}
+
+	this->estimate(X, nr, nc);
+}
+
+}} // Namespace fl::cluster
+
+
+#endif // FL_CLUSTER_FUZZY_CMEANS_H
@@ -30,12 +30,15 @@
 #define FL_CLUSTER_SUBTRACTIVE_H
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <fl/data_source.h>
 #include <fl/detail/math.h>
 #include <fl/detail/traits.h>
 #include <fl/fuzzylite.h>
 #include <fl/macro.h>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 
@@ -103,6 +106,17 @@ namespace fl { namespace cluster {
  *   by taking the min and max values.
  * .
  *
+ * The initial potentials are computed by visiting each pair of data points
+ * only once (the kernel is symmetric) and, when the library is built with
+ * \c FLX_CONFIG_HAVE_OPENMP, the computation of potentials is spread over
+ * multiple threads.
+ * The results only differ from the ones of a serial computation by the
+ * rounding errors due to a different order of summation.
+ *
+ * Datasets that do not fit in memory can be clustered by clusterStream(),
+ * which clusters a weighted summary of the data built while reading them in
+ * chunks.
+ *
  * The cluster estimates are often used to initialize other iterative
  * optimization-based clustering methods (e.g., fuzzy c-means) and model
  * identification methods (e.g, ANFIS).
@@ -116,11 +130,14 @@ namespace fl { namespace cluster {
  */
 class FL_API SubtractiveClustering
 {
+	friend class SubtractiveClusteringSweep;
+
 private:
 	static const fl::scalar DefaultRadius;
 	static const fl::scalar DefaultSquashingFactor;
 	static const fl::scalar DefaultAcceptanceRatio;
 	static const fl::scalar DefaultRejectionRatio;
+	static const fl::scalar DefaultSummaryResolution;
 
 public:
 	/// The default constructor
@@ -223,13 +240,95 @@ public:
 	 */
 	std::vector<std::vector<fl::scalar> > bounds() const;
 
+	/**
+	 * Sets the tolerance below which the contribution of a data point to the
+	 * potential of another data point is neglected.
+	 *
+	 * A positive tolerance \f$\tau\f$ enables the cutoff mode: the data
+	 * points are indexed by a k-d tree (built in the space scaled by the
+	 * cluster radii), and the potential of a data point is only accumulated
+	 * over the data points within \f$\sqrt{-\ln \tau}/2\f$ radii, while a
+	 * new cluster center only revises the potential of the data points
+	 * within \f$\sqrt{-\ln \tau}/2\f$ squashed radii.
+	 * For small radii, this makes the cost of clustering nearly linear in the
+	 * number of data points.
+	 * A zero tolerance (the default) disables the cutoff mode.
+	 */
+	void setCutoffTolerance(fl::scalar value);
+
+	/// Returns the tolerance below which contributions to potentials are neglected
+	fl::scalar getCutoffTolerance() const;
+
+	/**
+	 * Returns an upper bound on the absolute error that the cutoff mode
+	 * introduced in the potential of any data point during the last
+	 * clustering (zero if the cutoff mode is disabled).
+	 *
+	 * The bound is the sum of the neglected contributions to the initial
+	 * potential (each one less than the tolerance) and of the neglected
+	 * revisions made by each cluster center (each one less than the
+	 * tolerance times the potential of the center).
+	 * Dividing it by the potential of the first cluster center gives the
+	 * error on the potential ratios compared to the acceptance and rejection
+	 * ratios.
+	 */
+	fl::scalar cutoffErrorBound() const;
+
 	/// Resets the internal state of the clustering algorithm
 	void reset();
 
+	/**
+	 * Sets the resolution of the summary built by streaming clustering, as a
+	 * fraction of the cluster radii.
+	 *
+	 * The normalized data space is divided into cells whose width is the
+	 * given fraction of the cluster radius in each dimension.
+	 */
+	void setSummaryResolution(fl::scalar value);
+
+	/// Returns the resolution of the summary built by streaming clustering, as a fraction of the cluster radii
+	fl::scalar getSummaryResolution() const;
+
 	/// Applies the clustering algorithm to the given dataset
 	template <typename MatrixT>
 	void cluster(const MatrixT& data);
 
+	/**
+	 * Returns the initial potential of each data point of the given dataset,
+	 * that is the potentials cluster() starts from before extracting the
+	 * first cluster center.
+	 *
+	 * Data points are normalized as by cluster() (so, the bounds that are not
+	 * given are computed from data), and the cutoff mode applies if enabled.
+	 */
+	template <typename MatrixT>
+	std::vector<fl::scalar> potentials(const MatrixT& data);
+
+	/**
+	 * Applies the clustering algorithm to the data points read from the given
+	 * chunked source, without holding the whole dataset in memory.
+	 *
+	 * The source is read in at most three passes:
+	 * -# If bounds are not given, a first pass computes them.
+	 * -# A second pass bins the normalized data points into a uniform grid
+	 *    (see setSummaryResolution) and summarizes each non-empty cell by
+	 *    the centroid of its data points, weighted by their number.
+	 *    The weighted centroids are then clustered as in the batch algorithm,
+	 *    where the potential of a point accounts for the weight of each
+	 *    neighbor.
+	 * -# If \a refine is \c true, a last pass replaces each cluster center
+	 *    with the nearest data point of the stream.
+	 * .
+	 * Memory usage only depends on the chunk size and on the number of
+	 * non-empty cells.
+	 *
+	 * Each entry of the source is a data point, made of its inputs followed
+	 * by its outputs (as in fl::DataSet::matrix); see fl/data_source.h for
+	 * the sources provided by the library (e.g., fl::TextDataSource or
+	 * fl::DataSetSource).
+	 */
+	void clusterStream(fl::DataSource<fl::scalar>& source, bool refine = false);
+
 	/// Returns the found cluster centers
 	std::vector< std::vector<fl::scalar> > centers() const;
 
@@ -245,6 +344,66 @@ public:
 	std::vector<fl::scalar> rangeOfInfluence() const;
 
 
+private:
+	/// Enlarges or shrinks the vector of radii to fit the data dimension \a nc
+	void adjustRadii(std::size_t nc);
+
+	/// Prepares the bounds that are not given to be computed from data, telling which ones through \a clearLBounds and \a clearUBounds
+	void initBounds(std::size_t nc, bool& clearLBounds, bool& clearUBounds);
+
+	/// Updates the bounds being computed with the given data points
+	template <typename MatrixT>
+	void updateBounds(const MatrixT& data, bool clearLBounds, bool clearUBounds);
+
+	/// Checks the bounds and widens the computed ones for zero-range data
+	void checkBounds(std::size_t nc, bool clearLBounds, bool clearUBounds);
+
+	/// Normalizes the data points of \a data into \a datan (dimension-major), setting their number \a nr and dimension \a nc
+	template <typename MatrixT>
+	void normalizeData(const MatrixT& data, std::vector<fl::scalar>& datan, std::size_t& nr, std::size_t& nc);
+
+	/// Normalizes \a x into a unit hyperbox, storing the j-th component at position <code>j*stride</code> of \a xn
+	template <typename VectorT>
+	void normalizePoint(const VectorT& x, fl::scalar* xn, std::size_t stride) const;
+
+	/**
+	 * Computes the potentials of the normalized data points \a datan
+	 * (\a nr points of \a nc components, stored dimension-major) and extracts
+	 * the cluster centers (in normalized coordinates).
+	 *
+	 * If not empty, \a weights gives the multiplicity of each data point.
+	 */
+	void estimateCenters(const std::vector<fl::scalar>& datan, const std::vector<fl::scalar>& weights, std::size_t nr, std::size_t nc);
+
+	/**
+	 * Estimates the cluster centers of the normalized data points \a datan
+	 * for each clustering of \a group, which must share the radii and the
+	 * cutoff tolerance.
+	 *
+	 * The initial potentials are computed once for the whole group, and the
+	 * cluster centers of each clustering are then extracted concurrently.
+	 */
+	static void estimateCentersShared(const std::vector<fl::scalar>& datan, std::size_t nr, std::size_t nc, const std::vector<SubtractiveClustering*>& group);
+
+	/// The data points scaled by the kernel width (defined in the source file)
+	struct ScaledData;
+
+	/// Scales the normalized data points \a datan by the kernel width, indexing them in cutoff mode
+	void scaleData(const std::vector<fl::scalar>& datan, const std::vector<fl::scalar>& weights, std::size_t nr, std::size_t nc, ScaledData& sd) const;
+
+	/// Computes the initial potentials of the scaled data points and returns the error introduced by the cutoff mode
+	fl::scalar computeInitialPotentials(const ScaledData& sd, const std::vector<fl::scalar>& weights, std::vector<fl::scalar>& potentials) const;
+
+	/// Computes the initial potentials of the normalized data points \a datan (\a nr points of \a nc components, stored dimension-major)
+	void estimatePotentials(const std::vector<fl::scalar>& datan, std::size_t nr, std::size_t nc, std::vector<fl::scalar>& potentials) const;
+
+	/// Extracts the cluster centers (in normalized coordinates), starting from the given (and then revised) potentials
+	void extractCenters(const std::vector<fl::scalar>& datan, const ScaledData& sd, std::vector<fl::scalar>& potentials);
+
+	/// Scales the cluster centers back to the original range and computes their range of influence
+	void finalizeCenters(std::size_t nc);
+
+
 private:
 	std::vector<fl::scalar> radii_; ///< The vector of cluster sizes in each of the data dimensions
 	fl::scalar squashFactor_; ///< Used to multiply the cluster sizes to determine the neighborhood of a cluster center within which the existence of other cluster centers are discouraged
@@ -254,283 +413,117 @@ private:
 	std::vector<fl::scalar> ubounds_; ///< Upper bounds (one for each data dimension) used to normalized data point within a unit hyperbox
 	std::vector< std::vector<fl::scalar> > centers_; ///< The found cluster centers
 	std::vector<fl::scalar> sigma_; ///< Range of influence of the cluster centers
+	fl::scalar cutoffTol_; ///< The tolerance below which contributions to potentials are neglected (zero to compute potentials exactly)
+	fl::scalar cutoffErr_; ///< Upper bound on the error introduced by the cutoff mode during the last clustering
+	fl::scalar summaryRes_; ///< The width of the cells of the streaming summary, as a fraction of the cluster radii
 }; // SubtractiveClustering
 
 
 template <typename MatrixT>
 void SubtractiveClustering::cluster(const MatrixT& data)
 {
-	const std::size_t nr = data.size(); // Number of data points
+	std::vector<fl::scalar> datan;
+	std::size_t nr = 0;
+	std::size_t nc = 0;
+	this->normalizeData(data, datan, nr, nc);
+
+	// Computes potential values and extracts cluster centers
+	this->estimateCenters(datan, std::vector<fl::scalar>(), nr, nc);
+
+	// Scale the cluster centers back to the original range
+	this->finalizeCenters(nc);
+}
+
+template <typename MatrixT>
+std::vector<fl::scalar> SubtractiveClustering::potentials(const MatrixT& data)
+{
+	std::vector<fl::scalar> datan;
+	std::size_t nr = 0;
+	std::size_t nc = 0;
+	this->normalizeData(data, datan, nr, nc);
+
+	std::vector<fl::scalar> pots;
+	this->estimatePotentials(datan, nr, nc, pots);
+
+	return pots;
+}
+
+template <typename MatrixT>
+void SubtractiveClustering::normalizeData(const MatrixT& data, std::vector<fl::scalar>& datan, std::size_t& nr, std::size_t& nc)
+{
+	nr = data.size(); // Number of data points
 	if (nr == 0)
 	{
 		FL_THROW("Data set must have at least one point");
 	}
 
-	const std::size_t nc = data[0].size(); // Number of data parameters
+	nc = data[0].size(); // Number of data parameters
 
 	// Adjust radii parameters (if needed)
-	if (radii_.size() < nc)
-	{
-		// Enlarge and set default value
-		radii_.insert(radii_.end(), nc-radii_.size(), DefaultRadius);
-	}
-	else if (radii_.size() > nc)
-	{
-		// Shrink to fit current input data dimension
-		radii_.resize(nc);
-	}
-
-	// Precomputes distance multipliers for accumulating and squashing potentials
-	std::vector<fl::scalar> squash(radii_.size());
-	std::vector<fl::scalar> accum(radii_.size());
-	for (std::size_t i = 0; i < nc; ++i)
-	{
-		accum[i] = 1.0/radii_[i];
-		squash[i] = 1.0/(squashFactor_*radii_[i]);
-	}
+	this->adjustRadii(nc);
 
 	// Normalize data
 
 	// - Checks/sets data bounds
 	bool clearLBounds = false;
 	bool clearUBounds = false;
-	if (lbounds_.size() == 0 || ubounds_.size() == 0)
-	{
-		// No bound given => Use min and max values
-		if (lbounds_.size() == 0)
-		{
-			clearLBounds = true;
-			lbounds_.resize(nc, std::numeric_limits<fl::scalar>::max());
-		}
-		if (ubounds_.size() == 0)
-		{
-			clearUBounds = true;
-			ubounds_.resize(nc, std::numeric_limits<fl::scalar>::min());
-		}
-		if (clearLBounds || clearUBounds)
-		{
-			for (std::size_t j = 0; j < nc; ++j)
-			{
-				for (std::size_t i = 0; i < nr; ++i)
-				{
-					if (clearLBounds && lbounds_[j] > data[i][j])
-					{
-						lbounds_[j] = data[i][j];
-					}
-					if (clearUBounds && ubounds_[j] < data[i][j])
-					{
-						ubounds_[j] = data[i][j];
-					}
-				}
-			}
-		}
-		// For zero-range data, compute a small artificial range
-		for (std::size_t j = 0; j < nc; ++j)
-		{
-			if (fl::detail::FloatTraits<fl::scalar>::ApproximatelyEqual(lbounds_[j], ubounds_[j]))
-			{
-				if (clearLBounds)
-				{
-					lbounds_[j] -= 0.0001*(1+std::abs(lbounds_[j]));
-				}
-				if (clearUBounds)
-				{
-					ubounds_[j] += 0.0001*(1+std::abs(ubounds_[j]));
-				}
-			}
-		}
-	}
-	else
+	this->initBounds(nc, clearLBounds, clearUBounds);
+	if (clearLBounds || clearUBounds)
 	{
-		// Check size
-		if (lbounds_.size() != nc || ubounds_.size() != nc)
-		{
-			FL_THROW("Wrong dimension for data bound vectors");
-		}
-		// Check zero-range data
-		for (std::size_t i = 0; i < nc; ++i)
-		{
-			if (fl::detail::FloatTraits<fl::scalar>::ApproximatelyEqual(lbounds_[i], ubounds_[i]))
-			{
-				FL_THROW("Found zero data-range in data bound vector");
-			}
-		}
+		this->updateBounds(data, clearLBounds, clearUBounds);
 	}
+	this->checkBounds(nc, clearLBounds, clearUBounds);
+
 	// - Does data normalization
-	std::vector< std::vector<fl::scalar> > datan(nr);
+	//   Normalized data are stored dimension-major (i.e., the j-th component
+	//   of the i-th point is at position j*nr+i) so that the potential kernels
+	//   can sweep contiguous memory.
+	datan.resize(nr*nc);
 	for (std::size_t i = 0; i < nr; ++i)
 	{
-		datan[i].resize(nc);
-		for (std::size_t j = 0; j < nc; ++j)
-		{
-			datan[i][j] = std::min(std::max((data[i][j]-lbounds_[j])/(ubounds_[j]-lbounds_[j]), 0.0), 1.0);
-		}
+		this->normalizePoint(data[i], &datan[i], nr);
 	}
+}
 
-	// Computes potential values
-
-	// - Potential values for each data point
-	std::vector<fl::scalar> potentials(nr, 0);
-
-	// - Computes the initial potential values.
-	//   Also, find the data point with the highest potential.
-	//   The highest potential will be used as a reference for
-	//   accepting/rejecting other data points as cluster centers.
-	fl::scalar maxPotential = -1; // -1 is OK since potentials cannot be negative values
-	std::size_t maxPotentialIdx = 0;
-	for (std::size_t i = 0; i < nr; ++i)
-	{
-		const std::vector<fl::scalar>& point = datan[i];
-		for (std::size_t k = 0; k < nr; ++k)
-		{
-			fl::scalar distSq = 0; // the squared distance
-			for (std::size_t j = 0; j < nc; ++j)
-			{
-				const fl::scalar dist = (point[j]-datan[k][j])*accum[j];
-				distSq += fl::detail::Sqr(dist);
-			}
-			potentials[i] += std::exp(-4.0*distSq);
-		}
-
-		// Update max potential
-		if (maxPotential < potentials[i])
-		{
-			maxPotential = potentials[i];
-			maxPotentialIdx = i;
-		}
-	}
+template <typename MatrixT>
+void SubtractiveClustering::updateBounds(const MatrixT& data, bool clearLBounds, bool clearUBounds)
+{
+	const std::size_t nc = lbounds_.size();
 
-	// Start iteratively finding cluster centers and subtracting potential
-	// from neighboring data points. 
-	bool findMore = true;
-	const fl::scalar refPotential = maxPotential;
-	centers_.clear();
-	while (findMore && maxPotential > 0)
+	for (std::size_t i = 0,
+					 nr = data.size();
+		 i < nr;
+		 ++i)
 	{
-		const fl::scalar maxPotentialRatio = maxPotential/refPotential;
-		const std::vector<fl::scalar>& maxPotentialPoint = datan[maxPotentialIdx];
-
-		bool removePoint = false;
-		findMore = false;
-		if (maxPotentialRatio > acceptRatio_)
+		if (data[i].size() != nc)
 		{
-			// The new peak value is significant -> accept
-			findMore = true;
+			FL_THROW("Data points must have the same dimension");
 		}
-		else if (maxPotentialRatio > rejectRatio_)
-		{
-			// Accept this data point only if it achieves a good balance between having a reasonable potential and being far from all existing cluster centers
-			fl::scalar minDistSq = -1;//std::numeric_limits<fl::scalar>::infinity();
-
-			for (std::size_t i = 0,
-							 ni = centers_.size();
-				 i < ni;
-				 ++i)
-			{
-				fl::scalar distSq = 0;
-				for (std::size_t j = 0; j < nc; ++j)
-				{
-					const fl::scalar dist = (maxPotentialPoint[j]-centers_[i][j])*accum[j];
-					distSq += fl::detail::Sqr(dist);
-				}
-				if (minDistSq < 0 || distSq < minDistSq)
-				{
-					minDistSq = distSq;
-				}
-			}
 
-			fl::scalar minDist = std::sqrt(minDistSq);
-			if ((maxPotentialRatio+minDist) >= 1)
-			{
-				// Tentatively accept this data point as a cluster center
-				findMore = true;
-			}
-			else
-			{
-				// Remove this data point from further consideration and continue
-				findMore = true;
-				removePoint = true;
-			}
-		}
-
-		if (findMore)
+		for (std::size_t j = 0; j < nc; ++j)
 		{
-			if (removePoint)
+			if (clearLBounds && lbounds_[j] > data[i][j])
 			{
-				potentials[maxPotentialIdx] = 0;
-				// Recompute max potential
-				maxPotential = -1; // -1 is OK since potentials cannot be negative values
-				for (std::size_t i = 0; i < nr; ++i)
-				{
-					if (maxPotential < potentials[i])
-					{
-						maxPotential = potentials[i];
-						maxPotentialIdx = i;
-					}
-				}
+				lbounds_[j] = data[i][j];
 			}
-			else
+			if (clearUBounds && ubounds_[j] < data[i][j])
 			{
-				// Adds the data point to the list of cluster centers
-				centers_.push_back(maxPotentialPoint);
-
-				//FL_DEBUG_TRACE("Found cluster #" << centers_.size() << ", potential = " << maxPotentialRatio);
-
-				// subtract potential from data points near the new cluster center
-				for (std::size_t i = 0; i < nr; ++i)
-				{
-					fl::scalar distSq = 0;
-					for (std::size_t j = 0; j < nc; ++j)
-					{
-						const fl::scalar dist = (maxPotentialPoint[j]-datan[i][j])*squash[j];
-						distSq += fl::detail::Sqr(dist);
-					}
-					potentials[i] = std::max(potentials[i]-maxPotential*std::exp(-4.0*distSq), 0.0);
-				}
-
-				// Finds the data point with the highest remaining potential
-				maxPotential = -1; // OK since potentials cannot be negative values
-				for (std::size_t i = 0; i < nr; ++i)
-				{
-					if (maxPotential < potentials[i])
-					{
-						maxPotential = potentials[i];
-						maxPotentialIdx = i;
-					}
-				}
+				ubounds_[j] = data[i][j];
 			}
 		}
 	}
+}
 
-	// Scale the cluster centers from the normalized values back to values in
-	// the original range
-	for (std::size_t i = 0,
-					 numClusters = centers_.size();
-		 i < numClusters;
-		 ++i)
-	{
-		for (std::size_t j = 0; j < nc; ++j)
-		{
-			centers_[i][j] = centers_[i][j]*(ubounds_[j]-lbounds_[j]) + lbounds_[j];
-		}
-	}
-
-	// Compute the range of influence of the cluster centers for each data
-	// dimension
-	sigma_.resize(nc);
-	for (std::size_t i = 0; i < nc; ++i)
+template <typename VectorT>
+void SubtractiveClustering::normalizePoint(const VectorT& x, fl::scalar* xn, std::size_t stride) const
+{
+	for (std::size_t j = 0,
+					 nc = lbounds_.size();
+		 j < nc;
+		 ++j)
 	{
-		sigma_[i] = (radii_[i]*(ubounds_[i]-lbounds_[i]))/std::sqrt(8.0);
+		xn[j*stride] = std::min(std::max((x[j]-lbounds_[j])/(ubounds_[j]-lbounds_[j]), 0.0), 1.0);
 	}
-
-	//if (clearLBounds)
-	//{
-	//	lbounds_.clear();
-	//}
-	//if (clearUBounds)
-	//{
-	//	ubounds_.clear();
-	//}
 }
 
 }} // Namespace fl::cluster
@@ -0,0 +1,161 @@
+/**
+ * \file fl/cluster/subtractive_sweep.h
+ *
+ * \brief Subtractive clustering over a grid of parameter settings
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_CLUSTER_SUBTRACTIVE_SWEEP_H
+#define FL_CLUSTER_SUBTRACTIVE_SWEEP_H
+
+
+#include <cstddef>
+#include <fl/cluster/subtractive.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <vector>
+
+
+namespace fl { namespace cluster {
+
+/**
+ * \brief Runs subtractive clustering for every combination of a set of
+ *  candidate parameter values.
+ *
+ * The grid of settings is the Cartesian product of the candidate radii
+ * (each one used for all data dimensions), squashing factors, acceptance
+ * ratios and rejection ratios.
+ * A parameter without candidate values takes the value of the base
+ * clustering given at construction, which also provides the bounds and the
+ * cutoff tolerance.
+ *
+ * Compared to running each setting separately, the sweep:
+ * - normalizes the data only once;
+ * - computes the initial potentials (which take \f$O(n^2)\f$ time and only
+ *   depend on the radii) once per candidate radius;
+ * - extracts the cluster centers for all the settings sharing a radius
+ *   concurrently, when the library is built with \c FLX_CONFIG_HAVE_OPENMP.
+ * .
+ * The results are the same as the ones of running SubtractiveClustering
+ * with each setting.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class FL_API SubtractiveClusteringSweep
+{
+public:
+	/// Constructs a sweep whose unspecified parameters are taken from \a base
+	explicit SubtractiveClusteringSweep(const SubtractiveClustering& base = SubtractiveClustering());
+
+	/// Sets the candidate cluster radii (each one is used for all data dimensions)
+	void setRadii(const std::vector<fl::scalar>& values);
+
+	/// Returns the candidate cluster radii
+	std::vector<fl::scalar> radii() const;
+
+	/// Sets the candidate squashing factors
+	void setSquashingFactors(const std::vector<fl::scalar>& values);
+
+	/// Returns the candidate squashing factors
+	std::vector<fl::scalar> squashingFactors() const;
+
+	/// Sets the candidate acceptance ratios
+	void setAcceptanceRatios(const std::vector<fl::scalar>& values);
+
+	/// Returns the candidate acceptance ratios
+	std::vector<fl::scalar> acceptanceRatios() const;
+
+	/// Sets the candidate rejection ratios
+	void setRejectionRatios(const std::vector<fl::scalar>& values);
+
+	/// Returns the candidate rejection ratios
+	std::vector<fl::scalar> rejectionRatios() const;
+
+	/// Returns the number of settings in the grid
+	std::size_t numOfSettings() const;
+
+	/// Applies the clustering algorithm to the given dataset with every setting of the grid
+	template <typename MatrixT>
+	void cluster(const MatrixT& data);
+
+	/**
+	 * Returns the clusterings of the last sweep, one for each setting.
+	 *
+	 * Settings are ordered by radius, then by squashing factor, then by
+	 * acceptance ratio and finally by rejection ratio.
+	 * Each clustering carries its own parameters, so it can be used
+	 * (e.g., by SubtractiveClusteringFisBuilder) as any other clustering.
+	 */
+	const std::vector<SubtractiveClustering>& results() const;
+
+
+private:
+	/// Runs the sweep over the normalized data \a datan, stored dimension-major
+	void clusterNormalized(const SubtractiveClustering& ref, const std::vector<fl::scalar>& datan, std::size_t nr, std::size_t nc);
+
+
+private:
+	SubtractiveClustering base_; ///< The clustering providing the unspecified parameters
+	std::vector<fl::scalar> radii_; ///< The candidate cluster radii
+	std::vector<fl::scalar> squashFactors_; ///< The candidate squashing factors
+	std::vector<fl::scalar> acceptRatios_; ///< The candidate acceptance ratios
+	std::vector<fl::scalar> rejectRatios_; ///< The candidate rejection ratios
+	std::vector<SubtractiveClustering> results_; ///< The clusterings of the last sweep
+}; // SubtractiveClusteringSweep
+
+
+template <typename MatrixT>
+void SubtractiveClusteringSweep::cluster(const MatrixT& data)
+{
+	const std::size_t nr = data.size(); // Number of data points
+	if (nr == 0)
+	{
+		FL_THROW("Data set must have at least one point");
+	}
+
+	const std::size_t nc = data[0].size(); // Number of data parameters
+
+	// Normalizes the data once for all the settings (bounds do not depend on
+	// the parameters being swept)
+	SubtractiveClustering ref(base_);
+	ref.adjustRadii(nc);
+
+	bool clearLBounds = false;
+	bool clearUBounds = false;
+	ref.initBounds(nc, clearLBounds, clearUBounds);
+	if (clearLBounds || clearUBounds)
+	{
+		ref.updateBounds(data, clearLBounds, clearUBounds);
+	}
+	ref.checkBounds(nc, clearLBounds, clearUBounds);
+
+	std::vector<fl::scalar> datan(nr*nc);
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		ref.normalizePoint(data[i], &datan[i], nr);
+	}
+
+	this->clusterNormalized(ref, datan, nr, nc);
+}
+
+}} // Namespace fl::cluster
+
+
+#endif // FL_CLUSTER_SUBTRACTIVE_SWEEP_H
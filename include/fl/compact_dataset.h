@@ -0,0 +1,747 @@
+/**
+ * \file fl/compact_dataset.h
+ *
+ * \brief Datasets stored with reduced precision
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_COMPACT_DATASET_H
+#define FL_COMPACT_DATASET_H
+
+
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <cmath>
+#include <cstddef>
+#include <fl/data_source.h>
+#include <fl/dataset.h>
+#include <fl/dataset_statistics.h>
+#include <fl/detail/float16.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace fl {
+
+/**
+ * A dataset whose values are stored with reduced precision.
+ *
+ * Many datasets (e.g., sensor readings) have far less resolution than a
+ * \c double, so they can be stored in 4 or 2 bytes per value, letting 2 to
+ * 4 times more entries (4 to 8 times, for \c double values) fit in memory
+ * and reducing the memory traffic of each pass over the data.
+ * Values can be stored as:
+ * - IEEE 754 single-precision values (Float32Storage);
+ * - IEEE 754 half-precision values (Float16Storage), with 11 bits of
+ *   precision and magnitudes up to 65504;
+ * - bfloat16 values (BFloat16Storage), with 8 bits of precision and the
+ *   range of single-precision values;
+ * - 16-bit integers (ScaledInt16Storage), evenly spread over a range set
+ *   for each column (by default, the range of the values of the first
+ *   dataset added), with a resolution of 1/65534 of that range; values out
+ *   of the range are clamped to it.
+ * .
+ * Missing values (NaNs) are preserved in all cases.
+ *
+ * Values are widened back to \c ValueT on access: a whole range of entries
+ * is converted at once into a fl::DataSet (see decode()), by tight loops
+ * that compilers can vectorize.
+ * Algorithms that accept a fl::DataSource can read the entries chunk by
+ * chunk through fl::CompactDataSetSource, so that a full precision copy of
+ * the dataset is never needed.
+ *
+ * While entries are added, the error introduced by storing them is
+ * tracked column by column (see maxQuantizationError(),
+ * rmsQuantizationError() and quantizationReport()).
+ *
+ * \tparam ValueT Types for values of the entries
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class CompactDataSet
+{
+public:
+    /// The types of storage of values
+    enum StorageType
+    {
+        Float32Storage, ///< IEEE 754 single-precision values
+        Float16Storage, ///< IEEE 754 half-precision values
+        BFloat16Storage, ///< bfloat16 values
+        ScaledInt16Storage ///< 16-bit integers scaled to a range for each column
+    };
+
+
+public:
+    /// Constructs an empty dataset whose entries have \a ni inputs and \a no outputs, stored as \a type values
+    explicit CompactDataSet(std::size_t ni = 0, std::size_t no = 0, StorageType type = Float32Storage);
+
+    /// Constructs a dataset with the entries (and the labels) of \a data, stored as \a type values
+    CompactDataSet(const fl::DataSet<ValueT>& data, StorageType type);
+
+    /// Returns the type of storage of values
+    StorageType storageType() const;
+
+    /**
+     * Sets the range of the values of each column, to which 16-bit integers
+     * are scaled (with ScaledInt16Storage only).
+     *
+     * Columns are the inputs followed by the outputs.
+     * The range can only be set before adding entries.
+     */
+    void setRanges(const std::vector<ValueT>& lbounds, const std::vector<ValueT>& ubounds);
+
+    /// Encodes and adds the entry \a entry
+    void add(const fl::DataSetEntry<ValueT>& entry);
+
+    /// Encodes and adds the entries of \a data
+    void add(const fl::DataSet<ValueT>& data);
+
+    /**
+     * Encodes and adds all the entries of \a source.
+     *
+     * With ScaledInt16Storage, if ranges have not been set, the source is
+     * read twice: first to find the range of each column, then to add the
+     * entries.
+     */
+    void add(fl::DataSource<ValueT>& source);
+
+    std::size_t numOfInputs() const;
+
+    std::size_t numOfOutputs() const;
+
+    /// Returns the number of entries
+    std::size_t size() const;
+
+    /// Tells if there is no entry
+    bool empty() const;
+
+    /// Returns the number of bytes taken by the stored values
+    std::size_t numOfBytes() const;
+
+    /// Returns (a copy of) the \a idx-th entry, widened to \c ValueT
+    fl::DataSetEntry<ValueT> get(std::size_t idx) const;
+
+    /**
+     * Replaces the entries of \a data with the entries in the range
+     * [\a first, \a last), widened to \c ValueT.
+     *
+     * The storage of \a data is reused when possible, so that decoding
+     * consecutive ranges into the same dataset does not allocate memory.
+     */
+    void decode(std::size_t first, std::size_t last, fl::DataSet<ValueT>& data) const;
+
+    /// Returns all the entries, widened to \c ValueT
+    fl::DataSet<ValueT> dataSet() const;
+
+    template <typename IterT>
+    void setLabels(IterT first, IterT last);
+
+    std::vector<std::string> labels() const;
+
+    /// Returns the largest absolute error of the stored values of the \a j-th column
+    ValueT maxQuantizationError(std::size_t j) const;
+
+    /// Returns the root mean square error of the stored values of the \a j-th column
+    ValueT rmsQuantizationError(std::size_t j) const;
+
+    /// Returns a table with the quantization errors of each column
+    std::string quantizationReport() const;
+
+    /// Removes all the entries (but keeps the ranges)
+    void clear();
+
+
+private:
+    /// Encodes and adds the entry made of the inputs at \a in and of the outputs at \a out
+    void add(const ValueT* in, const ValueT* out);
+
+    /// Encodes and adds the value \a x of the \a j-th column
+    void add(std::size_t j, ValueT x);
+
+    /// Widens the values of the entries in the range [\a first, \a last) to \a out
+    void decode(std::size_t first, std::size_t last, ValueT* out) const;
+
+    /// Sets the ranges of columns to the ones of \a stats, if not set yet
+    void initRanges(const fl::DataSetStatistics<ValueT>& stats);
+
+    /// Makes sure the \a j-th column exists
+    void checkColumn(std::size_t j) const;
+
+
+private:
+    static const std::size_t BlockSize = 16384; ///< The number of entries widened by a thread at a time
+
+
+    StorageType type_; ///< The type of storage of values
+    std::size_t ni_; ///< Number of inputs in each entry
+    std::size_t no_; ///< Number of outputs in each entry
+    std::size_t n_; ///< Number of entries
+    std::vector<float> floats_; ///< The values of all entries, with Float32Storage
+    std::vector<boost::uint16_t> words_; ///< The values of all entries, with 16-bit storages
+    std::vector<ValueT> offsets_; ///< The middle of the range of each column, with ScaledInt16Storage
+    std::vector<ValueT> scales_; ///< The value of a unit step of each column, with ScaledInt16Storage
+    std::vector<std::size_t> errCounts_; ///< The number of (non missing) values of each column
+    std::vector<ValueT> errMaxs_; ///< The largest absolute error of each column
+    std::vector<ValueT> errSums_; ///< The sum of squared errors of each column
+    std::vector<std::string> labels_; ///< Labels of the columns
+}; // CompactDataSet
+
+
+/**
+ * A data source reading the entries of a compact dataset.
+ *
+ * Each chunk holds consecutive entries widened to \c ValueT (see
+ * fl::CompactDataSet::decode), in storage reused from chunk to chunk.
+ * When the source is consumed by fl::VisitChunks, values are widened by
+ * another thread while the previous chunk is processed.
+ * The dataset is not copied and must outlive the source.
+ *
+ * \tparam ValueT Types for values stored in the entries
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class CompactDataSetSource: public DataSource<ValueT>
+{
+public:
+    /// Constructs a source reading \a chunkSize entries of \a data at a time
+    explicit CompactDataSetSource(const CompactDataSet<ValueT>& data, std::size_t chunkSize = 65536);
+
+
+private:
+    void doRewind();
+
+    bool doRead(fl::DataSet<ValueT>& chunk);
+
+
+private:
+    const CompactDataSet<ValueT>& data_; ///< The dataset
+    std::size_t chunkSize_; ///< The maximum number of entries in a chunk
+    std::size_t pos_; ///< The position of the next entry to read
+}; // CompactDataSetSource
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+template <typename ValueT>
+CompactDataSet<ValueT>::CompactDataSet(std::size_t ni, std::size_t no, StorageType type)
+: type_(type),
+  ni_(ni),
+  no_(no),
+  n_(0),
+  errCounts_(ni+no, 0),
+  errMaxs_(ni+no, 0),
+  errSums_(ni+no, 0)
+{
+}
+
+template <typename ValueT>
+CompactDataSet<ValueT>::CompactDataSet(const fl::DataSet<ValueT>& data, StorageType type)
+: type_(type),
+  ni_(data.numOfInputs()),
+  no_(data.numOfOutputs()),
+  n_(0),
+  errCounts_(ni_+no_, 0),
+  errMaxs_(ni_+no_, 0),
+  errSums_(ni_+no_, 0),
+  labels_(data.labels())
+{
+    this->add(data);
+}
+
+template <typename ValueT>
+typename CompactDataSet<ValueT>::StorageType CompactDataSet<ValueT>::storageType() const
+{
+    return type_;
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::setRanges(const std::vector<ValueT>& lbounds, const std::vector<ValueT>& ubounds)
+{
+    const std::size_t nc = ni_+no_;
+
+    if (lbounds.size() != nc || ubounds.size() != nc)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of bounds");
+    }
+    if (n_ > 0)
+    {
+        FL_THROW2(std::logic_error, "Ranges cannot change once entries have been added");
+    }
+
+    offsets_.resize(nc);
+    scales_.resize(nc);
+    for (std::size_t j = 0; j < nc; ++j)
+    {
+        const ValueT lb = lbounds[j];
+        const ValueT ub = ubounds[j];
+
+        if (lb > ub)
+        {
+            FL_THROW2(std::invalid_argument, "Lower bound cannot be greater than the upper bound");
+        }
+
+        // Codes from -32767 to 32767 span the range (-32768 is left for NaN)
+        offsets_[j] = (lb == lb && ub == ub) ? lb+(ub-lb)/2 : 0;
+        scales_[j] = (ub-lb)/65534;
+        if (!(scales_[j] > 0) || scales_[j] > std::numeric_limits<ValueT>::max())
+        {
+            scales_[j] = 1;
+        }
+    }
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::add(const fl::DataSetEntry<ValueT>& entry)
+{
+    if (entry.numOfInputs() != ni_ || entry.numOfOutputs() != no_)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of inputs or outputs");
+    }
+
+    if (type_ == ScaledInt16Storage && offsets_.empty())
+    {
+        fl::DataSet<ValueT> data(ni_, no_);
+        data.add(entry);
+        std::vector<ValueT> lower;
+        std::vector<ValueT> upper;
+        fl::ColumnBounds(data, lower, upper);
+        this->setRanges(lower, upper);
+    }
+
+    this->add(entry.inputBegin(), entry.outputBegin());
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::add(const fl::DataSet<ValueT>& data)
+{
+    if (data.numOfInputs() != ni_ || data.numOfOutputs() != no_)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of inputs or outputs");
+    }
+
+    if (type_ == ScaledInt16Storage && offsets_.empty())
+    {
+        // The bounds are not cached with the dataset, which is left untouched
+        std::vector<ValueT> lower;
+        std::vector<ValueT> upper;
+        fl::ColumnBounds(data, lower, upper);
+        this->setRanges(lower, upper);
+    }
+
+    const std::size_t n = data.size();
+    if (type_ == Float32Storage)
+    {
+        floats_.reserve(floats_.size()+n*(ni_+no_));
+    }
+    else
+    {
+        words_.reserve(words_.size()+n*(ni_+no_));
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        this->add(data.inputs(i), data.outputs(i));
+    }
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::add(fl::DataSource<ValueT>& source)
+{
+    if (type_ == ScaledInt16Storage && offsets_.empty())
+    {
+        fl::DataSetStatistics<ValueT> stats(ni_+no_);
+        stats.update(source);
+        this->initRanges(stats);
+    }
+
+    fl::DataSet<ValueT> chunk(ni_, no_);
+    source.rewind();
+    while (source.read(chunk))
+    {
+        this->add(chunk);
+    }
+}
+
+template <typename ValueT>
+std::size_t CompactDataSet<ValueT>::numOfInputs() const
+{
+    return ni_;
+}
+
+template <typename ValueT>
+std::size_t CompactDataSet<ValueT>::numOfOutputs() const
+{
+    return no_;
+}
+
+template <typename ValueT>
+std::size_t CompactDataSet<ValueT>::size() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+bool CompactDataSet<ValueT>::empty() const
+{
+    return n_ == 0;
+}
+
+template <typename ValueT>
+std::size_t CompactDataSet<ValueT>::numOfBytes() const
+{
+    return floats_.size()*sizeof(float)+words_.size()*sizeof(boost::uint16_t);
+}
+
+template <typename ValueT>
+fl::DataSetEntry<ValueT> CompactDataSet<ValueT>::get(std::size_t idx) const
+{
+    if (idx >= n_)
+    {
+        FL_THROW2(std::invalid_argument, "Entry index is out-of-range");
+    }
+
+    std::vector<ValueT> values(ni_+no_);
+    if (!values.empty())
+    {
+        this->decode(idx, idx+1, &values[0]);
+    }
+
+    return fl::DataSetEntry<ValueT>(values.begin(), values.begin()+ni_, values.begin()+ni_, values.end());
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::decode(std::size_t first, std::size_t last, fl::DataSet<ValueT>& data) const
+{
+    if (first > last || last > n_)
+    {
+        FL_THROW2(std::invalid_argument, "Entry range is out-of-range");
+    }
+
+    if (data.isView() || data.numOfInputs() != ni_ || data.numOfOutputs() != no_)
+    {
+        // Resizing a view would copy its entries first
+        data = fl::DataSet<ValueT>(ni_, no_);
+    }
+    data.resize(last-first);
+    data.setLabels(labels_.begin(), labels_.end());
+
+    if (last > first && ni_+no_ > 0)
+    {
+        this->decode(first, last, data.rawData());
+    }
+}
+
+template <typename ValueT>
+fl::DataSet<ValueT> CompactDataSet<ValueT>::dataSet() const
+{
+    fl::DataSet<ValueT> data(ni_, no_);
+    data.resize(n_);
+    data.setLabels(labels_.begin(), labels_.end());
+
+    if (n_ > 0 && ni_+no_ > 0)
+    {
+        const std::size_t nc = ni_+no_;
+        const std::size_t nb = (n_+BlockSize-1)/BlockSize;
+        ValueT* out = data.rawData();
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+        for (long b = 0; b < static_cast<long>(nb); ++b)
+        {
+            const std::size_t first = b*BlockSize;
+            const std::size_t last = std::min(first+BlockSize, n_);
+
+            this->decode(first, last, out+first*nc);
+        }
+    }
+
+    return data;
+}
+
+template <typename ValueT>
+template <typename IterT>
+void CompactDataSet<ValueT>::setLabels(IterT first, IterT last)
+{
+    labels_.assign(first, last);
+}
+
+template <typename ValueT>
+std::vector<std::string> CompactDataSet<ValueT>::labels() const
+{
+    return labels_;
+}
+
+template <typename ValueT>
+ValueT CompactDataSet<ValueT>::maxQuantizationError(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return errMaxs_[j];
+}
+
+template <typename ValueT>
+ValueT CompactDataSet<ValueT>::rmsQuantizationError(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return errCounts_[j] > 0 ? std::sqrt(errSums_[j]/errCounts_[j]) : 0;
+}
+
+template <typename ValueT>
+std::string CompactDataSet<ValueT>::quantizationReport() const
+{
+    std::ostringstream oss;
+
+    oss << std::left << std::setw(16) << "Column"
+        << std::right << std::setw(14) << "Max error"
+        << std::setw(14) << "RMS error" << std::endl;
+    for (std::size_t j = 0,
+                     nc = ni_+no_;
+         j < nc;
+         ++j)
+    {
+        std::string name;
+        if (j < labels_.size() && !labels_[j].empty())
+        {
+            name = labels_[j];
+        }
+        else
+        {
+            std::ostringstream ossName;
+            ossName << (j < ni_ ? "in" : "out") << (j < ni_ ? j : j-ni_);
+            name = ossName.str();
+        }
+
+        oss << std::left << std::setw(16) << name
+            << std::right << std::setw(14) << std::setprecision(6) << this->maxQuantizationError(j)
+            << std::setw(14) << std::setprecision(6) << this->rmsQuantizationError(j) << std::endl;
+    }
+
+    return oss.str();
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::clear()
+{
+    n_ = 0;
+    floats_.clear();
+    words_.clear();
+    errCounts_.assign(ni_+no_, 0);
+    errMaxs_.assign(ni_+no_, 0);
+    errSums_.assign(ni_+no_, 0);
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::add(const ValueT* in, const ValueT* out)
+{
+    for (std::size_t j = 0; j < ni_; ++j)
+    {
+        this->add(j, in[j]);
+    }
+    for (std::size_t j = 0; j < no_; ++j)
+    {
+        this->add(ni_+j, out[j]);
+    }
+    ++n_;
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::add(std::size_t j, ValueT x)
+{
+    ValueT y = 0;
+
+    switch (type_)
+    {
+        case Float32Storage:
+            floats_.push_back(static_cast<float>(x));
+            y = floats_.back();
+            break;
+        case Float16Storage:
+            words_.push_back(fl::detail::FloatToHalf(static_cast<float>(x)));
+            y = fl::detail::HalfToFloat(words_.back());
+            break;
+        case BFloat16Storage:
+            words_.push_back(fl::detail::FloatToBFloat16(static_cast<float>(x)));
+            y = fl::detail::BFloat16ToFloat(words_.back());
+            break;
+        case ScaledInt16Storage:
+            {
+                // Codes are stored with an offset of 32768, so that 0 stands for NaN
+                boost::uint16_t w = 0;
+                if (x == x)
+                {
+                    const ValueT c = std::floor((x-offsets_[j])/scales_[j]+ValueT(0.5));
+                    w = static_cast<boost::uint16_t>(std::min(std::max(c, ValueT(-32767)), ValueT(32767))+32768);
+                }
+                words_.push_back(w);
+                y = w == 0 ? std::numeric_limits<ValueT>::quiet_NaN() : offsets_[j]+scales_[j]*(static_cast<int>(w)-32768);
+            }
+            break;
+    }
+
+    if (x == x)
+    {
+        const ValueT err = y == x ? ValueT(0) : std::abs(y-x);
+
+        ++errCounts_[j];
+        errMaxs_[j] = std::max(errMaxs_[j], err);
+        errSums_[j] += err*err;
+    }
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::decode(std::size_t first, std::size_t last, ValueT* out) const
+{
+    const std::size_t nc = ni_+no_;
+    const std::size_t nv = (last-first)*nc;
+
+    switch (type_)
+    {
+        case Float32Storage:
+            {
+                const float* in = &floats_[first*nc];
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+                for (std::size_t k = 0; k < nv; ++k)
+                {
+                    out[k] = in[k];
+                }
+            }
+            break;
+        case Float16Storage:
+            {
+                const boost::uint16_t* in = &words_[first*nc];
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+                for (std::size_t k = 0; k < nv; ++k)
+                {
+                    out[k] = fl::detail::HalfToFloat(in[k]);
+                }
+            }
+            break;
+        case BFloat16Storage:
+            {
+                const boost::uint16_t* in = &words_[first*nc];
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+                for (std::size_t k = 0; k < nv; ++k)
+                {
+                    out[k] = fl::detail::BFloat16ToFloat(in[k]);
+                }
+            }
+            break;
+        case ScaledInt16Storage:
+            {
+                const boost::uint16_t* in = &words_[first*nc];
+                const ValueT* offsets = &offsets_[0];
+                const ValueT* scales = &scales_[0];
+                for (std::size_t i = 0; i < nv; i += nc)
+                {
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+                    for (std::size_t j = 0; j < nc; ++j)
+                    {
+                        out[i+j] = offsets[j]+scales[j]*(static_cast<int>(in[i+j])-32768);
+                    }
+                }
+
+                // Missing values are rare: they are restored afterwards,
+                // so that the loop above has no branch
+                for (std::size_t k = 0; k < nv; ++k)
+                {
+                    if (in[k] == 0)
+                    {
+                        out[k] = std::numeric_limits<ValueT>::quiet_NaN();
+                    }
+                }
+            }
+            break;
+    }
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::initRanges(const fl::DataSetStatistics<ValueT>& stats)
+{
+    this->setRanges(stats.lowerBounds(), stats.upperBounds());
+}
+
+template <typename ValueT>
+void CompactDataSet<ValueT>::checkColumn(std::size_t j) const
+{
+    if (j >= ni_+no_)
+    {
+        FL_THROW2(std::invalid_argument, "Column index is out-of-range");
+    }
+}
+
+
+template <typename ValueT>
+CompactDataSetSource<ValueT>::CompactDataSetSource(const CompactDataSet<ValueT>& data, std::size_t chunkSize)
+: data_(data),
+  chunkSize_(chunkSize > 0 ? chunkSize : 1),
+  pos_(0)
+{
+}
+
+template <typename ValueT>
+void CompactDataSetSource<ValueT>::doRewind()
+{
+    pos_ = 0;
+}
+
+template <typename ValueT>
+bool CompactDataSetSource<ValueT>::doRead(fl::DataSet<ValueT>& chunk)
+{
+    const std::size_t n = data_.size();
+
+    if (pos_ >= n)
+    {
+        chunk.clear();
+        return false;
+    }
+
+    const std::size_t last = std::min(pos_+chunkSize_, n);
+
+    data_.decode(pos_, last, chunk);
+    pos_ = last;
+
+    return true;
+}
+
+} // Namespace fl
+
+#endif // FL_COMPACT_DATASET_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
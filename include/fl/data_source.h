@@ -0,0 +1,474 @@
+/**
+ * \file fl/data_source.h
+ *
+ * \brief Sources of data read in chunks, for datasets that do not fit in
+ *  memory
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DATA_SOURCE_H
+#define FL_DATA_SOURCE_H
+
+
+#include <algorithm>
+#include <boost/exception_ptr.hpp>
+#include <cstddef>
+#include <cstring>
+#include <fl/dataset.h>
+#include <fl/dataset_reader.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace fl {
+
+/**
+ * A source of dataset entries, read in chunks.
+ *
+ * A data source gives access to a (possibly huge) sequence of entries
+ * without holding it in memory: entries are read one chunk at a time, each
+ * chunk being a fl::DataSet, and the source can be rewound to read the
+ * entries again (e.g., at each training epoch).
+ * Entries may come from a file (see fl::TextDataSource), from a dataset
+ * already in memory or memory-mapped (see fl::DataSetSource) or from any
+ * other producer (e.g., a generator of synthetic entries), by overriding
+ * doRewind() and doRead().
+ *
+ * Sources are usually consumed by means of fl::VisitChunks, which reads the
+ * next chunk while the current one is processed.
+ *
+ * \tparam ValueT Types for values stored in the entries
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class DataSource
+{
+public:
+    /// The class destructor
+    virtual ~DataSource();
+
+    /// Restarts the source from the first entry
+    void rewind();
+
+    /**
+     * Replaces the entries of \a chunk with the next entries of the source,
+     * returning \c false if there are no more entries.
+     *
+     * The storage of \a chunk can be reused by the source, so that reading
+     * all the entries takes memory for a single chunk.
+     */
+    bool read(fl::DataSet<ValueT>& chunk);
+
+
+private:
+    /// Restarts the source from the first entry
+    virtual void doRewind() = 0;
+
+    /// Replaces the entries of \a chunk with the next entries of the source, returning \c false if there are no more entries
+    virtual bool doRead(fl::DataSet<ValueT>& chunk) = 0;
+}; // DataSource
+
+
+/**
+ * A data source reading the entries of a dataset.
+ *
+ * Chunks are views of consecutive entries of the dataset (see
+ * fl::DataSet::slice), so no entry is copied.
+ * The dataset is not copied either and must outlive the source.
+ *
+ * Combined with fl::BinaryDataSetReader, this source reads a memory-mapped
+ * dataset file: only the pages holding the entries being used need to be in
+ * memory, and they are loaded when a chunk is read (i.e., in the background,
+ * when the source is consumed by fl::VisitChunks).
+ *
+ * \tparam ValueT Types for values stored in the entries
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class DataSetSource: public DataSource<ValueT>
+{
+public:
+    /// Constructs a source reading \a chunkSize entries of \a data at a time
+    explicit DataSetSource(const fl::DataSet<ValueT>& data, std::size_t chunkSize = 65536);
+
+
+private:
+    void doRewind();
+
+    bool doRead(fl::DataSet<ValueT>& chunk);
+
+
+private:
+    const fl::DataSet<ValueT>& data_; ///< The dataset
+    std::size_t chunkSize_; ///< The maximum number of entries in a chunk
+    std::size_t pos_; ///< The position of the next entry to read
+}; // DataSetSource
+
+
+/**
+ * A data source reading the entries of a text file.
+ *
+ * The file is read in blocks of (about) a given number of bytes, made of
+ * whole lines, and each block is parsed by a fl::DataSetReader into a chunk;
+ * so a file of any size is read with memory for a single block.
+ * The labels found in the header of the file (if any) are given to every
+ * chunk.
+ *
+ * \tparam ValueT Types for values stored in the entries
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class TextDataSource: public DataSource<ValueT>
+{
+public:
+    /**
+     * Constructs a source reading the file \a fname in blocks of
+     * \a chunkSize bytes, each one parsed by \a reader.
+     */
+    explicit TextDataSource(const std::string& fname,
+                            const fl::DataSetReader& reader = fl::DataSetReader(),
+                            std::size_t chunkSize = 16*1024*1024);
+
+
+private:
+    void doRewind();
+
+    bool doRead(fl::DataSet<ValueT>& chunk);
+
+
+private:
+    std::string fname_; ///< The name of the file
+    fl::DataSetReader reader_; ///< The reader of the first block
+    fl::DataSetReader bodyReader_; ///< The reader of the other blocks (no header)
+    std::size_t chunkSize_; ///< The number of bytes read at a time
+    std::ifstream ifs_; ///< The file stream
+    std::vector<char> buf_; ///< The block being parsed
+    std::size_t carry_; ///< The number of bytes (of an incomplete line) carried over from the previous block
+    std::size_t offset_; ///< The position in the file of the first byte of the buffer
+    std::vector<std::string> labels_; ///< The labels read from the header
+}; // TextDataSource
+
+
+/**
+ * Calls \a fun on all the entries of \a source, one chunk at a time, from
+ * the first entry.
+ *
+ * Chunks are double-buffered: when the library is built with
+ * \c FLX_CONFIG_HAVE_OPENMP, the next chunk is read by another thread while
+ * \a fun processes the current one, so that reading is overlapped with
+ * processing.
+ * Memory is needed only for the two chunks.
+ *
+ * An exception raised while reading or processing chunks stops the visit and
+ * is rethrown as is (if both the reading and the processing fail, the
+ * exception of the processing is rethrown).
+ * Without C++11, exceptions are carried by \c boost::exception_ptr, which
+ * keeps the type of standard exceptions and of those thrown by
+ * \c boost::throw_exception, and reports other ones as
+ * \c boost::unknown_exception.
+ *
+ * \param source The data source
+ * \param fun A function object that is called as <code>fun(chunk)</code>
+ *  for each chunk, where \c chunk is a <code>const fl::DataSet<ValueT>&</code>
+ * \return The number of visited entries
+ */
+template <typename ValueT, typename FunctorT>
+std::size_t VisitChunks(DataSource<ValueT>& source, FunctorT& fun);
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+//////////////
+// DataSource
+//////////////
+
+
+template <typename ValueT>
+DataSource<ValueT>::~DataSource()
+{
+    // empty
+}
+
+template <typename ValueT>
+void DataSource<ValueT>::rewind()
+{
+    this->doRewind();
+}
+
+template <typename ValueT>
+bool DataSource<ValueT>::read(fl::DataSet<ValueT>& chunk)
+{
+    return this->doRead(chunk);
+}
+
+
+/////////////////
+// DataSetSource
+/////////////////
+
+
+template <typename ValueT>
+DataSetSource<ValueT>::DataSetSource(const fl::DataSet<ValueT>& data, std::size_t chunkSize)
+: data_(data),
+  chunkSize_(chunkSize > 0 ? chunkSize : 1),
+  pos_(0)
+{
+}
+
+template <typename ValueT>
+void DataSetSource<ValueT>::doRewind()
+{
+    pos_ = 0;
+}
+
+template <typename ValueT>
+bool DataSetSource<ValueT>::doRead(fl::DataSet<ValueT>& chunk)
+{
+    const std::size_t n = data_.size();
+
+    if (pos_ >= n)
+    {
+        chunk.clear();
+        return false;
+    }
+
+    const std::size_t last = std::min(pos_+chunkSize_, n);
+
+    chunk = data_.slice(pos_, last);
+    pos_ = last;
+
+    // Touches the values of the chunk (about one per page), so that the
+    // pages of a memory-mapped dataset are loaded now rather than when the
+    // chunk is processed (through a const reference, since the chunk is a
+    // read-only view)
+    const fl::DataSet<ValueT>& view = chunk;
+    const std::size_t entryBytes = sizeof(ValueT)*std::max(chunk.stride(), static_cast<std::size_t>(1));
+    const std::size_t step = std::max(static_cast<std::size_t>(4096)/entryBytes, static_cast<std::size_t>(1));
+    ValueT sum = 0;
+    for (std::size_t i = 0,
+                     nc = chunk.size();
+         i < nc;
+         i += step)
+    {
+        sum += *view.inputs(i);
+    }
+    volatile ValueT sink = sum;
+    FL_SUPPRESS_UNUSED_VARIABLE_WARNING(sink);
+
+    return true;
+}
+
+
+//////////////////
+// TextDataSource
+//////////////////
+
+
+template <typename ValueT>
+TextDataSource<ValueT>::TextDataSource(const std::string& fname,
+                                       const fl::DataSetReader& reader,
+                                       std::size_t chunkSize)
+: fname_(fname),
+  reader_(reader),
+  bodyReader_(reader),
+  chunkSize_(chunkSize > 0 ? chunkSize : 1),
+  ifs_(fname.c_str(), std::ios::in | std::ios::binary),
+  carry_(0),
+  offset_(0)
+{
+    if (!ifs_)
+    {
+        FL_THROW2(std::runtime_error, "Unable to open the file '" + fname + "'");
+    }
+
+    bodyReader_.setHeader(false);
+}
+
+template <typename ValueT>
+void TextDataSource<ValueT>::doRewind()
+{
+    ifs_.clear();
+    ifs_.seekg(0, std::ios::beg);
+    carry_ = 0;
+    offset_ = 0;
+}
+
+template <typename ValueT>
+bool TextDataSource<ValueT>::doRead(fl::DataSet<ValueT>& chunk)
+{
+    chunk.clear();
+
+    while (chunk.empty())
+    {
+        // Fills the buffer after the incomplete line carried over
+        buf_.resize(carry_+chunkSize_);
+        ifs_.read(&buf_[0]+carry_, chunkSize_);
+        const std::size_t numRead = static_cast<std::size_t>(ifs_.gcount());
+        const std::size_t len = carry_+numRead;
+        const bool eof = numRead < chunkSize_;
+
+        if (len == 0)
+        {
+            return false;
+        }
+
+        // Parses whole lines only (unless the file ends)
+        const char* first = &buf_[0];
+        const char* last = first+len;
+        const char* cut = last;
+        if (!eof)
+        {
+            const char* p = last;
+            while (p != first && p[-1] != '\n')
+            {
+                --p;
+            }
+            if (p == first)
+            {
+                // A line longer than the block: read more
+                carry_ = len;
+                continue;
+            }
+            cut = p;
+        }
+
+        try
+        {
+            if (offset_ == 0)
+            {
+                reader_.read(first, cut, chunk);
+                labels_ = reader_.hasHeader() ? chunk.labels() : std::vector<std::string>();
+            }
+            else
+            {
+                bodyReader_.read(first, cut, chunk);
+                if (!labels_.empty())
+                {
+                    chunk.setLabels(labels_.begin(), labels_.end());
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::ostringstream oss;
+            oss << "File '" << fname_ << "', block at byte " << offset_ << ": " << e.what();
+            FL_THROW2(std::runtime_error, oss.str());
+        }
+
+        // Moves the incomplete line to the beginning of the buffer
+        carry_ = last-cut;
+        offset_ += cut-first;
+        if (carry_ > 0)
+        {
+            std::memmove(&buf_[0], cut, carry_);
+        }
+    }
+
+    return true;
+}
+
+
+////////////////
+// VisitChunks
+////////////////
+
+
+template <typename ValueT, typename FunctorT>
+std::size_t VisitChunks(DataSource<ValueT>& source, FunctorT& fun)
+{
+    source.rewind();
+
+    fl::DataSet<ValueT> chunks[2];
+    std::size_t cur = 0;
+    bool more = source.read(chunks[cur]);
+    std::size_t n = 0;
+    // No exception can leave a parallel region, so they are rethrown outside
+    boost::exception_ptr p_readErr;
+    boost::exception_ptr p_funErr;
+
+    while (more && !p_readErr && !p_funErr)
+    {
+        const std::size_t next = 1-cur;
+
+        // Reads the next chunk while processing the current one
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel sections num_threads(2)
+#endif // FLX_CONFIG_HAVE_OPENMP
+        {
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp section
+#endif // FLX_CONFIG_HAVE_OPENMP
+            {
+                try
+                {
+                    more = source.read(chunks[next]);
+                }
+                catch (...)
+                {
+                    p_readErr = boost::current_exception();
+                }
+            }
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp section
+#endif // FLX_CONFIG_HAVE_OPENMP
+            {
+                try
+                {
+                    fun(static_cast<const fl::DataSet<ValueT>&>(chunks[cur]));
+                }
+                catch (...)
+                {
+                    p_funErr = boost::current_exception();
+                }
+            }
+        }
+
+        n += chunks[cur].size();
+        cur = next;
+    }
+
+    if (p_funErr)
+    {
+        boost::rethrow_exception(p_funErr);
+    }
+    if (p_readErr)
+    {
+        boost::rethrow_exception(p_readErr);
+    }
+
+    return n;
+}
+
+} // Namespace fl
+
+#endif // FL_DATA_SOURCE_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -26,20 +26,42 @@
 #define FL_DATASET_H
 
 
+#include <algorithm>
+#include <boost/iterator/iterator_adaptor.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/iterator/reverse_iterator.hpp>
+#include <boost/shared_ptr.hpp>
+#include <cmath>
 #include <cstddef>
+#include <fl/detail/array_view.h>
+#include <fl/detail/matrix_view.h>
+#include <fl/detail/random.h>
 #include <fl/macro.h>
 #include <fl/fuzzylite.h>
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 
 namespace fl {
 
+template <typename ValueT>
+class DataSetStatistics;
+
+
 /**
  * Single entry of a dataset
  *
+ * An entry either owns its values or is a view of the values of an entry
+ * stored in a fl::DataSet (see DataSetEntry(ValueT*,std::size_t,std::size_t)).
+ * In both cases, inputs are contiguous in memory, and so are outputs, so that
+ * input and output iterators are plain pointers (the outputs of a view do not
+ * necessarily follow its inputs, though).
+ * Copying a view gives another view of the same values; to get an entry that
+ * owns a copy of the values, use the iterator constructor.
+ *
  * \tparam ValueT Types for values stored in the dataset entry
  *
  * \author Marco Guazzone (marco.guazzone@gmail.com)
@@ -48,10 +70,10 @@ template <typename ValueT = fl::scalar>
 class DataSetEntry
 {
 private:
-    typedef std::vector<ValueT> Container;
+    typedef fl::detail::ArrayView<ValueT> Container;
 
-    FL_MAKE_ITERATORS(public, Container, Input, input, in_) 
-    FL_MAKE_ITERATORS(public, Container, Output, output, out_) 
+    FL_MAKE_ITERATORS(public, Container, Input, input, in_)
+    FL_MAKE_ITERATORS(public, Container, Output, output, out_)
 
 
 public:
@@ -61,9 +83,35 @@ public:
     DataSetEntry(InIterT inFirst, InIterT inLast,
                  OutIterT outFirst, OutIterT outLast);
 
+    /**
+     * Constructs a view of the entry made of the \a ni inputs stored at
+     * \a p, followed by \a no outputs.
+     *
+     * Values are not copied, so changes made through the entry are visible
+     * in the underlying storage and vice versa.
+     */
+    DataSetEntry(ValueT* p, std::size_t ni, std::size_t no);
+
+    /// Constructs a view of the entry made of the \a ni inputs stored at \a pIn and of the \a no outputs stored at \a pOut
+    DataSetEntry(ValueT* pIn, std::size_t ni, ValueT* pOut, std::size_t no);
+
+    DataSetEntry(const DataSetEntry& other);
+
+    DataSetEntry& operator=(const DataSetEntry& rhs);
+
+    /**
+     * Sets the inputs of this entry.
+     *
+     * If this entry is a view, the number of inputs cannot change.
+     */
     template <typename IterT>
     void setInputs(IterT first, IterT last);
 
+    /**
+     * Sets the outputs of this entry.
+     *
+     * If this entry is a view, the number of outputs cannot change.
+     */
     template <typename IterT>
     void setOutputs(IterT first, IterT last);
 
@@ -77,42 +125,361 @@ public:
 
     ValueT getOutput(std::size_t index) const;
 
+    /// Tells if this entry refers to values stored elsewhere rather than owning them
+    bool isView() const;
+
     //void resize(std::size_t ni, std::size_t no);
 
 private:
-    Container in_;
-    Container out_;
+    /// Makes the input and output views point to the owned buffer
+    void attach(std::size_t ni, std::size_t no);
+
+
+private:
+    std::vector<ValueT> buf_; ///< The owned values (inputs followed by outputs); empty for views
+    Container in_; ///< The inputs
+    Container out_; ///< The outputs
+    bool view_; ///< \c true if the entry does not own its values
 }; // DataSetEntry
 
 
-template <typename ValueT = fl::scalar>
-class DataSet
+namespace detail {
+
+/**
+ * Random-access iterator over the entries of a fl::DataSet.
+ *
+ * Dereferencing the iterator gives a view (see fl::DataSetEntry) of the
+ * entry stored at the current position.
+ *
+ * \tparam ValueT Types for values stored in the dataset
+ * \tparam EntryT The entry type (possibly \c const qualified)
+ */
+template <typename ValueT, typename EntryT>
+class DataSetEntryIterator: public boost::iterator_facade<DataSetEntryIterator<ValueT,EntryT>,
+                                                          EntryT,
+                                                          boost::random_access_traversal_tag,
+                                                          EntryT>
 {
+public:
+    DataSetEntryIterator()
+    : p_(0),
+      ni_(0),
+      no_(0),
+      outOff_(0),
+      stride_(0),
+      pos_(0),
+      idx_(0)
+    {
+    }
+
+    /**
+     * Constructs an iterator pointing to the \a idx-th entry of the dataset
+     * whose entries are stored at \a p, \a stride values apart, and whose
+     * \a i-th entry is the <code>pos[i]</code>-th stored entry (or the
+     * \a i-th one, if \a pos is null).
+     * The outputs of each entry are stored \a outOff values after its inputs.
+     */
+    DataSetEntryIterator(ValueT* p, std::size_t ni, std::size_t no, std::size_t outOff, std::size_t stride, const std::size_t* pos, std::size_t idx)
+    : p_(p),
+      ni_(ni),
+      no_(no),
+      outOff_(outOff),
+      stride_(stride),
+      pos_(pos),
+      idx_(idx)
+    {
+    }
+
+    /// Converts a mutable iterator to a constant one
+    template <typename OtherEntryT>
+    DataSetEntryIterator(const DataSetEntryIterator<ValueT,OtherEntryT>& other,
+                         typename boost::enable_if_convertible<OtherEntryT*,EntryT*>::type* = 0)
+    : p_(other.p_),
+      ni_(other.ni_),
+      no_(other.no_),
+      outOff_(other.outOff_),
+      stride_(other.stride_),
+      pos_(other.pos_),
+      idx_(other.idx_)
+    {
+    }
+
+    /// Returns the position of the pointed entry in the dataset
+    std::size_t index() const
+    {
+        return idx_;
+    }
+
+
 private:
-    typedef std::vector< DataSetEntry<ValueT> > EntryContainer;
+    friend class boost::iterator_core_access;
+
+    template <typename V, typename E>
+    friend class DataSetEntryIterator;
+
+
+    EntryT dereference() const
+    {
+        ValueT* p = p_+(pos_ ? pos_[idx_] : idx_)*stride_;
+
+        return EntryT(p, ni_, p+outOff_, no_);
+    }
+
+    template <typename OtherEntryT>
+    bool equal(const DataSetEntryIterator<ValueT,OtherEntryT>& other) const
+    {
+        return idx_ == other.idx_;
+    }
+
+    void increment()
+    {
+        ++idx_;
+    }
+
+    void decrement()
+    {
+        --idx_;
+    }
+
+    void advance(std::ptrdiff_t n)
+    {
+        idx_ += n;
+    }
+
+    template <typename OtherEntryT>
+    std::ptrdiff_t distance_to(const DataSetEntryIterator<ValueT,OtherEntryT>& other) const
+    {
+        return static_cast<std::ptrdiff_t>(other.idx_)-static_cast<std::ptrdiff_t>(idx_);
+    }
+
+
+    ValueT* p_; ///< The first value of the dataset
+    std::size_t ni_; ///< Number of inputs in each entry
+    std::size_t no_; ///< Number of outputs in each entry
+    std::size_t outOff_; ///< The distance between the first input and the first output of each entry
+    std::size_t stride_; ///< The distance between the first values of two consecutive stored entries
+    const std::size_t* pos_; ///< The positions of the entries among the stored ones (null if they are consecutive)
+    std::size_t idx_; ///< The position of the pointed entry
+}; // DataSetEntryIterator
+
+} // Namespace detail
+
 
-    FL_MAKE_ITERATORS(public, EntryContainer, Entry, entry, entries_) 
-    //FL_MAKE_STL_ITERATORS(public, EntryContainer, entries_) 
+/**
+ * A dataset
+ *
+ * Entries are stored one after the other in a single contiguous buffer, each
+ * one made of its inputs followed by its outputs (i.e., the dataset is a
+ * row-major matrix with stride() columns).
+ * Entry iterators and get() give views of the stored entries, while
+ * inputs(), outputs() and rawData() give direct access to the buffer, so
+ * that algorithms can scan the dataset without any per-entry indirection.
+ * As for \c std::vector, adding or removing entries invalidates iterators,
+ * views and pointers.
+ *
+ * A dataset can also be a view of entries stored elsewhere (e.g., in a
+ * memory-mapped file, see fl::BinaryDataSetReader), in which case no value is
+ * copied until entries are added or removed: at that point, the dataset makes
+ * its own copy of the viewed entries and stops being a view.
+ * Views of (a part of) another dataset are made by slice(), select() and
+ * shuffled(): they refer to the values of that dataset, which must outlive
+ * them, and can be passed wherever a dataset is expected (e.g., to training
+ * algorithms and FIS builders) to split a dataset into training and check
+ * sets, into folds or into mini-batches, and to visit its entries in a
+ * different order, without copying any entry.
+ * Views made by the const overloads of slice(), select() and shuffled() are
+ * read-only: the non-const member functions giving access to the values of
+ * such a view (and of its copies), like inputs() or set(), make it copy the
+ * viewed entries first, so that a const dataset is never written through
+ * them; read-only views are meant to be used as const datasets, and non-const
+ * accesses cost a copy of the view.
+ * The entries of a view are not necessarily contiguous (see isContiguous()),
+ * and are located by inputs() and outputs(); in a view, entries may even
+ * overlap, and the outputs of an entry do not necessarily follow its inputs
+ * (e.g., see fl::TimeSeriesDataSet).
+ *
+ * \tparam ValueT Types for values stored in the dataset
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class DataSet
+{
+public:
+    typedef detail::DataSetEntryIterator< ValueT, DataSetEntry<ValueT> > EntryIterator;
+    typedef detail::DataSetEntryIterator< ValueT, const DataSetEntry<ValueT> > ConstEntryIterator;
+    typedef boost::reverse_iterator<EntryIterator> ReverseEntryIterator;
+    typedef boost::reverse_iterator<ConstEntryIterator> ConstReverseEntryIterator;
+    typedef detail::MatrixView<ValueT> DataMatrix;
+    typedef detail::MatrixView<const ValueT> ConstDataMatrix;
 
 
 public:
     explicit DataSet(std::size_t ni = 0, std::size_t no = 0);
 
+    /**
+     * Constructs a view of the \a n entries stored at \a p, each one made of
+     * \a ni inputs followed by \a no outputs.
+     *
+     * Values are not copied, so they must outlive the dataset (and its
+     * copies), unless their storage is owned by \a holder.
+     */
+    DataSet(ValueT* p, std::size_t n, std::size_t ni, std::size_t no,
+            const boost::shared_ptr<void>& holder = boost::shared_ptr<void>());
+
+    /**
+     * Constructs a view of \a n entries stored at \a p, each one made of
+     * \a ni inputs and of \a no outputs stored \a outOff values after the
+     * inputs (with \a outOff not less than \a ni).
+     *
+     * The inputs of the \a i-th entry are stored at
+     * <code>p+pos[i]*stride</code>, where \c pos is the array pointed by
+     * \a p_pos (or the identity, if \a p_pos is null).
+     * Entries may overlap (e.g., when \a stride is less than the number of
+     * values of an entry).
+     *
+     * Values are not copied, so they must outlive the dataset (and its
+     * copies), unless their storage is owned by \a holder.
+     */
+    DataSet(ValueT* p, std::size_t n, std::size_t ni, std::size_t no,
+            std::size_t outOff, std::size_t stride,
+            const boost::shared_ptr< const std::vector<std::size_t> >& p_pos,
+            const boost::shared_ptr<void>& holder = boost::shared_ptr<void>());
+
+    EntryIterator entryBegin();
+
+    EntryIterator entryEnd();
+
+    ConstEntryIterator entryBegin() const;
+
+    ConstEntryIterator entryEnd() const;
+
+    ReverseEntryIterator entryRBegin();
+
+    ReverseEntryIterator entryREnd();
+
+    ConstReverseEntryIterator entryRBegin() const;
+
+    ConstReverseEntryIterator entryREnd() const;
+
+#ifdef FL_CPP11
+    ConstEntryIterator entryCBegin() const;
+
+    ConstEntryIterator entryCEnd() const;
+
+    ConstReverseEntryIterator entryCRBegin() const;
+
+    ConstReverseEntryIterator entryCREnd() const;
+#endif // FL_CPP11
+
     void add(const DataSetEntry<ValueT>& entry);
 
+    /**
+     * Adds the entry made of the given inputs and outputs, without creating
+     * an intermediate fl::DataSetEntry.
+     *
+     * The given ranges must not refer to values of this dataset.
+     */
+    template <typename InIterT, typename OutIterT>
+    void add(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast);
+
     EntryIterator insert(EntryIterator pos, const DataSetEntry<ValueT>& entry);
 
     EntryIterator insert(ConstEntryIterator pos, const DataSetEntry<ValueT>& entry);
 
-//  EntryIterator insert(ConstEntryIterator pos, const DataSetEntry<ValueT>& entry);
-
     EntryIterator erase(EntryIterator pos);
 
     EntryIterator erase(ConstEntryIterator pos);
 
-    void set(const DataSetEntry<ValueT>& entry, std::size_t idx) const;
+    void set(const DataSetEntry<ValueT>& entry, std::size_t idx);
+
+    /// Returns a view of the \a idx-th entry
+    const DataSetEntry<ValueT> get(std::size_t idx) const;
+
+    /// Returns a pointer to the inputs of the \a idx-th entry, which are followed by its outputs
+    ValueT* inputs(std::size_t idx);
+
+    /// Returns a pointer to the inputs of the \a idx-th entry, which are followed by its outputs
+    const ValueT* inputs(std::size_t idx) const;
+
+    /// Returns a pointer to the outputs of the \a idx-th entry
+    ValueT* outputs(std::size_t idx);
+
+    /// Returns a pointer to the outputs of the \a idx-th entry
+    const ValueT* outputs(std::size_t idx) const;
+
+    /**
+     * Returns a pointer to the buffer storing all the entries, or \c 0 if
+     * the dataset is empty.
+     *
+     * For views that are not contiguous (see isContiguous()), the buffer
+     * also stores entries not belonging to the view.
+     */
+    ValueT* rawData();
+
+    /// Returns a pointer to the buffer storing all the entries, or \c 0 if the dataset is empty (see rawData())
+    const ValueT* rawData() const;
+
+    /**
+     * Returns the distance between the first values of two consecutive
+     * entries in the buffer (i.e., the number of inputs plus the number of
+     * outputs, unless the dataset is a strided view).
+     */
+    std::size_t stride() const;
+
+    /// Tells if entries are stored one right after the other, in order, so that rawData() is a row-major matrix with numOfInputs()+numOfOutputs() columns
+    bool isContiguous() const;
+
+    /// Tells if the outputs of each entry immediately follow its inputs, as required by matrix()
+    bool hasAdjacentOutputs() const;
+
+    /**
+     * Returns a view of the entries from position \a first (included) to
+     * position \a last (excluded), taking one entry every \a step entries.
+     *
+     * With \a step equal to 1, the view is a contiguous range of entries.
+     */
+    DataSet<ValueT> slice(std::size_t first, std::size_t last, std::size_t step = 1);
+
+    /// Returns a read-only view of the entries from position \a first to position \a last, taking one entry every \a step entries (see slice())
+    const DataSet<ValueT> slice(std::size_t first, std::size_t last, std::size_t step = 1) const;
+
+    /**
+     * Returns a view of the entries at the positions in the range
+     * [\a first, \a last), in that order.
+     *
+     * Only positions are copied (and the same position can appear more
+     * than once).
+     */
+    template <typename IterT>
+    DataSet<ValueT> select(IterT first, IterT last);
+
+    /// Returns a read-only view of the entries at the positions in the range [\a first, \a last), in that order (see select())
+    template <typename IterT>
+    const DataSet<ValueT> select(IterT first, IterT last) const;
+
+    /**
+     * Returns a view of all the entries in a random order, drawn from the
+     * uniform random number generator \a urng.
+     *
+     * Calling this function once per epoch with a seeded generator gives a
+     * reproducible sequence of shuffled epochs.
+     */
+    template <typename URNGT>
+    DataSet<ValueT> shuffled(URNGT& urng);
+
+    /// Returns a read-only view of all the entries in a random order, drawn from the uniform random number generator \a urng (see shuffled())
+    template <typename URNGT>
+    const DataSet<ValueT> shuffled(URNGT& urng) const;
+
+    /// Preallocates the storage for \a n entries
+    void reserve(std::size_t n);
 
-    const DataSetEntry<ValueT>& get(std::size_t idx) const;
+    /// Resizes the dataset to \a n entries, where new entries have all values set to zero
+    void resize(std::size_t n);
+
+    /// Tells if this dataset refers to entries stored elsewhere rather than owning them
+    bool isView() const;
 
 	template <typename IterT>
 	void setLabels(IterT first, IterT last);
@@ -137,17 +504,92 @@ public:
 
     void clear();
 
+    /**
+     * Returns a view of the dataset as a matrix with one row per entry,
+     * each one made of its inputs followed by its outputs.
+     *
+     * The view refers to the values stored in the dataset (also when the
+     * dataset is a view that is not contiguous), and can be passed to the
+     * algorithms taking a matrix (e.g., clustering and FIS builders) in place
+     * of data().
+     *
+     * \throw std::logic_error if the outputs of entries do not immediately
+     *  follow their inputs (see hasAdjacentOutputs())
+     */
+    DataMatrix matrix();
+
+    /// Returns a view of the dataset as a matrix with one row per entry (see matrix())
+    ConstDataMatrix matrix() const;
+
+    /// Returns a view of the inputs of the dataset as a matrix with one row per entry
+    ConstDataMatrix inputMatrix() const;
+
+    /// Returns a view of the outputs of the dataset as a matrix with one row per entry
+    ConstDataMatrix outputMatrix() const;
+
+    /// Returns a copy of the dataset as a matrix with one row per entry (see matrix() for a view with no copy)
 	std::vector< std::vector<ValueT> > data() const;
 
+    /**
+     * Caches the statistics of the entries with the dataset (and its
+     * copies), for the algorithms that need them (see
+     * fl::CachedStatistics).
+     *
+     * The cache is dropped when entries are added, removed or replaced by
+     * the member functions of the dataset (e.g., add(), set() or resize());
+     * values changed through pointers, iterators or matrix views are not
+     * tracked, so after such changes the cache must be dropped by passing a
+     * null pointer.
+     * A dataset and the views made by slice(), select() and shuffled() share
+     * their values, so these changes (and a null pointer) also drop the
+     * caches of the datasets sharing the values (as well as the caches of
+     * copies of this dataset, which may be dropped more often than needed).
+     */
+    void setStatistics(const boost::shared_ptr< const DataSetStatistics<ValueT> >& p_stats) const;
+
+    /// Returns the cached statistics of the entries, or a null pointer if there are none
+    boost::shared_ptr< const DataSetStatistics<ValueT> > statistics() const;
+
 private:
-	void setDefaultLabels();
+    /// Checks that \a entry has the number of inputs and outputs of this dataset
+    void checkEntry(const DataSetEntry<ValueT>& entry) const;
+
+	void setDefaultLabels() const;
+
+    /// Makes this dataset own a copy of the viewed entries (if it is a view)
+    void detach();
+
+    /// Makes this dataset own a copy of the viewed entries if they are read-only, before giving write access to them
+    void detachReadOnly();
+
+    /// Drops the cached statistics of this dataset and of the datasets sharing its values (i.e., its views or the viewed dataset)
+    void dropStatistics();
+
+    /// Returns a view of the \a n entries stored at \a p, \a stride values apart, in the order given by \a p_pos (if not null), with the layout of the entries of this dataset
+    DataSet<ValueT> view(ValueT* p, std::size_t n, std::size_t stride, const boost::shared_ptr< const std::vector<std::size_t> >& p_pos) const;
+
+    /// Throws if matrix() cannot be used
+    void checkAdjacentOutputs() const;
+
+    /// Returns the positions of the entries among the stored ones, or \c 0 if they are consecutive
+    const std::size_t* positions() const;
 
 
 private:
     std::size_t ni_; ///< Number of inputs in each entry
     std::size_t no_; ///< Number of outputs in each entry
-    EntryContainer entries_; ///< The collection of data entries
-	std::vector<std::string> labels_; ///< The labels associated to data entry components
+    std::size_t n_; ///< Number of entries
+    std::vector<ValueT> data_; ///< The values of all entries, one entry after the other
+    ValueT* ext_; ///< The values of all entries, if stored elsewhere (i.e., if this dataset is a view)
+    std::size_t outOff_; ///< The distance between the first input and the first output of an entry
+    std::size_t stride_; ///< The distance between the first values of two consecutive stored entries
+    boost::shared_ptr< const std::vector<std::size_t> > p_pos_; ///< The positions of the viewed entries among the stored ones (null if they are consecutive)
+    boost::shared_ptr<void> holder_; ///< The owner of the storage of viewed entries (if any)
+    bool readOnly_; ///< Tells if the viewed entries must not be written (i.e., if this dataset is a view of a const dataset)
+	mutable std::vector<std::string> labels_; ///< The labels associated to data entry components
+    mutable boost::shared_ptr< const DataSetStatistics<ValueT> > p_stats_; ///< The cached statistics of the entries (if any)
+    boost::shared_ptr<std::size_t> p_version_; ///< The version of the stored values, shared with the views of this dataset and bumped when values change
+    mutable std::size_t statsVersion_; ///< The version of the stored values the cached statistics refer to
 };
 
 
@@ -163,6 +605,7 @@ private:
 
 template <typename ValueT>
 DataSetEntry<ValueT>::DataSetEntry()
+: view_(false)
 {
 }
 
@@ -170,25 +613,110 @@ template <typename ValueT>
 template <typename InIterT, typename OutIterT>
 DataSetEntry<ValueT>::DataSetEntry(InIterT inFirst, InIterT inLast,
                                    OutIterT outFirst, OutIterT outLast)
-: in_(inFirst, inLast),
-  out_(outFirst, outLast)
+: buf_(inFirst, inLast),
+  view_(false)
+{
+    const std::size_t ni = buf_.size();
+    buf_.insert(buf_.end(), outFirst, outLast);
+    this->attach(ni, buf_.size()-ni);
+}
+
+template <typename ValueT>
+DataSetEntry<ValueT>::DataSetEntry(ValueT* p, std::size_t ni, std::size_t no)
+: in_(p, ni),
+  out_(p+ni, no),
+  view_(true)
+{
+}
+
+template <typename ValueT>
+DataSetEntry<ValueT>::DataSetEntry(ValueT* pIn, std::size_t ni, ValueT* pOut, std::size_t no)
+: in_(pIn, ni),
+  out_(pOut, no),
+  view_(true)
 {
 }
 
+template <typename ValueT>
+DataSetEntry<ValueT>::DataSetEntry(const DataSetEntry& other)
+: buf_(other.buf_),
+  in_(other.in_),
+  out_(other.out_),
+  view_(other.view_)
+{
+    if (!view_)
+    {
+        this->attach(other.in_.size(), other.out_.size());
+    }
+}
+
+template <typename ValueT>
+DataSetEntry<ValueT>& DataSetEntry<ValueT>::operator=(const DataSetEntry& rhs)
+{
+    if (this != &rhs)
+    {
+        buf_ = rhs.buf_;
+        in_ = rhs.in_;
+        out_ = rhs.out_;
+        view_ = rhs.view_;
+        if (!view_)
+        {
+            this->attach(rhs.in_.size(), rhs.out_.size());
+        }
+    }
+
+    return *this;
+}
+
 template <typename ValueT>
 template <typename IterT>
 void DataSetEntry<ValueT>::setInputs(IterT first, IterT last)
 {
-    in_.clear();
-    in_.assign(first, last);
+    std::vector<ValueT> in(first, last);
+
+    if (view_)
+    {
+        if (in.size() != in_.size())
+        {
+            FL_THROW2(std::invalid_argument, "Cannot change the number of inputs of a view of a dataset entry");
+        }
+
+        std::copy(in.begin(), in.end(), in_.begin());
+    }
+    else
+    {
+        const std::size_t ni = in.size();
+        const std::size_t no = out_.size();
+
+        in.insert(in.end(), out_.begin(), out_.end());
+        buf_.swap(in);
+        this->attach(ni, no);
+    }
 }
 
 template <typename ValueT>
 template <typename IterT>
 void DataSetEntry<ValueT>::setOutputs(IterT first, IterT last)
 {
-    out_.clear();
-    out_.assign(first, last);
+    std::vector<ValueT> out(first, last);
+
+    if (view_)
+    {
+        if (out.size() != out_.size())
+        {
+            FL_THROW2(std::invalid_argument, "Cannot change the number of outputs of a view of a dataset entry");
+        }
+
+        std::copy(out.begin(), out.end(), out_.begin());
+    }
+    else
+    {
+        const std::size_t ni = in_.size();
+
+        buf_.resize(ni);
+        buf_.insert(buf_.end(), out.begin(), out.end());
+        this->attach(ni, out.size());
+    }
 }
 
 template <typename ValueT>
@@ -211,8 +739,8 @@ ValueT DataSetEntry<ValueT>::getField(std::size_t index) const
         FL_THROW2(std::invalid_argument, "Index is out-of-range");
     }
 
-    return index < in_.size() ? in_.at(index)
-                              : out_.at(index-in_.size());
+    return index < in_.size() ? in_[index]
+                              : out_[index-in_.size()];
 }
 
 template <typename ValueT>
@@ -223,7 +751,7 @@ ValueT DataSetEntry<ValueT>::getInput(std::size_t index) const
         FL_THROW2(std::invalid_argument, "Index is out-of-range");
     }
 
-    return in_.at(index);
+    return in_[index];
 }
 
 template <typename ValueT>
@@ -234,7 +762,24 @@ ValueT DataSetEntry<ValueT>::getOutput(std::size_t index) const
         FL_THROW2(std::invalid_argument, "Index is out-of-range");
     }
 
-    return out_.at(index);
+    return out_[index];
+}
+
+template <typename ValueT>
+bool DataSetEntry<ValueT>::isView() const
+{
+    return view_;
+}
+
+template <typename ValueT>
+void DataSetEntry<ValueT>::attach(std::size_t ni, std::size_t no)
+{
+    FL_DEBUG_ASSERT( buf_.size() == (ni+no) );
+
+    ValueT* p = buf_.empty() ? 0 : &buf_[0];
+
+    in_ = Container(p, ni);
+    out_ = Container(p+ni, no);
 }
 
 
@@ -246,105 +791,512 @@ ValueT DataSetEntry<ValueT>::getOutput(std::size_t index) const
 template <typename ValueT>
 DataSet<ValueT>::DataSet(std::size_t ni, std::size_t no)
 : ni_(ni),
-  no_(no)
+  no_(no),
+  n_(0),
+  ext_(0),
+  outOff_(ni),
+  stride_(ni+no),
+  readOnly_(false),
+  p_version_(new std::size_t(0)),
+  statsVersion_(0)
 {
 }
 
 template <typename ValueT>
-void DataSet<ValueT>::add(const DataSetEntry<ValueT>& entry)
+DataSet<ValueT>::DataSet(ValueT* p, std::size_t n, std::size_t ni, std::size_t no,
+                         const boost::shared_ptr<void>& holder)
+: ni_(ni),
+  no_(no),
+  n_(n),
+  ext_(p),
+  outOff_(ni),
+  stride_(ni+no),
+  holder_(holder),
+  readOnly_(false),
+  p_version_(new std::size_t(0)),
+  statsVersion_(0)
 {
-    if (entry.numOfInputs() != ni_)
+    if (n > 0 && !p)
     {
-        FL_THROW2(std::invalid_argument, "Unexpected number of inputs in the entry");
+        FL_THROW2(std::invalid_argument, "Viewed entries must not be null");
     }
-    if (entry.numOfOutputs() != no_)
+}
+
+template <typename ValueT>
+DataSet<ValueT>::DataSet(ValueT* p, std::size_t n, std::size_t ni, std::size_t no,
+                         std::size_t outOff, std::size_t stride,
+                         const boost::shared_ptr< const std::vector<std::size_t> >& p_pos,
+                         const boost::shared_ptr<void>& holder)
+: ni_(ni),
+  no_(no),
+  n_(n),
+  ext_(p),
+  outOff_(outOff),
+  stride_(stride),
+  p_pos_(p_pos),
+  holder_(holder),
+  readOnly_(false),
+  p_version_(new std::size_t(0)),
+  statsVersion_(0)
+{
+    if (n > 0 && !p)
     {
-        FL_THROW2(std::invalid_argument, "Unexpected number of outputs in the entry");
+        FL_THROW2(std::invalid_argument, "Viewed entries must not be null");
+    }
+    if (outOff < ni)
+    {
+        FL_THROW2(std::invalid_argument, "Outputs must not overlap inputs");
     }
+    if (p_pos && p_pos->size() < n)
+    {
+        FL_THROW2(std::invalid_argument, "Missing positions of viewed entries");
+    }
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::entryBegin()
+{
+    this->detachReadOnly();
 
-    entries_.push_back(entry);
+    return EntryIterator(this->rawData(), ni_, no_, outOff_, stride_, this->positions(), 0);
 }
 
 template <typename ValueT>
-typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::insert(typename DataSet<ValueT>::EntryIterator pos,
-                                                                const DataSetEntry<ValueT>& entry)
+typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::entryEnd()
 {
-    if (entry.numOfInputs() != ni_)
+    this->detachReadOnly();
+
+    return EntryIterator(this->rawData(), ni_, no_, outOff_, stride_, this->positions(), n_);
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstEntryIterator DataSet<ValueT>::entryBegin() const
+{
+    return ConstEntryIterator(const_cast<ValueT*>(this->rawData()), ni_, no_, outOff_, stride_, this->positions(), 0);
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstEntryIterator DataSet<ValueT>::entryEnd() const
+{
+    return ConstEntryIterator(const_cast<ValueT*>(this->rawData()), ni_, no_, outOff_, stride_, this->positions(), n_);
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ReverseEntryIterator DataSet<ValueT>::entryRBegin()
+{
+    return ReverseEntryIterator(this->entryEnd());
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ReverseEntryIterator DataSet<ValueT>::entryREnd()
+{
+    return ReverseEntryIterator(this->entryBegin());
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstReverseEntryIterator DataSet<ValueT>::entryRBegin() const
+{
+    return ConstReverseEntryIterator(this->entryEnd());
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstReverseEntryIterator DataSet<ValueT>::entryREnd() const
+{
+    return ConstReverseEntryIterator(this->entryBegin());
+}
+
+#ifdef FL_CPP11
+template <typename ValueT>
+typename DataSet<ValueT>::ConstEntryIterator DataSet<ValueT>::entryCBegin() const
+{
+    return this->entryBegin();
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstEntryIterator DataSet<ValueT>::entryCEnd() const
+{
+    return this->entryEnd();
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstReverseEntryIterator DataSet<ValueT>::entryCRBegin() const
+{
+    return this->entryRBegin();
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstReverseEntryIterator DataSet<ValueT>::entryCREnd() const
+{
+    return this->entryREnd();
+}
+#endif // FL_CPP11
+
+template <typename ValueT>
+void DataSet<ValueT>::add(const DataSetEntry<ValueT>& entry)
+{
+    this->checkEntry(entry);
+
+    if (ext_)
     {
-        FL_THROW2(std::invalid_argument, "Unexpected number of inputs in the entry");
+        // Copy the entry first since it may be a view of this dataset
+        std::vector<ValueT> tmp(entry.inputBegin(), entry.inputEnd());
+        tmp.insert(tmp.end(), entry.outputBegin(), entry.outputEnd());
+
+        this->detach();
+        this->add(tmp.begin(), tmp.begin()+ni_, tmp.begin()+ni_, tmp.end());
+        return;
     }
-    if (entry.numOfOutputs() != no_)
+
+    this->dropStatistics();
+
+    const std::size_t off = data_.size();
+
+    if (!data_.empty() && entry.inputBegin() >= &data_[0] && entry.inputBegin() < &data_[0]+off)
     {
-        FL_THROW2(std::invalid_argument, "Unexpected number of outputs in the entry");
+        // The entry is a view of this dataset: copy it before the buffer gets reallocated
+        std::vector<ValueT> tmp(entry.inputBegin(), entry.inputEnd());
+        tmp.insert(tmp.end(), entry.outputBegin(), entry.outputEnd());
+        data_.insert(data_.end(), tmp.begin(), tmp.end());
     }
-
-    return entries_.insert(pos, entry);
+    else
+    {
+        data_.resize(off+ni_+no_);
+        std::copy(entry.inputBegin(), entry.inputEnd(), data_.begin()+off);
+        std::copy(entry.outputBegin(), entry.outputEnd(), data_.begin()+off+ni_);
+    }
+    ++n_;
 }
 
 template <typename ValueT>
-typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::insert(typename DataSet<ValueT>::ConstEntryIterator pos,
-                                                                const DataSetEntry<ValueT>& entry)
+template <typename InIterT, typename OutIterT>
+void DataSet<ValueT>::add(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast)
 {
-    if (entry.numOfInputs() != ni_)
+    this->detach();
+    this->dropStatistics();
+
+    const std::size_t off = data_.size();
+
+    data_.resize(off+ni_+no_);
+
+    std::size_t i = 0;
+    for (; inFirst != inLast && i < ni_; ++inFirst, ++i)
+    {
+        data_[off+i] = *inFirst;
+    }
+    if (i != ni_ || inFirst != inLast)
     {
+        data_.resize(off);
         FL_THROW2(std::invalid_argument, "Unexpected number of inputs in the entry");
     }
-    if (entry.numOfOutputs() != no_)
+
+    std::size_t j = 0;
+    for (; outFirst != outLast && j < no_; ++outFirst, ++j)
+    {
+        data_[off+ni_+j] = *outFirst;
+    }
+    if (j != no_ || outFirst != outLast)
     {
+        data_.resize(off);
         FL_THROW2(std::invalid_argument, "Unexpected number of outputs in the entry");
     }
 
-    return entries_.insert(pos, entry);
+    ++n_;
 }
 
-//template <typename ValueT>
-//typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::insert(typename DataSet<ValueT>::ConstEntryIterator pos,
-//                                                                const DataSetEntry<ValueT>& entry)
-//{
-//  if (entry.numOfInputs() != ni_)
-//  {
-//      FL_THROW2(std::invalid_argument, "Unexpected number of inputs in the entry");
-//  }
-//  if (entry.numOfOutputs() != no_)
-//  {
-//      FL_THROW2(std::invalid_argument, "Unexpected number of outputs in the entry");
-//  }
-//
-//  return entries_.insert(pos, entry);
-//}
+template <typename ValueT>
+typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::insert(typename DataSet<ValueT>::EntryIterator pos,
+                                                                const DataSetEntry<ValueT>& entry)
+{
+    return this->insert(ConstEntryIterator(pos), entry);
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::insert(typename DataSet<ValueT>::ConstEntryIterator pos,
+                                                                const DataSetEntry<ValueT>& entry)
+{
+    this->checkEntry(entry);
+
+    const std::size_t idx = pos.index();
+
+    if (idx > n_)
+    {
+        FL_THROW2(std::invalid_argument, "Entry position is out-of-range");
+    }
+
+    // Copy the entry first since it may be a view of this dataset
+    std::vector<ValueT> tmp(entry.inputBegin(), entry.inputEnd());
+    tmp.insert(tmp.end(), entry.outputBegin(), entry.outputEnd());
+    this->detach();
+    this->dropStatistics();
+    data_.insert(data_.begin()+idx*this->stride(), tmp.begin(), tmp.end());
+    ++n_;
+
+    return this->entryBegin()+idx;
+}
 
 template <typename ValueT>
 typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::erase(typename DataSet<ValueT>::EntryIterator pos)
 {
-    return entries_.erase(pos);
+    return this->erase(ConstEntryIterator(pos));
 }
 
 template <typename ValueT>
 typename DataSet<ValueT>::EntryIterator DataSet<ValueT>::erase(typename DataSet<ValueT>::ConstEntryIterator pos)
 {
-    return entries_.erase(pos);
+    const std::size_t idx = pos.index();
+
+    if (idx >= n_)
+    {
+        FL_THROW2(std::invalid_argument, "Entry position is out-of-range");
+    }
+
+    this->detach();
+    this->dropStatistics();
+    data_.erase(data_.begin()+idx*this->stride(), data_.begin()+(idx+1)*this->stride());
+    --n_;
+
+    return this->entryBegin()+idx;
 }
 
 template <typename ValueT>
-void DataSet<ValueT>::set(const DataSetEntry<ValueT>& entry, std::size_t idx) const
+void DataSet<ValueT>::set(const DataSetEntry<ValueT>& entry, std::size_t idx)
 {
-	if (idx >= entries_.size())
+	if (idx >= n_)
 	{
 		FL_THROW2(std::invalid_argument, "Entry index is out-of-range");
 	}
 
-    return entries_[idx] = entry;
+    this->checkEntry(entry);
+
+    // A read-only view copies its entries first, so the viewed dataset keeps its statistics
+    this->detachReadOnly();
+    this->dropStatistics();
+    std::copy(entry.inputBegin(), entry.inputEnd(), this->inputs(idx));
+    std::copy(entry.outputBegin(), entry.outputEnd(), this->outputs(idx));
 }
 
 template <typename ValueT>
-const DataSetEntry<ValueT>& DataSet<ValueT>::get(std::size_t idx) const
+const DataSetEntry<ValueT> DataSet<ValueT>::get(std::size_t idx) const
 {
-	if (idx >= entries_.size())
+	if (idx >= n_)
 	{
 		FL_THROW2(std::invalid_argument, "Entry index is out-of-range");
 	}
 
-    return entries_.at(idx);
+    ValueT* p = const_cast<ValueT*>(this->inputs(idx));
+
+    return DataSetEntry<ValueT>(p, ni_, p+outOff_, no_);
+}
+
+template <typename ValueT>
+ValueT* DataSet<ValueT>::inputs(std::size_t idx)
+{
+    FL_DEBUG_ASSERT( idx < n_ );
+
+    this->detachReadOnly();
+
+    return this->rawData()+(p_pos_ ? (*p_pos_)[idx] : idx)*stride_;
+}
+
+template <typename ValueT>
+const ValueT* DataSet<ValueT>::inputs(std::size_t idx) const
+{
+    FL_DEBUG_ASSERT( idx < n_ );
+
+    return this->rawData()+(p_pos_ ? (*p_pos_)[idx] : idx)*stride_;
+}
+
+template <typename ValueT>
+ValueT* DataSet<ValueT>::outputs(std::size_t idx)
+{
+    return this->inputs(idx)+outOff_;
+}
+
+template <typename ValueT>
+const ValueT* DataSet<ValueT>::outputs(std::size_t idx) const
+{
+    return this->inputs(idx)+outOff_;
+}
+
+template <typename ValueT>
+ValueT* DataSet<ValueT>::rawData()
+{
+    this->detachReadOnly();
+
+    if (ext_)
+    {
+        return ext_;
+    }
+
+    return data_.empty() ? 0 : &data_[0];
+}
+
+template <typename ValueT>
+const ValueT* DataSet<ValueT>::rawData() const
+{
+    if (ext_)
+    {
+        return ext_;
+    }
+
+    return data_.empty() ? 0 : &data_[0];
+}
+
+template <typename ValueT>
+std::size_t DataSet<ValueT>::stride() const
+{
+    return stride_;
+}
+
+template <typename ValueT>
+bool DataSet<ValueT>::isContiguous() const
+{
+    return !p_pos_ && outOff_ == ni_ && (stride_ == ni_+no_ || n_ <= 1);
+}
+
+template <typename ValueT>
+bool DataSet<ValueT>::hasAdjacentOutputs() const
+{
+    return outOff_ == ni_;
+}
+
+template <typename ValueT>
+DataSet<ValueT> DataSet<ValueT>::slice(std::size_t first, std::size_t last, std::size_t step)
+{
+    DataSet<ValueT> data = static_cast<const DataSet<ValueT>&>(*this).slice(first, last, step);
+    data.readOnly_ = readOnly_;
+
+    return data;
+}
+
+template <typename ValueT>
+const DataSet<ValueT> DataSet<ValueT>::slice(std::size_t first, std::size_t last, std::size_t step) const
+{
+    if (first > last || last > n_)
+    {
+        FL_THROW2(std::invalid_argument, "Entry range is out-of-range");
+    }
+    if (step == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Step must be positive");
+    }
+
+    const std::size_t n = (last-first+step-1)/step;
+
+    if (n == 0)
+    {
+        return this->view(0, 0, stride_, boost::shared_ptr< const std::vector<std::size_t> >());
+    }
+
+    if (p_pos_)
+    {
+        boost::shared_ptr< std::vector<std::size_t> > p_pos(new std::vector<std::size_t>(n));
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            (*p_pos)[i] = (*p_pos_)[first+i*step];
+        }
+
+        return this->view(const_cast<ValueT*>(this->rawData()), n, stride_, p_pos);
+    }
+
+    return this->view(const_cast<ValueT*>(this->rawData())+first*stride_, n, stride_*step, boost::shared_ptr< const std::vector<std::size_t> >());
+}
+
+template <typename ValueT>
+template <typename IterT>
+DataSet<ValueT> DataSet<ValueT>::select(IterT first, IterT last)
+{
+    DataSet<ValueT> data = static_cast<const DataSet<ValueT>&>(*this).select(first, last);
+    data.readOnly_ = readOnly_;
+
+    return data;
+}
+
+template <typename ValueT>
+template <typename IterT>
+const DataSet<ValueT> DataSet<ValueT>::select(IterT first, IterT last) const
+{
+    boost::shared_ptr< std::vector<std::size_t> > p_pos(new std::vector<std::size_t>(first, last));
+
+    for (std::size_t i = 0,
+                     n = p_pos->size();
+         i < n;
+         ++i)
+    {
+        const std::size_t idx = (*p_pos)[i];
+
+        if (idx >= n_)
+        {
+            FL_THROW2(std::invalid_argument, "Entry index is out-of-range");
+        }
+
+        (*p_pos)[i] = p_pos_ ? (*p_pos_)[idx] : idx;
+    }
+
+    if (p_pos->empty())
+    {
+        return this->view(0, 0, stride_, boost::shared_ptr< const std::vector<std::size_t> >());
+    }
+
+    return this->view(const_cast<ValueT*>(this->rawData()), p_pos->size(), stride_, p_pos);
+}
+
+template <typename ValueT>
+template <typename URNGT>
+DataSet<ValueT> DataSet<ValueT>::shuffled(URNGT& urng)
+{
+    DataSet<ValueT> data = static_cast<const DataSet<ValueT>&>(*this).shuffled(urng);
+    data.readOnly_ = readOnly_;
+
+    return data;
+}
+
+template <typename ValueT>
+template <typename URNGT>
+const DataSet<ValueT> DataSet<ValueT>::shuffled(URNGT& urng) const
+{
+    if (n_ == 0)
+    {
+        return this->view(0, 0, stride_, boost::shared_ptr< const std::vector<std::size_t> >());
+    }
+
+    boost::shared_ptr< std::vector<std::size_t> > p_pos(new std::vector<std::size_t>(n_));
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        (*p_pos)[i] = p_pos_ ? (*p_pos_)[i] : i;
+    }
+
+    // Fisher-Yates shuffle
+    for (std::size_t i = n_-1; i > 0; --i)
+    {
+        const std::size_t j = fl::detail::RandIndex(0, i, urng);
+
+        std::swap((*p_pos)[i], (*p_pos)[j]);
+    }
+
+    return this->view(const_cast<ValueT*>(this->rawData()), n_, stride_, p_pos);
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::reserve(std::size_t n)
+{
+    this->detach();
+    data_.reserve(n*this->stride());
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::resize(std::size_t n)
+{
+    this->detach();
+    this->dropStatistics();
+    data_.resize(n*this->stride());
+    n_ = n;
+}
+
+template <typename ValueT>
+bool DataSet<ValueT>::isView() const
+{
+    return ext_ != 0;
 }
 
 template <typename ValueT>
@@ -360,7 +1312,7 @@ std::string DataSet<ValueT>::getLabel(std::size_t idx) const
 {
 	if (labels_.size() < (ni_+no_))
 	{
-		labels_ = this->setDefaultLabels();
+		this->setDefaultLabels();
 	}
 
 	if (idx >= labels_.size())
@@ -376,7 +1328,7 @@ std::vector<std::string> DataSet<ValueT>::labels() const
 {
 	if (labels_.size() < (ni_+no_))
 	{
-		labels_ = this->setDefaultLabels();
+		this->setDefaultLabels();
 	}
 
 	return labels_;
@@ -385,13 +1337,13 @@ std::vector<std::string> DataSet<ValueT>::labels() const
 template <typename ValueT>
 std::size_t DataSet<ValueT>::size() const
 {
-    return entries_.size();
+    return n_;
 }
 
 template <typename ValueT>
 bool DataSet<ValueT>::empty() const
 {
-    return entries_.empty();
+    return n_ == 0;
 }
 
 //template <typename ValueT>
@@ -418,33 +1370,137 @@ std::size_t DataSet<ValueT>::numOfOutputs() const
     return no_;
 }
 
-//template <typename ValueT>
-//void DataSet<ValueT>::resize(std::size_t ni, std::size_t no)
-//{
-//  for (std::size_t i = 0,
-//                   ni = entries_.size();
-//       i < ni;
-//       ++i)
-//  {
-//      entries_[i].resize(ni, no);
-//  }
-//}
-
 template <typename ValueT>
 void DataSet<ValueT>::clear()
 {
-    entries_.clear();
+    data_.clear();
+    ext_ = 0;
+    outOff_ = ni_;
+    stride_ = ni_+no_;
+    p_pos_.reset();
+    holder_.reset();
+    readOnly_ = false;
+    n_ = 0;
 	labels_.clear();
+    p_stats_.reset();
+    p_version_.reset(new std::size_t(0));
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::checkEntry(const DataSetEntry<ValueT>& entry) const
+{
+    if (entry.numOfInputs() != ni_)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of inputs in the entry");
+    }
+    if (entry.numOfOutputs() != no_)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of outputs in the entry");
+    }
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::detach()
+{
+    if (!ext_)
+    {
+        return;
+    }
+
+    if (this->isContiguous())
+    {
+        data_.assign(ext_, ext_+n_*(ni_+no_));
+    }
+    else
+    {
+        // Entries are read through the const accessors, which do not detach
+        const DataSet<ValueT>& self = *this;
+        std::vector<ValueT> tmp;
+        tmp.reserve(n_*(ni_+no_));
+        for (std::size_t i = 0; i < n_; ++i)
+        {
+            const ValueT* p = self.inputs(i);
+
+            tmp.insert(tmp.end(), p, p+ni_);
+            tmp.insert(tmp.end(), p+outOff_, p+outOff_+no_);
+        }
+        data_.swap(tmp);
+    }
+    ext_ = 0;
+    outOff_ = ni_;
+    stride_ = ni_+no_;
+    p_pos_.reset();
+    holder_.reset();
+    readOnly_ = false;
+    // The copied values are no longer shared with the viewed dataset
+    p_version_.reset(new std::size_t(*p_version_));
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::detachReadOnly()
+{
+    if (readOnly_)
+    {
+        this->detach();
+    }
 }
 
 template <typename ValueT>
-void DataSet<ValueT>::setDefaultLabels()
+void DataSet<ValueT>::dropStatistics()
+{
+    p_stats_.reset();
+    ++*p_version_;
+}
+
+template <typename ValueT>
+DataSet<ValueT> DataSet<ValueT>::view(ValueT* p, std::size_t n, std::size_t stride, const boost::shared_ptr< const std::vector<std::size_t> >& p_pos) const
+{
+    if (n == 0)
+    {
+        DataSet<ValueT> data(ni_, no_);
+        data.labels_ = labels_;
+
+        return data;
+    }
+
+    DataSet<ValueT> data(p, n, ni_, no_, outOff_, stride, p_pos, holder_);
+    data.labels_ = labels_;
+    data.readOnly_ = true;
+    data.p_version_ = p_version_;
+
+    return data;
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::checkAdjacentOutputs() const
+{
+    if (outOff_ != ni_)
+    {
+        FL_THROW2(std::logic_error, "The outputs of entries do not follow their inputs");
+    }
+}
+
+template <typename ValueT>
+const std::size_t* DataSet<ValueT>::positions() const
+{
+    return p_pos_ ? &(*p_pos_)[0] : 0;
+}
+
+template <typename ValueT>
+void DataSet<ValueT>::setDefaultLabels() const
 {
 	const std::size_t n = ni_+no_;
-	const std::size_t width = std::floor(std::log10(n))+1;
 
+	if (n == 0)
+	{
+		return;
+	}
+
+	const std::size_t width = std::floor(std::log10(static_cast<double>(n)))+1;
+
+	std::size_t i = labels_.size();
 	labels_.resize(n);
-	for (std::size_t i = labels_.size(); i < n; ++i)
+	for (; i < n; ++i)
 	{
 		std::ostringstream oss;
 		oss << "L" << std::setfill('0') << std::setw(width) << i;
@@ -452,32 +1508,76 @@ void DataSet<ValueT>::setDefaultLabels()
 	}
 }
 
+template <typename ValueT>
+typename DataSet<ValueT>::DataMatrix DataSet<ValueT>::matrix()
+{
+    this->checkAdjacentOutputs();
+    this->detachReadOnly();
+
+    return DataMatrix(this->rawData(), n_, ni_+no_, stride_, this->positions());
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstDataMatrix DataSet<ValueT>::matrix() const
+{
+    this->checkAdjacentOutputs();
+
+    return ConstDataMatrix(this->rawData(), n_, ni_+no_, stride_, this->positions());
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstDataMatrix DataSet<ValueT>::inputMatrix() const
+{
+    return ConstDataMatrix(this->rawData(), n_, ni_, stride_, this->positions());
+}
+
+template <typename ValueT>
+typename DataSet<ValueT>::ConstDataMatrix DataSet<ValueT>::outputMatrix() const
+{
+    return ConstDataMatrix(this->rawData() ? this->rawData()+outOff_ : 0, n_, no_, stride_, this->positions());
+}
+
 template <typename ValueT>
 std::vector< std::vector<ValueT> > DataSet<ValueT>::data() const
 {
 	std::vector< std::vector<ValueT> > rawData;
 
-	for (ConstEntryIterator it = entries_.begin(),
-							endIt = entries_.end();
-		 it != endIt;
-		 ++it)
+	rawData.reserve(n_);
+	for (std::size_t i = 0; i < n_; ++i)
 	{
-		std::vector<ValueT> rawEntry;
-//		for (typename DataSetEntry<ValueT>::ConstInputIterator entryIt = it->inputBegin(),
-//															   entryEndIt = it->inputEnd();
-//			 entryIt != entryEndIt;
-//			 ++entryIt)
-//		{
-//			rawEntry.push_back(*entry
-		rawEntry.assign(it->inputBegin(), it->inputEnd());
-		rawEntry.insert(rawEntry.end(), it->outputBegin(), it->outputEnd());
-
-		rawData.push_back(rawEntry);
+		const ValueT* p = this->inputs(i);
+
+		rawData.push_back(std::vector<ValueT>(p, p+ni_));
+		rawData.back().insert(rawData.back().end(), p+outOff_, p+outOff_+no_);
 	}
 
 	return rawData;
 }
 
+template <typename ValueT>
+void DataSet<ValueT>::setStatistics(const boost::shared_ptr< const DataSetStatistics<ValueT> >& p_stats) const
+{
+    if (!p_stats)
+    {
+        // Values may have been changed, also for the datasets sharing them
+        ++*p_version_;
+    }
+    p_stats_ = p_stats;
+    statsVersion_ = *p_version_;
+}
+
+template <typename ValueT>
+boost::shared_ptr< const DataSetStatistics<ValueT> > DataSet<ValueT>::statistics() const
+{
+    if (p_stats_ && statsVersion_ != *p_version_)
+    {
+        // Stale, since values have been changed through a dataset sharing them
+        return boost::shared_ptr< const DataSetStatistics<ValueT> >();
+    }
+
+    return p_stats_;
+}
+
 } // Namespace fl
 
 #endif // FL_DATASET_H
@@ -0,0 +1,711 @@
+/**
+ * \file fl/dataset_reader.h
+ *
+ * \brief Reading of datasets in text format
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DATASET_READER_H
+#define FL_DATASET_READER_H
+
+
+#include <algorithm>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstddef>
+#include <cstring>
+#include <fl/dataset.h>
+#include <fl/detail/parse.h>
+#include <fl/macro.h>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# include <omp.h>
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+
+namespace fl {
+
+/**
+ * Reads datasets in text format, where each line holds the fields of an
+ * entry.
+ *
+ * Fields are separated by whitespaces and/or by one of the delimiter
+ * characters (by default, comma and semicolon), so that both
+ * whitespace-separated and CSV files can be read.
+ * Blank lines and lines starting with a comment character (by default, '#'
+ * and '%') are ignored.
+ * If the file has a header, its first (non-comment) line holds the labels
+ * of the columns, which become the labels of the dataset (see
+ * fl::DataSet::setLabels).
+ *
+ * Input and output columns are selected by their (zero-based) position in
+ * the file; the other columns are skipped without being parsed, so they can
+ * also hold non-numeric values.
+ * If only one kind of columns is selected, all the other columns are taken
+ * as the other kind; if no column is selected, the last column is the output
+ * and all the other columns are inputs.
+ *
+ * Empty fields, missing fields (i.e., lines with fewer columns than the
+ * selected ones), and the values \c nan, \c na and \c ? (regardless of the
+ * case) are missing values and are handled according to the
+ * MissingValuePolicy.
+ *
+ * The file is memory-mapped and split into chunks of whole lines, which are
+ * parsed concurrently (when the library is built with
+ * \c FLX_CONFIG_HAVE_OPENMP) directly into the storage of the dataset, by
+ * means of fl::detail::ParseNumber.
+ * Entries are appended to the dataset in the order they appear in the file.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+class DataSetReader
+{
+public:
+    /// The policies to handle missing values
+    enum MissingValuePolicy
+    {
+        KeepMissingValues, ///< Missing values are stored as NaN
+        SkipMissingValues, ///< Entries with missing values are skipped
+        FailOnMissingValues ///< Missing values are errors
+    };
+
+
+    /// Default constructor
+    DataSetReader();
+
+    /// Sets the positions of the input columns
+    void setInputColumns(const std::vector<std::size_t>& value);
+
+    /// Gets the positions of the input columns
+    std::vector<std::size_t> getInputColumns() const;
+
+    /// Sets the positions of the output columns
+    void setOutputColumns(const std::vector<std::size_t>& value);
+
+    /// Gets the positions of the output columns
+    std::vector<std::size_t> getOutputColumns() const;
+
+    /// Sets the characters (other than whitespaces) separating fields
+    void setDelimiters(const std::string& value);
+
+    /// Gets the characters (other than whitespaces) separating fields
+    std::string getDelimiters() const;
+
+    /// Sets the characters starting a comment line
+    void setCommentCharacters(const std::string& value);
+
+    /// Gets the characters starting a comment line
+    std::string getCommentCharacters() const;
+
+    /// Sets whether the first line holds the labels of the columns
+    void setHeader(bool value);
+
+    /// Tells whether the first line holds the labels of the columns
+    bool hasHeader() const;
+
+    /// Sets the policy to handle missing values
+    void setMissingValuePolicy(MissingValuePolicy value);
+
+    /// Gets the policy to handle missing values
+    MissingValuePolicy getMissingValuePolicy() const;
+
+    /// Sets the size of the chunks (in bytes) that are parsed concurrently
+    void setChunkSize(std::size_t value);
+
+    /// Gets the size of the chunks (in bytes) that are parsed concurrently
+    std::size_t getChunkSize() const;
+
+    /**
+     * Reads the file \a fname and appends its entries to the dataset \a data.
+     *
+     * If \a data is empty and has a different number of inputs or outputs
+     * than the ones selected, it is replaced by a dataset with the selected
+     * number of inputs and outputs.
+     */
+    template <typename ValueT>
+    void read(const std::string& fname, fl::DataSet<ValueT>& data) const;
+
+    /// Reads the text in [\a first, \a last) and appends its entries to the dataset \a data
+    template <typename ValueT>
+    void read(const char* first, const char* last, fl::DataSet<ValueT>& data) const;
+
+
+private:
+    /// The outcome of the parsing of a chunk
+    struct ChunkResult
+    {
+        ChunkResult();
+
+        std::size_t numOfLines; ///< The number of lines in the chunk
+        std::size_t numOfEntries; ///< The number of parsed entries
+        std::size_t errorLine; ///< The line (relative to the chunk, one-based) of the first error, or zero
+        std::string errorMessage; ///< The description of the first error
+    };
+
+
+    /// Tells if \a c is a whitespace
+    static bool isSpace(char c);
+
+    /// Tells if \a c is a delimiter
+    bool isDelimiter(char c) const;
+
+    /// Tells if the line [\a first, \a last) holds no field
+    bool isSkippable(const char* first, const char* last) const;
+
+    /// Splits the line [\a first, \a last) into fields and returns their number
+    std::size_t split(const char* first, const char* last, std::vector<std::string>* p_fields) const;
+
+    /// Parses the line [\a first, \a last) into \a row and returns \c false if it holds an invalid value
+    template <typename ValueT>
+    bool parseLine(const char* first, const char* last, const std::vector<std::ptrdiff_t>& colMap, std::size_t stride, ValueT* row) const;
+
+    /// Parses the lines in [\a first, \a last) into consecutive rows starting at \a rows
+    template <typename ValueT>
+    void parseChunk(const char* first, const char* last, const std::vector<std::ptrdiff_t>& colMap, std::size_t stride, ValueT* rows, ChunkResult& res) const;
+
+
+private:
+    std::vector<std::size_t> inCols_; ///< The positions of the input columns
+    std::vector<std::size_t> outCols_; ///< The positions of the output columns
+    std::string delims_; ///< The delimiters of fields
+    std::vector<char> isDelim_; ///< Tells, for each character, if it is a delimiter (avoids searching delims_ for each parsed character)
+    std::string comments_; ///< The characters starting a comment line
+    bool header_; ///< Whether the first line holds the labels of the columns
+    MissingValuePolicy missingPolicy_; ///< The policy to handle missing values
+    std::size_t chunkSize_; ///< The size of the chunks parsed concurrently
+}; // DataSetReader
+
+
+////////////////////////
+// Inline definitions
+////////////////////////
+
+
+inline DataSetReader::ChunkResult::ChunkResult()
+: numOfLines(0),
+  numOfEntries(0),
+  errorLine(0)
+{
+}
+
+inline DataSetReader::DataSetReader()
+: isDelim_(256, 0),
+  comments_("#%"),
+  header_(false),
+  missingPolicy_(KeepMissingValues),
+  chunkSize_(1 << 22)
+{
+    this->setDelimiters(",;");
+}
+
+inline void DataSetReader::setInputColumns(const std::vector<std::size_t>& value)
+{
+    inCols_ = value;
+}
+
+inline std::vector<std::size_t> DataSetReader::getInputColumns() const
+{
+    return inCols_;
+}
+
+inline void DataSetReader::setOutputColumns(const std::vector<std::size_t>& value)
+{
+    outCols_ = value;
+}
+
+inline std::vector<std::size_t> DataSetReader::getOutputColumns() const
+{
+    return outCols_;
+}
+
+inline void DataSetReader::setDelimiters(const std::string& value)
+{
+    delims_ = value;
+
+    std::fill(isDelim_.begin(), isDelim_.end(), 0);
+    for (std::size_t i = 0,
+                     n = delims_.size();
+         i < n;
+         ++i)
+    {
+        isDelim_[static_cast<unsigned char>(delims_[i])] = 1;
+    }
+}
+
+inline std::string DataSetReader::getDelimiters() const
+{
+    return delims_;
+}
+
+inline void DataSetReader::setCommentCharacters(const std::string& value)
+{
+    comments_ = value;
+}
+
+inline std::string DataSetReader::getCommentCharacters() const
+{
+    return comments_;
+}
+
+inline void DataSetReader::setHeader(bool value)
+{
+    header_ = value;
+}
+
+inline bool DataSetReader::hasHeader() const
+{
+    return header_;
+}
+
+inline void DataSetReader::setMissingValuePolicy(MissingValuePolicy value)
+{
+    missingPolicy_ = value;
+}
+
+inline DataSetReader::MissingValuePolicy DataSetReader::getMissingValuePolicy() const
+{
+    return missingPolicy_;
+}
+
+inline void DataSetReader::setChunkSize(std::size_t value)
+{
+    chunkSize_ = std::max(value, static_cast<std::size_t>(1));
+}
+
+inline std::size_t DataSetReader::getChunkSize() const
+{
+    return chunkSize_;
+}
+
+inline bool DataSetReader::isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool DataSetReader::isDelimiter(char c) const
+{
+    return isDelim_[static_cast<unsigned char>(c)] != 0;
+}
+
+inline bool DataSetReader::isSkippable(const char* first, const char* last) const
+{
+    while (first != last && isSpace(*first))
+    {
+        ++first;
+    }
+
+    return first == last || comments_.find(*first) != std::string::npos;
+}
+
+inline std::size_t DataSetReader::split(const char* first, const char* last, std::vector<std::string>* p_fields) const
+{
+    std::size_t n = 0;
+    bool afterDelim = false;
+    const char* p = first;
+    while (true)
+    {
+        while (p != last && isSpace(*p))
+        {
+            ++p;
+        }
+        if (p == last)
+        {
+            if (afterDelim)
+            {
+                if (p_fields)
+                {
+                    p_fields->push_back(std::string());
+                }
+                ++n;
+            }
+            break;
+        }
+        if (this->isDelimiter(*p))
+        {
+            // Empty field
+            if (p_fields)
+            {
+                p_fields->push_back(std::string());
+            }
+            ++n;
+            ++p;
+            afterDelim = true;
+            continue;
+        }
+
+        const char* q = p;
+        while (q != last && !isSpace(*q) && !this->isDelimiter(*q))
+        {
+            ++q;
+        }
+        if (p_fields)
+        {
+            p_fields->push_back(std::string(p, q));
+        }
+        ++n;
+
+        p = q;
+        while (p != last && isSpace(*p))
+        {
+            ++p;
+        }
+        afterDelim = false;
+        if (p != last && this->isDelimiter(*p))
+        {
+            ++p;
+            afterDelim = true;
+        }
+    }
+
+    return n;
+}
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+template <typename ValueT>
+void DataSetReader::read(const std::string& fname, fl::DataSet<ValueT>& data) const
+{
+    namespace bip = boost::interprocess;
+
+    std::ifstream ifs(fname.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs)
+    {
+        FL_THROW2(std::runtime_error, "Unable to open the file '" + fname + "'");
+    }
+    const std::streamoff size = ifs.tellg();
+    ifs.close();
+
+    if (size == 0)
+    {
+        this->read(static_cast<const char*>(0), static_cast<const char*>(0), data);
+        return;
+    }
+
+    try
+    {
+        const bip::file_mapping mapping(fname.c_str(), bip::read_only);
+        const bip::mapped_region region(mapping, bip::read_only);
+        const char* first = static_cast<const char*>(region.get_address());
+
+        this->read(first, first+region.get_size(), data);
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+        FL_THROW2(std::runtime_error, "Unable to map the file '" + fname + "': " + e.what());
+    }
+}
+
+template <typename ValueT>
+void DataSetReader::read(const char* first, const char* last, fl::DataSet<ValueT>& data) const
+{
+    // Finds the header and the first data line, which sets the number of columns
+    std::size_t lineNo = 0; // The number of lines before the data start
+    std::vector<std::string> labels;
+    std::size_t numCols = 0;
+    const char* dataFirst = first;
+    for (const char* p = first; p < last; )
+    {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', last-p));
+        if (!eol)
+        {
+            eol = last;
+        }
+
+        if (!this->isSkippable(p, eol))
+        {
+            if (header_ && labels.empty())
+            {
+                this->split(p, eol, &labels);
+            }
+            else
+            {
+                numCols = this->split(p, eol, 0);
+                dataFirst = p;
+                break;
+            }
+        }
+
+        ++lineNo;
+        p = eol != last ? eol+1 : last;
+        dataFirst = p;
+    }
+
+    // Assigns columns
+    std::vector<std::size_t> inCols = inCols_;
+    std::vector<std::size_t> outCols = outCols_;
+    if (inCols.empty() && outCols.empty())
+    {
+        if (numCols == 0)
+        {
+            // Neither data nor column selection: nothing to read
+            return;
+        }
+        for (std::size_t j = 0; j+1 < numCols; ++j)
+        {
+            inCols.push_back(j);
+        }
+        outCols.push_back(numCols-1);
+    }
+    else if (inCols.empty() || outCols.empty())
+    {
+        std::vector<std::size_t>& given = inCols.empty() ? outCols : inCols;
+        std::vector<std::size_t>& others = inCols.empty() ? inCols : outCols;
+        for (std::size_t j = 0; j < numCols; ++j)
+        {
+            if (std::find(given.begin(), given.end(), j) == given.end())
+            {
+                others.push_back(j);
+            }
+        }
+    }
+
+    const std::size_t ni = inCols.size();
+    const std::size_t no = outCols.size();
+    const std::size_t stride = ni+no;
+
+    // Maps each column to its position in the entry
+    std::vector<std::ptrdiff_t> colMap;
+    for (std::size_t k = 0; k < stride; ++k)
+    {
+        const std::size_t j = k < ni ? inCols[k] : outCols[k-ni];
+        if (j >= colMap.size())
+        {
+            colMap.resize(j+1, -1);
+        }
+        if (colMap[j] >= 0)
+        {
+            FL_THROW2(std::invalid_argument, "A column cannot be selected more than once");
+        }
+        colMap[j] = k;
+    }
+
+    if (data.numOfInputs() != ni || data.numOfOutputs() != no)
+    {
+        if (!data.empty())
+        {
+            FL_THROW2(std::invalid_argument, "Unexpected number of inputs or outputs in the dataset");
+        }
+        data = fl::DataSet<ValueT>(ni, no);
+    }
+    if (header_)
+    {
+        std::vector<std::string> selLabels(stride);
+        for (std::size_t k = 0; k < stride; ++k)
+        {
+            const std::size_t j = k < ni ? inCols[k] : outCols[k-ni];
+            if (j < labels.size())
+            {
+                selLabels[k] = labels[j];
+            }
+        }
+        data.setLabels(selLabels.begin(), selLabels.end());
+    }
+
+    if (dataFirst == last || numCols == 0)
+    {
+        return;
+    }
+
+    // Splits data into chunks made of whole lines
+    const std::size_t size = last-dataFirst;
+    const std::size_t nc = std::max(size/chunkSize_, static_cast<std::size_t>(1));
+    std::vector<const char*> bounds(nc+1, last);
+    bounds[0] = dataFirst;
+    for (std::size_t c = 1; c < nc; ++c)
+    {
+        const char* p = std::max(dataFirst+c*(size/nc), bounds[c-1]);
+        const char* eol = p < last ? static_cast<const char*>(std::memchr(p, '\n', last-p)) : 0;
+        bounds[c] = eol ? eol+1 : last;
+    }
+
+    // Counts lines, to know where the entries of each chunk go
+    std::vector<ChunkResult> results(nc);
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(dynamic,1)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    for (std::size_t c = 0; c < nc; ++c)
+    {
+        if (bounds[c] < bounds[c+1])
+        {
+            results[c].numOfLines = std::count(bounds[c], bounds[c+1], '\n')
+                                    + (bounds[c+1][-1] != '\n' ? 1 : 0);
+        }
+    }
+
+    std::vector<std::size_t> offsets(nc+1, 0);
+    for (std::size_t c = 0; c < nc; ++c)
+    {
+        offsets[c+1] = offsets[c]+results[c].numOfLines;
+    }
+
+    // Parses chunks straight into the dataset
+    const std::size_t n0 = data.size();
+    data.resize(n0+offsets[nc]);
+    ValueT* rows = data.rawData()+n0*stride;
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(dynamic,1)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    for (std::size_t c = 0; c < nc; ++c)
+    {
+        this->parseChunk(bounds[c], bounds[c+1], colMap, stride, rows+offsets[c]*stride, results[c]);
+    }
+
+    // Reports the first error (if any) and closes the gaps left by skipped lines
+    std::size_t n = 0;
+    for (std::size_t c = 0; c < nc; ++c)
+    {
+        if (results[c].errorLine > 0)
+        {
+            data.resize(n0);
+
+            std::ostringstream oss;
+            oss << "Line " << (lineNo+offsets[c]+results[c].errorLine) << ": " << results[c].errorMessage;
+            FL_THROW2(std::runtime_error, oss.str());
+        }
+
+        if (n != offsets[c])
+        {
+            std::copy(rows+offsets[c]*stride, rows+(offsets[c]+results[c].numOfEntries)*stride, rows+n*stride);
+        }
+        n += results[c].numOfEntries;
+    }
+    data.resize(n0+n);
+}
+
+template <typename ValueT>
+bool DataSetReader::parseLine(const char* first, const char* last, const std::vector<std::ptrdiff_t>& colMap, std::size_t stride, ValueT* row) const
+{
+    std::fill(row, row+stride, std::numeric_limits<ValueT>::quiet_NaN());
+
+    std::size_t col = 0;
+    const char* p = first;
+    while (col < colMap.size())
+    {
+        while (p != last && isSpace(*p))
+        {
+            ++p;
+        }
+        if (p == last)
+        {
+            break;
+        }
+        if (this->isDelimiter(*p))
+        {
+            // Empty field (i.e., missing value)
+            ++col;
+            ++p;
+            continue;
+        }
+
+        const char* q = p;
+        while (q != last && !isSpace(*q) && !this->isDelimiter(*q))
+        {
+            ++q;
+        }
+        if (colMap[col] >= 0)
+        {
+            ValueT x = 0;
+            if (detail::ParseNumber(p, q, x) == q)
+            {
+                row[colMap[col]] = x;
+            }
+            else if (!((q-p) == 1 && *p == '?')
+                     && !((q-p) == 2 && detail::StartsWithNoCase(p, q, "na")))
+            {
+                return false;
+            }
+        }
+        ++col;
+
+        p = q;
+        while (p != last && isSpace(*p))
+        {
+            ++p;
+        }
+        if (p != last && this->isDelimiter(*p))
+        {
+            ++p;
+        }
+    }
+
+    return true;
+}
+
+template <typename ValueT>
+void DataSetReader::parseChunk(const char* first, const char* last, const std::vector<std::ptrdiff_t>& colMap, std::size_t stride, ValueT* rows, ChunkResult& res) const
+{
+    std::size_t lineNo = 0;
+    ValueT* row = rows;
+    for (const char* p = first; p < last; )
+    {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', last-p));
+        if (!eol)
+        {
+            eol = last;
+        }
+        ++lineNo;
+
+        if (!this->isSkippable(p, eol))
+        {
+            if (!this->parseLine(p, eol, colMap, stride, row))
+            {
+                res.errorLine = lineNo;
+                res.errorMessage = "Invalid number";
+                return;
+            }
+
+            bool missing = false;
+            for (std::size_t k = 0; k < stride && !missing; ++k)
+            {
+                missing = (row[k] != row[k]);
+            }
+
+            if (!missing || missingPolicy_ == KeepMissingValues)
+            {
+                row += stride;
+                ++res.numOfEntries;
+            }
+            else if (missingPolicy_ == FailOnMissingValues)
+            {
+                res.errorLine = lineNo;
+                res.errorMessage = "Missing value";
+                return;
+            }
+        }
+
+        p = eol != last ? eol+1 : last;
+    }
+}
+
+} // Namespace fl
+
+#endif // FL_DATASET_READER_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
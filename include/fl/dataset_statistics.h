@@ -0,0 +1,888 @@
+/**
+ * \file fl/dataset_statistics.h
+ *
+ * \brief Statistics and normalization of the columns of datasets
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DATASET_STATISTICS_H
+#define FL_DATASET_STATISTICS_H
+
+
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <cmath>
+#include <cstddef>
+#include <fl/data_source.h>
+#include <fl/dataset.h>
+#include <fl/detail/quantile_sketch.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl {
+
+/**
+ * Statistics of the columns (the inputs followed by the outputs) of a
+ * dataset: minimum, maximum, mean, variance and (approximate) quantiles.
+ *
+ * All the statistics are collected in a single pass over the entries, which
+ * are split into blocks visited in parallel (when the library is built with
+ * \c FLX_CONFIG_HAVE_OPENMP); the statistics of the blocks are then merged,
+ * always in the same order, so that results do not depend on the number of
+ * threads.
+ * Statistics can be updated with more entries (e.g., with the chunks of a
+ * fl::DataSource) and merged with the statistics of other entries.
+ * Missing values (i.e., NaNs) are ignored.
+ *
+ * Quantiles are estimated by a fl::detail::QuantileSketch per column, so
+ * that memory does not grow with the number of entries.
+ *
+ * The bounds of columns can be passed to the algorithms that normalize data
+ * (e.g., fl::cluster::SubtractiveClustering::setBounds) and to the FIS
+ * builders, and statistics can be cached with a dataset (see
+ * fl::CachedStatistics), so that they are computed only once for all of
+ * them.
+ *
+ * \tparam ValueT Types for values stored in the dataset
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class DataSetStatistics
+{
+public:
+    /// The default size of the quantile sketches (see fl::detail::QuantileSketch)
+    static const std::size_t DefaultSketchSize = 256;
+
+
+public:
+    /// Constructs empty statistics of \a numOfColumns columns (or of the columns of the first dataset passed to update(), if zero)
+    explicit DataSetStatistics(std::size_t numOfColumns = 0, std::size_t sketchSize = DefaultSketchSize);
+
+    /// Constructs the statistics of the entries of \a data
+    explicit DataSetStatistics(const fl::DataSet<ValueT>& data, std::size_t sketchSize = DefaultSketchSize);
+
+    /// Adds the entries of \a data to the statistics
+    void update(const fl::DataSet<ValueT>& data);
+
+    /// Adds all the entries read from \a source to the statistics
+    void update(fl::DataSource<ValueT>& source);
+
+    /// Adds the entries summarized by \a other to the statistics
+    void merge(const DataSetStatistics& other);
+
+    /// Returns the number of columns
+    std::size_t numOfColumns() const;
+
+    /// Returns the number of entries
+    std::size_t size() const;
+
+    /// Returns the number of (non-missing) values in column \a j
+    std::size_t numOfValues(std::size_t j) const;
+
+    /// Returns the minimum of column \a j (NaN if there is no value)
+    ValueT minimum(std::size_t j) const;
+
+    /// Returns the maximum of column \a j (NaN if there is no value)
+    ValueT maximum(std::size_t j) const;
+
+    /// Returns the mean of column \a j (NaN if there is no value)
+    ValueT mean(std::size_t j) const;
+
+    /// Returns the (population) variance of column \a j (NaN if there is no value)
+    ValueT variance(std::size_t j) const;
+
+    /// Returns the (population) standard deviation of column \a j (NaN if there is no value)
+    ValueT standardDeviation(std::size_t j) const;
+
+    /// Returns (an approximation of) the \a p-quantile of column \a j, with \a p in [0,1] (NaN if there is no value)
+    ValueT quantile(std::size_t j, double p) const;
+
+    /// Returns the minimum of each column
+    std::vector<ValueT> lowerBounds() const;
+
+    /// Returns the maximum of each column
+    std::vector<ValueT> upperBounds() const;
+
+    /// Removes all the entries from the statistics
+    void clear();
+
+
+private:
+    /// Adds the entries of \a data from position \a first (included) to position \a last (excluded)
+    void update(const fl::DataSet<ValueT>& data, std::size_t first, std::size_t last);
+
+    /// Adds the value \a x to column \a j
+    void add(std::size_t j, ValueT x);
+
+    /// Resets the statistics for \a nc columns
+    void init(std::size_t nc);
+
+    /// Throws if \a j is not a column
+    void checkColumn(std::size_t j) const;
+
+
+private:
+    static const std::size_t BlockSize = 16384; ///< The number of entries of the blocks visited in parallel
+
+
+    std::size_t sketchSize_; ///< The size of the quantile sketches
+    std::size_t n_; ///< The number of entries
+    std::vector<std::size_t> counts_; ///< The number of values of each column
+    std::vector<ValueT> mins_; ///< The minimum of each column
+    std::vector<ValueT> maxs_; ///< The maximum of each column
+    std::vector<ValueT> means_; ///< The mean of each column
+    std::vector<ValueT> m2s_; ///< The sum of squared deviations from the mean of each column
+    std::vector< fl::detail::QuantileSketch<ValueT> > sketches_; ///< The quantile sketch of each column
+}; // DataSetStatistics
+
+
+/**
+ * Returns the statistics of the entries of \a data, computing them only if
+ * they are not cached with the dataset (and caching them).
+ *
+ * \sa fl::DataSet::setStatistics
+ */
+template <typename ValueT>
+boost::shared_ptr< const DataSetStatistics<ValueT> > CachedStatistics(const fl::DataSet<ValueT>& data);
+
+/**
+ * Gets the minimum and the maximum of each column of \a data (NaN for the
+ * columns with no value), taken from the statistics cached with the dataset
+ * if any, and otherwise found by a single pass over the entries.
+ *
+ * Unlike fl::CachedStatistics, the dataset is left untouched, so that it can
+ * be shared by concurrent callers (e.g., the FIS builders).
+ */
+template <typename ValueT>
+void ColumnBounds(const fl::DataSet<ValueT>& data, std::vector<ValueT>& lower, std::vector<ValueT>& upper);
+
+
+/**
+ * A read-only matrix view of a dataset whose values are normalized (or
+ * de-normalized) when accessed.
+ *
+ * Rows are made of the inputs followed by the outputs of the entries, as for
+ * fl::DataSet::matrix, so that the view can be passed to the algorithms
+ * taking a matrix (e.g., clustering and FIS builders), but values are
+ * transformed on access, leaving the dataset untouched.
+ * The view refers to the dataset, which must outlive it.
+ *
+ * \tparam ValueT Types for values stored in the dataset
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class NormalizedMatrixView
+{
+public:
+    /// A row of the view, which refers to the view that returned it
+    class Row
+    {
+    public:
+        Row(const ValueT* pIn, const ValueT* pOut, const NormalizedMatrixView* p_view);
+
+        /// Returns the number of columns
+        std::size_t size() const;
+
+        /// Returns the transformed value of column \a j
+        ValueT operator[](std::size_t j) const;
+
+    private:
+        const ValueT* pIn_; ///< The inputs of the entry
+        const ValueT* pOut_; ///< The outputs of the entry
+        const NormalizedMatrixView* p_view_; ///< The view
+    }; // Row
+
+
+public:
+    /**
+     * Constructs a view of \a data where the value \f$x\f$ of column \f$j\f$
+     * is seen as \f$(x-o_j)/s_j\f$ (or as \f$x s_j+o_j\f$, if \a inverse is
+     * \c true), where \f$o_j\f$ and \f$s_j\f$ are the \f$j\f$-th elements of
+     * \a offsets and \a scales.
+     */
+    NormalizedMatrixView(const fl::DataSet<ValueT>& data, const std::vector<ValueT>& offsets, const std::vector<ValueT>& scales, bool inverse = false);
+
+    /// Returns the number of rows
+    std::size_t size() const;
+
+    /// Returns the \a i-th row
+    const Row operator[](std::size_t i) const;
+
+
+private:
+    const fl::DataSet<ValueT>* p_data_; ///< The dataset
+    std::vector<ValueT> offsets_; ///< The offset of each column
+    std::vector<ValueT> scales_; ///< The scale of each column
+    bool inverse_; ///< Whether values are de-normalized rather than normalized
+}; // NormalizedMatrixView
+
+
+/**
+ * Normalization of the columns of datasets, based on their statistics.
+ *
+ * Datasets can be normalized in place (and de-normalized back), or lazily,
+ * through a view that normalizes values when they are accessed (see
+ * normalizedMatrix()).
+ * Columns with no range are only shifted.
+ *
+ * \tparam ValueT Types for values stored in the dataset
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class DataSetNormalizer
+{
+public:
+    /// The kinds of normalization
+    enum NormalizationType
+    {
+        MinMaxNormalization, ///< Maps the range [minimum, maximum] of each column to [0, 1]
+        StandardNormalization ///< Maps each column to zero mean and unit standard deviation
+    };
+
+
+public:
+    /// Constructs a normalizer for the columns described by \a stats
+    explicit DataSetNormalizer(const DataSetStatistics<ValueT>& stats, NormalizationType type = MinMaxNormalization);
+
+    /// Returns the number of columns
+    std::size_t numOfColumns() const;
+
+    /// Returns the normalized value of \a x in column \a j
+    ValueT normalize(ValueT x, std::size_t j) const;
+
+    /// Returns the de-normalized value of \a x in column \a j
+    ValueT denormalize(ValueT x, std::size_t j) const;
+
+    /**
+     * Normalizes the entries of \a data in place (in parallel).
+     *
+     * If \a data is a view, the viewed values are changed, so the entries
+     * must not overlap (e.g., \a data must not be a view of a
+     * fl::TimeSeriesDataSet).
+     * The statistics cached with \a data (if any) are dropped.
+     */
+    void normalize(fl::DataSet<ValueT>& data) const;
+
+    /// De-normalizes the entries of \a data in place (see normalize(fl::DataSet<ValueT>&))
+    void denormalize(fl::DataSet<ValueT>& data) const;
+
+    /// Returns a view of \a data as a matrix whose values are normalized on access
+    NormalizedMatrixView<ValueT> normalizedMatrix(const fl::DataSet<ValueT>& data) const;
+
+    /// Returns a view of \a data as a matrix whose values are de-normalized on access
+    NormalizedMatrixView<ValueT> denormalizedMatrix(const fl::DataSet<ValueT>& data) const;
+
+
+private:
+    /// Normalizes (or de-normalizes, if \a inverse is \c true) the entries of \a data in place
+    void transform(fl::DataSet<ValueT>& data, bool inverse) const;
+
+    /// Throws if \a data has not the columns of this normalizer
+    void checkColumns(const fl::DataSet<ValueT>& data) const;
+
+
+private:
+    std::vector<ValueT> offsets_; ///< The value of each column mapped to zero
+    std::vector<ValueT> scales_; ///< The range of each column mapped to one
+}; // DataSetNormalizer
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+/////////////////////
+// DataSetStatistics
+/////////////////////
+
+
+template <typename ValueT>
+const std::size_t DataSetStatistics<ValueT>::DefaultSketchSize;
+
+template <typename ValueT>
+const std::size_t DataSetStatistics<ValueT>::BlockSize;
+
+template <typename ValueT>
+DataSetStatistics<ValueT>::DataSetStatistics(std::size_t numOfColumns, std::size_t sketchSize)
+: sketchSize_(sketchSize),
+  n_(0)
+{
+    this->init(numOfColumns);
+}
+
+template <typename ValueT>
+DataSetStatistics<ValueT>::DataSetStatistics(const fl::DataSet<ValueT>& data, std::size_t sketchSize)
+: sketchSize_(sketchSize),
+  n_(0)
+{
+    this->init(data.numOfInputs()+data.numOfOutputs());
+    this->update(data);
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::update(const fl::DataSet<ValueT>& data)
+{
+    const std::size_t nc = data.numOfInputs()+data.numOfOutputs();
+
+    if (counts_.empty() && n_ == 0)
+    {
+        this->init(nc);
+    }
+    if (nc != counts_.size())
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of columns in the dataset");
+    }
+
+    const std::size_t n = data.size();
+    const std::size_t nb = (n+BlockSize-1)/BlockSize;
+
+    if (nb <= 1)
+    {
+        this->update(data, 0, n);
+        return;
+    }
+
+    // Collects the statistics of each block in parallel, then merges them in
+    // order
+    std::vector<DataSetStatistics> blockStats(nb, DataSetStatistics(nc, sketchSize_));
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(dynamic,1)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    for (std::size_t b = 0; b < nb; ++b)
+    {
+        blockStats[b].update(data, b*BlockSize, std::min((b+1)*BlockSize, n));
+    }
+    for (std::size_t b = 0; b < nb; ++b)
+    {
+        this->merge(blockStats[b]);
+    }
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::update(fl::DataSource<ValueT>& source)
+{
+    fl::DataSet<ValueT> chunk;
+
+    source.rewind();
+    while (source.read(chunk))
+    {
+        this->update(chunk);
+    }
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::merge(const DataSetStatistics& other)
+{
+    if (other.n_ == 0 && other.counts_.empty())
+    {
+        return;
+    }
+    if (counts_.empty() && n_ == 0)
+    {
+        this->init(other.counts_.size());
+    }
+    if (other.counts_.size() != counts_.size())
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of columns in the statistics");
+    }
+
+    for (std::size_t j = 0,
+                     nc = counts_.size();
+         j < nc;
+         ++j)
+    {
+        const std::size_t na = counts_[j];
+        const std::size_t nb = other.counts_[j];
+
+        if (nb == 0)
+        {
+            continue;
+        }
+        if (na == 0)
+        {
+            counts_[j] = nb;
+            mins_[j] = other.mins_[j];
+            maxs_[j] = other.maxs_[j];
+            means_[j] = other.means_[j];
+            m2s_[j] = other.m2s_[j];
+            sketches_[j] = other.sketches_[j];
+            continue;
+        }
+
+        // Combines means and sums of squared deviations (Chan et al., 1979)
+        const std::size_t nab = na+nb;
+        const ValueT delta = other.means_[j]-means_[j];
+
+        counts_[j] = nab;
+        mins_[j] = std::min(mins_[j], other.mins_[j]);
+        maxs_[j] = std::max(maxs_[j], other.maxs_[j]);
+        means_[j] += delta*nb/nab;
+        m2s_[j] += other.m2s_[j] + delta*delta*(static_cast<ValueT>(na)*nb/nab);
+        sketches_[j].merge(other.sketches_[j]);
+    }
+    n_ += other.n_;
+}
+
+template <typename ValueT>
+std::size_t DataSetStatistics<ValueT>::numOfColumns() const
+{
+    return counts_.size();
+}
+
+template <typename ValueT>
+std::size_t DataSetStatistics<ValueT>::size() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+std::size_t DataSetStatistics<ValueT>::numOfValues(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return counts_[j];
+}
+
+template <typename ValueT>
+ValueT DataSetStatistics<ValueT>::minimum(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return mins_[j];
+}
+
+template <typename ValueT>
+ValueT DataSetStatistics<ValueT>::maximum(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return maxs_[j];
+}
+
+template <typename ValueT>
+ValueT DataSetStatistics<ValueT>::mean(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return means_[j];
+}
+
+template <typename ValueT>
+ValueT DataSetStatistics<ValueT>::variance(std::size_t j) const
+{
+    this->checkColumn(j);
+
+    return counts_[j] > 0 ? m2s_[j]/counts_[j] : std::numeric_limits<ValueT>::quiet_NaN();
+}
+
+template <typename ValueT>
+ValueT DataSetStatistics<ValueT>::standardDeviation(std::size_t j) const
+{
+    return std::sqrt(this->variance(j));
+}
+
+template <typename ValueT>
+ValueT DataSetStatistics<ValueT>::quantile(std::size_t j, double p) const
+{
+    this->checkColumn(j);
+
+    if (counts_[j] == 0)
+    {
+        return std::numeric_limits<ValueT>::quiet_NaN();
+    }
+    if (p <= 0)
+    {
+        return mins_[j];
+    }
+    if (p >= 1)
+    {
+        return maxs_[j];
+    }
+
+    return std::min(std::max(sketches_[j].quantile(p), mins_[j]), maxs_[j]);
+}
+
+template <typename ValueT>
+std::vector<ValueT> DataSetStatistics<ValueT>::lowerBounds() const
+{
+    return mins_;
+}
+
+template <typename ValueT>
+std::vector<ValueT> DataSetStatistics<ValueT>::upperBounds() const
+{
+    return maxs_;
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::clear()
+{
+    this->init(counts_.size());
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::update(const fl::DataSet<ValueT>& data, std::size_t first, std::size_t last)
+{
+    const std::size_t ni = data.numOfInputs();
+    const std::size_t no = data.numOfOutputs();
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const ValueT* in = data.inputs(i);
+        const ValueT* out = data.outputs(i);
+
+        for (std::size_t j = 0; j < ni; ++j)
+        {
+            this->add(j, in[j]);
+        }
+        for (std::size_t j = 0; j < no; ++j)
+        {
+            this->add(ni+j, out[j]);
+        }
+    }
+    n_ += last-first;
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::add(std::size_t j, ValueT x)
+{
+    if (x != x)
+    {
+        // Missing value
+        return;
+    }
+
+    // Updates the mean and the sum of squared deviations (Welford, 1962)
+    const std::size_t n = ++counts_[j];
+    if (n == 1)
+    {
+        mins_[j] = maxs_[j] = means_[j] = x;
+        m2s_[j] = 0;
+    }
+    else
+    {
+        if (x < mins_[j])
+        {
+            mins_[j] = x;
+        }
+        else if (x > maxs_[j])
+        {
+            maxs_[j] = x;
+        }
+        const ValueT delta = x-means_[j];
+        means_[j] += delta/n;
+        m2s_[j] += delta*(x-means_[j]);
+    }
+
+    sketches_[j].insert(x);
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::init(std::size_t nc)
+{
+    const ValueT nan = std::numeric_limits<ValueT>::quiet_NaN();
+
+    n_ = 0;
+    counts_.assign(nc, 0);
+    mins_.assign(nc, nan);
+    maxs_.assign(nc, nan);
+    means_.assign(nc, nan);
+    m2s_.assign(nc, 0);
+    sketches_.assign(nc, fl::detail::QuantileSketch<ValueT>(sketchSize_));
+}
+
+template <typename ValueT>
+void DataSetStatistics<ValueT>::checkColumn(std::size_t j) const
+{
+    if (j >= counts_.size())
+    {
+        FL_THROW2(std::invalid_argument, "Column index is out-of-range");
+    }
+}
+
+
+/////////////////////
+// CachedStatistics
+/////////////////////
+
+
+template <typename ValueT>
+boost::shared_ptr< const DataSetStatistics<ValueT> > CachedStatistics(const fl::DataSet<ValueT>& data)
+{
+    boost::shared_ptr< const DataSetStatistics<ValueT> > p_stats = data.statistics();
+
+    if (!p_stats)
+    {
+        p_stats.reset(new DataSetStatistics<ValueT>(data));
+        data.setStatistics(p_stats);
+    }
+
+    return p_stats;
+}
+
+template <typename ValueT>
+void ColumnBounds(const fl::DataSet<ValueT>& data, std::vector<ValueT>& lower, std::vector<ValueT>& upper)
+{
+    const boost::shared_ptr< const DataSetStatistics<ValueT> > p_stats = data.statistics();
+
+    if (p_stats)
+    {
+        lower = p_stats->lowerBounds();
+        upper = p_stats->upperBounds();
+        return;
+    }
+
+    const std::size_t ni = data.numOfInputs();
+    const std::size_t nc = ni+data.numOfOutputs();
+
+    lower.assign(nc, std::numeric_limits<ValueT>::quiet_NaN());
+    upper.assign(nc, std::numeric_limits<ValueT>::quiet_NaN());
+    for (std::size_t k = 0,
+                     n = data.size();
+         k < n;
+         ++k)
+    {
+        const ValueT* in = data.inputs(k);
+        const ValueT* out = data.outputs(k);
+        for (std::size_t j = 0; j < nc; ++j)
+        {
+            const ValueT x = j < ni ? in[j] : out[j-ni];
+            if (x != x)
+            {
+                // Missing value
+                continue;
+            }
+            if (lower[j] != lower[j] || x < lower[j])
+            {
+                lower[j] = x;
+            }
+            if (upper[j] != upper[j] || x > upper[j])
+            {
+                upper[j] = x;
+            }
+        }
+    }
+}
+
+
+////////////////////////
+// NormalizedMatrixView
+////////////////////////
+
+
+template <typename ValueT>
+NormalizedMatrixView<ValueT>::Row::Row(const ValueT* pIn, const ValueT* pOut, const NormalizedMatrixView* p_view)
+: pIn_(pIn),
+  pOut_(pOut),
+  p_view_(p_view)
+{
+}
+
+template <typename ValueT>
+std::size_t NormalizedMatrixView<ValueT>::Row::size() const
+{
+    return p_view_->offsets_.size();
+}
+
+template <typename ValueT>
+ValueT NormalizedMatrixView<ValueT>::Row::operator[](std::size_t j) const
+{
+    FL_DEBUG_ASSERT( j < this->size() );
+
+    const std::size_t ni = p_view_->p_data_->numOfInputs();
+    const ValueT x = j < ni ? pIn_[j] : pOut_[j-ni];
+
+    return p_view_->inverse_
+           ? x*p_view_->scales_[j]+p_view_->offsets_[j]
+           : (x-p_view_->offsets_[j])/p_view_->scales_[j];
+}
+
+template <typename ValueT>
+NormalizedMatrixView<ValueT>::NormalizedMatrixView(const fl::DataSet<ValueT>& data, const std::vector<ValueT>& offsets, const std::vector<ValueT>& scales, bool inverse)
+: p_data_(&data),
+  offsets_(offsets),
+  scales_(scales),
+  inverse_(inverse)
+{
+    if (offsets.size() != data.numOfInputs()+data.numOfOutputs() || scales.size() != offsets.size())
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of columns");
+    }
+}
+
+template <typename ValueT>
+std::size_t NormalizedMatrixView<ValueT>::size() const
+{
+    return p_data_->size();
+}
+
+template <typename ValueT>
+const typename NormalizedMatrixView<ValueT>::Row NormalizedMatrixView<ValueT>::operator[](std::size_t i) const
+{
+    FL_DEBUG_ASSERT( i < this->size() );
+
+    return Row(p_data_->inputs(i), p_data_->outputs(i), this);
+}
+
+
+/////////////////////
+// DataSetNormalizer
+/////////////////////
+
+
+template <typename ValueT>
+DataSetNormalizer<ValueT>::DataSetNormalizer(const DataSetStatistics<ValueT>& stats, NormalizationType type)
+: offsets_(stats.numOfColumns(), 0),
+  scales_(stats.numOfColumns(), 1)
+{
+    for (std::size_t j = 0,
+                     nc = stats.numOfColumns();
+         j < nc;
+         ++j)
+    {
+        if (stats.numOfValues(j) == 0)
+        {
+            continue;
+        }
+
+        switch (type)
+        {
+            case MinMaxNormalization:
+                offsets_[j] = stats.minimum(j);
+                scales_[j] = stats.maximum(j)-stats.minimum(j);
+                break;
+            case StandardNormalization:
+                offsets_[j] = stats.mean(j);
+                scales_[j] = stats.standardDeviation(j);
+                break;
+        }
+        if (!(scales_[j] > 0))
+        {
+            scales_[j] = 1;
+        }
+    }
+}
+
+template <typename ValueT>
+std::size_t DataSetNormalizer<ValueT>::numOfColumns() const
+{
+    return offsets_.size();
+}
+
+template <typename ValueT>
+ValueT DataSetNormalizer<ValueT>::normalize(ValueT x, std::size_t j) const
+{
+    FL_DEBUG_ASSERT( j < offsets_.size() );
+
+    return (x-offsets_[j])/scales_[j];
+}
+
+template <typename ValueT>
+ValueT DataSetNormalizer<ValueT>::denormalize(ValueT x, std::size_t j) const
+{
+    FL_DEBUG_ASSERT( j < offsets_.size() );
+
+    return x*scales_[j]+offsets_[j];
+}
+
+template <typename ValueT>
+void DataSetNormalizer<ValueT>::normalize(fl::DataSet<ValueT>& data) const
+{
+    this->transform(data, false);
+}
+
+template <typename ValueT>
+void DataSetNormalizer<ValueT>::denormalize(fl::DataSet<ValueT>& data) const
+{
+    this->transform(data, true);
+}
+
+template <typename ValueT>
+NormalizedMatrixView<ValueT> DataSetNormalizer<ValueT>::normalizedMatrix(const fl::DataSet<ValueT>& data) const
+{
+    this->checkColumns(data);
+
+    return NormalizedMatrixView<ValueT>(data, offsets_, scales_, false);
+}
+
+template <typename ValueT>
+NormalizedMatrixView<ValueT> DataSetNormalizer<ValueT>::denormalizedMatrix(const fl::DataSet<ValueT>& data) const
+{
+    this->checkColumns(data);
+
+    return NormalizedMatrixView<ValueT>(data, offsets_, scales_, true);
+}
+
+template <typename ValueT>
+void DataSetNormalizer<ValueT>::transform(fl::DataSet<ValueT>& data, bool inverse) const
+{
+    this->checkColumns(data);
+
+    const std::size_t n = data.size();
+    const std::size_t ni = data.numOfInputs();
+    const std::size_t no = data.numOfOutputs();
+
+    // Write access is taken once before the parallel loop, since a read-only
+    // view copies its entries at that point (see fl::DataSet::slice)
+    data.rawData();
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        ValueT* in = data.inputs(i);
+        ValueT* out = data.outputs(i);
+
+        for (std::size_t j = 0; j < ni; ++j)
+        {
+            in[j] = inverse ? this->denormalize(in[j], j) : this->normalize(in[j], j);
+        }
+        for (std::size_t j = 0; j < no; ++j)
+        {
+            out[j] = inverse ? this->denormalize(out[j], ni+j) : this->normalize(out[j], ni+j);
+        }
+    }
+
+    data.setStatistics(boost::shared_ptr< const DataSetStatistics<ValueT> >());
+}
+
+template <typename ValueT>
+void DataSetNormalizer<ValueT>::checkColumns(const fl::DataSet<ValueT>& data) const
+{
+    if (data.numOfInputs()+data.numOfOutputs() != offsets_.size())
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of columns in the dataset");
+    }
+}
+
+} // Namespace fl
+
+#endif // FL_DATASET_STATISTICS_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
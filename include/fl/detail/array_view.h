@@ -0,0 +1,246 @@
+/**
+ * \file fl/detail/array_view.h
+ *
+ * \brief A non-owning view of a contiguous array
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_ARRAY_VIEW_H
+#define FL_DETAIL_ARRAY_VIEW_H
+
+
+#include <cstddef>
+#include <fl/macro.h>
+#include <iterator>
+
+
+namespace fl { namespace detail {
+
+/**
+ * A non-owning view of \f$n\f$ contiguous values.
+ *
+ * The view has the interface of a fixed-size STL container, so that it can
+ * be used where a \c std::vector would be (e.g., with the iterator macros in
+ * fl/macro.h or as a row of a matrix), but copying it does not copy the
+ * values.
+ * The viewed memory must outlive the view.
+ *
+ * \tparam ValueT The type of values
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class ArrayView
+{
+public:
+    typedef ValueT value_type;
+    typedef ValueT& reference;
+    typedef const ValueT& const_reference;
+    typedef ValueT* pointer;
+    typedef const ValueT* const_pointer;
+    typedef ValueT* iterator;
+    typedef const ValueT* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+
+    /// Constructs an empty view
+    ArrayView();
+
+    /// Constructs a view of the \a n values starting at \a p
+    ArrayView(ValueT* p, std::size_t n);
+
+    /// Converts a view of mutable values to a view of constant values
+    template <typename OtherValueT>
+    ArrayView(const ArrayView<OtherValueT>& other);
+
+    /// Returns the number of values
+    std::size_t size() const;
+
+    /// Tells if the view has no value
+    bool empty() const;
+
+    /// Returns a pointer to the first value
+    ValueT* data() const;
+
+    /// Returns the \a i-th value
+    ValueT& operator[](std::size_t i) const;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+#ifdef FL_CPP11
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+#endif // FL_CPP11
+    reverse_iterator rbegin();
+    reverse_iterator rend();
+    const_reverse_iterator rbegin() const;
+    const_reverse_iterator rend() const;
+#ifdef FL_CPP11
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+#endif // FL_CPP11
+
+
+private:
+    ValueT* p_; ///< The first value
+    std::size_t n_; ///< The number of values
+}; // ArrayView
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename ValueT>
+ArrayView<ValueT>::ArrayView()
+: p_(0),
+  n_(0)
+{
+}
+
+template <typename ValueT>
+ArrayView<ValueT>::ArrayView(ValueT* p, std::size_t n)
+: p_(p),
+  n_(n)
+{
+}
+
+template <typename ValueT>
+template <typename OtherValueT>
+ArrayView<ValueT>::ArrayView(const ArrayView<OtherValueT>& other)
+: p_(other.data()),
+  n_(other.size())
+{
+}
+
+template <typename ValueT>
+std::size_t ArrayView<ValueT>::size() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+bool ArrayView<ValueT>::empty() const
+{
+    return n_ == 0;
+}
+
+template <typename ValueT>
+ValueT* ArrayView<ValueT>::data() const
+{
+    return p_;
+}
+
+template <typename ValueT>
+ValueT& ArrayView<ValueT>::operator[](std::size_t i) const
+{
+    FL_DEBUG_ASSERT( i < n_ );
+
+    return p_[i];
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::iterator ArrayView<ValueT>::begin()
+{
+    return p_;
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::iterator ArrayView<ValueT>::end()
+{
+    return p_+n_;
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::const_iterator ArrayView<ValueT>::begin() const
+{
+    return p_;
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::const_iterator ArrayView<ValueT>::end() const
+{
+    return p_+n_;
+}
+
+#ifdef FL_CPP11
+template <typename ValueT>
+typename ArrayView<ValueT>::const_iterator ArrayView<ValueT>::cbegin() const
+{
+    return p_;
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::const_iterator ArrayView<ValueT>::cend() const
+{
+    return p_+n_;
+}
+#endif // FL_CPP11
+
+template <typename ValueT>
+typename ArrayView<ValueT>::reverse_iterator ArrayView<ValueT>::rbegin()
+{
+    return reverse_iterator(this->end());
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::reverse_iterator ArrayView<ValueT>::rend()
+{
+    return reverse_iterator(this->begin());
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::const_reverse_iterator ArrayView<ValueT>::rbegin() const
+{
+    return const_reverse_iterator(this->end());
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::const_reverse_iterator ArrayView<ValueT>::rend() const
+{
+    return const_reverse_iterator(this->begin());
+}
+
+#ifdef FL_CPP11
+template <typename ValueT>
+typename ArrayView<ValueT>::const_reverse_iterator ArrayView<ValueT>::crbegin() const
+{
+    return const_reverse_iterator(this->end());
+}
+
+template <typename ValueT>
+typename ArrayView<ValueT>::const_reverse_iterator ArrayView<ValueT>::crend() const
+{
+    return const_reverse_iterator(this->begin());
+}
+#endif // FL_CPP11
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_ARRAY_VIEW_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,138 @@
+/**
+ * \file fl/detail/float16.h
+ *
+ * \brief Conversions between single-precision and 16-bit floating-point values
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_FLOAT16_H
+#define FL_DETAIL_FLOAT16_H
+
+
+#include <boost/cstdint.hpp>
+#include <cstring>
+
+
+namespace fl { namespace detail {
+
+/// Returns the bits of the single-precision value \a x
+inline boost::uint32_t FloatBits(float x)
+{
+    boost::uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+/// Returns the single-precision value made of the bits \a u
+inline float BitsFloat(boost::uint32_t u)
+{
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+/**
+ * Returns the IEEE 754 half-precision value nearest to \a x (ties to even).
+ *
+ * Values too large in magnitude become infinities, and NaNs stay (quiet)
+ * NaNs.
+ */
+inline boost::uint16_t FloatToHalf(float x)
+{
+    boost::uint32_t f = FloatBits(x);
+    const boost::uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    boost::uint32_t h = 0;
+    if (f >= 0x47800000u)
+    {
+        // Overflow (|x| >= 65536), infinity or NaN
+        h = f > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    }
+    else if (f < 0x38800000u)
+    {
+        // Subnormal result (|x| < 2^-14): the addition of 0.5 aligns the
+        // mantissa, and rounds it, to the precision of half subnormals
+        h = FloatBits(BitsFloat(f)+0.5f)-0x3f000000u;
+    }
+    else
+    {
+        // Normal result: rebiases the exponent and rounds the mantissa (a
+        // carry correctly gives the next exponent, or infinity)
+        const boost::uint32_t odd = (f >> 13) & 1u;
+        f += 0xc8000fffu + odd;
+        h = f >> 13;
+    }
+
+    return static_cast<boost::uint16_t>(h | (sign >> 16));
+}
+
+/// Returns the single-precision value equal to the half-precision value \a h
+inline float HalfToFloat(boost::uint16_t h)
+{
+    // Branch-free (selections are made by masks), so that loops over arrays
+    // can be vectorized
+    boost::uint32_t f = static_cast<boost::uint32_t>(h & 0x7fffu) << 13;
+    const boost::uint32_t e = f & 0x0f800000u;
+    const boost::uint32_t infMask = 0u-static_cast<boost::uint32_t>(e == 0x0f800000u);
+    const boost::uint32_t subMask = 0u-static_cast<boost::uint32_t>(e == 0);
+
+    // Rebiases the exponent (twice for infinities and NaNs)
+    f += 0x38000000u + (infMask & 0x38000000u);
+
+    // Subnormal (or zero) values: normalizes them by floating-point arithmetic
+    const boost::uint32_t sub = FloatBits(BitsFloat(f+0x00800000u)-6.103515625e-05f);
+    f = (f & ~subMask) | (sub & subMask);
+
+    return BitsFloat(f | (static_cast<boost::uint32_t>(h & 0x8000u) << 16));
+}
+
+/**
+ * Returns the bfloat16 value nearest to \a x (ties to even).
+ *
+ * A bfloat16 value is made of the 16 most significant bits of a
+ * single-precision value, so it has the same range but only 8 bits of
+ * precision.
+ */
+inline boost::uint16_t FloatToBFloat16(float x)
+{
+    const boost::uint32_t f = FloatBits(x);
+
+    if ((f & 0x7fffffffu) > 0x7f800000u)
+    {
+        // NaN: keeps it quiet (rounding might turn it into an infinity)
+        return static_cast<boost::uint16_t>((f >> 16) | 0x40u);
+    }
+
+    return static_cast<boost::uint16_t>((f+0x7fffu+((f >> 16) & 1u)) >> 16);
+}
+
+/// Returns the single-precision value equal to the bfloat16 value \a b
+inline float BFloat16ToFloat(boost::uint16_t b)
+{
+    return BitsFloat(static_cast<boost::uint32_t>(b) << 16);
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_FLOAT16_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,251 @@
+/**
+ * \file fl/detail/heap.h
+ *
+ * \brief An indexed binary max-heap
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_HEAP_H
+#define FL_DETAIL_HEAP_H
+
+
+#include <cstddef>
+#include <fl/macro.h>
+#include <vector>
+
+
+namespace fl { namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+/// Declarations
+////////////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * A binary max-heap over the keys of a fixed set of items \f$0,\ldots,n-1\f$.
+ *
+ * Unlike \c std::priority_queue, the key of any item can be changed in
+ * \f$O(\log n)\f$ time, since the heap keeps track of the position of each
+ * item.
+ * Among items with equal keys, the one with the lowest index comes first,
+ * so that the top of the heap is the same item a linear scan for the first
+ * maximum would find.
+ *
+ * \tparam KeyT The type of keys
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename KeyT>
+class IndexedMaxHeap
+{
+public:
+    /// Constructs an empty heap
+    IndexedMaxHeap();
+
+    /// Replaces the content of the heap with the keys in [\a first, \a last) in \f$O(n)\f$ time
+    template <typename IterT>
+    void assign(IterT first, IterT last);
+
+    /// Returns the number of items
+    std::size_t size() const;
+
+    /// Tells if the heap has no item
+    bool empty() const;
+
+    /// Returns the item with the highest key
+    std::size_t top() const;
+
+    /// Returns the highest key
+    const KeyT& topKey() const;
+
+    /// Returns the key of item \a i
+    const KeyT& key(std::size_t i) const;
+
+    /// Changes the key of item \a i to \a k
+    void update(std::size_t i, const KeyT& k);
+
+
+private:
+    /// Tells if item \a a must come before item \a b
+    bool before(std::size_t a, std::size_t b) const;
+
+    /// Moves the item at heap position \a h toward the root until the heap property holds
+    void siftUp(std::size_t h);
+
+    /// Moves the item at heap position \a h toward the leaves until the heap property holds
+    void siftDown(std::size_t h);
+
+    /// Places item \a i at heap position \a h
+    void place(std::size_t h, std::size_t i);
+
+
+private:
+    std::vector<KeyT> keys_; ///< The key of each item
+    std::vector<std::size_t> heap_; ///< The items in heap order
+    std::vector<std::size_t> pos_; ///< The heap position of each item
+}; // IndexedMaxHeap
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename KeyT>
+IndexedMaxHeap<KeyT>::IndexedMaxHeap()
+{
+}
+
+template <typename KeyT>
+template <typename IterT>
+void IndexedMaxHeap<KeyT>::assign(IterT first, IterT last)
+{
+    keys_.assign(first, last);
+
+    const std::size_t n = keys_.size();
+    heap_.resize(n);
+    pos_.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        heap_[i] = pos_[i] = i;
+    }
+
+    // Bottom-up heap construction
+    for (std::size_t h = n/2; h > 0; --h)
+    {
+        this->siftDown(h-1);
+    }
+}
+
+template <typename KeyT>
+std::size_t IndexedMaxHeap<KeyT>::size() const
+{
+    return heap_.size();
+}
+
+template <typename KeyT>
+bool IndexedMaxHeap<KeyT>::empty() const
+{
+    return heap_.empty();
+}
+
+template <typename KeyT>
+std::size_t IndexedMaxHeap<KeyT>::top() const
+{
+    FL_DEBUG_ASSERT( !heap_.empty() );
+
+    return heap_[0];
+}
+
+template <typename KeyT>
+const KeyT& IndexedMaxHeap<KeyT>::topKey() const
+{
+    FL_DEBUG_ASSERT( !heap_.empty() );
+
+    return keys_[heap_[0]];
+}
+
+template <typename KeyT>
+const KeyT& IndexedMaxHeap<KeyT>::key(std::size_t i) const
+{
+    FL_DEBUG_ASSERT( i < keys_.size() );
+
+    return keys_[i];
+}
+
+template <typename KeyT>
+void IndexedMaxHeap<KeyT>::update(std::size_t i, const KeyT& k)
+{
+    FL_DEBUG_ASSERT( i < keys_.size() );
+
+    const KeyT old = keys_[i];
+    keys_[i] = k;
+    if (old < k)
+    {
+        this->siftUp(pos_[i]);
+    }
+    else if (k < old)
+    {
+        this->siftDown(pos_[i]);
+    }
+}
+
+template <typename KeyT>
+bool IndexedMaxHeap<KeyT>::before(std::size_t a, std::size_t b) const
+{
+    return keys_[b] < keys_[a] || (!(keys_[a] < keys_[b]) && a < b);
+}
+
+template <typename KeyT>
+void IndexedMaxHeap<KeyT>::siftUp(std::size_t h)
+{
+    const std::size_t i = heap_[h];
+    while (h > 0)
+    {
+        const std::size_t parent = (h-1)/2;
+        if (!this->before(i, heap_[parent]))
+        {
+            break;
+        }
+        this->place(h, heap_[parent]);
+        h = parent;
+    }
+    this->place(h, i);
+}
+
+template <typename KeyT>
+void IndexedMaxHeap<KeyT>::siftDown(std::size_t h)
+{
+    const std::size_t n = heap_.size();
+    const std::size_t i = heap_[h];
+    while (true)
+    {
+        std::size_t child = 2*h+1;
+        if (child >= n)
+        {
+            break;
+        }
+        if (child+1 < n && this->before(heap_[child+1], heap_[child]))
+        {
+            ++child;
+        }
+        if (!this->before(heap_[child], i))
+        {
+            break;
+        }
+        this->place(h, heap_[child]);
+        h = child;
+    }
+    this->place(h, i);
+}
+
+template <typename KeyT>
+void IndexedMaxHeap<KeyT>::place(std::size_t h, std::size_t i)
+{
+    heap_[h] = i;
+    pos_[i] = h;
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_HEAP_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -1,372 +1,651 @@
+/**
+ * \file fl/detail/kalman.h
+ *
+ * \brief Kalman filter for the estimation of linear parameters.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
 #ifndef FL_DETAIL_KALMAN_H
 #define FL_DETAIL_KALMAN_H
 
 
 #include <algorithm>
 #include <cstddef>
-#include <cmath>
-#include <fl/detail/math.h>
+#include <fl/detail/memory.h>
+#include <fl/detail/sparse.h>
 #include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <iterator>
+#include <stdexcept>
 #include <vector>
 
 
 namespace fl { namespace detail {
 
+/**
+ * Kalman filter for the estimation of the parameters of a linear model.
+ *
+ * Given the linear model \f$\mathbf{b}^T = \mathbf{a}^T \mathbf{P}\f$, where
+ * \f$\mathbf{a}\f$ is the regressor vector and \f$\mathbf{b}\f$ is the output
+ * vector, recursively estimates the parameter matrix \f$\mathbf{P}\f$ as in
+ * (Jang, 1993):
+ * \f{align*}
+ *  \mathbf{S}_{k+1} &= \frac{1}{\lambda}\left[\mathbf{S}_k - \frac{\mathbf{S}_k \mathbf{a}_{k+1} \mathbf{a}_{k+1}^T \mathbf{S}_k}{\lambda + \mathbf{a}_{k+1}^T \mathbf{S}_k \mathbf{a}_{k+1}}\right],\\
+ *  \mathbf{P}_{k+1} &= \mathbf{P}_k + \mathbf{S}_{k+1} \mathbf{a}_{k+1} (\mathbf{b}_{k+1}^T - \mathbf{a}_{k+1}^T \mathbf{P}_k),
+ * \f}
+ * where \f$\lambda\f$ is the forgetting factor and \f$\mathbf{S}\f$ is the
+ * covariance matrix.
+ *
+ * All matrices are stored in contiguous and aligned row-major buffers which
+ * are allocated only when the dimensions change, so that estimating does not
+ * perform any memory allocation.
+ * The covariance matrix is stored together with a scale factor, so that the
+ * division by \f$\lambda\f$ does not need to touch the whole matrix.
+ * This allows sparse regressors to be processed by only updating the entries
+ * of the covariance matrix that really change (see
+ * estimate(const SparseVector<ValueT>&, const ValueT*, ValueT*)).
+ *
+ * References
+ * -# J.-S.R. Jang, "ANFIS: Adaptive-Network-based Fuzzy Inference Systems," IEEE Transactions on Systems, Man, and Cybernetics, 23(3):665-685, 1993.
+ * .
+ *
+ * \tparam ValueT The type for floating-point numbers
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
 template <typename ValueT>
 class KalmanFilter
 {
 public:
-	KalmanFilter(std::size_t p, std::size_t nin, std::size_t nout, ValueT lambda = 0.98)
-	: p_(p),
-	  in_n_(nin),
-	  out_n_(nout),
-	  lambda_(lambda),
-	  S_(0),
-	  P_(0),
-	  a_(0),
-	  b_(0),
-	  a_t_(0),
-	  b_t_(0),
-	  tmp1_(0),
-	  tmp2_(0),
-	  tmp3_(0),
-	  tmp4_(0),
-	  tmp5_(0),
-	  tmp6_(0),
-	  tmp7_(0)
-	{
-		allocateMemory();
-	}
-
-	~KalmanFilter()
-	{
-		deallocateMemory();
-	}
-
-	void reset(ValueT alpha = 1e+6)
-	{
-		reallocateMemory();
-
-		// reset S and P
-		for (std::size_t i = 0; i < in_n_; ++i)
-		{
-			for (std::size_t j = 0; j < out_n_; ++j)
-			{
-				P_[i][j] = 0;
-			}
-		}
-		for (std::size_t i = 0; i < in_n_; ++i)
-		{
-			for (std::size_t j = 0; j < in_n_; ++j)
-			{
-				if (i == j)
-				{
-					S_[i][j] = alpha; 
-				}
-				else
-				{
-					S_[i][j] = 0;
-				}
-			}
-		}
-	}
-
-	template <typename InIterT, typename OutIterT>
-	std::vector<ValueT> estimate(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast)
-	{
-		ValueT* in = new ValueT[in_n_];
-		std::copy(inFirst, inLast, in);
-
-		ValueT* out = new ValueT[out_n_];
-		std::copy(outFirst, outLast, out);
-
-		std::vector<ValueT> ret;
-
-		ret = this->estimate(in, out);
-
-		delete[] out;
-		delete[] in;
-
-		return ret;
-	}
-
-	std::vector<ValueT> estimate(ValueT* in, ValueT* out)
-	{
-		std::vector<ValueT> ret(out_n_);
-
-		for (std::size_t i = 0; i < in_n_; ++i)
-		{
-			a_[i][0] = in[i];
-		}
-
-		for (std::size_t i = 0; i < out_n_; ++i)
-		{
-			b_[i][0] = out[i];
-		}
-
-		transposeM(a_, in_n_, 1, a_t_);
-		transposeM(b_, out_n_, 1, b_t_);
-
-		/* recursive formulas for S, covariance matrix */
-		anfisMtimesM(S_, a_, in_n_, in_n_, 1, tmp1_);
-		anfisMtimesM(a_t_, tmp1_, 1, in_n_, 1, tmp2_);
-		ValueT denom = lambda_ + tmp2_[0][0];
-		anfisMtimesM(a_t_, S_, 1, in_n_, in_n_, tmp3_);
-		anfisMtimesM(tmp1_, tmp3_, in_n_, 1, in_n_, tmp4_);
-		anfisStimesM(1/denom, tmp4_, in_n_, in_n_, tmp4_);
-		anfisMminusM(S_, tmp4_, in_n_, in_n_, S_);
-		anfisStimesM(1/lambda_, S_, in_n_, in_n_, S_);
-//std::cerr << "KAL - Covariance Matrix ="; fl::detail::MatrixOutput(std::cerr, S_, in_n_, in_n_); std::cerr << std::endl;//XXX
-
-		// Compute the output estimate
-		anfisMtimesM(a_t_, P_, 1, in_n_, out_n_, tmp5_);
-		std::copy(tmp5_[0], tmp5_[0]+out_n_, ret.begin());
-
-		/* recursive formulas for P, the estimated parameter matrix */
-		anfisMtimesM(a_t_, P_, 1, in_n_, out_n_, tmp5_);
-		anfisMminusM(b_t_, tmp5_, 1, out_n_, tmp5_);
-		anfisMtimesM(a_, tmp5_, in_n_, 1, out_n_, tmp6_);
-		anfisMtimesM(S_, tmp6_, in_n_, in_n_, out_n_, tmp7_);
-		anfisMplusM(P_, tmp7_, in_n_, out_n_, P_);
-
-		return ret;
-	}
-
-	std::vector< std::vector<ValueT> > getEstimatedParameters() const
-	{
-		std::vector< std::vector<ValueT> > ret(in_n_);
-		for (std::size_t i = 0; i < in_n_; ++i)
-		{
-			ret[i].resize(out_n_);
-			std::copy(P_[i], P_[i]+out_n_, ret[i].begin());
-		}
-		return ret;
-	}
-
-	std::vector< std::vector<ValueT> > getCovarianceInverse() const
-	{
-		std::vector< std::vector<ValueT> > ret(in_n_);
-		for (std::size_t i = 0; i < in_n_; ++i)
-		{
-			ret[i].resize(in_n_);
-			std::copy(S_[i], S_[i]+in_n_, ret[i].begin());
-		}
-		return ret;
-	}
-
-	std::vector<ValueT> getRegressor() const
-	{
-		std::vector<ValueT> ret(in_n_);
-		for (std::size_t i = 0; i < in_n_; ++i)
-		{
-			ret[i] = a_[i][0];
-		}
-		return ret;
-	}
-
-	void setModelOrder(std::size_t p)
-	{
-		p_ = p+1;
-	}
-
-	std::size_t getModelOrder() const
-	{
-		if (p_ == 0)
-		{
-			return 0;
-		}
-		return p_-1;
-	}
-
-	void setInputDimension(std::size_t n)
-	{
-		in_n_ = n;
-	}
-
-	std::size_t getInputDimension() const
-	{
-		return in_n_;
-	}
-
-	void setOutputDimension(std::size_t n)
-	{
-		out_n_ = n;
-	}
-
-	std::size_t getOutputDimension() const
-	{
-		return out_n_;
-	}
-
-	void setForgettingFactor(ValueT value)
-	{
-		lambda_ = value;
-	}
-
-	ValueT getForgettingFactor() const
-	{
-		return lambda_;
-	}
+    /// Default constructor
+    KalmanFilter();
+
+    /// Constructs a filter where \a p is the model order, \a nin is the regressor dimension, \a nout is the output dimension and \a lambda is the forgetting factor
+    KalmanFilter(std::size_t p, std::size_t nin, std::size_t nout, ValueT lambda = 0.98);
+
+    /// Sets the order of the model
+    void setModelOrder(std::size_t p);
+
+    /// Gets the order of the model
+    std::size_t getModelOrder() const;
+
+    /// Sets the size of the regressor vector
+    void setInputDimension(std::size_t n);
+
+    /// Gets the size of the regressor vector
+    std::size_t getInputDimension() const;
+
+    /// Sets the size of the output vector
+    void setOutputDimension(std::size_t n);
+
+    /// Gets the size of the output vector
+    std::size_t getOutputDimension() const;
+
+    /// Sets the forgetting factor
+    void setForgettingFactor(ValueT value);
+
+    /// Gets the forgetting factor
+    ValueT getForgettingFactor() const;
+
+    /// Gets the covariance matrix
+    std::vector< std::vector<ValueT> > getCovarianceInverse() const;
+
+    /// Gets the last regressor vector
+    std::vector<ValueT> getRegressor() const;
+
+    /// Gets the matrix of estimated parameters
+    std::vector< std::vector<ValueT> > getEstimatedParameters() const;
+
+    /// Gets the total number of iterations performed to date
+    std::size_t numberOfIterations() const;
+
+    /// Resets the filter, setting the covariance matrix to \a alpha times the identity matrix
+    void reset(ValueT alpha = 1e+6);
+
+    /// Performs an iteration of the filter with respect to the given regressor and output, and returns the output estimated before the update
+    template <typename InIterT, typename OutIterT>
+    std::vector<ValueT> estimate(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast);
+
+    /**
+     * Performs an iteration of the filter with respect to the given regressor
+     * and output, and stores the output estimated before the update into the
+     * range starting at \a yhatFirst.
+     *
+     * This variant does not allocate memory.
+     */
+    template <typename InIterT, typename OutIterT, typename YHatIterT>
+    void estimate(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast, YHatIterT yhatFirst);
+
+    /// Performs an iteration of the filter with respect to the given regressor and output, and returns the output estimated before the update
+    std::vector<ValueT> estimate(const ValueT* in, const ValueT* out);
+
+    /**
+     * Performs an iteration of the filter with respect to the given regressor
+     * and output.
+     *
+     * If \a yhat is not null, it is filled with the output estimated before
+     * the update.
+     * This variant does not allocate memory.
+     */
+    void estimate(const ValueT* in, const ValueT* out, ValueT* yhat);
+
+    /**
+     * Performs an iteration of the filter for each of the \a n given samples.
+     *
+     * Regressors and outputs are stored by rows in \a in (a \f$n \times nin\f$
+     * matrix) and in \a out (a \f$n \times nout\f$ matrix), respectively.
+     * If \a yhat is not null, its i-th row (of size \f$nout\f$) is filled with
+     * the output estimated for the i-th sample before its update.
+     *
+     * The result is the same of calling estimate() for each sample, but
+     * without any memory allocation nor any per-sample overhead.
+     */
+    void estimateBatch(const ValueT* in, const ValueT* out, std::size_t n, ValueT* yhat = 0);
+
+    /// Performs an iteration of the filter with respect to the given sparse regressor and output, and returns the output estimated before the update
+    std::vector<ValueT> estimate(const SparseVector<ValueT>& in, const ValueT* out);
+
+    /**
+     * Performs an iteration of the filter with respect to the given sparse
+     * regressor and output.
+     *
+     * The result is the same of the dense update, but the cost is
+     * \f$O(n q + g^2)\f$ instead of \f$O(n^2)\f$, where \f$q\f$ is the
+     * number of nonzero elements of the regressor and \f$g\f$ is the number
+     * of nonzero elements of the gain vector.
+     * The latter only involves the parameters that have been excited
+     * together with the ones of the current regressor, which is typically a
+     * small number when regressors come from localized rules.
+     *
+     * If \a yhat is not null, it is filled with the output estimated before
+     * the update.
+     */
+    void estimate(const SparseVector<ValueT>& in, const ValueT* out, ValueT* yhat);
 
 
 private:
-	void allocateMemory()
-	{
-		if (in_n_ > 0 && out_n_ > 0)
-		{
-			S_ = createMatrix(in_n_, in_n_);
-			P_ = createMatrix(in_n_, out_n_);
-			a_ = createMatrix(in_n_, 1);
-			b_ = createMatrix(out_n_, 1);
-			a_t_ = createMatrix(1, in_n_);
-			b_t_ = createMatrix(1, out_n_);
-			tmp1_ = createMatrix(in_n_, 1);
-			tmp2_ = createMatrix(1, 1);
-			tmp3_ = createMatrix(1, in_n_);
-			tmp4_ = createMatrix(in_n_, in_n_);
-			tmp5_ = createMatrix(1, out_n_);
-			tmp6_ = createMatrix(in_n_, out_n_);
-			tmp7_ = createMatrix(in_n_, out_n_);
-		}
-	}
-
-	void deallocateMemory()
-	{
-		destroyMatrix(S_, in_n_, in_n_);
-		S_ = 0;
-		destroyMatrix(P_, in_n_, out_n_);
-		P_ = 0;
-		destroyMatrix(a_, in_n_, 1);
-		a_ = 0;
-		destroyMatrix(b_, out_n_, 1);
-		b_ = 0;
-		destroyMatrix(a_t_, 1, in_n_);
-		a_t_ = 0;
-		destroyMatrix(b_t_, 1, out_n_);
-		b_t_ = 0;
-		destroyMatrix(tmp1_, in_n_, 1);
-		tmp1_ = 0;
-		destroyMatrix(tmp2_, 1, 1);
-		tmp2_ = 0;
-		destroyMatrix(tmp3_, 1, in_n_);
-		tmp3_ = 0;
-		destroyMatrix(tmp4_, in_n_, in_n_);
-		tmp4_ = 0;
-		destroyMatrix(tmp5_, 1, out_n_);
-		tmp5_ = 0;
-		destroyMatrix(tmp6_, in_n_, out_n_);
-		tmp6_ = 0;
-		destroyMatrix(tmp7_, in_n_, out_n_);
-		tmp7_ = 0;
-	}
-
-	void reallocateMemory()
-	{
-		deallocateMemory();
-		allocateMemory();
-	}
-
-	static ValueT** createMatrix(std::size_t nrows, std::size_t ncols)
-	{
-		ValueT** tmp = new ValueT*[nrows];
-		for (std::size_t i = 0; i < nrows; ++i)
-		{
-			tmp[i] = new ValueT[ncols];
-		}
-		return tmp;
-	}
-
-	static void destroyMatrix(ValueT** m, std::size_t nrows, std::size_t ncols)
-	{
-		(void) ncols;
-		if (m)
-		{
-			for (std::size_t i = 0; i < nrows; ++i)
-			{
-				if (m[i])
-				{
-					delete[] m[i];
-				}
-			}
-			delete[] m;
-		}
-	}
-
-	/* matrix plus matrix */
-	static void anfisMplusM(ValueT **m1, ValueT **m2, std::size_t row, std::size_t col, ValueT **out)
-	{
-		for (std::size_t i = 0; i < row; ++i)
-			for (std::size_t j = 0; j < col; ++j)
-				out[i][j] = m1[i][j] + m2[i][j];
-	}
-
-	/* matrix minus matrix */
-	static void anfisMminusM(ValueT **m1, ValueT **m2, std::size_t row, std::size_t col, ValueT **out)
-	{
-		for (std::size_t i = 0; i < row; ++i)
-			for (std::size_t j = 0; j < col; ++j)
-				out[i][j] = m1[i][j] - m2[i][j];
-	}
-
-	/* matrix times matrix */
-	static void anfisMtimesM(ValueT **m1, ValueT **m2, std::size_t row1, std::size_t col1, std::size_t col2, ValueT **out)
-	{
-		for (std::size_t i = 0; i < row1; ++i)
-			for (std::size_t j = 0; j < col2; ++j) {
-				out[i][j] = 0;
-				for (std::size_t k = 0; k < col1; ++k)
-					out[i][j] += m1[i][k]* m2[k][j];
-			}
-	}
-
-	/* scalar times matrix */
-	static void anfisStimesM(ValueT c, ValueT **m, std::size_t row, std::size_t col, ValueT **out)
-	{
-		for (std::size_t i = 0; i < row; ++i)
-			for (std::size_t j = 0; j < col; ++j)
-				out[i][j] = c*m[i][j];
-	}
-
-	/* matrix transpose */
-	static void transposeM(ValueT **m, std::size_t row, std::size_t col, ValueT **m_t)
-	{
-		for (std::size_t i = 0; i < row; ++i)
-			for (std::size_t j = 0; j < col; ++j)
-				m_t[j][i] = m[i][j];
-	}
-
-	/* matrix L-2 norm */
-	static ValueT matrixNorm(ValueT **m, std::size_t row, std::size_t col)
-	{
-		ValueT total = 0;
-
-		for (std::size_t i = 0; i < col; ++i)
-			for (std::size_t j = 0; j < row; ++j)
-				total += m[i][j]*m[i][j];
-		return(std::sqrt(total));
-	}
+    /// Resizes the internal buffers according to the current dimensions
+    void allocate();
+
+    /// Performs an iteration of the filter on the regressor and output currently stored in a_ and b_
+    void update(ValueT* yhat);
+
+    /// Folds the scale factor into the covariance matrix when it gets too large or too small
+    void normalizeScale();
 
 
 private:
-	std::size_t p_; ///< Model order
-	std::size_t in_n_; ///< Number of inputs
-	std::size_t out_n_; ///< Number of outputs
-	ValueT lambda_; ///< Forgetting factor
-	ValueT** S_; ///< Inverse covariance matrix
-	ValueT** P_; ///< Parameters matrix
-	ValueT** a_; ///< Regressor vector
-	ValueT** b_; ///< Output vector
-	ValueT** a_t_; ///< Transpose of regressor vector
-	ValueT** b_t_; ///< Transpose of output vector
-	ValueT** tmp1_;
-	ValueT** tmp2_;
-	ValueT** tmp3_;
-	ValueT** tmp4_;
-	ValueT** tmp5_;
-	ValueT** tmp6_;
-	ValueT** tmp7_;
+    std::size_t p_; ///< Model order
+    std::size_t in_n_; ///< Number of inputs (regressor dimension)
+    std::size_t out_n_; ///< Number of outputs
+    ValueT lambda_; ///< Forgetting factor
+    AlignedArray<ValueT> S_; ///< Unscaled covariance matrix (in_n_ x in_n_, row-major)
+    ValueT scale_; ///< Scale factor of the covariance matrix (the covariance matrix is scale_*S_)
+    AlignedArray<ValueT> P_; ///< Parameters matrix (in_n_ x out_n_, row-major)
+    AlignedArray<ValueT> a_; ///< Regressor vector
+    AlignedArray<ValueT> b_; ///< Output vector
+    AlignedArray<ValueT> g_; ///< Auxiliary vector for the gain S*a
+    AlignedArray<ValueT> e_; ///< Auxiliary vector for the a-priori error
+    AlignedArray<ValueT> yhat_; ///< Auxiliary vector for the estimated output
+    AlignedArray<std::size_t> support_; ///< Auxiliary vector for the positions of the nonzero elements of the gain
+    std::size_t count_; ///< The total number of iterations performed so far
 }; // KalmanFilter
 
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+template <typename ValueT>
+KalmanFilter<ValueT>::KalmanFilter()
+: p_(0),
+  in_n_(0),
+  out_n_(0),
+  lambda_(0.98),
+  scale_(1),
+  count_(0)
+{
+}
+
+template <typename ValueT>
+KalmanFilter<ValueT>::KalmanFilter(std::size_t p, std::size_t nin, std::size_t nout, ValueT lambda)
+: p_(p),
+  in_n_(nin),
+  out_n_(nout),
+  lambda_(lambda),
+  scale_(1),
+  count_(0)
+{
+    this->allocate();
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::setModelOrder(std::size_t p)
+{
+    p_ = p+1;
+}
+
+template <typename ValueT>
+std::size_t KalmanFilter<ValueT>::getModelOrder() const
+{
+    if (p_ == 0)
+    {
+        return 0;
+    }
+
+    return p_-1;
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::setInputDimension(std::size_t n)
+{
+    in_n_ = n;
+}
+
+template <typename ValueT>
+std::size_t KalmanFilter<ValueT>::getInputDimension() const
+{
+    return in_n_;
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::setOutputDimension(std::size_t n)
+{
+    out_n_ = n;
+}
+
+template <typename ValueT>
+std::size_t KalmanFilter<ValueT>::getOutputDimension() const
+{
+    return out_n_;
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::setForgettingFactor(ValueT value)
+{
+    lambda_ = value;
+}
+
+template <typename ValueT>
+ValueT KalmanFilter<ValueT>::getForgettingFactor() const
+{
+    return lambda_;
+}
+
+template <typename ValueT>
+std::vector< std::vector<ValueT> > KalmanFilter<ValueT>::getCovarianceInverse() const
+{
+    std::vector< std::vector<ValueT> > ret(in_n_);
+    for (std::size_t i = 0; i < in_n_; ++i)
+    {
+        ret[i].assign(S_.begin()+i*in_n_, S_.begin()+(i+1)*in_n_);
+        for (std::size_t j = 0; j < in_n_; ++j)
+        {
+            ret[i][j] *= scale_;
+        }
+    }
+
+    return ret;
+}
+
+template <typename ValueT>
+std::vector<ValueT> KalmanFilter<ValueT>::getRegressor() const
+{
+    return std::vector<ValueT>(a_.begin(), a_.end());
+}
+
+template <typename ValueT>
+std::vector< std::vector<ValueT> > KalmanFilter<ValueT>::getEstimatedParameters() const
+{
+    std::vector< std::vector<ValueT> > ret(in_n_);
+    for (std::size_t i = 0; i < in_n_; ++i)
+    {
+        ret[i].assign(P_.begin()+i*out_n_, P_.begin()+(i+1)*out_n_);
+    }
+
+    return ret;
+}
+
+template <typename ValueT>
+std::size_t KalmanFilter<ValueT>::numberOfIterations() const
+{
+    return count_;
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::reset(ValueT alpha)
+{
+    this->allocate();
+
+    std::fill(P_.begin(), P_.end(), ValueT(0));
+    std::fill(S_.begin(), S_.end(), ValueT(0));
+    for (std::size_t i = 0; i < in_n_; ++i)
+    {
+        S_[i*in_n_+i] = alpha;
+    }
+    scale_ = 1;
+    std::fill(a_.begin(), a_.end(), ValueT(0));
+
+    count_ = 0;
+}
+
+template <typename ValueT>
+template <typename InIterT, typename OutIterT>
+std::vector<ValueT> KalmanFilter<ValueT>::estimate(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast)
+{
+    std::vector<ValueT> yhat(out_n_);
+
+    this->estimate(inFirst, inLast, outFirst, outLast, yhat.begin());
+
+    return yhat;
+}
+
+template <typename ValueT>
+template <typename InIterT, typename OutIterT, typename YHatIterT>
+void KalmanFilter<ValueT>::estimate(InIterT inFirst, InIterT inLast, OutIterT outFirst, OutIterT outLast, YHatIterT yhatFirst)
+{
+    if (static_cast<std::size_t>(std::distance(inFirst, inLast)) != in_n_)
+    {
+        FL_THROW2(std::invalid_argument, "Input dimension does not match");
+    }
+    if (static_cast<std::size_t>(std::distance(outFirst, outLast)) != out_n_)
+    {
+        FL_THROW2(std::invalid_argument, "Output dimension does not match");
+    }
+
+    std::copy(inFirst, inLast, a_.begin());
+    std::copy(outFirst, outLast, b_.begin());
+
+    this->update(yhat_.data());
+
+    std::copy(yhat_.begin(), yhat_.end(), yhatFirst);
+}
+
+template <typename ValueT>
+std::vector<ValueT> KalmanFilter<ValueT>::estimate(const ValueT* in, const ValueT* out)
+{
+    std::vector<ValueT> yhat(out_n_);
+
+    this->estimate(in, out, out_n_ > 0 ? &yhat[0] : 0);
+
+    return yhat;
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::estimate(const ValueT* in, const ValueT* out, ValueT* yhat)
+{
+    std::copy(in, in+in_n_, a_.begin());
+    std::copy(out, out+out_n_, b_.begin());
+
+    this->update(yhat);
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::estimateBatch(const ValueT* in, const ValueT* out, std::size_t n, ValueT* yhat)
+{
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        this->estimate(in+k*in_n_, out+k*out_n_, yhat ? yhat+k*out_n_ : 0);
+    }
+}
+
+template <typename ValueT>
+std::vector<ValueT> KalmanFilter<ValueT>::estimate(const SparseVector<ValueT>& in, const ValueT* out)
+{
+    std::vector<ValueT> yhat(out_n_);
+
+    this->estimate(in, out, out_n_ > 0 ? &yhat[0] : 0);
+
+    return yhat;
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::estimate(const SparseVector<ValueT>& in, const ValueT* out, ValueT* yhat)
+{
+    if (in.size() != in_n_)
+    {
+        FL_THROW2(std::invalid_argument, "Input dimension does not match");
+    }
+    if (S_.size() != in_n_*in_n_ || P_.size() != in_n_*out_n_)
+    {
+        FL_THROW2(std::logic_error, "Kalman filter has not been reset after a change of dimensions");
+    }
+
+    ++count_;
+
+    const std::size_t n = in_n_;
+    const std::size_t m = out_n_;
+    const std::size_t nnz = in.numOfNonZeros();
+    ValueT* S = S_.data();
+    ValueT* P = P_.data();
+    ValueT* g = g_.data();
+    ValueT* e = e_.data();
+    std::size_t* supp = support_.data();
+
+    // Keep track of the last regressor
+    std::fill(a_.begin(), a_.end(), ValueT(0));
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        a_[in.index(k)] = in.value(k);
+    }
+
+    // g = S*a = scale*sum_k a_k*S(k,:) (S is symmetric), only over the nonzero elements of a
+    std::fill(g, g+n, ValueT(0));
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        const ValueT* Sk = S+in.index(k)*n;
+        const ValueT ak = in.value(k);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            g[i] += ak*Sk[i];
+        }
+    }
+    std::size_t nsupp = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (g[i] != 0)
+        {
+            g[i] *= scale_;
+            supp[nsupp++] = i;
+        }
+    }
+
+    // denom = lambda + a'*S*a
+    ValueT denom = lambda_;
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        denom += in.value(k)*g[in.index(k)];
+    }
+
+    // S = (S - g*g'/denom)/lambda, where only the entries in the support of g change
+    const ValueT invDenom = ValueT(1)/denom;
+    const ValueT c = invDenom/scale_;
+    for (std::size_t k1 = 0; k1 < nsupp; ++k1)
+    {
+        const std::size_t i = supp[k1];
+        ValueT* Si = S+i*n;
+        const ValueT gi = g[i]*c;
+        for (std::size_t k2 = 0; k2 < nsupp; ++k2)
+        {
+            const std::size_t j = supp[k2];
+            Si[j] -= gi*g[j];
+        }
+    }
+    scale_ /= lambda_;
+
+    // e = b - P'*a (the a-priori estimation error)
+    std::fill(e, e+m, ValueT(0));
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        const ValueT* Pi = P+in.index(k)*m;
+        const ValueT ai = in.value(k);
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            e[j] += ai*Pi[j];
+        }
+    }
+    if (yhat)
+    {
+        std::copy(e, e+m, yhat);
+    }
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        e[j] = out[j] - e[j];
+    }
+
+    // P = P + S_new*a*e', where S_new*a = g/denom
+    for (std::size_t k = 0; k < nsupp; ++k)
+    {
+        const std::size_t i = supp[k];
+        ValueT* Pi = P+i*m;
+        const ValueT gi = g[i]*invDenom;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            Pi[j] += gi*e[j];
+        }
+    }
+
+    this->normalizeScale();
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::allocate()
+{
+    S_.resize(in_n_*in_n_);
+    P_.resize(in_n_*out_n_);
+    a_.resize(in_n_);
+    b_.resize(out_n_);
+    g_.resize(in_n_);
+    e_.resize(out_n_);
+    yhat_.resize(out_n_);
+    support_.resize(in_n_);
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::update(ValueT* yhat)
+{
+    if (S_.size() != in_n_*in_n_ || P_.size() != in_n_*out_n_)
+    {
+        FL_THROW2(std::logic_error, "Kalman filter has not been reset after a change of dimensions");
+    }
+
+    ++count_;
+
+    const std::size_t n = in_n_;
+    const std::size_t m = out_n_;
+    const ValueT* a = a_.data();
+    ValueT* S = S_.data();
+    ValueT* P = P_.data();
+    ValueT* g = g_.data();
+    ValueT* e = e_.data();
+
+    // g = S*a and denom = lambda + a'*S*a
+    ValueT denom = lambda_;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const ValueT* Si = S+i*n;
+        ValueT s = 0;
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            s += Si[j]*a[j];
+        }
+        g[i] = scale_*s;
+        denom += a[i]*g[i];
+    }
+
+    // S = (S - g*g'/denom)/lambda (S is symmetric, hence a'*S = g')
+    // The division by lambda is deferred to the scale factor
+    const ValueT invDenom = ValueT(1)/denom;
+    const ValueT c = invDenom/scale_;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        ValueT* Si = S+i*n;
+        const ValueT gi = g[i]*c;
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            Si[j] -= gi*g[j];
+        }
+    }
+    scale_ /= lambda_;
+
+    // e = b - P'*a (the a-priori estimation error)
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        e[j] = 0;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const ValueT* Pi = P+i*m;
+        const ValueT ai = a[i];
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            e[j] += ai*Pi[j];
+        }
+    }
+    if (yhat)
+    {
+        std::copy(e, e+m, yhat);
+    }
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        e[j] = b_[j] - e[j];
+    }
+
+    // P = P + S_new*a*e', where S_new*a = g/denom
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        ValueT* Pi = P+i*m;
+        const ValueT gi = g[i]*invDenom;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            Pi[j] += gi*e[j];
+        }
+    }
+
+    this->normalizeScale();
+}
+
+template <typename ValueT>
+void KalmanFilter<ValueT>::normalizeScale()
+{
+    // Bounds are kept well inside the range of single-precision numbers
+    const ValueT maxScale = 1e+16;
+    const ValueT minScale = 1e-16;
+
+    if (scale_ > maxScale || scale_ < minScale)
+    {
+        for (std::size_t i = 0,
+                         ni = S_.size();
+             i < ni;
+             ++i)
+        {
+            S_[i] *= scale_;
+        }
+        scale_ = 1;
+    }
+}
+
 }} // Namespace fl::detail
 
+
 #endif // FL_DETAIL_KALMAN_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
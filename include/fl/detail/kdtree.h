@@ -0,0 +1,345 @@
+/**
+ * \file fl/detail/kdtree.h
+ *
+ * \brief A k-d tree for range queries over points stored dimension-major
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_KDTREE_H
+#define FL_DETAIL_KDTREE_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <fl/macro.h>
+#include <vector>
+
+
+namespace fl { namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+/// Declarations
+////////////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * A k-d tree whose leaves are contiguous ranges of points.
+ *
+ * The tree does not store the points: it only computes a permutation of
+ * them such that the points of each leaf are consecutive.
+ * Callers are expected to reorder their data according to permutation(), so
+ * that the points of a leaf can be processed by kernels working on
+ * contiguous memory.
+ *
+ * Points are split at the median of the dimension with the widest extent and
+ * each node keeps the tight bounding box of its points, which is used to
+ * prune range queries.
+ *
+ * \tparam ValueT The type for floating-point numbers
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class KdTree
+{
+public:
+    /// The default maximum number of points in a leaf
+    static const std::size_t DefaultLeafSize = 32;
+
+
+    /// Constructs an empty tree
+    KdTree();
+
+    /**
+     * Builds the tree over the \a n points of dimension \a d stored
+     * dimension-major in \a X (i.e., the \f$j\f$-th component of the
+     * \f$i\f$-th point is <code>X[j*n+i]</code>).
+     */
+    void build(const ValueT* X, std::size_t n, std::size_t d, std::size_t leafSize = DefaultLeafSize);
+
+    /// Returns the number of indexed points
+    std::size_t size() const;
+
+    /// Returns the dimension of the indexed points
+    std::size_t dimension() const;
+
+    /// Returns the permutation mapping positions in tree order to the original positions of points
+    const std::vector<std::size_t>& permutation() const;
+
+    /// Returns the number of leaves
+    std::size_t numOfLeaves() const;
+
+    /// Returns the position (in tree order) of the first point of the \a l-th leaf
+    std::size_t leafBegin(std::size_t l) const;
+
+    /// Returns the position (in tree order) one past the last point of the \a l-th leaf
+    std::size_t leafEnd(std::size_t l) const;
+
+    /**
+     * Appends to \a leaves the leaves whose bounding box has a squared
+     * distance from the point \a c not greater than \a r2.
+     *
+     * All the points within that distance from \a c are guaranteed to belong
+     * to one of the returned leaves.
+     */
+    void findLeaves(const ValueT* c, ValueT r2, std::vector<std::size_t>& leaves) const;
+
+
+private:
+    /// A node of the tree
+    struct Node
+    {
+        std::size_t begin; ///< Position of the first point of this node
+        std::size_t end; ///< Position one past the last point of this node
+        std::size_t left; ///< The left child (0 for leaves)
+        std::size_t right; ///< The right child (0 for leaves)
+        std::size_t leaf; ///< The leaf number (only meaningful for leaves)
+    };
+
+    /// Compares two points according to one of their components
+    struct ComponentLess
+    {
+        ComponentLess(const ValueT* Xj) : Xj_(Xj) {}
+        bool operator()(std::size_t a, std::size_t b) const { return Xj_[a] < Xj_[b]; }
+        const ValueT* Xj_; ///< The component of all the points
+    };
+
+    /// Recursively builds the subtree for the points in [\a begin, \a end) and returns its node
+    std::size_t buildNode(const ValueT* X, std::size_t begin, std::size_t end);
+
+    /// Returns the squared distance between the point \a c and the bounding box of node \a k
+    ValueT boxDistanceSq(std::size_t k, const ValueT* c) const;
+
+
+private:
+    std::size_t n_; ///< The number of points
+    std::size_t d_; ///< The dimension of points
+    std::size_t leafSize_; ///< The maximum number of points in a leaf
+    std::vector<std::size_t> perm_; ///< The positions of points in tree order
+    std::vector<Node> nodes_; ///< The nodes (the root is the first one)
+    std::vector<ValueT> lo_; ///< Lower corners of node bounding boxes (d_ per node)
+    std::vector<ValueT> hi_; ///< Upper corners of node bounding boxes (d_ per node)
+    std::vector<std::size_t> leafNodes_; ///< The node of each leaf
+}; // KdTree
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename ValueT>
+const std::size_t KdTree<ValueT>::DefaultLeafSize;
+
+template <typename ValueT>
+KdTree<ValueT>::KdTree()
+: n_(0),
+  d_(0),
+  leafSize_(DefaultLeafSize)
+{
+}
+
+template <typename ValueT>
+void KdTree<ValueT>::build(const ValueT* X, std::size_t n, std::size_t d, std::size_t leafSize)
+{
+    n_ = n;
+    d_ = d;
+    leafSize_ = std::max(leafSize, std::size_t(1));
+
+    perm_.resize(n_);
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        perm_[i] = i;
+    }
+
+    nodes_.clear();
+    lo_.clear();
+    hi_.clear();
+    leafNodes_.clear();
+
+    if (n_ > 0)
+    {
+        const std::size_t maxNodes = 2*((n_+leafSize_-1)/leafSize_)+1;
+        nodes_.reserve(maxNodes);
+        lo_.reserve(maxNodes*d_);
+        hi_.reserve(maxNodes*d_);
+
+        this->buildNode(X, 0, n_);
+    }
+}
+
+template <typename ValueT>
+std::size_t KdTree<ValueT>::buildNode(const ValueT* X, std::size_t begin, std::size_t end)
+{
+    const std::size_t k = nodes_.size();
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.left = node.right = node.leaf = 0;
+    nodes_.push_back(node);
+
+    // Computes the bounding box and finds its widest dimension
+    lo_.resize(lo_.size()+d_);
+    hi_.resize(hi_.size()+d_);
+    std::size_t split = 0;
+    ValueT maxWidth = -1;
+    for (std::size_t j = 0; j < d_; ++j)
+    {
+        const ValueT* Xj = X+j*n_;
+        ValueT lo = Xj[perm_[begin]];
+        ValueT hi = lo;
+        for (std::size_t p = begin+1; p < end; ++p)
+        {
+            lo = std::min(lo, Xj[perm_[p]]);
+            hi = std::max(hi, Xj[perm_[p]]);
+        }
+        lo_[k*d_+j] = lo;
+        hi_[k*d_+j] = hi;
+        if (hi-lo > maxWidth)
+        {
+            maxWidth = hi-lo;
+            split = j;
+        }
+    }
+
+    if (end-begin <= leafSize_ || maxWidth <= 0)
+    {
+        nodes_[k].leaf = leafNodes_.size();
+        leafNodes_.push_back(k);
+        return k;
+    }
+
+    const std::size_t mid = begin+(end-begin)/2;
+    std::nth_element(perm_.begin()+begin, perm_.begin()+mid, perm_.begin()+end, ComponentLess(X+split*n_));
+
+    const std::size_t left = this->buildNode(X, begin, mid);
+    const std::size_t right = this->buildNode(X, mid, end);
+    nodes_[k].left = left;
+    nodes_[k].right = right;
+
+    return k;
+}
+
+template <typename ValueT>
+std::size_t KdTree<ValueT>::size() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+std::size_t KdTree<ValueT>::dimension() const
+{
+    return d_;
+}
+
+template <typename ValueT>
+const std::vector<std::size_t>& KdTree<ValueT>::permutation() const
+{
+    return perm_;
+}
+
+template <typename ValueT>
+std::size_t KdTree<ValueT>::numOfLeaves() const
+{
+    return leafNodes_.size();
+}
+
+template <typename ValueT>
+std::size_t KdTree<ValueT>::leafBegin(std::size_t l) const
+{
+    FL_DEBUG_ASSERT( l < leafNodes_.size() );
+
+    return nodes_[leafNodes_[l]].begin;
+}
+
+template <typename ValueT>
+std::size_t KdTree<ValueT>::leafEnd(std::size_t l) const
+{
+    FL_DEBUG_ASSERT( l < leafNodes_.size() );
+
+    return nodes_[leafNodes_[l]].end;
+}
+
+template <typename ValueT>
+ValueT KdTree<ValueT>::boxDistanceSq(std::size_t k, const ValueT* c) const
+{
+    const ValueT* lo = &lo_[k*d_];
+    const ValueT* hi = &hi_[k*d_];
+
+    ValueT distSq = 0;
+    for (std::size_t j = 0; j < d_; ++j)
+    {
+        ValueT diff = 0;
+        if (c[j] < lo[j])
+        {
+            diff = lo[j]-c[j];
+        }
+        else if (c[j] > hi[j])
+        {
+            diff = c[j]-hi[j];
+        }
+        distSq += diff*diff;
+    }
+
+    return distSq;
+}
+
+template <typename ValueT>
+void KdTree<ValueT>::findLeaves(const ValueT* c, ValueT r2, std::vector<std::size_t>& leaves) const
+{
+    if (nodes_.empty())
+    {
+        return;
+    }
+
+    // The depth of the tree is logarithmic in the number of points, so a
+    // small fixed-size stack is enough
+    std::size_t stack[128];
+    std::size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const std::size_t k = stack[--top];
+
+        if (this->boxDistanceSq(k, c) > r2)
+        {
+            continue;
+        }
+
+        const Node& node = nodes_[k];
+        if (node.left == 0)
+        {
+            leaves.push_back(node.leaf);
+        }
+        else
+        {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_KDTREE_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
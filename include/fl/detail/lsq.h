@@ -26,8 +26,12 @@
 #define FL_DETAIL_LSQ_H
 
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <fl/detail/arrays.h>
+#include <fl/detail/memory.h>
 #include <fl/macro.h>
 #include <iostream>
 #include <limits>
@@ -35,7 +39,6 @@
 #include <vector>
 
 #ifdef FLX_CONFIG_HAVE_LAPACK
-# include <algorithm>
 # ifdef FLX_CONFIG_HAVE_LAPACKE
 #  include <lapacke.h>
 # endif // FLX_CONFIG_HAVE_LAPACKE
@@ -55,6 +58,239 @@ std::vector<ValueT> LsqSolve(const MatrixT& A, const VectorT& b);
 template <typename ValueT, typename AMatrixT, typename BMatrixT>
 std::vector< std::vector<ValueT> > LsqSolveMulti(const AMatrixT& A, const BMatrixT& B);
 
+/**
+ * Solves the Tikhonov-regularized (ridge) least-squares problem
+ * \f$\min_{\mathbf{X}} \|\mathbf{A}\mathbf{X}-\mathbf{B}\|_2^2+\lambda\|\mathbf{X}\|_2^2\f$
+ * for the regularization parameter \f$\lambda\f$ in \a lambdas that
+ * minimizes the generalized cross-validation score.
+ *
+ * The coefficient matrix is factorized, and the right-hand side matrix is
+ * projected, only once for the whole grid.
+ * If \a pLambda is not null, it is set to the selected parameter.
+ */
+template <typename ValueT, typename AMatrixT, typename BMatrixT>
+std::vector< std::vector<ValueT> > LsqSolveMultiRidge(const AMatrixT& A, const BMatrixT& B, const std::vector<ValueT>& lambdas, ValueT* pLambda = 0);
+
+template <typename ValueT>
+class LsqSolverPlan;
+
+/// Same as above but solves through the given plan, whose buffers are reused if it already has the shape of the problem
+template <typename ValueT, typename AMatrixT, typename BMatrixT>
+std::vector< std::vector<ValueT> > LsqSolveMultiRidge(LsqSolverPlan<ValueT>& plan, const AMatrixT& A, const BMatrixT& B, const std::vector<ValueT>& lambdas, ValueT* pLambda = 0);
+
+/// Returns \a n regularization parameters logarithmically spaced between \a lo and \a hi (both included)
+template <typename ValueT>
+std::vector<ValueT> RidgeParameterGrid(ValueT lo, ValueT hi, std::size_t n);
+
+#if defined(FLX_CONFIG_HAVE_LAPACK) && !defined(FLX_CONFIG_HAVE_LAPACKE)
+typedef int lapack_int;
+typedef int lapack_logical;
+#endif // FLX_CONFIG_HAVE_LAPACK && !FLX_CONFIG_HAVE_LAPACKE
+
+template <class RealT>
+class SVDDecomposition;
+
+/**
+ * A reusable plan for solving least-squares problems of a fixed shape.
+ *
+ * A plan solves the (possibly rank-deficient) problem
+ * \f$\min_{\mathbf{X}} \|\mathbf{A}\mathbf{X}-\mathbf{B}\|_2\f$, where
+ * \f$\mathbf{A}\f$ is a \f$m \times n\f$ matrix and \f$\mathbf{B}\f$ is a
+ * \f$m \times nrhs\f$ matrix, through the singular value decomposition of
+ * \f$\mathbf{A}\f$.
+ *
+ * All the buffers (including the LAPACK workspace, whose optimal size is
+ * queried only once) are allocated when the shape of the problem is set and
+ * are then reused by every subsequent solve of the same shape.
+ * Furthermore, once \f$\mathbf{A}\f$ has been factorized, the problem can be
+ * solved for as many right-hand sides as needed without factorizing
+ * \f$\mathbf{A}\f$ again, and the projection \f$\mathbf{U}^T\mathbf{B}\f$
+ * of a right-hand side is computed only once for all the (plain or ridge)
+ * solves and scores that use it.
+ *
+ * Typical usage:
+ * \code
+ * LsqSolverPlan<double> plan(m, n, nrhs);
+ * for (...)
+ * {
+ *     plan.factorize(A);
+ *     X1 = plan.solve(B1);
+ *     X2 = plan.solve(B2); // Reuses the factorization of A
+ * }
+ * \endcode
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class LsqSolverPlan
+{
+public:
+    /// Constructs a plan for problems with a \a m by \a n coefficient matrix and \a nrhs right-hand sides
+    explicit LsqSolverPlan(std::size_t m = 0, std::size_t n = 0, std::size_t nrhs = 1);
+
+    /// Changes the shape of the problem; buffers are reallocated only if the shape really changes
+    void reshape(std::size_t m, std::size_t n, std::size_t nrhs);
+
+    /// Returns the number of rows of the coefficient matrix
+    std::size_t numOfRows() const;
+
+    /// Returns the number of columns of the coefficient matrix
+    std::size_t numOfColumns() const;
+
+    /// Returns the number of right-hand sides
+    std::size_t numOfRightHandSides() const;
+
+    /**
+     * Sets the relative threshold below which singular values are considered
+     * as zero.
+     *
+     * Singular values \f$s_i \le rcond \cdot s_1\f$ are treated as zero.
+     * If negative, a default based on expected roundoff error is used.
+     */
+    void setRCond(ValueT value);
+
+    /// Gets the relative threshold below which singular values are considered as zero
+    ValueT getRCond() const;
+
+    /**
+     * Returns the buffer for the coefficient matrix.
+     *
+     * The buffer stores the \f$m \times n\f$ matrix in column-major order
+     * with leading dimension \f$m\f$ and can be filled directly by the
+     * caller before calling factorize().
+     * Its content is destroyed by the factorization.
+     */
+    ValueT* matrixData();
+
+    /**
+     * Returns the buffer for the right-hand side matrix.
+     *
+     * The buffer stores the \f$m \times nrhs\f$ matrix in column-major
+     * order with leading dimension \f$\max(m,n)\f$ and can be filled
+     * directly by the caller before calling solve().
+     * After solve(), the first \f$n\f$ rows of each column hold the solution.
+     * Calling this function discards the projection of the previous
+     * right-hand sides.
+     */
+    ValueT* rhsData();
+
+    /// Returns the leading dimension of the right-hand side buffer
+    std::size_t rhsLeadingDimension() const;
+
+    /// Copies the given coefficient matrix into the plan and factorizes it
+    template <typename MatrixT>
+    void factorize(const MatrixT& A);
+
+    /// Factorizes the coefficient matrix currently stored in matrixData()
+    void factorize();
+
+    /// Tells if a coefficient matrix has been factorized
+    bool factorized() const;
+
+    /// Returns the effective rank of the last factorized coefficient matrix
+    std::size_t rank() const;
+
+    /// Solves the problem for the given right-hand side matrix, reusing the current factorization
+    template <typename MatrixT>
+    std::vector< std::vector<ValueT> > solve(const MatrixT& B);
+
+    /// Solves the problem for the right-hand sides currently stored in rhsData(), in place
+    void solve();
+
+    /// Factorizes \a A and solves the problem for the right-hand side matrix \a B
+    template <typename AMatrixT, typename BMatrixT>
+    std::vector< std::vector<ValueT> > solve(const AMatrixT& A, const BMatrixT& B);
+
+    /**
+     * Solves the ridge problem
+     * \f$\min_{\mathbf{X}} \|\mathbf{A}\mathbf{X}-\mathbf{B}\|_2^2+\lambda\|\mathbf{X}\|_2^2\f$
+     * for the given right-hand side matrix, reusing the current factorization.
+     *
+     * With the SVD \f$\mathbf{A}=\mathbf{U}\mathbf{S}\mathbf{V}^T\f$, the
+     * solution is \f$\mathbf{V}\mathbf{F}\mathbf{U}^T\mathbf{B}\f$, where
+     * \f$\mathbf{F}\f$ is diagonal with \f$F_{ii}=s_i/(s_i^2+\lambda)\f$.
+     * Thus, solving for a different \f$\lambda\f$ does not require a new
+     * factorization.
+     */
+    template <typename MatrixT>
+    std::vector< std::vector<ValueT> > solveRidge(const MatrixT& B, ValueT lambda);
+
+    /// Solves the ridge problem for the right-hand sides currently stored in rhsData(), in place
+    void solveRidge(ValueT lambda);
+
+    /**
+     * Computes the generalized cross-validation (GCV) score of the ridge
+     * solutions for the given right-hand side matrix and each of the given
+     * regularization parameters.
+     *
+     * The GCV score of \f$\lambda\f$ is
+     * \f$m\|\mathbf{A}\mathbf{X}_\lambda-\mathbf{B}\|_F^2/(m-\mathrm{df}(\lambda))^2\f$,
+     * where \f$\mathrm{df}(\lambda)=\sum_i s_i^2/(s_i^2+\lambda)\f$ are the
+     * effective degrees of freedom.
+     * Residuals are obtained from \f$\mathbf{U}^T\mathbf{B}\f$, which is
+     * computed once, so each parameter costs \f$O(\min(m,n) \cdot nrhs)\f$
+     * operations.
+     */
+    template <typename MatrixT>
+    std::vector<ValueT> ridgeGcvScores(const MatrixT& B, const std::vector<ValueT>& lambdas);
+
+    /// Computes the GCV scores for the right-hand sides currently stored in rhsData(), which are left untouched
+    std::vector<ValueT> ridgeGcvScores(const std::vector<ValueT>& lambdas);
+
+    /// Returns the solution stored in the right-hand side buffer by the last in-place solve
+    std::vector< std::vector<ValueT> > storedSolution() const;
+
+    /**
+     * Computes the mean squared error of the ridge solutions on the hold-out
+     * set \f$(\mathbf{A}_v,\mathbf{B}_v)\f$ for the given right-hand side
+     * matrix and each of the given regularization parameters.
+     *
+     * \f$\mathbf{A}_v\mathbf{V}\f$ and \f$\mathbf{U}^T\mathbf{B}\f$ are
+     * computed once, so each parameter costs
+     * \f$O(m_v \cdot \min(m,n) \cdot nrhs)\f$ operations.
+     */
+    template <typename BMatrixT, typename AvMatrixT, typename BvMatrixT>
+    std::vector<ValueT> ridgeHoldOutErrors(const BMatrixT& B, const std::vector<ValueT>& lambdas, const AvMatrixT& Av, const BvMatrixT& Bv);
+
+
+private:
+    /// Returns the absolute threshold below which singular values are considered as zero
+    ValueT threshold() const;
+
+    /// Copies the given right-hand side matrix into the right-hand side buffer
+    template <typename MatrixT>
+    void loadRhs(const MatrixT& B);
+
+    /// Computes \f$\mathbf{U}^T\mathbf{B}\f$ from the right-hand side buffer, unless it is already available
+    void projectRhs();
+
+    /// Computes \f$\mathbf{V}\mathbf{T}\f$ from the temporary buffer into the right-hand side buffer
+    void backProjectSolution();
+
+
+private:
+    std::size_t m_; ///< The number of rows of the coefficient matrix
+    std::size_t n_; ///< The number of columns of the coefficient matrix
+    std::size_t nrhs_; ///< The number of right-hand sides
+    ValueT rcond_; ///< The relative threshold for singular values
+    bool factorized_; ///< Tells if the coefficient matrix has been factorized
+    bool projected_; ///< Tells if the projection of the current right-hand sides is available
+    ValueT rhsSqrNorm_; ///< The squared Frobenius norm of the current right-hand sides
+    AlignedArray<ValueT> a_; ///< The coefficient matrix (column-major)
+    AlignedArray<ValueT> b_; ///< The right-hand side/solution matrix (column-major)
+    AlignedArray<ValueT> s_; ///< The singular values of the coefficient matrix
+    AlignedArray<ValueT> utb_; ///< The projected right-hand sides (\f$\mathbf{U}^T\mathbf{B}\f$)
+    AlignedArray<ValueT> tmp_; ///< Temporary storage for the scaled projected right-hand sides
+#ifdef FLX_CONFIG_HAVE_LAPACK
+    AlignedArray<ValueT> u_; ///< The left singular vectors (column-major)
+    AlignedArray<ValueT> vt_; ///< The transposed right singular vectors (column-major)
+    AlignedArray<ValueT> work_; ///< The LAPACK workspace
+    AlignedArray<lapack_int> iwork_; ///< The LAPACK integer workspace
+#else
+    SVDDecomposition<ValueT> svd_; ///< The singular value decomposition of the coefficient matrix
+#endif // FLX_CONFIG_HAVE_LAPACK
+}; // LsqSolverPlan
+
 
 /////////////////
 // Definitions
@@ -64,9 +300,6 @@ std::vector< std::vector<ValueT> > LsqSolveMulti(const AMatrixT& A, const BMatri
 
 #ifndef FLX_CONFIG_HAVE_LAPACKE
 
-typedef int lapack_int;
-typedef int lapack_logical;
-
 extern "C"
 void dgecon_(const char* norm, const lapack_int* n, const double* a,
              const lapack_int* lda, const double* anorm, double* rcond,
@@ -104,6 +337,13 @@ void dgeqrf_(const lapack_int* m, const lapack_int* n, double* a,
              const lapack_int* lda, double* tau, double* work,
              const lapack_int* lwork, lapack_int* info);
 
+extern "C"
+void dgesdd_(const char* jobz, const lapack_int* m, const lapack_int* n,
+             double* a, const lapack_int* lda, double* s, double* u,
+             const lapack_int* ldu, double* vt, const lapack_int* ldvt,
+             double* work, const lapack_int* lwork, lapack_int* iwork,
+             lapack_int* info);
+
 extern "C"
 void dgesvd_(const char* jobu, const char* jobvt,
              const lapack_int* m, const lapack_int* n, double* a,
@@ -120,6 +360,26 @@ double dlange_(const char* norm, const lapack_int* m,
                const lapack_int* n, const double* a, const lapack_int* lda,
                double* work );
 
+extern "C"
+void sgels_(const char* trans, const lapack_int* m,
+            const lapack_int* n, const lapack_int* nrhs, float* a,
+            const lapack_int* lda, float* b, const lapack_int* ldb,
+            float* work, const lapack_int* lwork, lapack_int* info);
+
+extern "C"
+void sgelsd_(const lapack_int* m, const lapack_int* n,
+             const lapack_int* nrhs, float* a, const lapack_int* lda,
+             float* b, const lapack_int* ldb, float* s, const float* rcond,
+             lapack_int* rank, float* work, const lapack_int* lwork,
+             lapack_int* iwork, lapack_int* info);
+
+extern "C"
+void sgesdd_(const char* jobz, const lapack_int* m, const lapack_int* n,
+             float* a, const lapack_int* lda, float* s, float* u,
+             const lapack_int* ldu, float* vt, const lapack_int* ldvt,
+             float* work, const lapack_int* lwork, lapack_int* iwork,
+             lapack_int* info);
+
 extern "C"
 lapack_int ilaenv_(const lapack_int* ispec, const char* name,
                    const char* opt, const lapack_int* n1, const lapack_int* n2,
@@ -135,12 +395,120 @@ void dgemm_(const char* transa, const char* transb,
             double* B, const lapack_int* ldb, const double* beta,
             double* C, const lapack_int* ldc);
 
+/// Fortran BLAS SGEMM subroutine
+extern "C"
+void sgemm_(const char* transa, const char* transb,
+            const lapack_int* m, const lapack_int* n, const lapack_int* k,
+            const float* alpha, float* A, const lapack_int* lda,
+            float* B, const lapack_int* ldb, const float* beta,
+            float* C, const lapack_int* ldc);
+
 ///// Fortran BLAS DNRM2 subrouting
 //extern "C"
 //void dnrm2_(const lapack_int* n, double* x, const lapack_int* incx, double* norm);
 
+//
+// Precision-overloaded wrappers of BLAS/LAPACK routines, so that templated
+// code can select the double-precision (D) or single-precision (S) routine
+// simply by the type of its arguments.
+//
+
+/// Computes C=alpha*op(A)*op(B)+beta*C (xGEMM)
+inline
+void BlasGemm(char transa, char transb, lapack_int m, lapack_int n, lapack_int k, double alpha, const double* A, lapack_int ldA, const double* B, lapack_int ldB, double beta, double* C, lapack_int ldC)
+{
+    dgemm_(&transa, &transb, &m, &n, &k, &alpha, const_cast<double*>(A), &ldA, const_cast<double*>(B), &ldB, &beta, C, &ldC);
+}
+
+/// Computes C=alpha*op(A)*op(B)+beta*C (xGEMM)
+inline
+void BlasGemm(char transa, char transb, lapack_int m, lapack_int n, lapack_int k, float alpha, const float* A, lapack_int ldA, const float* B, lapack_int ldB, float beta, float* C, lapack_int ldC)
+{
+    sgemm_(&transa, &transb, &m, &n, &k, &alpha, const_cast<float*>(A), &ldA, const_cast<float*>(B), &ldB, &beta, C, &ldC);
+}
+
+/// Solves a full-rank least-squares problem by QR factorization (xGELS); returns the LAPACK info code
+inline
+lapack_int LapackGels(char trans, lapack_int m, lapack_int n, lapack_int nrhs, double* A, lapack_int ldA, double* B, lapack_int ldB, double* work, lapack_int lwork)
+{
+#ifdef FLX_CONFIG_HAVE_LAPACKE
+    return LAPACKE_dgels_work(LAPACK_COL_MAJOR, trans, m, n, nrhs, A, ldA, B, ldB, work, lwork);
+#else
+    lapack_int info = 0;
+    dgels_(&trans, &m, &n, &nrhs, A, &ldA, B, &ldB, work, &lwork, &info);
+    return info;
+#endif // FLX_CONFIG_HAVE_LAPACKE
+}
+
+/// Solves a full-rank least-squares problem by QR factorization (xGELS); returns the LAPACK info code
+inline
+lapack_int LapackGels(char trans, lapack_int m, lapack_int n, lapack_int nrhs, float* A, lapack_int ldA, float* B, lapack_int ldB, float* work, lapack_int lwork)
+{
+#ifdef FLX_CONFIG_HAVE_LAPACKE
+    return LAPACKE_sgels_work(LAPACK_COL_MAJOR, trans, m, n, nrhs, A, ldA, B, ldB, work, lwork);
+#else
+    lapack_int info = 0;
+    sgels_(&trans, &m, &n, &nrhs, A, &ldA, B, &ldB, work, &lwork, &info);
+    return info;
+#endif // FLX_CONFIG_HAVE_LAPACKE
+}
+
+/// Solves a least-squares problem by SVD with divide-and-conquer (xGELSD); returns the LAPACK info code
+inline
+lapack_int LapackGelsd(lapack_int m, lapack_int n, lapack_int nrhs, double* A, lapack_int ldA, double* B, lapack_int ldB, double* s, double rcond, lapack_int* rank, double* work, lapack_int lwork, lapack_int* iwork)
+{
+#ifdef FLX_CONFIG_HAVE_LAPACKE
+    return LAPACKE_dgelsd_work(LAPACK_COL_MAJOR, m, n, nrhs, A, ldA, B, ldB, s, rcond, rank, work, lwork, iwork);
+#else
+    lapack_int info = 0;
+    dgelsd_(&m, &n, &nrhs, A, &ldA, B, &ldB, s, &rcond, rank, work, &lwork, iwork, &info);
+    return info;
+#endif // FLX_CONFIG_HAVE_LAPACKE
+}
+
+/// Solves a least-squares problem by SVD with divide-and-conquer (xGELSD); returns the LAPACK info code
+inline
+lapack_int LapackGelsd(lapack_int m, lapack_int n, lapack_int nrhs, float* A, lapack_int ldA, float* B, lapack_int ldB, float* s, float rcond, lapack_int* rank, float* work, lapack_int lwork, lapack_int* iwork)
+{
+#ifdef FLX_CONFIG_HAVE_LAPACKE
+    return LAPACKE_sgelsd_work(LAPACK_COL_MAJOR, m, n, nrhs, A, ldA, B, ldB, s, rcond, rank, work, lwork, iwork);
+#else
+    lapack_int info = 0;
+    sgelsd_(&m, &n, &nrhs, A, &ldA, B, &ldB, s, &rcond, rank, work, &lwork, iwork, &info);
+    return info;
+#endif // FLX_CONFIG_HAVE_LAPACKE
+}
+
+/// Computes the SVD of a general matrix with divide-and-conquer (xGESDD); returns the LAPACK info code
+inline
+lapack_int LapackGesdd(char jobz, lapack_int m, lapack_int n, double* A, lapack_int ldA, double* s, double* U, lapack_int ldU, double* VT, lapack_int ldVT, double* work, lapack_int lwork, lapack_int* iwork)
+{
+#ifdef FLX_CONFIG_HAVE_LAPACKE
+    return LAPACKE_dgesdd_work(LAPACK_COL_MAJOR, jobz, m, n, A, ldA, s, U, ldU, VT, ldVT, work, lwork, iwork);
+#else
+    lapack_int info = 0;
+    dgesdd_(&jobz, &m, &n, A, &ldA, s, U, &ldU, VT, &ldVT, work, &lwork, iwork, &info);
+    return info;
+#endif // FLX_CONFIG_HAVE_LAPACKE
+}
+
+/// Computes the SVD of a general matrix with divide-and-conquer (xGESDD); returns the LAPACK info code
+inline
+lapack_int LapackGesdd(char jobz, lapack_int m, lapack_int n, float* A, lapack_int ldA, float* s, float* U, lapack_int ldU, float* VT, lapack_int ldVT, float* work, lapack_int lwork, lapack_int* iwork)
+{
+#ifdef FLX_CONFIG_HAVE_LAPACKE
+    return LAPACKE_sgesdd_work(LAPACK_COL_MAJOR, jobz, m, n, A, ldA, s, U, ldU, VT, ldVT, work, lwork, iwork);
+#else
+    lapack_int info = 0;
+    sgesdd_(&jobz, &m, &n, A, &ldA, s, U, &ldU, VT, &ldVT, work, &lwork, iwork, &info);
+    return info;
+#endif // FLX_CONFIG_HAVE_LAPACKE
+}
+
 
-static double* LapackLsqSolveGELS(double* A, lapack_int m, lapack_int n, lapack_int ldA, double* B, lapack_int nrhs);
+
+template <typename ValueT>
+ValueT* LapackLsqSolveGELS(const ValueT* A, lapack_int m, lapack_int n, lapack_int ldA, const ValueT* B, lapack_int nrhs);
 static double* LapackLsqSolveGELSD(double* A, lapack_int m, lapack_int n, lapack_int ldA, double* B, lapack_int nrhs);
 static double* LapackLsqSolveGELSS(double* A, lapack_int m, lapack_int n, lapack_int ldA, double* B, lapack_int nrhs);
 static double* LapackLsqSolveGELSY(double* A, lapack_int m, lapack_int n, lapack_int ldA, double* B, lapack_int nrhs);
@@ -507,7 +875,8 @@ double* LapackLsqResidualsNorm(double* A, lapack_int m, lapack_int n, lapack_int
 	return norm;
 }
 
-double* LapackLsqSolveGELS(double* A, lapack_int m, lapack_int n, lapack_int ldA, double* B, lapack_int nrhs)
+template <typename ValueT>
+ValueT* LapackLsqSolveGELS(const ValueT* A, lapack_int m, lapack_int n, lapack_int ldA, const ValueT* B, lapack_int nrhs)
 {
 	assert( A );
 	assert( m > 0 );
@@ -517,48 +886,34 @@ double* LapackLsqSolveGELS(double* A, lapack_int m, lapack_int n, lapack_int ldA
 	assert( nrhs > 0 );
 
 	// Make a copy of the input matrix A to avoid changing its content
-	lapack_int A_sz = m*n;
-	double* AA = new double[A_sz];
-	std::copy(A, A+A_sz, AA);
+	std::vector<ValueT> AA(A, A+m*n);
 
 	const lapack_int ldX = std::max(m,n);
 
 	// Make a copy of the input matrix B to avoid changing its content
-	double* X = new double[nrhs*ldX];
-	std::copy(B, B+m*nrhs, X);
-	std::fill(X+m*nrhs, X+ldX*nrhs, 0);
+	ValueT* X = new ValueT[nrhs*ldX];
+	std::fill(X, X+nrhs*ldX, ValueT(0));
+	for (lapack_int j = 0; j < nrhs; ++j)
+	{
+		std::copy(B+j*m, B+(j+1)*m, X+j*ldX);
+	}
 
-	lapack_int info = 0;
-#ifdef FLX_CONFIG_HAVE_LAPACKE
-	info = LAPACKE_dgels(LAPACK_COL_MAJOR, 'N', m, n, nrhs, AA, ldA, X, ldX );
-#else
-    {
-        const char trans = 'N';
-        const lapack_int lwork = std::max(1, std::min(m,n)+std::max(std::min(m,n), nrhs));
-        double work[lwork];
-        dgels_(&trans, &m, &n, &nrhs, AA, &ldA, X, &ldX, work, &lwork, &info);
-    }
-#endif // FLX_CONFIG_HAVE_LAPACKE
+	// Query and allocate the optimal workspace
+	ValueT optWork = 0;
+	lapack_int info = LapackGels('N', m, n, nrhs, &AA[0], ldA, X, ldX, &optWork, -1);
+	if (!info)
+	{
+		std::vector<ValueT> work(std::max(static_cast<lapack_int>(optWork), static_cast<lapack_int>(1)));
+		info = LapackGels('N', m, n, nrhs, &AA[0], ldA, X, ldX, &work[0], static_cast<lapack_int>(work.size()));
+	}
 	if (info)
 	{
-		if (AA)
-		{
-			delete[] AA;
-		}
-		if (X)
-		{
-			delete[] X;
-		}
+		delete[] X;
 
 		std::ostringstream oss;
 		oss << "Unable to solve LSQ problem. LAPACK xGELS returned: " << info;
 		throw std::runtime_error(oss.str());
 	}
-	if (AA)
-	{
-		AA = 0;
-		delete[] AA;
-	}
 
 	return X;
 }
@@ -582,9 +937,12 @@ double* LapackLsqSolveGELSD(double* A, lapack_int m, lapack_int n, lapack_int ld
 	std::copy(A, A+A_sz, AA);
 
 	// Make a copy of the input matrix B to avoid changing its content
-	double* X = new double[n*ldX];
-	std::copy(B, B+m*nrhs, X);
-	std::fill(X+m*nrhs, X+n*ldX, 0);
+	double* X = new double[nrhs*ldX];
+	std::fill(X, X+nrhs*ldX, 0);
+	for (lapack_int j = 0; j < nrhs; ++j)
+	{
+		std::copy(B+j*m, B+(j+1)*m, X+j*ldX);
+	}
 
 	double* s = new double[m];
 
@@ -664,9 +1022,12 @@ double* LapackLsqSolveGELSS(double* A, lapack_int m, lapack_int n, lapack_int ld
 	std::copy(A, A+A_sz, AA);
 
 	// Make a copy of the input matrix B to avoid changing its content
-	double* X = new double[n*ldX];
-	std::copy(B, B+m*nrhs, X);
-	std::fill(X+m*nrhs, X+n*ldX, 0);
+	double* X = new double[nrhs*ldX];
+	std::fill(X, X+nrhs*ldX, 0);
+	for (lapack_int j = 0; j < nrhs; ++j)
+	{
+		std::copy(B+j*m, B+(j+1)*m, X+j*ldX);
+	}
 
 	double* s = new double[m];
 
@@ -735,9 +1096,12 @@ double* LapackLsqSolveGELSY(double* A, lapack_int m, lapack_int n, lapack_int ld
 	std::copy(A, A+A_sz, AA);
 
 	// Make a copy of the input matrix B to avoid changing its content
-	double* X = new double[n*ldX];
-	std::copy(B, B+m*nrhs, X);
-	std::fill(X+m*nrhs, X+n*ldX, 0);
+	double* X = new double[nrhs*ldX];
+	std::fill(X, X+nrhs*ldX, 0);
+	for (lapack_int j = 0; j < nrhs; ++j)
+	{
+		std::copy(B+j*m, B+(j+1)*m, X+j*ldX);
+	}
 
 	lapack_int* jpvt = new lapack_int[n];
 
@@ -809,7 +1173,7 @@ std::vector< std::vector<ValueT> > LsqSolveMultiQR(const AMatrixT& A, const BMat
     lapack_int A_n = A[0].size();
     lapack_int nrhs = B[0].size();
     lapack_int ldA = A_m;
-    lapack_int ldB = std::max(A_m, A_n);
+    lapack_int ldX = std::max(A_m, A_n);
 
     ValueT* flat_A = 0;
     ValueT* flat_B = 0;
@@ -826,8 +1190,6 @@ std::vector< std::vector<ValueT> > LsqSolveMultiQR(const AMatrixT& A, const BMat
                 flat_A[offs+i] = A[i][j];
             }
         }
-std::cerr << "[LsqQR] A: "; MatrixOutput(std::cerr, A); std::cerr << std::endl;//XXX
-std::cerr << "[LsqQR] flat_A: "; VectorOutput(std::cerr, flat_A, A_m*A_n); std::cerr << std::endl;//XXX
         // Copy B and store it in column-major order
         flat_B = new ValueT[A_m*nrhs];
         for (std::size_t j = 0; j < nrhs; ++j)
@@ -838,10 +1200,8 @@ std::cerr << "[LsqQR] flat_A: "; VectorOutput(std::cerr, flat_A, A_m*A_n); std::
                 flat_B[offs+i] = B[i][j];
             }
         }
-std::cerr << "[LsqQR] B: "; MatrixOutput(std::cerr, B); std::cerr << std::endl;//XXX
-std::cerr << "[LsqQR] flat_B: "; VectorOutput(std::cerr, flat_B, A_m*nrhs); std::cerr << std::endl;//XXX
 
-        double* flat_X = 0;
+        ValueT* flat_X = 0;
         flat_X = LapackLsqSolveGELS(flat_A, A_m, A_n, ldA, flat_B, nrhs);
         if (flat_X)
         {
@@ -851,12 +1211,11 @@ std::cerr << "[LsqQR] flat_B: "; VectorOutput(std::cerr, flat_B, A_m*nrhs); std:
                 X[i].resize(nrhs);
                 for (lapack_int j = 0; j < nrhs; ++j)
                 {
-                    X[i][j] = flat_B[j*A_n+i];
+                    X[i][j] = flat_X[j*ldX+i];
                 }
             }
             delete[] flat_X;
         }
-std::cerr << "[LsqQR] X: "; MatrixOutput(std::cerr, X); std::cerr << std::endl;//XXX
     }
     catch (...)
     {
@@ -883,6 +1242,13 @@ std::cerr << "[LsqQR] X: "; MatrixOutput(std::cerr, X); std::cerr << std::endl;/
     return X;
 }
 
+/**
+ * Solves the least-squares problem through a plan used only for this call.
+ *
+ * This is just a convenience for one-off problems: code solving the same
+ * coefficient matrix for several right-hand sides or ridge parameters should
+ * keep its own LsqSolverPlan, so that the factorization is reused.
+ */
 template <typename ValueT, typename AMatrixT, typename BMatrixT>
 std::vector< std::vector<ValueT> > LsqSolveMultiSVD(const AMatrixT& A, const BMatrixT& B)
 {
@@ -899,114 +1265,37 @@ std::vector< std::vector<ValueT> > LsqSolveMultiSVD(const AMatrixT& A, const BMa
         FL_THROW2(std::invalid_argument, "Coefficient matrix and right-hand side matrix are not conformant");
     }
 
-    std::vector< std::vector<ValueT> > X; // The solution matrix X such that: AX=B
+    LsqSolverPlan<ValueT> plan(A.size(), A[0].size(), B[0].size());
 
-    lapack_int A_m = A.size();
-    lapack_int A_n = A[0].size();
-    lapack_int nrhs = B[0].size();
-    lapack_int ldA = A_m;
+    return plan.solve(A, B);
+}
 
-    ValueT* flat_A = 0;
-    ValueT* flat_B = 0;
+template <typename ValueT, typename AMatrixT, typename BMatrixT>
+std::vector< std::vector<ValueT> > LsqSolveMulti(const AMatrixT& A, const BMatrixT& B)
+{
+    // NOTE: QR implementation is faster but more sensible to ill-conditioned problems.
+    //       SVD implementation is slower but more robust.
 
-    try
+std::vector< std::vector<ValueT> > X;
+#if 0
+    X = LsqSolveMultiQR<ValueT>(A, B);
+#else
+    X = LsqSolveMultiSVD<ValueT>(A, B);
+#endif
+return X;
+}
+
+template <typename ValueT, typename MatrixT, typename VectorT>
+std::vector<ValueT> LsqSolve(const MatrixT& A, const VectorT& b)
+{
+    std::vector< std::vector<ValueT> > B(b.size());
+    for (std::size_t i = 0,
+                     ni = b.size();
+         i < ni;
+         ++i)
     {
-        // Copy A and store it in column-major order
-        flat_A = new ValueT[A_m*A_n];
-        for (lapack_int j = 0; j < A_n; ++j)
-        {
-            const lapack_int offs = j*ldA;
-            for (lapack_int i = 0; i < A_m; ++i)
-            {
-                flat_A[offs+i] = A[i][j];
-            }
-        }
-std::cerr << "[LsqSVD] A: "; MatrixOutput(std::cerr, A); std::cerr << std::endl;//XXX
-std::cerr << "[LsqSVD] flat_A: "; VectorOutput(std::cerr, flat_A, A_m*A_n); std::cerr << std::endl;//XXX
-        // Copy B and store it in column-major order
-        flat_B = new ValueT[A_m*nrhs];
-        std::fill(flat_B, flat_B+A_m*nrhs, 0);
-        for (lapack_int j = 0; j < nrhs; ++j)
-        {
-            const lapack_int offs = j*A_m;
-            for (lapack_int i = 0; i < A_m; ++i)
-            {
-                flat_B[offs+i] = B[i][j];
-            }
-        }
-std::cerr << "[LsqSVD] B: "; MatrixOutput(std::cerr, B); std::cerr << std::endl;//XXX
-std::cerr << "[LsqSVD] flat_B: "; VectorOutput(std::cerr, flat_B, A_m*nrhs); std::cerr << std::endl;//XXX
-
-        double* flat_X = 0;
-        flat_X = LapackLsqSolveGELSD(flat_A, A_m, A_n, ldA, flat_B, nrhs);
-        //flat_X = LapackLsqSolveGELSS(flat_A, A_m, A_n, ldA, flat_B, nrhs);
-        //flat_X = LapackLsqSolveGELSY(flat_A, A_m, A_n, ldA, flat_B, nrhs);
-        if (flat_X)
-        {
-            X.resize(A_n);
-            for (lapack_int i = 0; i < A_n; ++i)
-            {
-                X[i].resize(nrhs);
-                for (lapack_int j = 0; j < nrhs; ++j)
-                {
-                    X[i][j] = flat_X[j*A_n+i];
-                }
-            }
-            delete[] flat_X;
-        }
-std::cerr << "[LsqQR] X: "; MatrixOutput(std::cerr, X); std::cerr << std::endl;//XXX
-    }
-    catch (...)
-    {
-        if (flat_A)
-        {
-            delete[] flat_A;
-        }
-        if (flat_B)
-        {
-            delete[] flat_B;
-        }
-        throw;
-    }
-
-    if (flat_A)
-    {
-        delete[] flat_A;
-    }
-    if (flat_B)
-    {
-        delete[] flat_B;
-    }
-
-    return X;
-}
-
-template <typename ValueT, typename AMatrixT, typename BMatrixT>
-std::vector< std::vector<ValueT> > LsqSolveMulti(const AMatrixT& A, const BMatrixT& B)
-{
-    // NOTE: QR implementation is faster but more sensible to ill-conditioned problems.
-    //       SVD implementation is slower but more robust.
-
-std::vector< std::vector<ValueT> > X;
-#if 0
-    X = LsqSolveMultiQR<ValueT>(A, B);
-#else
-    X = LsqSolveMultiSVD<ValueT>(A, B);
-#endif
-return X;
-}
-
-template <typename ValueT, typename MatrixT, typename VectorT>
-std::vector<ValueT> LsqSolve(const MatrixT& A, const VectorT& b)
-{
-    std::vector< std::vector<ValueT> > B(b.size());
-    for (std::size_t i = 0,
-                     ni = b.size();
-         i < ni;
-         ++i)
-    {
-        B[i].push_back(b[i]);
-    }
+        B[i].push_back(b[i]);
+    }
 
     std::vector< std::vector<ValueT> > X;
     X = LsqSolveMulti<ValueT>(A, B);
@@ -1157,6 +1446,24 @@ public:
      */
 	std::vector< std::vector<RealT> > nullspace(RealT thresh = -1) const;
 
+    /// Returns the singular values of A in descending order
+    const std::vector<RealT>& singularValues() const
+    {
+        return w_;
+    }
+
+    /// Returns the left singular vectors of A (as the columns of a \f$m \times n\f$ matrix)
+    const std::vector< std::vector<RealT> >& leftSingularVectors() const
+    {
+        return u_;
+    }
+
+    /// Returns the right singular vectors of A (as the columns of a \f$n \times n\f$ matrix)
+    const std::vector< std::vector<RealT> >& rightSingularVectors() const
+    {
+        return v_;
+    }
+
 
 private:
     /// Performs the SVD computation
@@ -1722,7 +2029,7 @@ RealT SVDDecomposition<RealT>::getDefaultThreshold() const
 {
     const RealT eps = std::numeric_limits<RealT>::epsilon();
 
-    return 0.5*std::sqrt(m_+n_+1.0)*w_[0]*eps;
+    return RealT(0.5)*std::sqrt(static_cast<RealT>(m_+n_+1))*w_[0]*eps;
 }
 
 template <typename RealT>
@@ -1765,6 +2072,688 @@ std::vector< std::vector<ValueT> > LsqSolveMulti(const AMatrixT& A, const BMatri
 
 #endif // FLX_CONFIG_HAVE_LAPACK
 
+////////////////////////////////////////////////////////
+// LsqSolverPlan
+
+
+template <typename ValueT>
+LsqSolverPlan<ValueT>::LsqSolverPlan(std::size_t m, std::size_t n, std::size_t nrhs)
+: m_(0),
+  n_(0),
+  nrhs_(0),
+  rcond_(-1),
+  factorized_(false),
+  projected_(false),
+  rhsSqrNorm_(0)
+{
+    this->reshape(m, n, nrhs);
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::reshape(std::size_t m, std::size_t n, std::size_t nrhs)
+{
+    if (m == m_ && n == n_ && nrhs == nrhs_)
+    {
+        return;
+    }
+
+    m_ = m;
+    n_ = n;
+    nrhs_ = nrhs;
+    factorized_ = false;
+    projected_ = false;
+
+    const std::size_t k = std::min(m_, n_);
+
+    a_.resize(m_*n_);
+    b_.resize(this->rhsLeadingDimension()*nrhs_);
+    s_.resize(k);
+    utb_.resize(k*nrhs_);
+    tmp_.resize(k*nrhs_);
+
+#ifdef FLX_CONFIG_HAVE_LAPACK
+    u_.resize(m_*k);
+    vt_.resize(k*n_);
+    iwork_.resize(8*k);
+
+    if (k == 0)
+    {
+        work_.clear();
+        return;
+    }
+
+    // Query the optimal workspace size (only once per shape)
+    const lapack_int lm = static_cast<lapack_int>(m_);
+    const lapack_int ln = static_cast<lapack_int>(n_);
+    const lapack_int lk = static_cast<lapack_int>(k);
+    ValueT optWork = 0;
+    const lapack_int info = LapackGesdd('S', lm, ln, a_.data(), lm, s_.data(), u_.data(), lm, vt_.data(), lk, &optWork, -1, iwork_.data());
+    if (info)
+    {
+        std::ostringstream oss;
+        oss << "Unable to query the workspace size. LAPACK xGESDD returned: " << info;
+        FL_THROW2(std::runtime_error, oss.str());
+    }
+    work_.resize(std::max(static_cast<std::size_t>(optWork), static_cast<std::size_t>(1)));
+#endif // FLX_CONFIG_HAVE_LAPACK
+}
+
+template <typename ValueT>
+std::size_t LsqSolverPlan<ValueT>::numOfRows() const
+{
+    return m_;
+}
+
+template <typename ValueT>
+std::size_t LsqSolverPlan<ValueT>::numOfColumns() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+std::size_t LsqSolverPlan<ValueT>::numOfRightHandSides() const
+{
+    return nrhs_;
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::setRCond(ValueT value)
+{
+    rcond_ = value;
+}
+
+template <typename ValueT>
+ValueT LsqSolverPlan<ValueT>::getRCond() const
+{
+    return rcond_;
+}
+
+template <typename ValueT>
+ValueT* LsqSolverPlan<ValueT>::matrixData()
+{
+    factorized_ = false;
+    projected_ = false;
+
+    return a_.data();
+}
+
+template <typename ValueT>
+ValueT* LsqSolverPlan<ValueT>::rhsData()
+{
+    projected_ = false;
+
+    return b_.data();
+}
+
+template <typename ValueT>
+std::size_t LsqSolverPlan<ValueT>::rhsLeadingDimension() const
+{
+    return std::max(m_, n_);
+}
+
+template <typename ValueT>
+template <typename MatrixT>
+void LsqSolverPlan<ValueT>::factorize(const MatrixT& A)
+{
+    if (A.size() != m_ || (m_ > 0 && A[0].size() != n_))
+    {
+        FL_THROW2(std::invalid_argument, "Coefficient matrix does not match the shape of the plan");
+    }
+
+    ValueT* a = this->matrixData();
+    for (std::size_t j = 0; j < n_; ++j)
+    {
+        const std::size_t offs = j*m_;
+        for (std::size_t i = 0; i < m_; ++i)
+        {
+            a[offs+i] = A[i][j];
+        }
+    }
+
+    this->factorize();
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::factorize()
+{
+    if (m_ == 0 || n_ == 0)
+    {
+        FL_THROW2(std::logic_error, "Cannot factorize an empty coefficient matrix");
+    }
+
+#ifdef FLX_CONFIG_HAVE_LAPACK
+    const lapack_int lm = static_cast<lapack_int>(m_);
+    const lapack_int ln = static_cast<lapack_int>(n_);
+    const lapack_int lk = static_cast<lapack_int>(std::min(m_, n_));
+    const lapack_int lwork = static_cast<lapack_int>(work_.size());
+    const lapack_int info = LapackGesdd('S', lm, ln, a_.data(), lm, s_.data(), u_.data(), lm, vt_.data(), lk, work_.data(), lwork, iwork_.data());
+    if (info)
+    {
+        std::ostringstream oss;
+        oss << "Unable to factorize the coefficient matrix. LAPACK xGESDD returned: " << info;
+        FL_THROW2(std::runtime_error, oss.str());
+    }
+#else // FLX_CONFIG_HAVE_LAPACK
+    std::vector< std::vector<ValueT> > A(m_, std::vector<ValueT>(n_));
+    for (std::size_t i = 0; i < m_; ++i)
+    {
+        for (std::size_t j = 0; j < n_; ++j)
+        {
+            A[i][j] = a_[j*m_+i];
+        }
+    }
+    svd_.decompose(A);
+    const std::vector<ValueT>& w = svd_.singularValues();
+    std::copy(w.begin(), w.begin()+s_.size(), s_.begin());
+#endif // FLX_CONFIG_HAVE_LAPACK
+
+    factorized_ = true;
+    projected_ = false;
+}
+
+template <typename ValueT>
+bool LsqSolverPlan<ValueT>::factorized() const
+{
+    return factorized_;
+}
+
+template <typename ValueT>
+std::size_t LsqSolverPlan<ValueT>::rank() const
+{
+    if (!factorized_)
+    {
+        FL_THROW2(std::logic_error, "Coefficient matrix has not been factorized yet");
+    }
+
+    const ValueT tsh = this->threshold();
+
+    std::size_t r = 0;
+    for (std::size_t i = 0,
+                     ni = s_.size();
+         i < ni;
+         ++i)
+    {
+        if (s_[i] > tsh)
+        {
+            ++r;
+        }
+    }
+
+    return r;
+}
+
+template <typename ValueT>
+template <typename MatrixT>
+std::vector< std::vector<ValueT> > LsqSolverPlan<ValueT>::solve(const MatrixT& B)
+{
+    this->loadRhs(B);
+    this->solve();
+
+    return this->storedSolution();
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::solve()
+{
+    if (!factorized_)
+    {
+        FL_THROW2(std::logic_error, "Coefficient matrix has not been factorized yet");
+    }
+
+    const std::size_t k = s_.size();
+    const ValueT tsh = this->threshold();
+
+    // X = V*inv(S)*U'*B
+    this->projectRhs();
+    for (std::size_t j = 0; j < nrhs_; ++j)
+    {
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            tmp_[j*k+i] = (s_[i] > tsh) ? utb_[j*k+i]/s_[i] : 0;
+        }
+    }
+    this->backProjectSolution();
+}
+
+template <typename ValueT>
+template <typename AMatrixT, typename BMatrixT>
+std::vector< std::vector<ValueT> > LsqSolverPlan<ValueT>::solve(const AMatrixT& A, const BMatrixT& B)
+{
+    this->factorize(A);
+
+    return this->solve(B);
+}
+
+template <typename ValueT>
+template <typename MatrixT>
+std::vector< std::vector<ValueT> > LsqSolverPlan<ValueT>::solveRidge(const MatrixT& B, ValueT lambda)
+{
+    this->loadRhs(B);
+    this->solveRidge(lambda);
+
+    return this->storedSolution();
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::solveRidge(ValueT lambda)
+{
+    if (!factorized_)
+    {
+        FL_THROW2(std::logic_error, "Coefficient matrix has not been factorized yet");
+    }
+    if (lambda < 0)
+    {
+        FL_THROW2(std::invalid_argument, "Regularization parameter must be non-negative");
+    }
+
+    const std::size_t k = s_.size();
+    const ValueT tsh = this->threshold();
+
+    // X = V*F*U'*B, with F=diag(s_i/(s_i^2+lambda))
+    this->projectRhs();
+    for (std::size_t i = 0; i < k; ++i)
+    {
+        const ValueT f = (s_[i] > tsh) ? s_[i]/(s_[i]*s_[i]+lambda) : 0;
+        for (std::size_t j = 0; j < nrhs_; ++j)
+        {
+            tmp_[j*k+i] = utb_[j*k+i]*f;
+        }
+    }
+    this->backProjectSolution();
+}
+
+template <typename ValueT>
+template <typename MatrixT>
+std::vector<ValueT> LsqSolverPlan<ValueT>::ridgeGcvScores(const MatrixT& B, const std::vector<ValueT>& lambdas)
+{
+    this->loadRhs(B);
+
+    return this->ridgeGcvScores(lambdas);
+}
+
+template <typename ValueT>
+std::vector<ValueT> LsqSolverPlan<ValueT>::ridgeGcvScores(const std::vector<ValueT>& lambdas)
+{
+    if (!factorized_)
+    {
+        FL_THROW2(std::logic_error, "Coefficient matrix has not been factorized yet");
+    }
+
+    // The part of B outside the range of U does not depend on lambda:
+    //  ||B||^2 - ||U'B||^2
+    const std::size_t k = s_.size();
+    this->projectRhs();
+    ValueT outResid = rhsSqrNorm_;
+    // Squared norms of the rows of U'B
+    std::vector<ValueT> c2(k, 0);
+    for (std::size_t j = 0; j < nrhs_; ++j)
+    {
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            c2[i] += utb_[j*k+i]*utb_[j*k+i];
+        }
+    }
+    for (std::size_t i = 0; i < k; ++i)
+    {
+        outResid -= c2[i];
+    }
+    outResid = std::max(outResid, ValueT(0));
+
+    const ValueT tsh = this->threshold();
+    const ValueT m = static_cast<ValueT>(m_);
+
+    std::vector<ValueT> scores(lambdas.size());
+    for (std::size_t l = 0,
+                     nl = lambdas.size();
+         l < nl;
+         ++l)
+    {
+        const ValueT lambda = lambdas[l];
+
+        if (lambda < 0)
+        {
+            FL_THROW2(std::invalid_argument, "Regularization parameter must be non-negative");
+        }
+
+        ValueT resid = outResid;
+        ValueT dof = 0;
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            if (s_[i] > tsh)
+            {
+                const ValueT s2 = s_[i]*s_[i];
+                const ValueT r = lambda/(s2+lambda);
+
+                resid += r*r*c2[i];
+                dof += s2/(s2+lambda);
+            }
+            else
+            {
+                resid += c2[i];
+            }
+        }
+
+        const ValueT den = m-dof;
+        scores[l] = (den > 0) ? m*resid/(den*den) : std::numeric_limits<ValueT>::infinity();
+    }
+
+    return scores;
+}
+
+template <typename ValueT>
+template <typename BMatrixT, typename AvMatrixT, typename BvMatrixT>
+std::vector<ValueT> LsqSolverPlan<ValueT>::ridgeHoldOutErrors(const BMatrixT& B, const std::vector<ValueT>& lambdas, const AvMatrixT& Av, const BvMatrixT& Bv)
+{
+    if (!factorized_)
+    {
+        FL_THROW2(std::logic_error, "Coefficient matrix has not been factorized yet");
+    }
+
+    const std::size_t mv = Av.size();
+
+    if (Bv.size() != mv
+        || (mv > 0 && (Av[0].size() != n_ || Bv[0].size() != nrhs_)))
+    {
+        FL_THROW2(std::invalid_argument, "Hold-out matrices do not match the shape of the plan");
+    }
+
+    const std::size_t k = s_.size();
+
+    this->loadRhs(B);
+    this->projectRhs();
+
+    // W = Av*V (mv x k, row-major)
+    std::vector<ValueT> W(mv*k, 0);
+    for (std::size_t r = 0; r < mv; ++r)
+    {
+        for (std::size_t c = 0; c < n_; ++c)
+        {
+            const ValueT a = Av[r][c];
+            if (a == 0)
+            {
+                continue;
+            }
+            for (std::size_t i = 0; i < k; ++i)
+            {
+#ifdef FLX_CONFIG_HAVE_LAPACK
+                W[r*k+i] += a*vt_[c*k+i];
+#else
+                W[r*k+i] += a*svd_.rightSingularVectors()[c][i];
+#endif // FLX_CONFIG_HAVE_LAPACK
+            }
+        }
+    }
+
+    const ValueT tsh = this->threshold();
+
+    std::vector<ValueT> f(k);
+    std::vector<ValueT> errs(lambdas.size());
+    for (std::size_t l = 0,
+                     nl = lambdas.size();
+         l < nl;
+         ++l)
+    {
+        const ValueT lambda = lambdas[l];
+
+        if (lambda < 0)
+        {
+            FL_THROW2(std::invalid_argument, "Regularization parameter must be non-negative");
+        }
+
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            f[i] = (s_[i] > tsh) ? s_[i]/(s_[i]*s_[i]+lambda) : 0;
+        }
+
+        ValueT sse = 0;
+        for (std::size_t r = 0; r < mv; ++r)
+        {
+            for (std::size_t j = 0; j < nrhs_; ++j)
+            {
+                ValueT yhat = 0;
+                for (std::size_t i = 0; i < k; ++i)
+                {
+                    yhat += W[r*k+i]*f[i]*utb_[j*k+i];
+                }
+                const ValueT e = Bv[r][j]-yhat;
+                sse += e*e;
+            }
+        }
+
+        errs[l] = (mv > 0) ? sse/static_cast<ValueT>(mv*nrhs_) : 0;
+    }
+
+    return errs;
+}
+
+template <typename ValueT>
+ValueT LsqSolverPlan<ValueT>::threshold() const
+{
+    const ValueT smax = (s_.size() > 0) ? s_[0] : ValueT(0);
+
+    if (rcond_ >= 0)
+    {
+        return rcond_*smax;
+    }
+
+    // Same default as SVDDecomposition
+    return 0.5*std::sqrt(static_cast<ValueT>(m_+n_+1))*smax*std::numeric_limits<ValueT>::epsilon();
+}
+
+template <typename ValueT>
+template <typename MatrixT>
+void LsqSolverPlan<ValueT>::loadRhs(const MatrixT& B)
+{
+    if (B.size() != m_ || (m_ > 0 && B[0].size() != nrhs_))
+    {
+        FL_THROW2(std::invalid_argument, "Right-hand side matrix does not match the shape of the plan");
+    }
+
+    const std::size_t ldB = this->rhsLeadingDimension();
+
+    for (std::size_t j = 0; j < nrhs_; ++j)
+    {
+        const std::size_t offs = j*ldB;
+        for (std::size_t i = 0; i < m_; ++i)
+        {
+            b_[offs+i] = B[i][j];
+        }
+    }
+
+    projected_ = false;
+}
+
+template <typename ValueT>
+std::vector< std::vector<ValueT> > LsqSolverPlan<ValueT>::storedSolution() const
+{
+    const std::size_t ldB = this->rhsLeadingDimension();
+
+    std::vector< std::vector<ValueT> > X(n_, std::vector<ValueT>(nrhs_));
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        for (std::size_t j = 0; j < nrhs_; ++j)
+        {
+            X[i][j] = b_[j*ldB+i];
+        }
+    }
+
+    return X;
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::projectRhs()
+{
+    if (projected_)
+    {
+        return;
+    }
+
+    const std::size_t k = s_.size();
+    const std::size_t ldB = this->rhsLeadingDimension();
+
+    rhsSqrNorm_ = 0;
+    for (std::size_t j = 0; j < nrhs_; ++j)
+    {
+        const ValueT* b = b_.data()+j*ldB;
+        for (std::size_t i = 0; i < m_; ++i)
+        {
+            rhsSqrNorm_ += b[i]*b[i];
+        }
+    }
+
+#ifdef FLX_CONFIG_HAVE_LAPACK
+    const lapack_int lm = static_cast<lapack_int>(m_);
+    const lapack_int lk = static_cast<lapack_int>(k);
+    const lapack_int lnrhs = static_cast<lapack_int>(nrhs_);
+    const lapack_int lldB = static_cast<lapack_int>(ldB);
+
+    BlasGemm('T', 'N', lk, lnrhs, lm, ValueT(1), u_.data(), lm, b_.data(), lldB, ValueT(0), utb_.data(), lk);
+#else // FLX_CONFIG_HAVE_LAPACK
+    const std::vector< std::vector<ValueT> >& U = svd_.leftSingularVectors();
+
+    for (std::size_t j = 0; j < nrhs_; ++j)
+    {
+        const ValueT* b = b_.data()+j*ldB;
+        ValueT* t = utb_.data()+j*k;
+
+        std::fill(t, t+k, ValueT(0));
+        for (std::size_t r = 0; r < m_; ++r)
+        {
+            for (std::size_t i = 0; i < k; ++i)
+            {
+                t[i] += U[r][i]*b[r];
+            }
+        }
+    }
+#endif // FLX_CONFIG_HAVE_LAPACK
+
+    projected_ = true;
+}
+
+template <typename ValueT>
+void LsqSolverPlan<ValueT>::backProjectSolution()
+{
+    const std::size_t k = s_.size();
+    const std::size_t ldB = this->rhsLeadingDimension();
+
+#ifdef FLX_CONFIG_HAVE_LAPACK
+    const lapack_int ln = static_cast<lapack_int>(n_);
+    const lapack_int lk = static_cast<lapack_int>(k);
+    const lapack_int lnrhs = static_cast<lapack_int>(nrhs_);
+    const lapack_int lldB = static_cast<lapack_int>(ldB);
+
+    BlasGemm('T', 'N', ln, lnrhs, lk, ValueT(1), vt_.data(), lk, tmp_.data(), lk, ValueT(0), b_.data(), lldB);
+#else // FLX_CONFIG_HAVE_LAPACK
+    const std::vector< std::vector<ValueT> >& V = svd_.rightSingularVectors();
+
+    for (std::size_t j = 0; j < nrhs_; ++j)
+    {
+        const ValueT* t = tmp_.data()+j*k;
+        ValueT* x = b_.data()+j*ldB;
+
+        for (std::size_t r = 0; r < n_; ++r)
+        {
+            ValueT sum = 0;
+            for (std::size_t i = 0; i < k; ++i)
+            {
+                sum += V[r][i]*t[i];
+            }
+            x[r] = sum;
+        }
+    }
+#endif // FLX_CONFIG_HAVE_LAPACK
+}
+
+template <typename ValueT, typename AMatrixT, typename BMatrixT>
+std::vector< std::vector<ValueT> > LsqSolveMultiRidge(const AMatrixT& A, const BMatrixT& B, const std::vector<ValueT>& lambdas, ValueT* pLambda)
+{
+    if (A.size() == 0 || A[0].size() == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Coefficient matrix cannot be empty");
+    }
+    if (B.size() != A.size() || B[0].size() == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Right-hand side matrix does not match the coefficient matrix");
+    }
+    if (lambdas.size() == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Grid of regularization parameters cannot be empty");
+    }
+
+    LsqSolverPlan<ValueT> plan;
+
+    return LsqSolveMultiRidge(plan, A, B, lambdas, pLambda);
+}
+
+template <typename ValueT, typename AMatrixT, typename BMatrixT>
+std::vector< std::vector<ValueT> > LsqSolveMultiRidge(LsqSolverPlan<ValueT>& plan, const AMatrixT& A, const BMatrixT& B, const std::vector<ValueT>& lambdas, ValueT* pLambda)
+{
+    if (A.size() == 0 || A[0].size() == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Coefficient matrix cannot be empty");
+    }
+    if (B.size() != A.size() || B[0].size() == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Right-hand side matrix does not match the coefficient matrix");
+    }
+    if (lambdas.size() == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Grid of regularization parameters cannot be empty");
+    }
+
+    plan.reshape(A.size(), A[0].size(), B[0].size());
+    plan.factorize(A);
+
+    std::size_t best = 0;
+    if (lambdas.size() > 1)
+    {
+        // Scoring leaves the projection of B in the plan, so that the
+        // selected solution is obtained without projecting B again
+        const std::vector<ValueT> scores = plan.ridgeGcvScores(B, lambdas);
+
+        best = std::min_element(scores.begin(), scores.end())-scores.begin();
+
+        plan.solveRidge(lambdas[best]);
+    }
+    else
+    {
+        plan.solveRidge(B, lambdas[best]);
+    }
+
+    if (pLambda)
+    {
+        *pLambda = lambdas[best];
+    }
+
+    return plan.storedSolution();
+}
+
+template <typename ValueT>
+std::vector<ValueT> RidgeParameterGrid(ValueT lo, ValueT hi, std::size_t n)
+{
+    if (lo <= 0 || hi < lo)
+    {
+        FL_THROW2(std::invalid_argument, "Bounds of the grid must satisfy 0 < lo <= hi");
+    }
+
+    std::vector<ValueT> grid(n);
+    if (n == 1)
+    {
+        grid[0] = lo;
+    }
+    else if (n > 1)
+    {
+        const ValueT step = (std::log(hi)-std::log(lo))/static_cast<ValueT>(n-1);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            grid[i] = std::exp(std::log(lo)+step*static_cast<ValueT>(i));
+        }
+        grid[n-1] = hi;
+    }
+
+    return grid;
+}
+
 }} // Namespace fl::detail
 
 
@@ -0,0 +1,205 @@
+/**
+ * \file fl/detail/matrix_view.h
+ *
+ * \brief A non-owning view of a row-major matrix
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_MATRIX_VIEW_H
+#define FL_DETAIL_MATRIX_VIEW_H
+
+
+#include <cstddef>
+#include <fl/detail/array_view.h>
+#include <fl/macro.h>
+
+
+namespace fl { namespace detail {
+
+/**
+ * A non-owning view of a row-major matrix.
+ *
+ * The view has the interface of a vector of rows (i.e., \c size() and
+ * \c operator[], each row being a fl::detail::ArrayView), so that it can be
+ * passed to the algorithms that take a \c MatrixT template parameter (e.g.,
+ * fl::cluster::SubtractiveClustering::cluster) in place of a
+ * \c std::vector< std::vector<T> >, without copying the values.
+ * The viewed rows can also be an arbitrary selection of the rows of the
+ * matrix, given by an array of row positions (see rowIndices()).
+ * The viewed memory (and the array of row positions) must outlive the view.
+ *
+ * \tparam ValueT The type of values (\c const qualified for read-only views)
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class MatrixView
+{
+public:
+    typedef ArrayView<ValueT> value_type;
+    typedef ArrayView<ValueT> reference;
+    typedef ArrayView<ValueT> const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+
+    /// Constructs an empty view
+    MatrixView();
+
+    /**
+     * Constructs a view of the \a nr by \a nc matrix stored at \a p, where
+     * the first values of two consecutive rows are \a stride values apart
+     * (rows overlap if \a stride is less than \a nc).
+     *
+     * If \a idx is not null, the \a i-th row of the view is the
+     * <code>idx[i]</code>-th row of the matrix stored at \a p.
+     */
+    MatrixView(ValueT* p, std::size_t nr, std::size_t nc, std::size_t stride, const std::size_t* idx = 0);
+
+    /// Converts a view of mutable values to a view of constant values
+    template <typename OtherValueT>
+    MatrixView(const MatrixView<OtherValueT>& other);
+
+    /// Returns the number of rows
+    std::size_t size() const;
+
+    /// Tells if the view has no row
+    bool empty() const;
+
+    /// Returns the number of rows
+    std::size_t numOfRows() const;
+
+    /// Returns the number of columns
+    std::size_t numOfColumns() const;
+
+    /// Returns the distance between the first values of two consecutive rows
+    std::size_t stride() const;
+
+    /// Returns a pointer to the first value
+    ValueT* data() const;
+
+    /// Returns the positions of the viewed rows, or \c 0 if rows are consecutive
+    const std::size_t* rowIndices() const;
+
+    /// Returns the \a i-th row
+    ArrayView<ValueT> operator[](std::size_t i) const;
+
+
+private:
+    ValueT* p_; ///< The first value
+    std::size_t nr_; ///< The number of rows
+    std::size_t nc_; ///< The number of columns
+    std::size_t stride_; ///< The distance between two consecutive rows
+    const std::size_t* idx_; ///< The positions of the viewed rows (null if rows are consecutive)
+}; // MatrixView
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename ValueT>
+MatrixView<ValueT>::MatrixView()
+: p_(0),
+  nr_(0),
+  nc_(0),
+  stride_(0),
+  idx_(0)
+{
+}
+
+template <typename ValueT>
+MatrixView<ValueT>::MatrixView(ValueT* p, std::size_t nr, std::size_t nc, std::size_t stride, const std::size_t* idx)
+: p_(p),
+  nr_(nr),
+  nc_(nc),
+  stride_(stride),
+  idx_(idx)
+{
+}
+
+template <typename ValueT>
+template <typename OtherValueT>
+MatrixView<ValueT>::MatrixView(const MatrixView<OtherValueT>& other)
+: p_(other.data()),
+  nr_(other.numOfRows()),
+  nc_(other.numOfColumns()),
+  stride_(other.stride()),
+  idx_(other.rowIndices())
+{
+}
+
+template <typename ValueT>
+std::size_t MatrixView<ValueT>::size() const
+{
+    return nr_;
+}
+
+template <typename ValueT>
+bool MatrixView<ValueT>::empty() const
+{
+    return nr_ == 0;
+}
+
+template <typename ValueT>
+std::size_t MatrixView<ValueT>::numOfRows() const
+{
+    return nr_;
+}
+
+template <typename ValueT>
+std::size_t MatrixView<ValueT>::numOfColumns() const
+{
+    return nc_;
+}
+
+template <typename ValueT>
+std::size_t MatrixView<ValueT>::stride() const
+{
+    return stride_;
+}
+
+template <typename ValueT>
+ValueT* MatrixView<ValueT>::data() const
+{
+    return p_;
+}
+
+template <typename ValueT>
+const std::size_t* MatrixView<ValueT>::rowIndices() const
+{
+    return idx_;
+}
+
+template <typename ValueT>
+ArrayView<ValueT> MatrixView<ValueT>::operator[](std::size_t i) const
+{
+    FL_DEBUG_ASSERT( i < nr_ );
+
+    return ArrayView<ValueT>(p_+(idx_ ? idx_[i] : i)*stride_, nc_);
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_MATRIX_VIEW_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,342 @@
+/**
+ * \file fl/detail/memory.h
+ *
+ * \brief Memory management utilities
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_MEMORY_H
+#define FL_DETAIL_MEMORY_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fl/macro.h>
+#include <new>
+
+
+namespace fl { namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+/// Declarations
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// The default alignment (in bytes) of the memory returned by AlignedAllocate (a cache line)
+const std::size_t DefaultMemoryAlignment = 64;
+
+/**
+ * Allocates \a n bytes of memory whose address is a multiple of \a alignment
+ *
+ * The \a alignment must be a power of two.
+ * The returned memory must be released with AlignedDeallocate.
+ *
+ * \throw std::bad_alloc if the memory cannot be allocated
+ */
+void* AlignedAllocate(std::size_t n, std::size_t alignment = DefaultMemoryAlignment);
+
+/// Releases the memory previously obtained by AlignedAllocate
+void AlignedDeallocate(void* p);
+
+/**
+ * A contiguous and aligned array of plain values.
+ *
+ * Unlike \c std::vector, the array never initializes its elements and can be
+ * reserved once and then resized for free as long as the requested size does
+ * not exceed its capacity.
+ * This makes it suitable as a reusable workspace for numerical kernels.
+ *
+ * \tparam T The type of the elements; must be a POD type
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename T>
+class AlignedArray
+{
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+
+    /// Constructs an array of \a n (uninitialized) elements
+    explicit AlignedArray(std::size_t n = 0);
+
+    /// Copy constructor
+    AlignedArray(const AlignedArray<T>& other);
+
+    /// Destructor
+    ~AlignedArray();
+
+    /// Assignment operator
+    AlignedArray<T>& operator=(const AlignedArray<T>& rhs);
+
+    /// Changes the size of this array; old elements are kept, new elements are not initialized
+    void resize(std::size_t n);
+
+    /// Changes the size of this array and sets all its elements to \a value
+    void assign(std::size_t n, const T& value);
+
+    /// Makes sure that the array can hold at least \a n elements without reallocating
+    void reserve(std::size_t n);
+
+    /// Releases the memory held by this array
+    void clear();
+
+    /// Swaps the content of this array with the one of \a other
+    void swap(AlignedArray<T>& other);
+
+    /// Returns the number of elements in this array
+    std::size_t size() const;
+
+    /// Returns the number of elements this array can hold without reallocating
+    std::size_t capacity() const;
+
+    /// Tells if this array is empty
+    bool empty() const;
+
+    /// Returns a pointer to the first element
+    T* data();
+
+    /// Returns a pointer to the first element
+    const T* data() const;
+
+    /// Returns an iterator to the first element
+    T* begin();
+
+    /// Returns an iterator to the first element
+    const T* begin() const;
+
+    /// Returns an iterator to one past the last element
+    T* end();
+
+    /// Returns an iterator to one past the last element
+    const T* end() const;
+
+    /// Accesses the \a i-th element
+    T& operator[](std::size_t i);
+
+    /// Accesses the \a i-th element
+    const T& operator[](std::size_t i) const;
+
+
+private:
+    T* data_; ///< The elements
+    std::size_t size_; ///< The number of elements
+    std::size_t capacity_; ///< The number of allocated elements
+}; // AlignedArray
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+inline
+void* AlignedAllocate(std::size_t n, std::size_t alignment)
+{
+    FL_DEBUG_ASSERT( alignment > 0 && (alignment & (alignment-1)) == 0 );
+
+    // Over-allocate and store the address returned by malloc just before the
+    // aligned block, so that it can be retrieved on deallocation
+    void* raw = std::malloc(n+alignment+sizeof(void*));
+    if (!raw)
+    {
+        throw std::bad_alloc();
+    }
+
+    const std::size_t addr = reinterpret_cast<std::size_t>(static_cast<char*>(raw)+sizeof(void*));
+    void* p = reinterpret_cast<void*>((addr+alignment-1) & ~(alignment-1));
+    static_cast<void**>(p)[-1] = raw;
+
+    return p;
+}
+
+inline
+void AlignedDeallocate(void* p)
+{
+    if (p)
+    {
+        std::free(static_cast<void**>(p)[-1]);
+    }
+}
+
+template <typename T>
+AlignedArray<T>::AlignedArray(std::size_t n)
+: data_(0),
+  size_(0),
+  capacity_(0)
+{
+    this->resize(n);
+}
+
+template <typename T>
+AlignedArray<T>::AlignedArray(const AlignedArray<T>& other)
+: data_(0),
+  size_(0),
+  capacity_(0)
+{
+    this->resize(other.size_);
+    std::copy(other.begin(), other.end(), data_);
+}
+
+template <typename T>
+AlignedArray<T>::~AlignedArray()
+{
+    this->clear();
+}
+
+template <typename T>
+AlignedArray<T>& AlignedArray<T>::operator=(const AlignedArray<T>& rhs)
+{
+    if (this != &rhs)
+    {
+        AlignedArray<T> tmp(rhs);
+        this->swap(tmp);
+    }
+
+    return *this;
+}
+
+template <typename T>
+void AlignedArray<T>::resize(std::size_t n)
+{
+    this->reserve(n);
+    size_ = n;
+}
+
+template <typename T>
+void AlignedArray<T>::assign(std::size_t n, const T& value)
+{
+    this->resize(n);
+    std::fill(data_, data_+size_, value);
+}
+
+template <typename T>
+void AlignedArray<T>::reserve(std::size_t n)
+{
+    if (n <= capacity_)
+    {
+        return;
+    }
+
+    T* p = static_cast<T*>(AlignedAllocate(n*sizeof(T)));
+    if (data_)
+    {
+        std::copy(data_, data_+size_, p);
+        AlignedDeallocate(data_);
+    }
+    data_ = p;
+    capacity_ = n;
+}
+
+template <typename T>
+void AlignedArray<T>::clear()
+{
+    AlignedDeallocate(data_);
+    data_ = 0;
+    size_ = capacity_ = 0;
+}
+
+template <typename T>
+void AlignedArray<T>::swap(AlignedArray<T>& other)
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+}
+
+template <typename T>
+std::size_t AlignedArray<T>::size() const
+{
+    return size_;
+}
+
+template <typename T>
+std::size_t AlignedArray<T>::capacity() const
+{
+    return capacity_;
+}
+
+template <typename T>
+bool AlignedArray<T>::empty() const
+{
+    return size_ == 0;
+}
+
+template <typename T>
+T* AlignedArray<T>::data()
+{
+    return data_;
+}
+
+template <typename T>
+const T* AlignedArray<T>::data() const
+{
+    return data_;
+}
+
+template <typename T>
+T* AlignedArray<T>::begin()
+{
+    return data_;
+}
+
+template <typename T>
+const T* AlignedArray<T>::begin() const
+{
+    return data_;
+}
+
+template <typename T>
+T* AlignedArray<T>::end()
+{
+    return data_+size_;
+}
+
+template <typename T>
+const T* AlignedArray<T>::end() const
+{
+    return data_+size_;
+}
+
+template <typename T>
+T& AlignedArray<T>::operator[](std::size_t i)
+{
+    FL_DEBUG_ASSERT( i < size_ );
+
+    return data_[i];
+}
+
+template <typename T>
+const T& AlignedArray<T>::operator[](std::size_t i) const
+{
+    FL_DEBUG_ASSERT( i < size_ );
+
+    return data_[i];
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_MEMORY_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,68 @@
+/**
+ * \file fl/detail/parallel.h
+ *
+ * \brief Utilities for the data-parallel kernels
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_PARALLEL_H
+#define FL_DETAIL_PARALLEL_H
+
+
+#include <cstddef>
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# include <omp.h>
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+
+namespace fl { namespace detail {
+
+/**
+ * Number of consecutive data points processed at a time by the tiled
+ * kernels, so that the per-point buffers of a tile stay in cache.
+ */
+const std::size_t TileSize = 256;
+
+/// Returns the maximum number of threads used by parallel regions
+inline std::size_t MaxNumOfThreads()
+{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+    return static_cast<std::size_t>(omp_get_max_threads());
+#else
+    return 1;
+#endif // FLX_CONFIG_HAVE_OPENMP
+}
+
+/// Returns the identifier of the calling thread within the current parallel region
+inline std::size_t ThreadNum()
+{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+    return static_cast<std::size_t>(omp_get_thread_num());
+#else
+    return 0;
+#endif // FLX_CONFIG_HAVE_OPENMP
+}
+
+}} // Namespace fl::detail
+
+#endif // FL_DETAIL_PARALLEL_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,233 @@
+/**
+ * \file fl/detail/parse.h
+ *
+ * \brief Fast parsing of numbers from character ranges
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_PARSE_H
+#define FL_DETAIL_PARSE_H
+
+
+#include <boost/cstdint.hpp>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+
+
+namespace fl { namespace detail {
+
+/// Tells if \a c is a decimal digit
+inline bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/// Tells if the range [\a first, \a last) starts with the (lowercase) word \a w, regardless of the case
+inline bool StartsWithNoCase(const char* first, const char* last, const char* w)
+{
+    for (; *w; ++w, ++first)
+    {
+        if (first == last || (*first | 0x20) != *w)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Parses a decimal floating-point number at the beginning of the range
+ * [\a first, \a last), in the same spirit as C++17 \c std::from_chars.
+ *
+ * The accepted syntax is the one of \c strtod for decimal numbers (with an
+ * optional sign), plus \c nan, \c inf and \c infinity (regardless of the
+ * case).
+ * Unlike \c strtod, the range does not need to be null-terminated, leading
+ * whitespaces are not skipped, and the decimal point is always '.'.
+ *
+ * Numbers whose significand fits into 53 bits and whose decimal exponent is
+ * at most 22 in absolute value (i.e., almost all numbers written in data
+ * files) are converted exactly with a single floating-point multiplication
+ * or division [Clinger1990]; the other ones are converted by a stream imbued
+ * with the classic "C" locale, so that the result never depends on the
+ * global locale (as it would with \c strtod).
+ * Numbers too large to be represented are converted to infinity.
+ *
+ * References:
+ * -# [Clinger1990] W.D. Clinger, "How to read floating point numbers accurately," in Proc. of the ACM SIGPLAN '90 Conference on Programming Language Design and Implementation, pp. 92-101, 1990.
+ * .
+ *
+ * \param first The beginning of the range
+ * \param last The end of the range
+ * \param x The parsed number (unchanged if no number is found)
+ * \return The position right after the parsed number, or \a first if no
+ *  number is found
+ */
+template <typename ValueT>
+const char* ParseNumber(const char* first, const char* last, ValueT& x)
+{
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+                                    1e21, 1e22 };
+    static const boost::uint64_t maxExactMantissa = static_cast<boost::uint64_t>(1) << 53;
+
+    const char* p = first;
+
+    bool neg = false;
+    if (p != last && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    // Special values
+    if (p != last && !IsDigit(*p) && *p != '.')
+    {
+        if (StartsWithNoCase(p, last, "nan"))
+        {
+            x = std::numeric_limits<ValueT>::quiet_NaN();
+            return p+3;
+        }
+        if (StartsWithNoCase(p, last, "inf"))
+        {
+            x = neg ? -std::numeric_limits<ValueT>::infinity() : std::numeric_limits<ValueT>::infinity();
+            return StartsWithNoCase(p, last, "infinity") ? p+8 : p+3;
+        }
+        return first;
+    }
+
+    // Significand
+    boost::uint64_t m = 0;
+    int numDigits = 0; // Number of significant digits accumulated in m
+    int exp10 = 0;
+    bool exact = true;
+    bool anyDigit = false;
+    for (; p != last && IsDigit(*p); ++p)
+    {
+        anyDigit = true;
+        if (numDigits < 19)
+        {
+            m = m*10+(*p-'0');
+            numDigits += (m > 0);
+        }
+        else
+        {
+            ++exp10;
+            exact = exact && (*p == '0');
+        }
+    }
+    if (p != last && *p == '.')
+    {
+        ++p;
+        for (; p != last && IsDigit(*p); ++p)
+        {
+            anyDigit = true;
+            if (numDigits < 19)
+            {
+                m = m*10+(*p-'0');
+                numDigits += (m > 0);
+                --exp10;
+            }
+            else
+            {
+                exact = exact && (*p == '0');
+            }
+        }
+    }
+    if (!anyDigit)
+    {
+        return first;
+    }
+
+    // Exponent
+    if (p != last && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p+1;
+        bool negExp = false;
+        if (q != last && (*q == '-' || *q == '+'))
+        {
+            negExp = (*q == '-');
+            ++q;
+        }
+        if (q != last && IsDigit(*q))
+        {
+            int e = 0;
+            for (; q != last && IsDigit(*q); ++q)
+            {
+                if (e < 100000)
+                {
+                    e = e*10+(*q-'0');
+                }
+            }
+            exp10 += negExp ? -e : e;
+            p = q;
+        }
+    }
+
+    if (exact && m <= maxExactMantissa && exp10 >= -22 && exp10 <= 22)
+    {
+        double v = static_cast<double>(m);
+        v = exp10 < 0 ? v/pow10[-exp10] : v*pow10[exp10];
+        x = static_cast<ValueT>(neg ? -v : v);
+    }
+    else if (m == 0)
+    {
+        x = neg ? -ValueT(0) : ValueT(0);
+    }
+    else
+    {
+        std::istringstream iss(std::string(first, p));
+        iss.imbue(std::locale::classic());
+
+        double v = 0;
+        iss >> v;
+        const bool ok = !iss.fail();
+        iss.clear();
+        if (iss.peek() != std::istringstream::traits_type::eof())
+        {
+            // Trailing characters not consumed by the stream
+            return first;
+        }
+        if (!ok)
+        {
+            // The syntax has been checked above, so this is a range error
+            if (exp10 < 0)
+            {
+                v = neg ? -0.0 : 0.0;
+            }
+            else
+            {
+                v = neg ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+            }
+        }
+        x = static_cast<ValueT>(v);
+    }
+
+    return p;
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_PARSE_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,247 @@
+/**
+ * \file fl/detail/quantile_sketch.h
+ *
+ * \brief A mergeable sketch for approximate quantiles
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_QUANTILE_SKETCH_H
+#define FL_DETAIL_QUANTILE_SKETCH_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <fl/macro.h>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+namespace fl { namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+/// Declarations
+////////////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * A sketch of a stream of values giving approximate quantiles in bounded
+ * memory.
+ *
+ * Values are kept in levels, where each value of level \f$h\f$ stands for
+ * \f$2^h\f$ values of the stream.
+ * When a level holds \f$k\f$ values, it is compacted: its values are sorted
+ * and every other one is moved to the next level (taking alternately the
+ * ones at odd and at even positions, so that rank errors tend to cancel).
+ * So, after \f$n\f$ values, the sketch holds \f$O(k \log(n/k))\f$ values and
+ * the rank of a quantile is off by \f$O(n \log(n/k)/k)\f$ at most.
+ *
+ * Sketches of different parts of a stream can be merged, so that they can be
+ * built in parallel.
+ *
+ * \tparam ValueT The type of values
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class QuantileSketch
+{
+public:
+    /// Constructs an empty sketch whose levels hold at most \a k values
+    explicit QuantileSketch(std::size_t k = 256);
+
+    /// Adds the value \a x
+    void insert(ValueT x);
+
+    /// Adds the values summarized by \a other
+    void merge(const QuantileSketch& other);
+
+    /// Returns the number of added values
+    std::size_t size() const;
+
+    /// Tells if no value has been added
+    bool empty() const;
+
+    /// Returns (an approximation of) the \a p-quantile of the added values, with \a p in [0,1] (NaN if there is no value)
+    ValueT quantile(double p) const;
+
+    /// Removes all the values
+    void clear();
+
+
+private:
+    /// Moves half the values of level \a h to the next level
+    void compact(std::size_t h);
+
+
+private:
+    std::size_t k_; ///< The maximum number of values in a level
+    std::size_t n_; ///< The number of added values
+    std::vector< std::vector<ValueT> > levels_; ///< The values of each level
+    std::vector<std::size_t> offsets_; ///< The position (0 or 1) of the first value to promote at the next compaction of each level
+}; // QuantileSketch
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename ValueT>
+QuantileSketch<ValueT>::QuantileSketch(std::size_t k)
+: k_(std::max(k, static_cast<std::size_t>(2))),
+  n_(0),
+  levels_(1),
+  offsets_(1, 0)
+{
+}
+
+template <typename ValueT>
+void QuantileSketch<ValueT>::insert(ValueT x)
+{
+    levels_[0].push_back(x);
+    ++n_;
+
+    if (levels_[0].size() >= k_)
+    {
+        this->compact(0);
+    }
+}
+
+template <typename ValueT>
+void QuantileSketch<ValueT>::merge(const QuantileSketch& other)
+{
+    if (other.levels_.size() > levels_.size())
+    {
+        levels_.resize(other.levels_.size());
+        offsets_.resize(other.levels_.size(), 0);
+    }
+    for (std::size_t h = 0,
+                     nh = other.levels_.size();
+         h < nh;
+         ++h)
+    {
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+    }
+    n_ += other.n_;
+
+    // Compacting a level can only fill the levels above it
+    for (std::size_t h = 0; h < levels_.size(); ++h)
+    {
+        if (levels_[h].size() >= k_)
+        {
+            this->compact(h);
+        }
+    }
+}
+
+template <typename ValueT>
+std::size_t QuantileSketch<ValueT>::size() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+bool QuantileSketch<ValueT>::empty() const
+{
+    return n_ == 0;
+}
+
+template <typename ValueT>
+ValueT QuantileSketch<ValueT>::quantile(double p) const
+{
+    if (n_ == 0)
+    {
+        return std::numeric_limits<ValueT>::quiet_NaN();
+    }
+
+    // Sorts the values along with their weights
+    std::vector< std::pair<ValueT,std::size_t> > items;
+    for (std::size_t h = 0,
+                     nh = levels_.size();
+         h < nh;
+         ++h)
+    {
+        const std::size_t w = static_cast<std::size_t>(1) << h;
+        for (std::size_t i = 0,
+                         ni = levels_[h].size();
+             i < ni;
+             ++i)
+        {
+            items.push_back(std::make_pair(levels_[h][i], w));
+        }
+    }
+    std::sort(items.begin(), items.end());
+
+    // Returns the first value whose cumulative weight reaches the rank
+    const double rank = std::min(std::max(p, 0.0), 1.0)*n_;
+    std::size_t cum = 0;
+    for (std::size_t i = 0,
+                     ni = items.size();
+         i < ni;
+         ++i)
+    {
+        cum += items[i].second;
+        if (cum >= rank && cum > 0)
+        {
+            return items[i].first;
+        }
+    }
+
+    return items.back().first;
+}
+
+template <typename ValueT>
+void QuantileSketch<ValueT>::clear()
+{
+    n_ = 0;
+    levels_.assign(1, std::vector<ValueT>());
+    offsets_.assign(1, 0);
+}
+
+template <typename ValueT>
+void QuantileSketch<ValueT>::compact(std::size_t h)
+{
+    if (h+1 == levels_.size())
+    {
+        levels_.resize(h+2);
+        offsets_.resize(h+2, 0);
+    }
+
+    std::vector<ValueT>& level = levels_[h];
+    std::sort(level.begin(), level.end());
+
+    // With an odd number of values, the largest one stays, so that the
+    // total weight is preserved
+    const std::size_t np = level.size() - level.size() % 2;
+    for (std::size_t i = offsets_[h]; i < np; i += 2)
+    {
+        levels_[h+1].push_back(level[i]);
+    }
+    level.erase(level.begin(), level.begin()+np);
+    offsets_[h] = 1-offsets_[h];
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_QUANTILE_SKETCH_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
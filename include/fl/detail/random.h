@@ -27,6 +27,7 @@
 
 
 //#include <cstdlib>
+#include <cstddef>
 #include <fl/fuzzylite.h>
 #ifdef FL_CPP11
 # include <random>
@@ -80,6 +81,14 @@ int RandUnif(int from, int thru, EngineT& eng)
     return d(eng, parm_t{from, thru});
 }
 
+/// Draws an index uniformly in [\a from, \a thru], over the whole range of std::size_t
+template <typename EngineT>
+std::size_t RandIndex(std::size_t from, std::size_t thru, EngineT& eng)
+{
+    std::uniform_int_distribution<std::size_t> d(from, thru);
+    return d(eng);
+}
+
 template <typename RealT>
 RealT RandUnif(RealT from, RealT upto)
 {
@@ -135,6 +144,14 @@ int RandUnif(int from, int thru, EngineT& eng)
     return d(eng, typename boost::random::uniform_int_distribution<>::param_type(from, thru));
 }
 
+/// Draws an index uniformly in [\a from, \a thru], over the whole range of std::size_t
+template <typename EngineT>
+std::size_t RandIndex(std::size_t from, std::size_t thru, EngineT& eng)
+{
+    boost::random::uniform_int_distribution<std::size_t> d(from, thru);
+    return d(eng);
+}
+
 template <typename RealT>
 RealT RandUnif(RealT from, RealT upto)
 {
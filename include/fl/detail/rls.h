@@ -28,6 +28,7 @@
 
 #include <cstddef>
 #include <fl/detail/math.h>
+#include <fl/detail/sparse.h>
 #include <fl/fuzzylite.h>
 #include <fl/macro.h>
 #include <limits>
@@ -51,6 +52,11 @@ namespace fl { namespace detail {
  * \f]
  * where \f$\hat{y}(n)=\sum_{k=0}^p \theta_k u(n-k)\f$.
  *
+ * The covariance matrix is stored together with a scale factor, so that
+ * sparse inputs can be processed by only updating the entries of the
+ * covariance matrix that really change (see
+ * estimate(const SparseVector<ValueT>&, const std::vector<ValueT>&)).
+ *
  * \tparam ValueT The type for floating-point numbers
  *
  * \author Marco Guazzone (marco.guazzone@gmail.com)
@@ -122,6 +128,31 @@ public:
     /// Performs an iteration of the RLS algorithm with respect to the given inputs and outputs, and returns the estimated output
     std::vector<ValueT> estimate(const std::vector<ValueT>& u, const std::vector<ValueT>& y);
 
+    /**
+     * Performs an iteration of the RLS algorithm with respect to the given
+     * sparse inputs and outputs, and returns the estimated output.
+     *
+     * The result is the same of the dense update.
+     * For a model of order zero (where the regressor is the input itself),
+     * the cost is \f$O(n q + g^2)\f$ instead of \f$O(n^2)\f$, where
+     * \f$q\f$ is the number of nonzero inputs and \f$g\f$ is the number of
+     * nonzero elements of the gain vector (see
+     * KalmanFilter::estimate(const SparseVector<ValueT>&, const ValueT*, ValueT*)),
+     * and no memory is allocated but the returned vector.
+     */
+    std::vector<ValueT> estimate(const SparseVector<ValueT>& u, const std::vector<ValueT>& y);
+
+
+private:
+    /// Checks the dimensions of inputs \a u and outputs \a y, and of the model
+    void check(std::size_t nu, const std::vector<ValueT>& y) const;
+
+    /// Updates the parameter and covariance matrices with the regressor currently stored in phi_ and the outputs \a y, and returns the estimated output
+    std::vector<ValueT> update(const std::vector<ValueT>& y);
+
+    /// Folds the scale factor into the covariance matrix when it gets too large or too small (always if \a force is \c true)
+    void normalizeScale(bool force = false);
+
 
 private:
     std::size_t p_; ///< The model order
@@ -129,9 +160,13 @@ private:
     std::size_t ny_; ///< The output dimension
     ValueT lambda_; ///< Forgetting factor
     MatrixType Theta_; ///< Parameter matrix
-    MatrixType P_; ///< Covariance matrix
+    MatrixType P_; ///< Unscaled covariance matrix
+    ValueT scale_; ///< Scale factor of the covariance matrix (the covariance matrix is scale_*P_)
     VectorType phi_; ///< Regressor vector
     std::size_t count_; ///< The total number of iterations performed so far
+    VectorType g_; ///< Auxiliary vector for the gain of the sparse update
+    VectorType e_; ///< Auxiliary vector for the a-priori error of the sparse update
+    std::vector<std::size_t> support_; ///< Auxiliary vector for the positions of the nonzero elements of the gain
 }; // RecursiveLeastSquares
 
 
@@ -146,6 +181,7 @@ RecursiveLeastSquaresEstimator<ValueT>::RecursiveLeastSquaresEstimator()
   nu_(0),
   ny_(0),
   lambda_(0),
+  scale_(1),
   count_(0)
 {
 }
@@ -156,6 +192,7 @@ RecursiveLeastSquaresEstimator<ValueT>::RecursiveLeastSquaresEstimator(std::size
   nu_(nu),
   ny_(ny),
   lambda_(lambda),
+  scale_(1),
   count_(0)
 {
     this->reset();
@@ -223,7 +260,16 @@ ValueT RecursiveLeastSquaresEstimator<ValueT>::getForgettingFactor() const
 template <typename ValueT>
 std::vector< std::vector<ValueT> > RecursiveLeastSquaresEstimator<ValueT>::getCovarianceInverse() const
 {
-    return P_;
+    MatrixType P(P_);
+    for (std::size_t i = 0; i < P.size(); ++i)
+    {
+        for (std::size_t j = 0; j < P[i].size(); ++j)
+        {
+            P[i][j] *= scale_;
+        }
+    }
+
+    return P;
 }
 
 //template <typename ValueT>
@@ -270,6 +316,11 @@ void RecursiveLeastSquaresEstimator<ValueT>::reset(ValueT delta)
         P_[i].resize(n, 0);
         P_[i][i] = delta;
     }
+    scale_ = 1;
+
+    g_.assign(n, 0);
+    e_.assign(ny_, 0);
+    support_.assign(n, 0);
 
     count_ = 0;
 }
@@ -284,7 +335,153 @@ std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(UIterT uFir
 template <typename ValueT>
 std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const std::vector<ValueT>& u, const std::vector<ValueT>& y)
 {
-    if (u.size() != nu_)
+    this->check(u.size(), y);
+
+    ++count_;
+
+    // Update the regressor vector
+    //  $\phi(k+1) = [u_1(k) ... u_1(k-p+1) ... u_{n_u}(k) ... u_{n_u}(k-p+1)]^T$
+    // - Shift the old p-1 u values: \phi(k+1) = [? u_1(k-1) ... u_1(k-p+1) ? u_2(k-1) ... u_{n_u}(k-p+1)]^T
+    // - Copy the new u into the regressor vector: \phi(k+1) = [u_1(k) u_1(k-1) ... u_1(k-p+1) u_2(k) u_2(k-1) ... u_{n_u}(k-p+1)]^T
+    for (std::size_t j = 0; j < nu_; ++j)
+    {
+        const std::size_t jna = j*p_;
+
+        for (std::size_t i = p_-1; i > 0; --i)
+        {
+            phi_[i+jna] = phi_[(i-1)+jna];
+        }
+        phi_[jna] = u[j];
+    }
+
+    return this->update(y);
+}
+
+template <typename ValueT>
+std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const SparseVector<ValueT>& u, const std::vector<ValueT>& y)
+{
+    this->check(u.size(), y);
+
+    ++count_;
+
+    const std::size_t nnz = u.numOfNonZeros();
+
+    if (p_ > 1)
+    {
+        // Past inputs make the regressor dense: updates it in place as in the dense case
+        for (std::size_t j = 0; j < nu_; ++j)
+        {
+            const std::size_t jna = j*p_;
+
+            for (std::size_t i = p_-1; i > 0; --i)
+            {
+                phi_[i+jna] = phi_[(i-1)+jna];
+            }
+            phi_[jna] = 0;
+        }
+        for (std::size_t k = 0; k < nnz; ++k)
+        {
+            phi_[u.index(k)*p_] = u.value(k);
+        }
+
+        return this->update(y);
+    }
+
+    // The regressor is the input itself: the covariance matrix only changes
+    // in the rows and columns of the support of the gain
+    const std::size_t n = phi_.size();
+    if (P_.size() != n || Theta_.size() != n || g_.size() != n || e_.size() != ny_)
+    {
+        FL_THROW2(std::logic_error, "RLS estimator has not been reset after a change of dimensions");
+    }
+
+    std::fill(phi_.begin(), phi_.end(), ValueT(0));
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        phi_[u.index(k)] = u.value(k);
+    }
+
+    // g = P*phi = scale*sum_k phi_k*P(k,:) (P is symmetric), only over the nonzero elements of phi
+    std::fill(g_.begin(), g_.end(), ValueT(0));
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        const VectorType& Pk = P_[u.index(k)];
+        const ValueT phik = u.value(k);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            g_[i] += phik*Pk[i];
+        }
+    }
+    std::size_t nsupp = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (g_[i] != 0)
+        {
+            g_[i] *= scale_;
+            support_[nsupp++] = i;
+        }
+    }
+
+    // denom = lambda + phi'*P*phi
+    ValueT denom = lambda_;
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        denom += u.value(k)*g_[u.index(k)];
+    }
+
+    // P = (P - g*g'/denom)/lambda, where only the entries in the support of g change
+    const ValueT invDenom = ValueT(1)/denom;
+    const ValueT c = invDenom/scale_;
+    for (std::size_t k1 = 0; k1 < nsupp; ++k1)
+    {
+        const std::size_t i = support_[k1];
+        VectorType& Pi = P_[i];
+        const ValueT gi = g_[i]*c;
+        for (std::size_t k2 = 0; k2 < nsupp; ++k2)
+        {
+            const std::size_t j = support_[k2];
+            Pi[j] -= gi*g_[j];
+        }
+    }
+    scale_ /= lambda_;
+
+    // yhat = (phi'*Theta)' (the output estimated before the update)
+    VectorType yhat(ny_, 0);
+    for (std::size_t k = 0; k < nnz; ++k)
+    {
+        const VectorType& Thetak = Theta_[u.index(k)];
+        const ValueT phik = u.value(k);
+        for (std::size_t j = 0; j < ny_; ++j)
+        {
+            yhat[j] += phik*Thetak[j];
+        }
+    }
+    for (std::size_t j = 0; j < ny_; ++j)
+    {
+        e_[j] = y[j]-yhat[j];
+    }
+
+    // Theta = Theta + P_new*phi*e', where P_new*phi = g/denom
+    for (std::size_t k = 0; k < nsupp; ++k)
+    {
+        const std::size_t i = support_[k];
+        VectorType& Thetai = Theta_[i];
+        const ValueT gi = g_[i]*invDenom;
+        for (std::size_t j = 0; j < ny_; ++j)
+        {
+            Thetai[j] += gi*e_[j];
+        }
+    }
+
+    this->normalizeScale();
+
+    return yhat;
+}
+
+template <typename ValueT>
+void RecursiveLeastSquaresEstimator<ValueT>::check(std::size_t nu, const std::vector<ValueT>& y) const
+{
+    if (nu != nu_)
     {
         FL_THROW2(std::invalid_argument, "Input dimension does not match");
     }
@@ -304,10 +501,11 @@ std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const std::
     {
         FL_THROW2(std::logic_error, "Wrong model order");
     }
+}
 
-    ++count_;
-
-    const std::size_t n = phi_.size();
+template <typename ValueT>
+std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::update(const std::vector<ValueT>& y)
+{
 
 //std::cerr << "COUNT=" << count_ << std::endl;//XXX
 //std::cerr << "y(k)="; fl::detail::VectorOutput(std::cerr, y); std::cerr << std::endl; //XXX
@@ -316,29 +514,12 @@ std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const std::
 //std::cerr << "Theta(k)="; fl::detail::MatrixOutput(std::cerr, Theta_); std::cerr << std::endl; //XXX
     VectorType yhat;
 
-    // Update the regressor vector
-    //  $\phi(k+1) = [u_1(k) ... u_1(k-p+1) ... u_{n_u}(k) ... u_{n_u}(k-p+1)]^T$
-    VectorType phiNew(n, 0);
-    // - Copy the new u into the regressor vector: \phi(k+1) = [u_1(k) 0 ... 0 u_2(k) 0 ... 0 u_{n_u}(k) 0 ... 0]^T
-    for (std::size_t i = 0; i < nu_; ++i)
-    {
-        phiNew[i*p_] = u[i];
-    }
-    // - Append the old na-1 u values into the regressor vector: \phi(k+1) = [u_1(k) u_1(k-1) ... u_1(k-p+1) u_2(k) u_2(k-1) ... u_{n_u}(k-p+1)]^T
-    for (std::size_t i = 1; i < p_; ++i)
-    {
-        for (std::size_t j = 0; j < nu_; ++j)
-        {
-            const std::size_t jna = j*p_;
-
-            phiNew[i+jna] = phi_[(i-1)+jna];
-        }
-    }
-    phi_ = phiNew;
-
     // Update parameter and covariance matrices (to be done only after enough observations have been seen)
     if (count_ >= p_)
     {
+        // The dense update touches the whole covariance matrix anyway
+        this->normalizeScale(true);
+
 #if 0
             // Compute the Gain:
             //  $l(k+1) = \frac{P(k)\phi(k+1)}{\lambda(k)+\phi^T(k+1)P(k)\phi(k+1)}$
@@ -392,9 +573,9 @@ std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const std::
 			VectorType aux2 = fl::detail::VectorMatrixProduct(phi_, P_);
 			MatrixType aux3 = fl::detail::VectorOuterProduct<MatrixType>(aux1, aux2);
 			const ValueT denom = lambda_ + fl::detail::VectorInnerProduct(phi_, aux1);
-			aux3 = fl::detail::MatrixScalarProduct(aux3, 1.0/denom);
+			aux3 = fl::detail::MatrixScalarProduct(aux3, ValueT(1)/denom);
 			P_ = fl::detail::MatrixDiff(P_, aux3);
-			P_ = fl::detail::MatrixScalarProduct(P_, 1.0/lambda_);
+			P_ = fl::detail::MatrixScalarProduct(P_, ValueT(1)/lambda_);
 
             // Computes the output estimate
             //  $\hat{y}(k+1) = (\phi^T(k+1)\Theta(k))^T$
@@ -408,10 +589,13 @@ std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const std::
 			//const MatrixType aux6 = fl::detail::VectorOuterProduct<MatrixType>(phi_, aux5);
 			//const MatrixType aux7 = fl::detail::MatrixProduct(P_, aux6);
 			//Theta_ = fl::detail::MatrixSum(Theta_, aux7);
+			// Since $P(k+1)\phi(k+1) = \frac{P(k)\phi(k+1)}{\lambda+\phi^T(k+1)P(k)\phi(k+1)}$, use the gain
+			// computed from P(k) rather than the updated P(k+1): the latter suffers from cancellation when
+			// P(k) is large (e.g., right after a reset), which badly hurts single-precision estimates.
+			const VectorType gain = fl::detail::VectorScalarProduct(aux1, ValueT(1)/denom);
 			aux1 = fl::detail::VectorDiff(y, yhat);
-			aux3 = fl::detail::VectorOuterProduct<MatrixType>(phi_, aux1);
-			MatrixType aux4 = fl::detail::MatrixProduct(P_, aux3);
-			Theta_ = fl::detail::MatrixSum(Theta_, aux4);
+			aux3 = fl::detail::VectorOuterProduct<MatrixType>(gain, aux1);
+			Theta_ = fl::detail::MatrixSum(Theta_, aux3);
 #endif // if 0
 //std::cerr << "RLS - Covariance Matrix ="; fl::detail::MatrixOutput(std::cerr, P_); std::cerr << std::endl; //XXX
 //std::cerr << "RLS - Regressor = "; fl::detail::VectorOutput(std::cerr, phi_); std::cerr << std::endl; //XXX
@@ -430,6 +614,26 @@ std::vector<ValueT> RecursiveLeastSquaresEstimator<ValueT>::estimate(const std::
     return yhat;
 }
 
+template <typename ValueT>
+void RecursiveLeastSquaresEstimator<ValueT>::normalizeScale(bool force)
+{
+    // Bounds are kept well inside the range of single-precision numbers
+    const ValueT maxScale = 1e+16;
+    const ValueT minScale = 1e-16;
+
+    if (scale_ != 1 && (force || scale_ > maxScale || scale_ < minScale))
+    {
+        for (std::size_t i = 0; i < P_.size(); ++i)
+        {
+            for (std::size_t j = 0; j < P_[i].size(); ++j)
+            {
+                P_[i][j] *= scale_;
+            }
+        }
+        scale_ = 1;
+    }
+}
+
 }} // Namespace fl::detail
 
 #endif // FL_DETAIL_RLS_H
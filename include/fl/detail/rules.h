@@ -0,0 +1,86 @@
+/**
+ * \file fl/detail/rules.h
+ *
+ * \brief Thread-safe creation of fuzzylite rules
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_RULES_H
+#define FL_DETAIL_RULES_H
+
+
+#include <boost/exception_ptr.hpp>
+#include <cstddef>
+#include <fl/Engine.h>
+#include <fl/fuzzylite.h>
+#include <fl/rule/Rule.h>
+#include <fl/rule/RuleBlock.h>
+#include <string>
+#include <vector>
+
+
+namespace fl { namespace detail {
+
+/**
+ * Parses the given rules and adds them to \a p_rules.
+ *
+ * Parsing goes through the fuzzylite factories, which are shared by all
+ * threads, so it is serialized by the \c fl_fuzzylite_factories critical
+ * section, which must guard any other use of the factories from parallel
+ * code (e.g., fl::anfis::Engine::build).
+ * The texts of the rules are meant to be composed beforehand, so that only
+ * parsing runs inside the critical section.
+ */
+inline void AddParsedRules(fl::RuleBlock* p_rules, const std::vector<std::string>& texts, const fl::Engine* p_engine)
+{
+    // No exception can leave a critical section, so it is rethrown outside
+    boost::exception_ptr p_err;
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (fl_fuzzylite_factories)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        try
+        {
+            for (std::size_t r = 0,
+                             nr = texts.size();
+                 r < nr;
+                 ++r)
+            {
+                p_rules->addRule(fl::Rule::parse(texts[r], p_engine));
+            }
+        }
+        catch (...)
+        {
+            p_err = boost::current_exception();
+        }
+    }
+
+    if (p_err)
+    {
+        boost::rethrow_exception(p_err);
+    }
+}
+
+}} // Namespace fl::detail
+
+#endif // FL_DETAIL_RULES_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
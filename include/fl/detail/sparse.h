@@ -0,0 +1,546 @@
+/**
+ * \file fl/detail/sparse.h
+ *
+ * \brief Sparse vectors and sparse-aware least-squares accumulators
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2014 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_DETAIL_SPARSE_H
+#define FL_DETAIL_SPARSE_H
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fl/detail/lsq.h>
+#include <fl/detail/memory.h>
+#include <fl/macro.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl { namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+/// Declarations
+////////////////////////////////////////////////////////////////////////////////
+
+
+/**
+ * A sparse vector storing only its nonzero elements.
+ *
+ * Elements are stored as (index, value) pairs sorted by increasing index.
+ * The buffers are never shrunk, so that a vector can be cleared and filled
+ * again for each sample without allocating memory.
+ *
+ * \tparam ValueT The type for floating-point numbers
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class SparseVector
+{
+public:
+    /// Constructs an empty (i.e., all-zero) vector of size \a n
+    explicit SparseVector(std::size_t n = 0);
+
+    /// Constructs a vector from the dense range [\a first, \a last), dropping the elements whose magnitude is not greater than \a threshold
+    template <typename IterT>
+    SparseVector(IterT first, IterT last, ValueT threshold = 0);
+
+    /// Assigns the dense range [\a first, \a last) to this vector, dropping the elements whose magnitude is not greater than \a threshold
+    template <typename IterT>
+    void assign(IterT first, IterT last, ValueT threshold = 0);
+
+    /// Changes the size of this vector and removes all its nonzero elements
+    void resize(std::size_t n);
+
+    /// Removes all the nonzero elements (the size is left unchanged)
+    void clear();
+
+    /// Appends the element \a value at position \a i, which must be greater than the one of the last stored element
+    void append(std::size_t i, ValueT value);
+
+    /// Returns the size of this vector
+    std::size_t size() const;
+
+    /// Returns the number of stored elements
+    std::size_t numOfNonZeros() const;
+
+    /// Returns the position of the \a k-th stored element
+    std::size_t index(std::size_t k) const;
+
+    /// Returns the value of the \a k-th stored element
+    ValueT value(std::size_t k) const;
+
+    /// Returns the dense representation of this vector
+    std::vector<ValueT> toDense() const;
+
+
+private:
+    std::size_t n_; ///< The size of the vector
+    std::vector<std::size_t> idx_; ///< The positions of the stored elements
+    std::vector<ValueT> val_; ///< The values of the stored elements
+}; // SparseVector
+
+
+/**
+ * Accumulator of the normal equations
+ * \f$\mathbf{A}^T\mathbf{A}\mathbf{X}=\mathbf{A}^T\mathbf{B}\f$ of a
+ * least-squares problem whose coefficient matrix \f$\mathbf{A}\f$ is given
+ * one (sparse) row at a time.
+ *
+ * Accumulating a row with \f$q\f$ nonzero elements costs \f$O(q^2)\f$
+ * operations, instead of the \f$O(n^2)\f$ of a dense row.
+ * The system is solved only once, at the end, through the Cholesky
+ * factorization of \f$\mathbf{A}^T\mathbf{A}+\lambda\mathbf{I}\f$, which
+ * costs \f$O(n^3/3)\f$ operations independently of the number of rows.
+ *
+ * The price is accuracy: the condition number of
+ * \f$\mathbf{A}^T\mathbf{A}\f$ is the square of the one of
+ * \f$\mathbf{A}\f$, so about half of the significant digits that a solver
+ * working on \f$\mathbf{A}\f$ itself would keep can be lost on
+ * ill-conditioned problems (a positive \f$\lambda\f$ mitigates that).
+ * When the matrix is not numerically positive definite (e.g., because some
+ * unknown is never excited), the system is solved through the SVD instead,
+ * so that rank-deficient problems get the minimum-norm solution.
+ *
+ * \tparam ValueT The type for floating-point numbers
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT>
+class SparseNormalEquations
+{
+public:
+    /// Constructs an accumulator for \a n unknowns and \a nrhs right-hand sides
+    explicit SparseNormalEquations(std::size_t n = 0, std::size_t nrhs = 1);
+
+    /// Changes the dimensions of the problem and resets the accumulated equations
+    void reshape(std::size_t n, std::size_t nrhs);
+
+    /// Gets the number of unknowns
+    std::size_t numOfUnknowns() const;
+
+    /// Gets the number of right-hand sides
+    std::size_t numOfRightHandSides() const;
+
+    /// Gets the number of accumulated rows
+    std::size_t numOfRows() const;
+
+    /// Resets the accumulated equations
+    void reset();
+
+    /// Accumulates the row \a a of the coefficient matrix together with the row \a b (of size nrhs) of the right-hand side matrix
+    void accumulate(const SparseVector<ValueT>& a, const ValueT* b);
+
+    /**
+     * Solves the accumulated equations and returns the \f$n \times nrhs\f$
+     * solution matrix.
+     *
+     * If \a lambda is positive, solves the ridge problem
+     * \f$(\mathbf{A}^T\mathbf{A}+\lambda\mathbf{I})\mathbf{X}=\mathbf{A}^T\mathbf{B}\f$.
+     */
+    std::vector< std::vector<ValueT> > solve(ValueT lambda = 0) const;
+
+
+private:
+    /// Solves the equations through the Cholesky factorization; returns \c false if the matrix is not numerically positive definite
+    bool solveCholesky(ValueT lambda, std::vector< std::vector<ValueT> >& X) const;
+
+    /// Solves the equations through the SVD
+    std::vector< std::vector<ValueT> > solveSVD(ValueT lambda) const;
+
+
+private:
+    std::size_t n_; ///< The number of unknowns
+    std::size_t nrhs_; ///< The number of right-hand sides
+    std::size_t count_; ///< The number of accumulated rows
+    AlignedArray<ValueT> AtA_; ///< The upper triangle of A'A (n_ x n_, row-major)
+    AlignedArray<ValueT> AtB_; ///< The matrix A'B (n_ x nrhs_, row-major)
+}; // SparseNormalEquations
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Definitions
+////////////////////////////////////////////////////////////////////////////////
+
+
+template <typename ValueT>
+SparseVector<ValueT>::SparseVector(std::size_t n)
+: n_(n)
+{
+}
+
+template <typename ValueT>
+template <typename IterT>
+SparseVector<ValueT>::SparseVector(IterT first, IterT last, ValueT threshold)
+: n_(0)
+{
+    this->assign(first, last, threshold);
+}
+
+template <typename ValueT>
+template <typename IterT>
+void SparseVector<ValueT>::assign(IterT first, IterT last, ValueT threshold)
+{
+    this->resize(0);
+
+    std::size_t i = 0;
+    for (; first != last; ++first)
+    {
+        const ValueT x = *first;
+        if (std::abs(x) > threshold)
+        {
+            idx_.push_back(i);
+            val_.push_back(x);
+        }
+        ++i;
+    }
+    n_ = i;
+}
+
+template <typename ValueT>
+void SparseVector<ValueT>::resize(std::size_t n)
+{
+    n_ = n;
+    this->clear();
+}
+
+template <typename ValueT>
+void SparseVector<ValueT>::clear()
+{
+    idx_.clear();
+    val_.clear();
+}
+
+template <typename ValueT>
+void SparseVector<ValueT>::append(std::size_t i, ValueT value)
+{
+    if (i >= n_ || (!idx_.empty() && i <= idx_.back()))
+    {
+        FL_THROW2(std::invalid_argument, "Sparse elements must be appended by increasing position within the vector size");
+    }
+
+    idx_.push_back(i);
+    val_.push_back(value);
+}
+
+template <typename ValueT>
+std::size_t SparseVector<ValueT>::size() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+std::size_t SparseVector<ValueT>::numOfNonZeros() const
+{
+    return idx_.size();
+}
+
+template <typename ValueT>
+std::size_t SparseVector<ValueT>::index(std::size_t k) const
+{
+    FL_DEBUG_ASSERT( k < idx_.size() );
+
+    return idx_[k];
+}
+
+template <typename ValueT>
+ValueT SparseVector<ValueT>::value(std::size_t k) const
+{
+    FL_DEBUG_ASSERT( k < val_.size() );
+
+    return val_[k];
+}
+
+template <typename ValueT>
+std::vector<ValueT> SparseVector<ValueT>::toDense() const
+{
+    std::vector<ValueT> x(n_, 0);
+
+    for (std::size_t k = 0,
+                     nk = idx_.size();
+         k < nk;
+         ++k)
+    {
+        x[idx_[k]] = val_[k];
+    }
+
+    return x;
+}
+
+template <typename ValueT>
+SparseNormalEquations<ValueT>::SparseNormalEquations(std::size_t n, std::size_t nrhs)
+: n_(0),
+  nrhs_(0),
+  count_(0)
+{
+    this->reshape(n, nrhs);
+}
+
+template <typename ValueT>
+void SparseNormalEquations<ValueT>::reshape(std::size_t n, std::size_t nrhs)
+{
+    n_ = n;
+    nrhs_ = nrhs;
+    AtA_.resize(n_*n_);
+    AtB_.resize(n_*nrhs_);
+
+    this->reset();
+}
+
+template <typename ValueT>
+std::size_t SparseNormalEquations<ValueT>::numOfUnknowns() const
+{
+    return n_;
+}
+
+template <typename ValueT>
+std::size_t SparseNormalEquations<ValueT>::numOfRightHandSides() const
+{
+    return nrhs_;
+}
+
+template <typename ValueT>
+std::size_t SparseNormalEquations<ValueT>::numOfRows() const
+{
+    return count_;
+}
+
+template <typename ValueT>
+void SparseNormalEquations<ValueT>::reset()
+{
+    std::fill(AtA_.begin(), AtA_.end(), ValueT(0));
+    std::fill(AtB_.begin(), AtB_.end(), ValueT(0));
+    count_ = 0;
+}
+
+template <typename ValueT>
+void SparseNormalEquations<ValueT>::accumulate(const SparseVector<ValueT>& a, const ValueT* b)
+{
+    if (a.size() != n_)
+    {
+        FL_THROW2(std::invalid_argument, "Row dimension does not match the number of unknowns");
+    }
+
+    const std::size_t nnz = a.numOfNonZeros();
+
+    for (std::size_t k1 = 0; k1 < nnz; ++k1)
+    {
+        const std::size_t i = a.index(k1);
+        const ValueT ai = a.value(k1);
+
+        // Upper triangle only: indices are sorted, so j >= i
+        ValueT* AtAi = AtA_.data()+i*n_;
+        for (std::size_t k2 = k1; k2 < nnz; ++k2)
+        {
+            AtAi[a.index(k2)] += ai*a.value(k2);
+        }
+
+        ValueT* AtBi = AtB_.data()+i*nrhs_;
+        for (std::size_t j = 0; j < nrhs_; ++j)
+        {
+            AtBi[j] += ai*b[j];
+        }
+    }
+
+    ++count_;
+}
+
+template <typename ValueT>
+std::vector< std::vector<ValueT> > SparseNormalEquations<ValueT>::solve(ValueT lambda) const
+{
+    if (n_ == 0)
+    {
+        return std::vector< std::vector<ValueT> >();
+    }
+    if (lambda < 0)
+    {
+        FL_THROW2(std::invalid_argument, "Regularization parameter must be non-negative");
+    }
+
+    std::vector< std::vector<ValueT> > X;
+    if (!this->solveCholesky(lambda, X))
+    {
+        X = this->solveSVD(lambda);
+    }
+
+    return X;
+}
+
+template <typename ValueT>
+bool SparseNormalEquations<ValueT>::solveCholesky(ValueT lambda, std::vector< std::vector<ValueT> >& X) const
+{
+    // Upper-triangular factor R of A'A+lambda*I = R'R (row-major, upper triangle only)
+    AlignedArray<ValueT> R(AtA_);
+
+    ValueT maxDiag = 0;
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        R[i*n_+i] += lambda;
+        maxDiag = std::max(maxDiag, R[i*n_+i]);
+    }
+
+    if (!(maxDiag > 0))
+    {
+        return false;
+    }
+
+    // Pivots below this threshold mean that the matrix is (numerically) singular
+    const ValueT tol = static_cast<ValueT>(n_)*std::numeric_limits<ValueT>::epsilon()*maxDiag;
+
+    // Right-looking factorization, so that inner loops run along rows
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        ValueT* Ri = R.data()+i*n_;
+
+        if (!(Ri[i] > tol))
+        {
+            return false;
+        }
+        Ri[i] = std::sqrt(Ri[i]);
+
+        const ValueT inv = 1/Ri[i];
+        for (std::size_t j = i+1; j < n_; ++j)
+        {
+            Ri[j] *= inv;
+        }
+        for (std::size_t k = i+1; k < n_; ++k)
+        {
+            const ValueT rik = Ri[k];
+            if (rik == 0)
+            {
+                continue;
+            }
+            ValueT* Rk = R.data()+k*n_;
+            for (std::size_t j = k; j < n_; ++j)
+            {
+                Rk[j] -= rik*Ri[j];
+            }
+        }
+    }
+
+    // Forward substitution R'Y=A'B, then back substitution RX=Y (row-major, in place)
+    AlignedArray<ValueT> Y(AtB_);
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        const ValueT* Ri = R.data()+i*n_;
+        ValueT* Yi = Y.data()+i*nrhs_;
+
+        for (std::size_t c = 0; c < nrhs_; ++c)
+        {
+            Yi[c] /= Ri[i];
+        }
+        for (std::size_t j = i+1; j < n_; ++j)
+        {
+            const ValueT rij = Ri[j];
+            if (rij == 0)
+            {
+                continue;
+            }
+            ValueT* Yj = Y.data()+j*nrhs_;
+            for (std::size_t c = 0; c < nrhs_; ++c)
+            {
+                Yj[c] -= rij*Yi[c];
+            }
+        }
+    }
+    for (std::size_t i = n_; i-- > 0; )
+    {
+        const ValueT* Ri = R.data()+i*n_;
+        ValueT* Yi = Y.data()+i*nrhs_;
+
+        for (std::size_t j = i+1; j < n_; ++j)
+        {
+            const ValueT rij = Ri[j];
+            if (rij == 0)
+            {
+                continue;
+            }
+            const ValueT* Yj = Y.data()+j*nrhs_;
+            for (std::size_t c = 0; c < nrhs_; ++c)
+            {
+                Yi[c] -= rij*Yj[c];
+            }
+        }
+        for (std::size_t c = 0; c < nrhs_; ++c)
+        {
+            Yi[c] /= Ri[i];
+        }
+    }
+
+    X.assign(n_, std::vector<ValueT>(nrhs_));
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        std::copy(Y.data()+i*nrhs_, Y.data()+(i+1)*nrhs_, X[i].begin());
+    }
+
+    return true;
+}
+
+template <typename ValueT>
+std::vector< std::vector<ValueT> > SparseNormalEquations<ValueT>::solveSVD(ValueT lambda) const
+{
+    LsqSolverPlan<ValueT> plan(n_, n_, nrhs_);
+
+    // Expand the upper triangle into the full (column-major) matrix
+    ValueT* M = plan.matrixData();
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        for (std::size_t j = i; j < n_; ++j)
+        {
+            M[j*n_+i] = M[i*n_+j] = AtA_[i*n_+j];
+        }
+        M[i*n_+i] += lambda;
+    }
+
+    ValueT* R = plan.rhsData();
+    const std::size_t ldR = plan.rhsLeadingDimension();
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        for (std::size_t j = 0; j < nrhs_; ++j)
+        {
+            R[j*ldR+i] = AtB_[i*nrhs_+j];
+        }
+    }
+
+    plan.factorize();
+    plan.solve();
+
+    std::vector< std::vector<ValueT> > X(n_, std::vector<ValueT>(nrhs_));
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        for (std::size_t j = 0; j < nrhs_; ++j)
+        {
+            X[i][j] = R[j*ldR+i];
+        }
+    }
+
+    return X;
+}
+
+}} // Namespace fl::detail
+
+
+#endif // FL_DETAIL_SPARSE_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,255 @@
+/**
+ * \file fl/fis_builder/fuzzy_cmeans.h
+ *
+ * \brief Input partitioning method based on fuzzy c-means clustering for the
+ *  fuzzy identification
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FL_FIS_BUILDER_FUZZY_CMEANS_H
+#define FL_FIS_BUILDER_FUZZY_CMEANS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <fl/cluster/fuzzy_cmeans.h>
+#include <fl/dataset.h>
+#include <fl/dataset_statistics.h>
+#include <fl/fis_builder/takagi_sugeno.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl {
+
+/**
+ * FIS builder based on the <em>fuzzy c-means</em> clustering method.
+ *
+ * The multidimensional input-output data space is partitioned by fuzzy
+ * c-means, and each cluster is used as the basis of a Takagi-Sugeno rule:
+ * the antecedent of the rule has a Gaussian membership function for each
+ * input, centered at the cluster center and as wide as the fuzzy spread of
+ * the cluster in that input, and the consequent is a linear function of
+ * the inputs, whose parameters are estimated by least squares as for
+ * SubtractiveClusteringFisBuilder (see fl::detail::EstimateTakagiSugenoConsequents).
+ *
+ * Unlike subtractive clustering, the number of rules is given (it is the
+ * number of clusters of the fuzzy c-means algorithm), and each rule has its
+ * own widths.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename EngineT>
+class FuzzyCMeansFisBuilder
+{
+public:
+    FuzzyCMeansFisBuilder();
+
+    FuzzyCMeansFisBuilder(const fl::cluster::FuzzyCMeansClustering& fcm);
+
+    FL_unique_ptr<EngineT> build(const fl::DataSet<fl::scalar>& data);
+
+    template <typename MatrixT>
+    FL_unique_ptr<EngineT> build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs);
+
+    /**
+     * Sets the candidate regularization parameters for the estimation of the
+     * consequent parameters.
+     *
+     * \sa SubtractiveClusteringFisBuilder::setRidgeParameters
+     */
+    void setRidgeParameters(const std::vector<fl::scalar>& values);
+
+    /// Gets the candidate regularization parameters for the estimation of the consequent parameters
+    std::vector<fl::scalar> getRidgeParameters() const;
+
+    /// Gets the regularization parameter selected by the last build (zero if no regularization is used)
+    fl::scalar getSelectedRidgeParameter() const;
+
+    /**
+     * Sets the lower and upper bounds of the inputs followed by the outputs,
+     * which are the ranges of the generated variables (by default, the
+     * bounds are the ones of the data, taken from the statistics cached with
+     * the dataset, if any, see fl::ColumnBounds)
+     */
+    void setBounds(const std::vector<fl::scalar>& lower, const std::vector<fl::scalar>& upper);
+
+    /// Gets the lower bounds of the inputs followed by the outputs (empty if they are the ones of the data)
+    std::vector<fl::scalar> lowerBounds() const;
+
+    /// Gets the upper bounds of the inputs followed by the outputs (empty if they are the ones of the data)
+    std::vector<fl::scalar> upperBounds() const;
+
+
+private:
+    /// Builds the FIS with the given bounds of the inputs followed by the outputs
+    template <typename MatrixT>
+    FL_unique_ptr<EngineT> build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs, const std::vector<fl::scalar>& mins, const std::vector<fl::scalar>& maxs);
+
+
+private:
+    fl::cluster::FuzzyCMeansClustering fcm_; ///< The (unapplied) clustering used to partition the data space
+    std::vector<fl::scalar> ridgeParams_; ///< The candidate regularization parameters
+    fl::scalar ridgeParam_; ///< The regularization parameter selected by the last build
+    std::vector<fl::scalar> lbounds_; ///< The lower bounds of the inputs followed by the outputs (empty if taken from data)
+    std::vector<fl::scalar> ubounds_; ///< The upper bounds of the inputs followed by the outputs (empty if taken from data)
+}; // FuzzyCMeansFisBuilder
+
+
+/////////////////////////
+// Template definitions
+/////////////////////////
+
+
+template <typename EngineT>
+FuzzyCMeansFisBuilder<EngineT>::FuzzyCMeansFisBuilder()
+: ridgeParam_(0)
+{
+}
+
+template <typename EngineT>
+FuzzyCMeansFisBuilder<EngineT>::FuzzyCMeansFisBuilder(const fl::cluster::FuzzyCMeansClustering& fcm)
+: fcm_(fcm),
+  ridgeParam_(0)
+{
+}
+
+template <typename EngineT>
+void FuzzyCMeansFisBuilder<EngineT>::setRidgeParameters(const std::vector<fl::scalar>& values)
+{
+    for (std::size_t i = 0,
+                     ni = values.size();
+         i < ni;
+         ++i)
+    {
+        if (values[i] < 0)
+        {
+            FL_THROW2(std::invalid_argument, "Regularization parameters must be non-negative");
+        }
+    }
+
+    ridgeParams_ = values;
+}
+
+template <typename EngineT>
+std::vector<fl::scalar> FuzzyCMeansFisBuilder<EngineT>::getRidgeParameters() const
+{
+    return ridgeParams_;
+}
+
+template <typename EngineT>
+fl::scalar FuzzyCMeansFisBuilder<EngineT>::getSelectedRidgeParameter() const
+{
+    return ridgeParam_;
+}
+
+template <typename EngineT>
+void FuzzyCMeansFisBuilder<EngineT>::setBounds(const std::vector<fl::scalar>& lower, const std::vector<fl::scalar>& upper)
+{
+    if (lower.size() != upper.size())
+    {
+        FL_THROW2(std::invalid_argument, "Vector dimensions mismatch");
+    }
+
+    lbounds_ = lower;
+    ubounds_ = upper;
+}
+
+template <typename EngineT>
+std::vector<fl::scalar> FuzzyCMeansFisBuilder<EngineT>::lowerBounds() const
+{
+    return lbounds_;
+}
+
+template <typename EngineT>
+std::vector<fl::scalar> FuzzyCMeansFisBuilder<EngineT>::upperBounds() const
+{
+    return ubounds_;
+}
+
+template <typename EngineT>
+FL_unique_ptr<EngineT> FuzzyCMeansFisBuilder<EngineT>::build(const fl::DataSet<fl::scalar>& data)
+{
+    if (lbounds_.empty())
+    {
+        std::vector<fl::scalar> lower;
+        std::vector<fl::scalar> upper;
+        fl::ColumnBounds(data, lower, upper);
+
+        return this->build(data.matrix(), data.numOfInputs(), data.numOfOutputs(), lower, upper);
+    }
+
+    return this->build(data.matrix(), data.numOfInputs(), data.numOfOutputs());
+}
+
+template <typename EngineT>
+template <typename MatrixT>
+FL_unique_ptr<EngineT> FuzzyCMeansFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs)
+{
+    if (!lbounds_.empty())
+    {
+        return this->build(data, numInputs, numOutputs, lbounds_, ubounds_);
+    }
+
+    // The ranges of variables are the ones of data
+    const std::size_t numInOuts = numInputs+numOutputs;
+    std::vector<fl::scalar> mins(numInOuts, fl::inf);
+    std::vector<fl::scalar> maxs(numInOuts, -fl::inf);
+    for (std::size_t k = 0,
+                     numData = data.size();
+         k < numData;
+         ++k)
+    {
+        for (std::size_t j = 0; j < numInOuts; ++j)
+        {
+            mins[j] = std::min(mins[j], static_cast<fl::scalar>(data[k][j]));
+            maxs[j] = std::max(maxs[j], static_cast<fl::scalar>(data[k][j]));
+        }
+    }
+
+    return this->build(data, numInputs, numOutputs, mins, maxs);
+}
+
+template <typename EngineT>
+template <typename MatrixT>
+FL_unique_ptr<EngineT> FuzzyCMeansFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs, const std::vector<fl::scalar>& mins, const std::vector<fl::scalar>& maxs)
+{
+    if (mins.size() != numInputs+numOutputs || maxs.size() != numInputs+numOutputs)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of bounds");
+    }
+
+    fl::cluster::FuzzyCMeansClustering fcm(fcm_);
+    fcm.cluster(data);
+
+    const std::vector< std::vector<fl::scalar> > centers = fcm.centers();
+    const std::vector< std::vector<fl::scalar> > spreads = fcm.spreads();
+
+    const std::vector< std::vector<fl::scalar> > outParams = fl::detail::EstimateTakagiSugenoConsequents(data, numInputs, numOutputs, centers, spreads, ridgeParams_, &ridgeParam_);
+
+    return fl::detail::MakeTakagiSugenoEngine<EngineT>(numInputs, numOutputs, mins, maxs, centers, spreads, outParams);
+}
+
+} // Namespace fl
+
+#endif // FL_FIS_BUILDER_FUZZY_CMEANS_H
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
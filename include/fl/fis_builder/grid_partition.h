@@ -29,8 +29,11 @@
 #include <cstddef>
 #include <fl/activation/General.h>
 #include <fl/dataset.h>
+#include <fl/dataset_statistics.h>
 #include <fl/defuzzifier/WeightedAverage.h>
 #include <fl/detail/math.h>
+#include <fl/detail/parallel.h>
+#include <fl/detail/rules.h>
 #include <fl/detail/traits.h>
 #include <fl/fuzzylite.h>
 #include <fl/macro.h>
@@ -51,6 +54,8 @@
 #include <fl/term/Trapezoid.h>
 #include <fl/variable/InputVariable.h>
 #include <fl/variable/OutputVariable.h>
+#include <limits>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -75,6 +80,18 @@ namespace fl {
  * - Also, some of the generated rules may turn out to be meaningless [2].
  * .
  *
+ * To mitigate these problems, the builder can be asked to generate only the
+ * rules whose antecedent cell is covered by the data (see
+ * setRuleGeneration()).
+ * A data point covers the cell made of the most active term of each input
+ * variable (i.e., the cell of the rule with the highest firing strength, as
+ * rules are combined with the algebraic product).
+ * Cells can be further filtered by their <em>support</em> (the number of data
+ * points covering them) and by their <em>firing-strength mass</em> (the sum
+ * of the firing strengths of the rule over the data points covering the
+ * cell), so that the number of rules is bounded by the number of data points
+ * rather than by the size of the grid.
+ *
  * References:
  * -# F.O. Karray et al., "Soft Computing and Intelligent Systems Design: Theory, Tools, and Applications,"
  * -# J.-S. R. Jang et al., "Neuro-Fuzzy and Soft Computing: A Computational Approach to Learning and Machine Intelligence," Prentice-Hall, Inc., 1997.
@@ -93,6 +110,14 @@ private:
 
 
 public:
+    /// The ways rules can be generated from the grid of input terms
+    enum RuleGenerationType
+    {
+        FullGridRuleGeneration, ///< A rule for every cell of the grid
+        DataDrivenRuleGeneration ///< A rule for every cell covered by the data
+    };
+
+
     GridPartitionFisBuilder();
 
     GridPartitionFisBuilder(std::size_t numInputTerms,
@@ -110,12 +135,75 @@ public:
     template <typename MatrixT>
     FL_unique_ptr<EngineT> build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs);
 
+    /**
+     * Sets the lower and upper bounds of the inputs followed by the outputs,
+     * which are the ranges of the generated variables (by default, the
+     * bounds are the ones of the data, taken from the statistics cached with
+     * the dataset, if any, see fl::ColumnBounds)
+     */
+    void setBounds(const std::vector<fl::scalar>& lower, const std::vector<fl::scalar>& upper);
+
+    /// Gets the lower bounds of the inputs followed by the outputs (empty if they are the ones of the data)
+    std::vector<fl::scalar> lowerBounds() const;
+
+    /// Gets the upper bounds of the inputs followed by the outputs (empty if they are the ones of the data)
+    std::vector<fl::scalar> upperBounds() const;
+
+    /// Sets the way rules are generated (by default, a rule for every cell of the grid)
+    void setRuleGeneration(RuleGenerationType value);
+
+    /// Gets the way rules are generated
+    RuleGenerationType getRuleGeneration() const;
+
+    /// Sets the minimum number of data points that must cover a cell to generate its rule (data-driven generation only)
+    void setMinRuleSupport(std::size_t value);
+
+    /// Gets the minimum number of data points that must cover a cell to generate its rule
+    std::size_t getMinRuleSupport() const;
+
+    /// Sets the minimum firing-strength mass a cell must accumulate over the data points covering it to generate its rule (data-driven generation only)
+    void setMinRuleFiringMass(fl::scalar value);
+
+    /// Gets the minimum firing-strength mass a cell must accumulate over the data points covering it to generate its rule
+    fl::scalar getMinRuleFiringMass() const;
+
+
+private:
+    /// The statistics of a cell of the grid collected over the data
+    struct CellStatistics
+    {
+        std::size_t support; ///< The number of data points covering the cell
+        fl::scalar mass; ///< The sum of the firing strengths of the cell over the data points covering it
+    };
+
+    typedef std::map<std::size_t, CellStatistics> CellStatisticsMap;
+
+
+    /// Builds the FIS with the given bounds of the inputs followed by the outputs
+    template <typename MatrixT>
+    FL_unique_ptr<EngineT> build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs, std::vector<fl::scalar> mins, std::vector<fl::scalar> maxs);
+
+    /**
+     * Returns, in increasing order, the indices of the cells covered by
+     * \a data that satisfy the minimum support and firing-mass criteria.
+     *
+     * The index of a cell is the sum of the indices of its input terms
+     * weighted by \a strides, that is the index of its rule in the full grid.
+     */
+    template <typename MatrixT>
+    std::vector<std::size_t> coveredCells(const MatrixT& data, const std::vector<fl::InputVariable*>& inputs, const std::vector<std::size_t>& strides) const;
+
 
 private:
     std::vector<std::size_t> numInTerms_;
     std::vector<std::string> inTerms_;
     std::vector<std::size_t> numOutTerms_;
     std::vector<std::string> outTerms_;
+    RuleGenerationType ruleGen_; ///< The way rules are generated
+    std::size_t minRuleSupport_; ///< The minimum support of a cell to generate its rule
+    fl::scalar minRuleMass_; ///< The minimum firing-strength mass of a cell to generate its rule
+    std::vector<fl::scalar> lbounds_; ///< The lower bounds of the inputs followed by the outputs (empty if taken from data)
+    std::vector<fl::scalar> ubounds_; ///< The upper bounds of the inputs followed by the outputs (empty if taken from data)
 }; // GridPartitionFisBuilder
 
 
@@ -129,7 +217,10 @@ GridPartitionFisBuilder<EngineT>::GridPartitionFisBuilder()
 : numInTerms_(1, DefaultNumberOfInputTerms),
   inTerms_(1, DefaultInputTerm),
   numOutTerms_(1, DefaultNumberOfOutputTerms),
-  outTerms_(1, DefaultOutputTerm)
+  outTerms_(1, DefaultOutputTerm),
+  ruleGen_(FullGridRuleGeneration),
+  minRuleSupport_(1),
+  minRuleMass_(0)
 {
 }
 
@@ -140,7 +231,10 @@ GridPartitionFisBuilder<EngineT>::GridPartitionFisBuilder(std::size_t numInputTe
 : numInTerms_(1, numInputTerms),
   inTerms_(1, inputTermClass),
   numOutTerms_(1, DefaultNumberOfOutputTerms),
-  outTerms_(1, outputTermClass)
+  outTerms_(1, outputTermClass),
+  ruleGen_(FullGridRuleGeneration),
+  minRuleSupport_(1),
+  minRuleMass_(0)
 {
 }
 
@@ -153,7 +247,10 @@ GridPartitionFisBuilder<EngineT>::GridPartitionFisBuilder(NumInTermsIterT numInT
 : numInTerms_(numInTermsFirst, numInTermsLast),
   inTerms_(inTermClassFirst, inTermClassLast),
   numOutTerms_(1, DefaultNumberOfOutputTerms),
-  outTerms_(1, outTermClass)
+  outTerms_(1, outTermClass),
+  ruleGen_(FullGridRuleGeneration),
+  minRuleSupport_(1),
+  minRuleMass_(0)
 {
 }
 
@@ -447,15 +544,56 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const fl::DataSet
 template <typename EngineT>
 FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const fl::DataSet<fl::scalar>& data)
 {
-    return this->build(data.data(), data.numOfInputs(), data.numOfOutputs());
+    if (lbounds_.empty())
+    {
+        std::vector<fl::scalar> lower;
+        std::vector<fl::scalar> upper;
+        fl::ColumnBounds(data, lower, upper);
+
+        return this->build(data.matrix(), data.numOfInputs(), data.numOfOutputs(), lower, upper);
+    }
+
+    return this->build(data.matrix(), data.numOfInputs(), data.numOfOutputs());
 }
 
 template <typename EngineT>
 template <typename MatrixT>
 FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs)
 {
+    if (!lbounds_.empty())
+    {
+        return this->build(data, numInputs, numOutputs, lbounds_, ubounds_);
+    }
+
+    // Compute data range
     const std::size_t numInOuts = numInputs+numOutputs;
-    const std::size_t numData = data.size();
+    std::vector<fl::scalar> mins(numInOuts, fl::inf);
+    std::vector<fl::scalar> maxs(numInOuts, -fl::inf);
+    for (std::size_t k = 0,
+                     numData = data.size();
+         k < numData;
+         ++k)
+    {
+        for (std::size_t i = 0; i < numInOuts; ++i)
+        {
+            mins[i] = std::min(data[k][i], mins[i]);
+            maxs[i] = std::max(data[k][i], maxs[i]);
+        }
+    }
+
+    return this->build(data, numInputs, numOutputs, mins, maxs);
+}
+
+template <typename EngineT>
+template <typename MatrixT>
+FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs, std::vector<fl::scalar> mins, std::vector<fl::scalar> maxs)
+{
+    const std::size_t numInOuts = numInputs+numOutputs;
+
+    if (mins.size() != numInOuts || maxs.size() != numInOuts)
+    {
+        FL_THROW2(std::invalid_argument, "Unexpected number of bounds");
+    }
 
     //if (numOutputs > 1)
     //{
@@ -477,17 +615,6 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& da
         numOutTerms_.resize(numInputs, DefaultNumberOfOutputTerms);
         outTerms_.resize(numOutputs, DefaultOutputTerm);
     }
-    // Compute data range
-    std::vector<fl::scalar> mins(numInOuts, fl::inf);
-    std::vector<fl::scalar> maxs(numInOuts, -fl::inf);
-    for (std::size_t k = 0; k < numData; ++k)
-    {
-        for (std::size_t i = 0; i < numInOuts; ++i)
-        {
-            mins[i] = std::min(data[k][i], mins[i]);
-            maxs[i] = std::max(data[k][i], maxs[i]);
-        }
-    }
     // Fix for zero range
     for (std::size_t i = 0; i < numInOuts; ++i)
     {
@@ -617,10 +744,44 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& da
         }
 
         p_fis->addInputVariable(p_iv);
+        inputs[i] = p_iv;
 
         numRules *= numTerms;
     }
 
+    // Select the cells covered by data
+    std::vector<std::size_t> cells;
+    if (ruleGen_ == DataDrivenRuleGeneration)
+    {
+        // The weight of each input in the index of a cell, so that cells are
+        // numbered like the rules of the full grid
+        std::vector<std::size_t> strides(numInputs);
+        std::size_t numCells = 1;
+        for (std::size_t i = 0; i < numInputs; ++i)
+        {
+#ifdef FL_DEBUG
+            // Same order of MATLAB, where the last input varies fastest
+            const std::size_t ii = numInputs-i-1;
+#else // FL_DEBUG
+            const std::size_t ii = i;
+#endif // FL_DEBUG
+            strides[ii] = numCells;
+            if (numInTerms_[ii] > 0 && numCells > std::numeric_limits<std::size_t>::max()/numInTerms_[ii])
+            {
+                FL_THROW2(std::overflow_error, "Too many cells in the grid of input terms");
+            }
+            numCells *= numInTerms_[ii];
+        }
+
+        cells = this->coveredCells(data, inputs, strides);
+        if (cells.empty())
+        {
+            FL_THROW2(std::runtime_error, "No cell of the grid satisfies the minimum support and firing mass");
+        }
+
+        numRules = cells.size();
+    }
+
     // Generate output variables and terms
     std::vector<fl::OutputVariable*> outputs(numOutputs);
     for (std::size_t i = 0; i < numOutputs; ++i)
@@ -669,13 +830,14 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& da
     //p_rules->setActivation(fl::null);
     p_rules->setActivation(new fl::General());
     p_rules->setImplication(new fl::AlgebraicProduct());
+    std::vector<std::string> ruleTexts(numRules);
     for (std::size_t r = 0; r < numRules; ++r)
     {
         std::ostringstream oss;
 
         oss << fl::Rule::ifKeyword() << " ";
 
-        std::size_t tmp = r;
+        std::size_t tmp = (ruleGen_ == DataDrivenRuleGeneration) ? cells[r] : r;
 #ifdef FL_DEBUG
         // Generates rule in the same order of MATLAB
         std::vector<std::size_t> ruleTerms(numInputs);
@@ -686,7 +848,7 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& da
 
             ruleTerms[jj] = termIdx;
 
-            tmp = static_cast<std::size_t>(std::floor(tmp/static_cast<double>(numInTerms_[jj])));
+            tmp /= numInTerms_[jj];
         }
         for (std::size_t j = 0; j < numInputs; ++j)
         {
@@ -712,7 +874,7 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& da
                 oss << fl::Rule::andKeyword() << " ";
             }
 
-            tmp = static_cast<std::size_t>(std::floor(tmp/static_cast<double>(numInTerms_[j])));
+            tmp /= numInTerms_[j];
         }
 #endif // FL_DEBUG
 
@@ -727,13 +889,171 @@ FL_unique_ptr<EngineT> GridPartitionFisBuilder<EngineT>::build(const MatrixT& da
                 oss << " " << fl::Rule::andKeyword() << " ";
             }
         }
-        p_rules->addRule(fl::Rule::parse(oss.str(), p_fis.get()));
+        ruleTexts[r] = oss.str();
     }
     p_fis->addRuleBlock(p_rules);
+    fl::detail::AddParsedRules(p_rules, ruleTexts, p_fis.get());
 
     return p_fis;
 }
 
+template <typename EngineT>
+void GridPartitionFisBuilder<EngineT>::setRuleGeneration(RuleGenerationType value)
+{
+    ruleGen_ = value;
+}
+
+template <typename EngineT>
+typename GridPartitionFisBuilder<EngineT>::RuleGenerationType GridPartitionFisBuilder<EngineT>::getRuleGeneration() const
+{
+    return ruleGen_;
+}
+
+template <typename EngineT>
+void GridPartitionFisBuilder<EngineT>::setMinRuleSupport(std::size_t value)
+{
+    minRuleSupport_ = value;
+}
+
+template <typename EngineT>
+std::size_t GridPartitionFisBuilder<EngineT>::getMinRuleSupport() const
+{
+    return minRuleSupport_;
+}
+
+template <typename EngineT>
+void GridPartitionFisBuilder<EngineT>::setMinRuleFiringMass(fl::scalar value)
+{
+    minRuleMass_ = value;
+}
+
+template <typename EngineT>
+fl::scalar GridPartitionFisBuilder<EngineT>::getMinRuleFiringMass() const
+{
+    return minRuleMass_;
+}
+
+template <typename EngineT>
+void GridPartitionFisBuilder<EngineT>::setBounds(const std::vector<fl::scalar>& lower, const std::vector<fl::scalar>& upper)
+{
+    if (lower.size() != upper.size())
+    {
+        FL_THROW2(std::invalid_argument, "Vector dimensions mismatch");
+    }
+
+    lbounds_ = lower;
+    ubounds_ = upper;
+}
+
+template <typename EngineT>
+std::vector<fl::scalar> GridPartitionFisBuilder<EngineT>::lowerBounds() const
+{
+    return lbounds_;
+}
+
+template <typename EngineT>
+std::vector<fl::scalar> GridPartitionFisBuilder<EngineT>::upperBounds() const
+{
+    return ubounds_;
+}
+
+template <typename EngineT>
+template <typename MatrixT>
+std::vector<std::size_t> GridPartitionFisBuilder<EngineT>::coveredCells(const MatrixT& data, const std::vector<fl::InputVariable*>& inputs, const std::vector<std::size_t>& strides) const
+{
+    const std::size_t numData = data.size();
+    const std::size_t numInputs = inputs.size();
+
+    // Each thread collects the statistics of the cells covered by its share
+    // of data, which are then merged, so that memory grows with the number of
+    // covered cells rather than with the size of the grid or of the data
+    std::vector<CellStatisticsMap> threadStats(fl::detail::MaxNumOfThreads());
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        CellStatisticsMap& localStats = threadStats[fl::detail::ThreadNum()];
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+        for (std::size_t k = 0; k < numData; ++k)
+        {
+            // With the product conjunction, the most active rule is made of
+            // the most active term of each input
+            std::size_t cell = 0;
+            fl::scalar strength = 1;
+            for (std::size_t i = 0; i < numInputs; ++i)
+            {
+                const fl::InputVariable* p_iv = inputs[i];
+                const fl::scalar x = data[k][i];
+
+                std::size_t bestTerm = 0;
+                fl::scalar bestMu = -1;
+                for (std::size_t j = 0,
+                                 nj = p_iv->numberOfTerms();
+                     j < nj;
+                     ++j)
+                {
+                    const fl::scalar mu = p_iv->getTerm(j)->membership(x);
+                    if (mu > bestMu)
+                    {
+                        bestMu = mu;
+                        bestTerm = j;
+                    }
+                }
+
+                cell += bestTerm*strides[i];
+                strength *= bestMu;
+            }
+
+            typename CellStatisticsMap::iterator it = localStats.find(cell);
+            if (it == localStats.end())
+            {
+                CellStatistics cs;
+                cs.support = 0;
+                cs.mass = 0;
+                it = localStats.insert(typename CellStatisticsMap::value_type(cell, cs)).first;
+            }
+            ++it->second.support;
+            it->second.mass += strength;
+        }
+    }
+
+    // Merges in thread order, that is in the order of the data shares, so
+    // that the firing masses do not depend on the scheduling of the threads
+    CellStatisticsMap stats;
+    for (std::size_t t = 0,
+                     nt = threadStats.size();
+         t < nt;
+         ++t)
+    {
+        for (typename CellStatisticsMap::const_iterator it = threadStats[t].begin(),
+                                                        endIt = threadStats[t].end();
+             it != endIt;
+             ++it)
+        {
+            CellStatistics& cs = stats[it->first];
+            cs.support += it->second.support;
+            cs.mass += it->second.mass;
+        }
+    }
+
+    std::vector<std::size_t> cells;
+    for (typename CellStatisticsMap::const_iterator it = stats.begin(),
+                                                    endIt = stats.end();
+         it != endIt;
+         ++it)
+    {
+        if (it->second.support >= minRuleSupport_ && it->second.mass >= minRuleMass_)
+        {
+            cells.push_back(it->first);
+        }
+    }
+
+    return cells;
+}
+
 template <typename EngineT>
 const std::size_t GridPartitionFisBuilder<EngineT>::DefaultNumberOfInputTerms = 2;
 
@@ -0,0 +1,892 @@
+/**
+ * \file fl/fis_builder/structure_search.h
+ *
+ * \brief Automatic search of the structure of ANFIS models
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_FIS_BUILDER_STRUCTURE_SEARCH_H
+#define FL_FIS_BUILDER_STRUCTURE_SEARCH_H
+
+
+#include <algorithm>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <cmath>
+#include <cstddef>
+#include <fl/anfis/engine.h>
+#include <fl/cluster/subtractive.h>
+#include <fl/dataset.h>
+#include <fl/detail/math.h>
+#include <fl/fis_builder/grid_partition.h>
+#include <fl/fis_builder/subtractive_clustering.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <fl/Operation.h>
+#include <fl/rule/RuleBlock.h>
+#include <fl/term/Linear.h>
+#include <fl/variable/InputVariable.h>
+#include <fl/variable/OutputVariable.h>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# include <omp.h>
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+
+namespace fl {
+
+/**
+ * A candidate structure of a FIS, that is the configuration of the FIS
+ * builder used to generate it.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename EngineT>
+class FisStructure
+{
+public:
+    virtual ~FisStructure() {}
+
+    /// Builds a FIS with this structure from the given training data
+    virtual FL_unique_ptr<EngineT> build(const fl::DataSet<fl::scalar>& data) const = 0;
+
+    /// Returns a short human-readable description of this structure
+    virtual std::string toString() const = 0;
+
+    /// Returns a copy of this structure
+    virtual FisStructure* clone() const = 0;
+}; // FisStructure
+
+
+/// A FIS structure generated by the grid partitioning method (see fl::GridPartitionFisBuilder)
+template <typename EngineT>
+class GridPartitionFisStructure: public FisStructure<EngineT>
+{
+public:
+    typedef typename GridPartitionFisBuilder<EngineT>::RuleGenerationType RuleGenerationType;
+
+
+    /// Constructs a structure with the given number and class of terms for each input, and the given class of output terms
+    GridPartitionFisStructure(const std::vector<std::size_t>& numInputTerms,
+                              const std::vector<std::string>& inputTermClasses,
+                              const std::string& outputTermClass,
+                              RuleGenerationType ruleGen = GridPartitionFisBuilder<EngineT>::FullGridRuleGeneration);
+
+    FL_unique_ptr<EngineT> build(const fl::DataSet<fl::scalar>& data) const;
+
+    std::string toString() const;
+
+    GridPartitionFisStructure* clone() const;
+
+
+private:
+    std::vector<std::size_t> numInTerms_; ///< The number of terms of each input
+    std::vector<std::string> inTerms_; ///< The class of terms of each input
+    std::string outTerm_; ///< The class of output terms
+    RuleGenerationType ruleGen_; ///< The way rules are generated
+}; // GridPartitionFisStructure
+
+
+/// A FIS structure generated by the subtractive clustering method (see fl::SubtractiveClusteringFisBuilder)
+template <typename EngineT>
+class SubtractiveClusteringFisStructure: public FisStructure<EngineT>
+{
+public:
+    /// Constructs a structure generated with the given clustering parameters
+    explicit SubtractiveClusteringFisStructure(const fl::cluster::SubtractiveClustering& subclust);
+
+    /// Constructs a structure generated with the clustering parameters of \a base and the given radius for all data dimensions
+    SubtractiveClusteringFisStructure(const fl::cluster::SubtractiveClustering& base, fl::scalar radius);
+
+    FL_unique_ptr<EngineT> build(const fl::DataSet<fl::scalar>& data) const;
+
+    std::string toString() const;
+
+    SubtractiveClusteringFisStructure* clone() const;
+
+
+private:
+    fl::cluster::SubtractiveClustering subclust_; ///< The clustering parameters
+    fl::scalar radius_; ///< The radius for all data dimensions (NaN to use the radii of the clustering)
+}; // SubtractiveClusteringFisStructure
+
+
+/// The outcome of the evaluation of a candidate structure by fl::FisStructureSearch
+struct FisStructureSearchResult
+{
+    /// The ways the evaluation of a candidate can end
+    enum Status
+    {
+        Completed, ///< Trained for all the epochs
+        Truncated, ///< Trained for fewer epochs, because the time budget ran out
+        Abandoned, ///< Stopped because clearly dominated by another candidate
+        Skipped, ///< Not evaluated, because the time budget ran out
+        Failed ///< The model could not be built or trained
+    };
+
+
+    std::size_t structure; ///< The index of the structure in the search
+    std::string description; ///< The description of the structure
+    Status status; ///< How the evaluation ended
+    std::size_t numOfRules; ///< The number of rules of the model
+    std::size_t inferenceCost; ///< The number of term evaluations and multiply-adds needed to evaluate the model once
+    std::size_t numOfEpochs; ///< The number of epochs the model has been trained for
+    fl::scalar trainError; ///< The training error of the last epoch (NaN if not trained)
+    fl::scalar checkError; ///< The root mean squared error of the model over the check data (infinite if not evaluated)
+    std::vector<fl::scalar> checkErrors; ///< The check error of the model as built and after each epoch
+}; // FisStructureSearchResult
+
+
+/**
+ * Automatic search of the structure of ANFIS models.
+ *
+ * Given a set of candidate structures (e.g., different numbers and classes of
+ * membership functions for the grid partitioning method, or different radii
+ * for the subtractive clustering method), the search builds each candidate
+ * from the training data, trains it for a few epochs with a copy of a given
+ * training algorithm and evaluates it over the check data.
+ * The result is the set of the candidates that are Pareto-optimal with
+ * respect to the check error, the number of rules and the inference cost,
+ * so that the trade-off between accuracy and complexity can be chosen after
+ * the search.
+ *
+ * When the library is built with \c FLX_CONFIG_HAVE_OPENMP, candidates are
+ * built, trained and evaluated concurrently (only the steps that go through
+ * the shared fuzzylite factories, that is the parsing of rules and the
+ * creation of the hedge nodes of the network, are serialized).
+ *
+ * The search can be bounded by:
+ * - a time budget: once it runs out, candidates not started yet are skipped
+ *   and running ones are evaluated as they are at the end of their current
+ *   epoch;
+ * - early abandonment: a candidate is stopped as soon as, after an epoch, its
+ *   check error is greater, by more than a given ratio, than the one an
+ *   already evaluated candidate with no more rules and no higher cost had
+ *   after the same number of epochs.
+ * .
+ *
+ * \tparam TrainerT The type of the training algorithm, which must be a
+ *  copyable fl::anfis::TrainingAlgorithm
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename TrainerT>
+class FisStructureSearch
+{
+    FL_DISABLE_COPY(FisStructureSearch)
+
+public:
+    typedef fl::anfis::Engine EngineType;
+    typedef FisStructure<EngineType> StructureType;
+    typedef FisStructureSearchResult ResultType;
+
+
+    /// Constructs a search training candidates with copies of \a trainer
+    explicit FisStructureSearch(const TrainerT& trainer = TrainerT());
+
+    /// The destructor
+    ~FisStructureSearch();
+
+    /// Adds a copy of the given candidate structure
+    void add(const StructureType& structure);
+
+    /**
+     * Adds the grid partitioning structures with the same number and class
+     * of terms for every one of the \a numInputs inputs, for each combination
+     * of the given numbers of terms and term classes.
+     */
+    void addGridPartitionStructures(std::size_t numInputs,
+                                    const std::vector<std::size_t>& numInputTerms,
+                                    const std::vector<std::string>& inputTermClasses,
+                                    const std::string& outputTermClass,
+                                    typename GridPartitionFisStructure<EngineType>::RuleGenerationType ruleGen = GridPartitionFisBuilder<EngineType>::FullGridRuleGeneration);
+
+    /// Adds the subtractive clustering structures with the parameters of \a base and each of the given radii (used for all data dimensions)
+    void addSubtractiveClusteringStructures(const fl::cluster::SubtractiveClustering& base,
+                                            const std::vector<fl::scalar>& radii);
+
+    /// Returns the number of candidate structures
+    std::size_t numOfStructures() const;
+
+    /// Sets the number of epochs each candidate is trained for
+    void setNumOfEpochs(std::size_t value);
+
+    /// Gets the number of epochs each candidate is trained for
+    std::size_t getNumOfEpochs() const;
+
+    /// Sets the time budget of the search, in seconds (zero, the default, means no limit)
+    void setTimeBudget(fl::scalar value);
+
+    /// Gets the time budget of the search, in seconds
+    fl::scalar getTimeBudget() const;
+
+    /**
+     * Sets the ratio above which a candidate is abandoned.
+     *
+     * A candidate is abandoned when, after an epoch, its check error is
+     * greater than the check error that a Pareto-optimal candidate with no
+     * more rules and no higher inference cost had after the same number of
+     * epochs, multiplied by this ratio.
+     * Comparing candidates at the same point of their training makes the
+     * criterion robust to the different learning speeds of the structures,
+     * while the ratio (which should be greater than 1) is the margin a
+     * candidate is given to recover.
+     * A value of zero (the default) disables early abandonment.
+     */
+    void setAbandonRatio(fl::scalar value);
+
+    /// Gets the ratio above which a candidate is abandoned
+    fl::scalar getAbandonRatio() const;
+
+    /**
+     * Runs the search and returns the outcome of each candidate structure,
+     * in the order they were added.
+     *
+     * Candidates are evaluated over \a checkData or, if \a checkData is
+     * empty, over \a trainData.
+     */
+    std::vector<ResultType> search(const fl::DataSet<fl::scalar>& trainData,
+                                   const fl::DataSet<fl::scalar>& checkData = fl::DataSet<fl::scalar>());
+
+    /// Returns the Pareto-optimal candidates of the last search, by increasing number of rules
+    std::vector<ResultType> paretoFront() const;
+
+    /// Returns the trained model of the given structure if it is Pareto-optimal, or a null pointer otherwise
+    const EngineType* model(std::size_t structure) const;
+
+
+private:
+    /// Returns the wall-clock time in seconds (from an arbitrary origin)
+    static double now();
+
+    /// Returns the root mean squared error of the outputs of \a anfis over \a data
+    static fl::scalar error(EngineType& anfis, const fl::DataSet<fl::scalar>& data);
+
+    /// Returns the number of term evaluations and multiply-adds needed to evaluate \a anfis once
+    static std::size_t inferenceCost(const EngineType& anfis);
+
+    /// Tells if \a a is no worse than \a b in error, number of rules and inference cost
+    static bool weaklyDominates(const ResultType& a, const ResultType& b);
+
+    /// Evaluates the given candidate structure
+    void evaluate(std::size_t s, const fl::DataSet<fl::scalar>& trainData, const fl::DataSet<fl::scalar>& checkData, double start);
+
+    /// Tells if the given candidate is clearly dominated by a Pareto-optimal candidate
+    bool dominated(const ResultType& res) const;
+
+    /// Adds the given candidate to the Pareto front if it is not dominated, taking ownership of its model
+    void updateFront(const ResultType& res, EngineType* p_anfis);
+
+    /// Destroys the candidate structures
+    void clearStructures();
+
+    /// Destroys the models of the last search
+    void clearModels();
+
+
+private:
+    TrainerT trainer_; ///< The prototype of the training algorithm
+    std::vector<StructureType*> structures_; ///< The candidate structures
+    std::size_t numEpochs_; ///< The number of training epochs of each candidate
+    fl::scalar timeBudget_; ///< The time budget in seconds (zero means no limit)
+    fl::scalar abandonRatio_; ///< The ratio above which a candidate is abandoned (zero means never)
+    std::vector<ResultType> results_; ///< The outcomes of the last search
+    std::vector<std::size_t> front_; ///< The Pareto-optimal candidates of the last search
+    std::vector<EngineType*> models_; ///< The trained models of the Pareto-optimal candidates
+}; // FisStructureSearch
+
+
+/////////////////////////
+// Template definitions
+/////////////////////////
+
+
+template <typename EngineT>
+GridPartitionFisStructure<EngineT>::GridPartitionFisStructure(const std::vector<std::size_t>& numInputTerms,
+                                                              const std::vector<std::string>& inputTermClasses,
+                                                              const std::string& outputTermClass,
+                                                              RuleGenerationType ruleGen)
+: numInTerms_(numInputTerms),
+  inTerms_(inputTermClasses),
+  outTerm_(outputTermClass),
+  ruleGen_(ruleGen)
+{
+}
+
+template <typename EngineT>
+FL_unique_ptr<EngineT> GridPartitionFisStructure<EngineT>::build(const fl::DataSet<fl::scalar>& data) const
+{
+    GridPartitionFisBuilder<EngineT> builder(numInTerms_.begin(), numInTerms_.end(),
+                                             inTerms_.begin(), inTerms_.end(),
+                                             outTerm_);
+    builder.setRuleGeneration(ruleGen_);
+
+    return builder.build(data);
+}
+
+template <typename EngineT>
+std::string GridPartitionFisStructure<EngineT>::toString() const
+{
+    std::ostringstream oss;
+
+    oss << "GridPartition(";
+    for (std::size_t i = 0,
+                     ni = numInTerms_.size();
+         i < ni;
+         ++i)
+    {
+        if (i > 0)
+        {
+            oss << ", ";
+        }
+        oss << numInTerms_[i] << " " << inTerms_[i];
+    }
+    oss << "; " << outTerm_;
+    if (ruleGen_ == GridPartitionFisBuilder<EngineT>::DataDrivenRuleGeneration)
+    {
+        oss << "; data-driven rules";
+    }
+    oss << ")";
+
+    return oss.str();
+}
+
+template <typename EngineT>
+GridPartitionFisStructure<EngineT>* GridPartitionFisStructure<EngineT>::clone() const
+{
+    return new GridPartitionFisStructure<EngineT>(*this);
+}
+
+template <typename EngineT>
+SubtractiveClusteringFisStructure<EngineT>::SubtractiveClusteringFisStructure(const fl::cluster::SubtractiveClustering& subclust)
+: subclust_(subclust),
+  radius_(fl::nan)
+{
+}
+
+template <typename EngineT>
+SubtractiveClusteringFisStructure<EngineT>::SubtractiveClusteringFisStructure(const fl::cluster::SubtractiveClustering& base, fl::scalar radius)
+: subclust_(base),
+  radius_(radius)
+{
+}
+
+template <typename EngineT>
+FL_unique_ptr<EngineT> SubtractiveClusteringFisStructure<EngineT>::build(const fl::DataSet<fl::scalar>& data) const
+{
+    fl::cluster::SubtractiveClustering subclust(subclust_);
+    if (!fl::Op::isNaN(radius_))
+    {
+        // The data dimension is only known now
+        subclust.setRadii(radius_, data.numOfInputs()+data.numOfOutputs());
+    }
+
+    SubtractiveClusteringFisBuilder<EngineT> builder(subclust);
+
+    return builder.build(data);
+}
+
+template <typename EngineT>
+std::string SubtractiveClusteringFisStructure<EngineT>::toString() const
+{
+    const std::vector<fl::scalar> radii = fl::Op::isNaN(radius_) ? subclust_.radii() : std::vector<fl::scalar>(1, radius_);
+
+    std::ostringstream oss;
+
+    oss << "SubtractiveClustering(radii:";
+    for (std::size_t i = 0,
+                     ni = radii.size();
+         i < ni;
+         ++i)
+    {
+        oss << " " << radii[i];
+    }
+    oss << ")";
+
+    return oss.str();
+}
+
+template <typename EngineT>
+SubtractiveClusteringFisStructure<EngineT>* SubtractiveClusteringFisStructure<EngineT>::clone() const
+{
+    return new SubtractiveClusteringFisStructure<EngineT>(*this);
+}
+
+template <typename TrainerT>
+FisStructureSearch<TrainerT>::FisStructureSearch(const TrainerT& trainer)
+: trainer_(trainer),
+  numEpochs_(10),
+  timeBudget_(0),
+  abandonRatio_(0)
+{
+}
+
+template <typename TrainerT>
+FisStructureSearch<TrainerT>::~FisStructureSearch()
+{
+    this->clearModels();
+    this->clearStructures();
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::add(const StructureType& structure)
+{
+    structures_.push_back(structure.clone());
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::addGridPartitionStructures(std::size_t numInputs,
+                                                              const std::vector<std::size_t>& numInputTerms,
+                                                              const std::vector<std::string>& inputTermClasses,
+                                                              const std::string& outputTermClass,
+                                                              typename GridPartitionFisStructure<EngineType>::RuleGenerationType ruleGen)
+{
+    for (std::size_t i = 0,
+                     ni = numInputTerms.size();
+         i < ni;
+         ++i)
+    {
+        for (std::size_t j = 0,
+                         nj = inputTermClasses.size();
+             j < nj;
+             ++j)
+        {
+            this->add(GridPartitionFisStructure<EngineType>(std::vector<std::size_t>(numInputs, numInputTerms[i]),
+                                                            std::vector<std::string>(numInputs, inputTermClasses[j]),
+                                                            outputTermClass,
+                                                            ruleGen));
+        }
+    }
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::addSubtractiveClusteringStructures(const fl::cluster::SubtractiveClustering& base,
+                                                                      const std::vector<fl::scalar>& radii)
+{
+    for (std::size_t i = 0,
+                     ni = radii.size();
+         i < ni;
+         ++i)
+    {
+        this->add(SubtractiveClusteringFisStructure<EngineType>(base, radii[i]));
+    }
+}
+
+template <typename TrainerT>
+std::size_t FisStructureSearch<TrainerT>::numOfStructures() const
+{
+    return structures_.size();
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::setNumOfEpochs(std::size_t value)
+{
+    numEpochs_ = value;
+}
+
+template <typename TrainerT>
+std::size_t FisStructureSearch<TrainerT>::getNumOfEpochs() const
+{
+    return numEpochs_;
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::setTimeBudget(fl::scalar value)
+{
+    timeBudget_ = value;
+}
+
+template <typename TrainerT>
+fl::scalar FisStructureSearch<TrainerT>::getTimeBudget() const
+{
+    return timeBudget_;
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::setAbandonRatio(fl::scalar value)
+{
+    abandonRatio_ = value;
+}
+
+template <typename TrainerT>
+fl::scalar FisStructureSearch<TrainerT>::getAbandonRatio() const
+{
+    return abandonRatio_;
+}
+
+template <typename TrainerT>
+std::vector<typename FisStructureSearch<TrainerT>::ResultType> FisStructureSearch<TrainerT>::search(const fl::DataSet<fl::scalar>& trainData,
+                                                                                                   const fl::DataSet<fl::scalar>& checkData)
+{
+    const std::size_t ns = structures_.size();
+    const double start = now();
+
+    this->clearModels();
+    results_.assign(ns, ResultType());
+    models_.assign(ns, fl::null);
+    front_.clear();
+
+    // Candidates may take very different times (e.g., depending on their
+    // number of rules), hence they are handed out one at a time
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(dynamic,1)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    for (std::size_t s = 0; s < ns; ++s)
+    {
+        this->evaluate(s, trainData, checkData.size() > 0 ? checkData : trainData, start);
+    }
+
+    return results_;
+}
+
+template <typename TrainerT>
+std::vector<typename FisStructureSearch<TrainerT>::ResultType> FisStructureSearch<TrainerT>::paretoFront() const
+{
+    std::vector<ResultType> front;
+    for (std::size_t i = 0,
+                     ni = front_.size();
+         i < ni;
+         ++i)
+    {
+        // Keeps the front sorted by number of rules (insertion sort, as the front is small)
+        const ResultType& res = results_[front_[i]];
+        typename std::vector<ResultType>::iterator it = front.begin();
+        while (it != front.end() && (it->numOfRules < res.numOfRules || (it->numOfRules == res.numOfRules && it->structure < res.structure)))
+        {
+            ++it;
+        }
+        front.insert(it, res);
+    }
+
+    return front;
+}
+
+template <typename TrainerT>
+const typename FisStructureSearch<TrainerT>::EngineType* FisStructureSearch<TrainerT>::model(std::size_t structure) const
+{
+    return structure < models_.size() ? models_[structure] : fl::null;
+}
+
+template <typename TrainerT>
+double FisStructureSearch<TrainerT>::now()
+{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+    return omp_get_wtime();
+#else
+    // Not std::clock, which measures the processor time of the process
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+    return (boost::posix_time::microsec_clock::universal_time()-epoch).total_microseconds()*1e-6;
+#endif // FLX_CONFIG_HAVE_OPENMP
+}
+
+template <typename TrainerT>
+fl::scalar FisStructureSearch<TrainerT>::error(EngineType& anfis, const fl::DataSet<fl::scalar>& data)
+{
+    fl::scalar sse = 0;
+    for (typename fl::DataSet<fl::scalar>::ConstEntryIterator entryIt = data.entryBegin(),
+                                                              entryEndIt = data.entryEnd();
+         entryIt != entryEndIt;
+         ++entryIt)
+    {
+        const fl::DataSetEntry<fl::scalar>& entry = *entryIt;
+
+        const std::vector<fl::scalar> targetOut(entry.outputBegin(), entry.outputEnd());
+        const std::vector<fl::scalar> anfisOut = anfis.eval(entry.inputBegin(), entry.inputEnd());
+
+        for (std::size_t i = 0,
+                         ni = targetOut.size();
+             i < ni;
+             ++i)
+        {
+            sse += fl::detail::Sqr(targetOut[i]-anfisOut[i]);
+        }
+    }
+
+    const fl::scalar rmse = std::sqrt(sse/data.size());
+
+    // A diverged model is just worse than any other one
+    return (rmse == rmse) ? rmse : std::numeric_limits<fl::scalar>::infinity();
+}
+
+template <typename TrainerT>
+std::size_t FisStructureSearch<TrainerT>::inferenceCost(const EngineType& anfis)
+{
+    const std::size_t numInputs = anfis.numberOfInputVariables();
+
+    std::size_t cost = 0;
+
+    // Membership functions
+    for (std::size_t i = 0; i < numInputs; ++i)
+    {
+        cost += anfis.getInputVariable(i)->numberOfTerms();
+    }
+    // Rule activations
+    for (std::size_t i = 0,
+                     ni = anfis.numberOfRuleBlocks();
+         i < ni;
+         ++i)
+    {
+        cost += anfis.getRuleBlock(i)->numberOfRules()*numInputs;
+    }
+    // Consequents
+    for (std::size_t i = 0,
+                     ni = anfis.numberOfOutputVariables();
+         i < ni;
+         ++i)
+    {
+        const fl::OutputVariable* p_ov = anfis.getOutputVariable(i);
+        for (std::size_t j = 0,
+                         nj = p_ov->numberOfTerms();
+             j < nj;
+             ++j)
+        {
+            cost += dynamic_cast<const fl::Linear*>(p_ov->getTerm(j)) ? numInputs+1 : 1;
+        }
+    }
+
+    return cost;
+}
+
+template <typename TrainerT>
+bool FisStructureSearch<TrainerT>::weaklyDominates(const ResultType& a, const ResultType& b)
+{
+    return a.checkError <= b.checkError
+           && a.numOfRules <= b.numOfRules
+           && a.inferenceCost <= b.inferenceCost;
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::evaluate(std::size_t s, const fl::DataSet<fl::scalar>& trainData, const fl::DataSet<fl::scalar>& checkData, double start)
+{
+    ResultType& res = results_[s];
+    res.structure = s;
+    res.description = structures_[s]->toString();
+    res.status = ResultType::Completed;
+    res.numOfRules = 0;
+    res.inferenceCost = 0;
+    res.numOfEpochs = 0;
+    res.trainError = fl::nan;
+    res.checkError = std::numeric_limits<fl::scalar>::infinity();
+    res.checkErrors.clear();
+
+    if (timeBudget_ > 0 && (now()-start) >= timeBudget_)
+    {
+        res.status = ResultType::Skipped;
+        return;
+    }
+
+    // No exception can escape from a parallel region, so failures are
+    // recorded in the outcome of the candidate.
+    // Candidates are built concurrently (the builders serialize only the
+    // parsing of rules), while the network is built under the same critical
+    // section, since it creates hedges through the shared fuzzylite factories
+    // (see fl::detail::AddParsedRules).
+    FL_unique_ptr<EngineType> p_built;
+    try
+    {
+        p_built = structures_[s]->build(trainData);
+    }
+    catch (...)
+    {
+        res.status = ResultType::Failed;
+        return;
+    }
+    bool built = false;
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (fl_fuzzylite_factories)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        try
+        {
+            p_built->build();
+            built = true;
+        }
+        catch (...)
+        {
+        }
+    }
+    if (!built)
+    {
+        res.status = ResultType::Failed;
+        return;
+    }
+    EngineType* p_anfis = p_built.release();
+
+    res.numOfRules = 0;
+    for (std::size_t i = 0,
+                     ni = p_anfis->numberOfRuleBlocks();
+         i < ni;
+         ++i)
+    {
+        res.numOfRules += p_anfis->getRuleBlock(i)->numberOfRules();
+    }
+    res.inferenceCost = inferenceCost(*p_anfis);
+
+    try
+    {
+        TrainerT trainer(trainer_);
+        trainer.setEngine(p_anfis);
+        trainer.reset();
+
+        res.checkError = error(*p_anfis, checkData);
+        res.checkErrors.push_back(res.checkError);
+        for (std::size_t epoch = 0; epoch < numEpochs_; ++epoch)
+        {
+            if (timeBudget_ > 0 && (now()-start) >= timeBudget_)
+            {
+                res.status = ResultType::Truncated;
+                break;
+            }
+
+            res.trainError = trainer.trainSingleEpoch(trainData);
+            res.checkError = error(*p_anfis, checkData);
+            res.checkErrors.push_back(res.checkError);
+            ++res.numOfEpochs;
+
+            if (abandonRatio_ > 0 && this->dominated(res))
+            {
+                res.status = ResultType::Abandoned;
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        res.status = ResultType::Failed;
+    }
+
+    if (res.status == ResultType::Completed || res.status == ResultType::Truncated)
+    {
+        this->updateFront(res, p_anfis);
+    }
+    else
+    {
+        delete p_anfis;
+    }
+}
+
+template <typename TrainerT>
+bool FisStructureSearch<TrainerT>::dominated(const ResultType& res) const
+{
+    bool ret = false;
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (fl_fis_structure_search_front)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        for (std::size_t i = 0,
+                         ni = front_.size();
+             i < ni && !ret;
+             ++i)
+        {
+            const ResultType& other = results_[front_[i]];
+            const std::size_t epoch = std::min(res.numOfEpochs, other.numOfEpochs);
+
+            ret = other.numOfRules <= res.numOfRules
+                  && other.inferenceCost <= res.inferenceCost
+                  && other.checkErrors[epoch]*abandonRatio_ < res.checkError;
+        }
+    }
+
+    return ret;
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::updateFront(const ResultType& res, EngineType* p_anfis)
+{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (fl_fis_structure_search_front)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        bool optimal = true;
+        for (std::size_t i = 0,
+                         ni = front_.size();
+             i < ni && optimal;
+             ++i)
+        {
+            optimal = !weaklyDominates(results_[front_[i]], res);
+        }
+
+        if (optimal)
+        {
+            // Removes (and destroys the models of) the candidates dominated by the new one
+            std::size_t n = 0;
+            for (std::size_t i = 0,
+                             ni = front_.size();
+                 i < ni;
+                 ++i)
+            {
+                const std::size_t other = front_[i];
+                if (weaklyDominates(res, results_[other]))
+                {
+                    delete models_[other];
+                    models_[other] = fl::null;
+                }
+                else
+                {
+                    front_[n++] = other;
+                }
+            }
+            front_.resize(n);
+            front_.push_back(res.structure);
+            models_[res.structure] = p_anfis;
+        }
+        else
+        {
+            delete p_anfis;
+        }
+    }
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::clearStructures()
+{
+    for (std::size_t i = 0,
+                     ni = structures_.size();
+         i < ni;
+         ++i)
+    {
+        delete structures_[i];
+    }
+    structures_.clear();
+}
+
+template <typename TrainerT>
+void FisStructureSearch<TrainerT>::clearModels()
+{
+    for (std::size_t i = 0,
+                     ni = models_.size();
+         i < ni;
+         ++i)
+    {
+        delete models_[i];
+    }
+    models_.clear();
+    front_.clear();
+}
+
+} // Namespace fl
+
+#endif // FL_FIS_BUILDER_STRUCTURE_SEARCH_H
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -31,30 +31,47 @@
 #ifndef FL_FIS_SUBTRACTIVE_CLUSTERINGARTITION_H
 #define FL_FIS_SUBTRACTIVE_CLUSTERINGARTITION_H
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
-#include <fl/activation/General.h>
 #include <fl/cluster/subtractive.h>
+#include <fl/cluster/subtractive_sweep.h>
 #include <fl/dataset.h>
-#include <fl/defuzzifier/WeightedAverage.h>
+#include <fl/dataset_statistics.h>
 #include <fl/detail/math.h>
+#include <fl/detail/traits.h>
+#include <fl/fis_builder/takagi_sugeno.h>
 #include <fl/fuzzylite.h>
 #include <fl/macro.h>
-#include <fl/norm/s/Maximum.h>
-#include <fl/norm/t/AlgebraicProduct.h>
-#include <fl/norm/s/AlgebraicSum.h>
-#include <fl/rule/Rule.h>
-#include <fl/rule/RuleBlock.h>
-#include <fl/term/Accumulated.h> //FIXME: needed even if not explicitly used because of fwd decl in fl::OutputVariable
-#include <fl/term/Gaussian.h>
-#include <fl/term/Linear.h>
-#include <fl/variable/InputVariable.h>
-#include <fl/variable/OutputVariable.h>
-#include <sstream>
+#include <stdexcept>
 #include <vector>
 
 
 namespace fl {
 
+/// A candidate model structure scored by SubtractiveClusteringFisBuilder::rank
+struct SubtractiveClusteringFisCandidate
+{
+    fl::cluster::SubtractiveClustering clustering; ///< The clustering the model is built from
+    std::size_t numOfRules; ///< The number of rules of the model
+    fl::scalar ridgeParameter; ///< The regularization parameter selected for the consequent parameters
+    fl::scalar error; ///< The root mean squared error of the model outputs (infinite if the model cannot be built)
+};
+
+namespace detail {
+
+/// Orders candidate model structures by increasing error and, for equal errors, by increasing number of rules
+struct SubtractiveClusteringFisCandidateLess
+{
+    bool operator()(const SubtractiveClusteringFisCandidate& a, const SubtractiveClusteringFisCandidate& b) const
+    {
+        return a.error < b.error || (!(b.error < a.error) && a.numOfRules < b.numOfRules);
+    }
+};
+
+} // Namespace detail
+
+
 /**
  * FIS builder based on the <em>subtractive clustering</em> method discussed in
  * (Chiu, 1994).
@@ -77,14 +94,81 @@ public:
 
     SubtractiveClusteringFisBuilder(const fl::cluster::SubtractiveClustering& subclust);
 
+    /**
+     * Builds the FIS from \a data.
+     *
+     * The bounds of the data that are not set in the clustering are taken
+     * from the statistics cached with the dataset, if any, or found in a
+     * single pass over the dataset (see fl::ColumnBounds), rather than found
+     * by clustering.
+     */
     FL_unique_ptr<EngineT> build(const fl::DataSet<fl::scalar>& data);
 
     template <typename MatrixT>
     FL_unique_ptr<EngineT> build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs);
 
+    /**
+     * Applies \a sweep to \a data, builds a model for each of the resulting
+     * clusterings and returns them sorted by increasing error (and, for equal
+     * errors, by increasing number of rules).
+     *
+     * The error of a model is the root mean squared error of its outputs over
+     * \a checkData or, if \a checkData is empty, over \a data.
+     * Since the outputs of the Takagi-Sugeno models built here only depend on
+     * the cluster centers and on the consequent parameters, models are scored
+     * without creating their engines, and, when the library is built with
+     * \c FLX_CONFIG_HAVE_OPENMP, candidates are scored concurrently.
+     * The engine of a candidate is obtained by building it with a builder
+     * constructed from the clustering of the candidate.
+     */
+    template <typename MatrixT>
+    std::vector<SubtractiveClusteringFisCandidate> rank(const MatrixT& data,
+                                                         std::size_t numInputs,
+                                                         std::size_t numOutputs,
+                                                         fl::cluster::SubtractiveClusteringSweep& sweep,
+                                                         const MatrixT& checkData = MatrixT());
+
+    /**
+     * Sets the candidate regularization parameters for the estimation of the
+     * consequent parameters.
+     *
+     * If empty (the default), consequent parameters are estimated by plain
+     * least squares.
+     * Otherwise, they are estimated by ridge regression, and if more than one
+     * parameter is given, the one with the smallest generalized
+     * cross-validation score is selected (the regression matrix is factorized
+     * only once for the whole grid).
+     *
+     * \sa fl::detail::RidgeParameterGrid
+     */
+    void setRidgeParameters(const std::vector<fl::scalar>& values);
+
+    /// Gets the candidate regularization parameters for the estimation of the consequent parameters
+    std::vector<fl::scalar> getRidgeParameters() const;
+
+    /// Gets the regularization parameter selected by the last build (zero if no regularization is used)
+    fl::scalar getSelectedRidgeParameter() const;
+
 
 private:
-    fl::cluster::SubtractiveClustering subclust_;
+    /// Builds the FIS from the clusters found in \a data by \a subclust
+    template <typename MatrixT>
+    FL_unique_ptr<EngineT> build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs, fl::cluster::SubtractiveClustering subclust);
+
+    /// Returns the root mean squared error of the outputs of the model with the given rules over \a data
+    template <typename MatrixT>
+    fl::scalar predictionError(const MatrixT& data,
+                               std::size_t numInputs,
+                               std::size_t numOutputs,
+                               const std::vector< std::vector<fl::scalar> >& centers,
+                               const std::vector<fl::scalar>& sigmas,
+                               const std::vector< std::vector<fl::scalar> >& outParams) const;
+
+
+private:
+    fl::cluster::SubtractiveClustering subclust_; ///< The (unapplied) clustering used to partition the data space
+    std::vector<fl::scalar> ridgeParams_; ///< The candidate regularization parameters
+    fl::scalar ridgeParam_; ///< The regularization parameter selected by the last build
 }; // SubtractiveClusteringFisBuilder
 
 
@@ -95,227 +179,247 @@ private:
 
 template <typename EngineT>
 SubtractiveClusteringFisBuilder<EngineT>::SubtractiveClusteringFisBuilder()
+: ridgeParam_(0)
 {
 }
 
 template <typename EngineT>
 SubtractiveClusteringFisBuilder<EngineT>::SubtractiveClusteringFisBuilder(const fl::cluster::SubtractiveClustering& subclust)
-: subclust_(subclust)
+: subclust_(subclust),
+  ridgeParam_(0)
 {
 }
 
 template <typename EngineT>
-FL_unique_ptr<EngineT> SubtractiveClusteringFisBuilder<EngineT>::build(const fl::DataSet<fl::scalar>& data)
+void SubtractiveClusteringFisBuilder<EngineT>::setRidgeParameters(const std::vector<fl::scalar>& values)
 {
-    return this->build(data.data(), data.numOfInputs(), data.numOfOutputs());
+    for (std::size_t i = 0,
+                     ni = values.size();
+         i < ni;
+         ++i)
+    {
+        if (values[i] < 0)
+        {
+            FL_THROW2(std::invalid_argument, "Regularization parameters must be non-negative");
+        }
+    }
+
+    ridgeParams_ = values;
 }
 
 template <typename EngineT>
-template <typename MatrixT>
-FL_unique_ptr<EngineT> SubtractiveClusteringFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs)
+std::vector<fl::scalar> SubtractiveClusteringFisBuilder<EngineT>::getRidgeParameters() const
 {
-    //const std::size_t numInOuts = numInputs+numOutputs;
-    const std::size_t numData = data.size();
-
-    subclust_.reset();
-    subclust_.cluster(data);
-
-    const std::vector< std::vector<fl::scalar> > centers = subclust_.centers();
-    const std::vector<fl::scalar> sigmas = subclust_.rangeOfInfluence();
-    const std::size_t numRules = centers.size();
-
-    std::vector<fl::scalar> distFactors(numInputs);
-    const fl::scalar invSqrt2 = 1.0/std::sqrt(2.0);
-    for (std::size_t i = 0; i < numInputs; ++i)
-    {
-        distFactors[i] = invSqrt2 / sigmas[i];
-    }
+    return ridgeParams_;
+}
 
+template <typename EngineT>
+fl::scalar SubtractiveClusteringFisBuilder<EngineT>::getSelectedRidgeParameter() const
+{
+    return ridgeParam_;
+}
 
-    // Computes values for eq. (4) and (5) in (Chiu,1994)
+template <typename EngineT>
+FL_unique_ptr<EngineT> SubtractiveClusteringFisBuilder<EngineT>::build(const fl::DataSet<fl::scalar>& data)
+{
+    fl::cluster::SubtractiveClustering subclust(subclust_);
 
-    std::vector<fl::scalar> sumMuValues(numData);
-    std::vector<fl::scalar> invSumMuValues(numData);
-    std::vector< std::vector<fl::scalar> > muMatrix(numData);
-    const std::size_t muMatrixNumCols = numRules*(numInputs+1);
-    for (std::size_t i = 0; i < numRules; ++i)
+    if (data.size() > 0 && (subclust.lowerBounds().empty() || subclust.upperBounds().empty()))
     {
-        //std::vector< std::vector<fl::scalar> > sqDistMatrix(numData, numInputs);
-        std::vector<fl::scalar> muValues(numData);
-        for (std::size_t k = 0; k < numData; ++k)
+        std::vector<fl::scalar> lower;
+        std::vector<fl::scalar> upper;
+        fl::ColumnBounds(data, lower, upper);
+        if (!subclust.lowerBounds().empty())
         {
-            fl::scalar sqDistSum = 0;
-            for (std::size_t j = 0; j < numInputs; ++j)
-            {
-                const fl::scalar sqDist = fl::detail::Sqr((data[k][j]-centers[i][j])*distFactors[j]);
-
-                //sqDistMatrix[k][j] = sqDist;
-                sqDistSum += sqDist;
-            }
-            muValues[k] = std::exp(-sqDistSum);
-            sumMuValues[k] += muValues[k];
+            lower = subclust.lowerBounds();
         }
-
-        const std::size_t offset = i*(numInputs+1);
-        for (std::size_t k = 0; k < numData; ++k)
+        if (!subclust.upperBounds().empty())
         {
-            muMatrix[k].resize(muMatrixNumCols);
-
-            for (std::size_t j = 0; j < numInputs; ++j)
-            {
-                muMatrix[k][j+offset] = data[k][j]*muValues[k];
-            }
-            //muMatrix[k][numInputs+offset+1] = muValues[k];
-            muMatrix[k][numInputs+offset] = muValues[k];
+            upper = subclust.upperBounds();
         }
-    }
-    for (std::size_t i = 0; i < numData; ++i)
-    {
-        invSumMuValues[i] = 1.0/sumMuValues[i];
 
-        for (std::size_t j = 0; j < muMatrixNumCols; ++j)
+        // For zero-range data, uses the same small artificial range the
+        // clustering would use for bounds found in data
+        for (std::size_t j = 0,
+                         nc = std::min(lower.size(), upper.size());
+             j < nc;
+             ++j)
         {
-            muMatrix[i][j] *= invSumMuValues[i];
-        }
-    }
-
-    // Computes the Tagagi-Sugeno parameters by solving a linear least-squares estimation problem
-
-    std::vector< std::vector<fl::scalar> > outParams; // The matrix of output parameters with dimension ((numRules*(numInputs+1) x numOutputs)
-    {
-        // Each column of outParams will contain the output equation parameters
-        // for an output variable.  For example, if output variable y1 is given by
-        // the equation y1 = k1*x1 + k2*x2 + k3*x3 + k0, then column 1 of
-        // outParams contains [k1 k2 k3 k0] for rule #1, followed by [k1 k2 k3 k0]
-        // for rule #2, etc.
- 
-        std::vector< std::vector<fl::scalar> > dataOut(numData);
-        for (std::size_t i = 0; i < numData; ++i)
-        {
-            dataOut[i].resize(numOutputs);
-            for (std::size_t j = 0; j < numOutputs; ++j)
+            if (fl::detail::FloatTraits<fl::scalar>::ApproximatelyEqual(lower[j], upper[j]))
             {
-                dataOut[i][j] = data[i][j+numInputs];
+                if (subclust.lowerBounds().empty())
+                {
+                    lower[j] -= 0.0001*(1+std::abs(lower[j]));
+                }
+                if (subclust.upperBounds().empty())
+                {
+                    upper[j] += 0.0001*(1+std::abs(upper[j]));
+                }
             }
         }
-        outParams = fl::detail::LsqSolveMulti<fl::scalar>(muMatrix, dataOut);
-std::cerr << "muMatrix: "; fl::detail::MatrixOutput(std::cerr, muMatrix); std::cerr << std::endl;
-std::cerr << "Xout: "; fl::detail::MatrixOutput(std::cerr, dataOut); std::cerr << std::endl;
-std::cerr << "outEqns: "; fl::detail::MatrixOutput(std::cerr, outParams); std::cerr << std::endl;
-    }
 
-    const std::vector<fl::scalar> mins = subclust_.lowerBounds();
-    const std::vector<fl::scalar> maxs = subclust_.upperBounds();
-
-    FL_unique_ptr<EngineT> p_fis(new EngineT());
-
-    // Generates input variables and terms
-    std::vector<fl::InputVariable*> inputs(numInputs);
-    for (std::size_t i = 0; i < numInputs; ++i)
-    {
-        std::ostringstream oss;
+        subclust.setBounds(lower, upper);
+    }
 
-        fl::InputVariable* p_iv = new fl::InputVariable();
+    return this->build(data.matrix(), data.numOfInputs(), data.numOfOutputs(), subclust);
+}
 
-        oss << "in" << i;
-        p_iv->setEnabled(true);
-        p_iv->setName(oss.str());
-        p_iv->setRange(mins[i], maxs[i]);
+template <typename EngineT>
+template <typename MatrixT>
+FL_unique_ptr<EngineT> SubtractiveClusteringFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs)
+{
+    return this->build(data, numInputs, numOutputs, subclust_);
+}
 
-        for (std::size_t j = 0; j < numRules; ++j)
-        {
-            // Give a name to this term
-            oss.str("");
-            oss << p_iv->getName() << "mf" << j;
+template <typename EngineT>
+template <typename MatrixT>
+FL_unique_ptr<EngineT> SubtractiveClusteringFisBuilder<EngineT>::build(const MatrixT& data, std::size_t numInputs, std::size_t numOutputs, fl::cluster::SubtractiveClustering subclust)
+{
+    // Clusters a copy, so that the configured clustering is not altered by
+    // the data (e.g., by the bounds found in them)
+    subclust.cluster(data);
 
-            p_iv->addTerm(new fl::Gaussian(oss.str(), centers[j][i], sigmas[i]));
-        }
+    const std::vector< std::vector<fl::scalar> > centers = subclust.centers();
 
-        p_fis->addInputVariable(p_iv);
-    }
+    // All the rules share the ranges of influence of the clustering
+    const std::vector< std::vector<fl::scalar> > sigmas(centers.size(), subclust.rangeOfInfluence());
 
-    // Generate output variables and terms
-    std::vector<fl::OutputVariable*> outputs(numOutputs);
-    for (std::size_t i = 0; i < numOutputs; ++i)
-    {
-        const std::size_t k = numInputs+i;
+    const std::vector< std::vector<fl::scalar> > outParams = fl::detail::EstimateTakagiSugenoConsequents(data, numInputs, numOutputs, centers, sigmas, ridgeParams_, &ridgeParam_);
 
-        fl::OutputVariable* p_ov = new fl::OutputVariable();
+    return fl::detail::MakeTakagiSugenoEngine<EngineT>(numInputs, numOutputs, subclust.lowerBounds(), subclust.upperBounds(), centers, sigmas, outParams);
+}
 
-        std::ostringstream oss;
+template <typename EngineT>
+template <typename MatrixT>
+std::vector<SubtractiveClusteringFisCandidate> SubtractiveClusteringFisBuilder<EngineT>::rank(const MatrixT& data,
+                                                                                               std::size_t numInputs,
+                                                                                               std::size_t numOutputs,
+                                                                                               fl::cluster::SubtractiveClusteringSweep& sweep,
+                                                                                               const MatrixT& checkData)
+{
+    sweep.cluster(data);
 
-        oss << "out" << i;
-        p_ov->setEnabled(true);
-        p_ov->setName(oss.str());
-        p_ov->setRange(mins[k], maxs[k]);
-        p_ov->fuzzyOutput()->setAccumulation(new fl::Maximum());
-    //p_ov->fuzzyOutput()->setAccumulation(fl::null);
-        p_ov->setDefuzzifier(new fl::WeightedAverage());
-        p_ov->setDefaultValue(fl::nan);
-        p_ov->setPreviousValue(false);
+    const std::vector<fl::cluster::SubtractiveClustering>& results = sweep.results();
+    const std::size_t numCandidates = results.size();
+    const MatrixT& evalData = checkData.size() > 0 ? checkData : data;
 
-        for (std::size_t j = 0; j < numRules; ++j)
+    std::vector<SubtractiveClusteringFisCandidate> candidates(numCandidates);
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        // Candidates with the same number of rules share the shape of the
+        // least-squares problem, so each thread reuses a single plan
+        fl::detail::LsqSolverPlan<fl::scalar> plan;
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(dynamic)
+#endif // FLX_CONFIG_HAVE_OPENMP
+        for (std::size_t k = 0; k < numCandidates; ++k)
         {
-            // Give a name to this term
-            oss.str("");
-            oss << p_ov->getName() << "mf" << j;
+            SubtractiveClusteringFisCandidate& cand = candidates[k];
+            cand.clustering = results[k];
+            cand.numOfRules = results[k].numOfClusters();
+            cand.ridgeParameter = 0;
+            cand.error = fl::inf;
 
-            const std::size_t numParams = numInputs+1;
-            std::vector<fl::scalar> params(numParams);
-            for (std::size_t k = 0; k < numParams; ++k)
+            if (cand.numOfRules == 0)
             {
-                params[k] = outParams[j*numParams+k][i];
+                continue;
             }
 
-            p_ov->addTerm(new fl::Linear(oss.str(), params, p_fis.get()));
+            // Exceptions cannot leave a parallel region: a candidate whose
+            // consequent parameters cannot be estimated is just ranked last
+            try
+            {
+                const std::vector< std::vector<fl::scalar> > centers = results[k].centers();
+                const std::vector<fl::scalar> sigmas = results[k].rangeOfInfluence();
+                const std::vector< std::vector<fl::scalar> > ruleSigmas(centers.size(), sigmas);
+                const std::vector< std::vector<fl::scalar> > outParams = fl::detail::EstimateTakagiSugenoConsequents(plan, data, numInputs, numOutputs, centers, ruleSigmas, ridgeParams_, &cand.ridgeParameter);
+
+                const fl::scalar error = this->predictionError(evalData, numInputs, numOutputs, centers, sigmas, outParams);
+                if (error == error) // Not NaN
+                {
+                    cand.error = error;
+                }
+            }
+            catch (...)
+            {
+            }
         }
-
-        p_fis->addOutputVariable(p_ov);
     }
 
-    // Generate rules
-    fl::RuleBlock* p_rules = new fl::RuleBlock();
-    p_rules->setEnabled(true);
-    p_rules->setConjunction(new fl::AlgebraicProduct());
-    p_rules->setDisjunction(new fl::AlgebraicSum());
-    ////p_rules->setActivation(new fl::AlgebraicProduct());
-    //p_rules->setActivation(fl::null);
-    p_rules->setActivation(new fl::General());
-    p_rules->setImplication(new fl::AlgebraicProduct());
-    for (std::size_t r = 0; r < numRules; ++r)
-    {
-        std::ostringstream oss;
+    std::stable_sort(candidates.begin(), candidates.end(), detail::SubtractiveClusteringFisCandidateLess());
 
-        oss << fl::Rule::ifKeyword() << " ";
+    return candidates;
+}
 
-        for (std::size_t j = 0; j < numInputs; ++j)
-        {
-            const fl::InputVariable* p_iv = p_fis->getInputVariable(j);
+template <typename EngineT>
+template <typename MatrixT>
+fl::scalar SubtractiveClusteringFisBuilder<EngineT>::predictionError(const MatrixT& data,
+                                                                     std::size_t numInputs,
+                                                                     std::size_t numOutputs,
+                                                                     const std::vector< std::vector<fl::scalar> >& centers,
+                                                                     const std::vector<fl::scalar>& sigmas,
+                                                                     const std::vector< std::vector<fl::scalar> >& outParams) const
+{
+    const std::size_t numData = data.size();
+    const std::size_t numRules = centers.size();
+    const std::size_t numParams = numInputs+1;
+
+    if (numData == 0)
+    {
+        return fl::nan;
+    }
 
-            oss << p_iv->getName() << " " << fl::Rule::isKeyword() << " " << p_iv->getTerm(r)->getName() << " ";
+    std::vector<fl::scalar> distFactors(numInputs);
+    const fl::scalar invSqrt2 = 1.0/std::sqrt(2.0);
+    for (std::size_t i = 0; i < numInputs; ++i)
+    {
+        distFactors[i] = invSqrt2 / sigmas[i];
+    }
 
-            if (j < (numInputs-1))
+    // The output of the model is the average of the rule outputs weighted by
+    // the firing strengths (i.e., the product of the Gaussian memberships)
+    fl::scalar sse = 0;
+    std::vector<fl::scalar> muValues(numRules);
+    std::vector<fl::scalar> outputs(numOutputs);
+    for (std::size_t k = 0; k < numData; ++k)
+    {
+        fl::scalar sumMu = 0;
+        for (std::size_t r = 0; r < numRules; ++r)
+        {
+            fl::scalar sqDistSum = 0;
+            for (std::size_t j = 0; j < numInputs; ++j)
             {
-                oss << fl::Rule::andKeyword() << " ";
+                sqDistSum += fl::detail::Sqr((data[k][j]-centers[r][j])*distFactors[j]);
             }
+            muValues[r] = std::exp(-sqDistSum);
+            sumMu += muValues[r];
         }
 
-        oss << fl::Rule::thenKeyword();
-
-        for (std::size_t j = 0; j < numOutputs; ++j)
+        std::fill(outputs.begin(), outputs.end(), fl::scalar(0));
+        for (std::size_t r = 0; r < numRules; ++r)
         {
-            const fl::OutputVariable* p_ov = p_fis->getOutputVariable(j);
-            oss << " " << p_ov->getName() << " " << fl::Rule::isKeyword() << " " << p_ov->getTerm(r)->getName();
-            if (j < (numOutputs-1))
+            const std::size_t offset = r*numParams;
+            for (std::size_t i = 0; i < numOutputs; ++i)
             {
-                oss << " " << fl::Rule::andKeyword() << " ";
+                fl::scalar ruleOut = outParams[offset+numInputs][i];
+                for (std::size_t j = 0; j < numInputs; ++j)
+                {
+                    ruleOut += outParams[offset+j][i]*data[k][j];
+                }
+                outputs[i] += muValues[r]*ruleOut;
             }
         }
-        p_rules->addRule(fl::Rule::parse(oss.str(), p_fis.get()));
+
+        for (std::size_t i = 0; i < numOutputs; ++i)
+        {
+            sse += fl::detail::Sqr(outputs[i]/sumMu-data[k][numInputs+i]);
+        }
     }
-    p_fis->addRuleBlock(p_rules);
 
-    return p_fis;
+    return std::sqrt(sse/(numData*numOutputs));
 }
 
 } // Namespace fl
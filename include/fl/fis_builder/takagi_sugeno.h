@@ -0,0 +1,364 @@
+/**
+ * \file fl/fis_builder/takagi_sugeno.h
+ *
+ * \brief Shared parts of the clustering-based builders of Takagi-Sugeno FIS
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FL_FIS_BUILDER_TAKAGI_SUGENO_H
+#define FL_FIS_BUILDER_TAKAGI_SUGENO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fl/activation/General.h>
+#include <fl/defuzzifier/WeightedAverage.h>
+#include <fl/detail/lsq.h>
+#include <fl/detail/math.h>
+#include <fl/detail/parallel.h>
+#include <fl/detail/rules.h>
+#include <fl/fuzzylite.h>
+#include <fl/norm/s/Maximum.h>
+#include <fl/norm/t/AlgebraicProduct.h>
+#include <fl/norm/s/AlgebraicSum.h>
+#include <fl/rule/Rule.h>
+#include <fl/rule/RuleBlock.h>
+#include <fl/term/Accumulated.h> //FIXME: needed even if not explicitly used because of fwd decl in fl::OutputVariable
+#include <fl/term/Gaussian.h>
+#include <fl/term/Linear.h>
+#include <fl/variable/InputVariable.h>
+#include <fl/variable/OutputVariable.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace fl { namespace detail {
+
+/**
+ * Estimates by least squares the consequent parameters of the Takagi-Sugeno
+ * rules with Gaussian antecedents centered at \a centers and with spreads
+ * \a sigmas (both indexed by rule and then by input), over the first
+ * \a numInputs columns of \a data followed by \a numOutputs output columns
+ * (see eq. (4) and (5) in (Chiu,1994)).
+ *
+ * If \a ridgeParams is empty, parameters are estimated by plain least
+ * squares and \a pRidgeParam is set to zero; otherwise, they are estimated
+ * by ridge regression with the parameter of \a ridgeParams with the smallest
+ * generalized cross-validation score, which is stored in \a pRidgeParam.
+ *
+ * Each column of the returned matrix contains the parameters of an output
+ * variable: if output \f$y_1\f$ is given by \f$y_1 = k_1 x_1 + k_2 x_2 + k_0\f$,
+ * column 1 contains \f$[k_1\ k_2\ k_0]\f$ for rule 1, followed by the ones
+ * for rule 2, and so on.
+ *
+ * The problem is solved through \a plan, which is reshaped only if needed,
+ * so that callers estimating several models of the same size reuse its
+ * buffers and LAPACK workspace; the regression matrix is factorized only
+ * once for all the ridge parameters.
+ */
+template <typename MatrixT>
+std::vector< std::vector<fl::scalar> > EstimateTakagiSugenoConsequents(fl::detail::LsqSolverPlan<fl::scalar>& plan,
+                                                                       const MatrixT& data,
+                                                                       std::size_t numInputs,
+                                                                       std::size_t numOutputs,
+                                                                       const std::vector< std::vector<fl::scalar> >& centers,
+                                                                       const std::vector< std::vector<fl::scalar> >& sigmas,
+                                                                       const std::vector<fl::scalar>& ridgeParams,
+                                                                       fl::scalar* pRidgeParam)
+{
+    const std::size_t numData = data.size();
+    const std::size_t numRules = centers.size();
+    const std::size_t numParams = numInputs+1;
+
+    std::vector<fl::scalar> distFactors(numRules*numInputs);
+    const fl::scalar invSqrt2 = 1.0/std::sqrt(2.0);
+    for (std::size_t r = 0; r < numRules; ++r)
+    {
+        for (std::size_t i = 0; i < numInputs; ++i)
+        {
+            distFactors[r*numInputs+i] = invSqrt2 / sigmas[r][i];
+        }
+    }
+
+    // The regression matrix (of dimension numData x numRules*(numInputs+1))
+    // holds, for each rule, the inputs multiplied by the normalized firing
+    // strength of the rule, followed by the normalized firing strength itself.
+    // It is written, together with the outputs, in a single pass over the
+    // data, straight into the column-major buffers of the least-squares plan,
+    // so that they are handed to LAPACK without any further copy.
+    // Data are processed in tiles of consecutive rows, so that each tile
+    // fills contiguous runs of each column.
+
+    plan.reshape(numData, numRules*numParams, numOutputs);
+
+    fl::scalar* A = plan.matrixData();
+    fl::scalar* B = plan.rhsData();
+    const std::size_t ldB = plan.rhsLeadingDimension();
+
+    const std::size_t tileSize = fl::detail::TileSize;
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        // Normalized firing strength of each rule for each row of the tile
+        std::vector<fl::scalar> muTile(numRules*tileSize);
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+        for (std::size_t first = 0; first < numData; first += tileSize)
+        {
+            const std::size_t last = std::min(first+tileSize, numData);
+            const std::size_t len = last-first;
+
+            for (std::size_t k = first; k < last; ++k)
+            {
+                fl::scalar sumMu = 0;
+                for (std::size_t r = 0; r < numRules; ++r)
+                {
+                    const fl::scalar* factors = &distFactors[r*numInputs];
+
+                    fl::scalar sqDistSum = 0;
+                    for (std::size_t j = 0; j < numInputs; ++j)
+                    {
+                        sqDistSum += fl::detail::Sqr((data[k][j]-centers[r][j])*factors[j]);
+                    }
+                    const fl::scalar mu = std::exp(-sqDistSum);
+                    muTile[r*tileSize+(k-first)] = mu;
+                    sumMu += mu;
+                }
+
+                // A row no rule fires on (due to underflow far from all the
+                // centers) does not constrain the parameters
+                const fl::scalar invSumMu = (sumMu > 0) ? 1.0/sumMu : 0;
+                for (std::size_t r = 0; r < numRules; ++r)
+                {
+                    muTile[r*tileSize+(k-first)] *= invSumMu;
+                }
+            }
+
+            for (std::size_t r = 0; r < numRules; ++r)
+            {
+                const fl::scalar* mu = &muTile[r*tileSize];
+                const std::size_t offset = r*numParams;
+
+                for (std::size_t j = 0; j < numInputs; ++j)
+                {
+                    fl::scalar* col = A+(offset+j)*numData+first;
+                    for (std::size_t k = 0; k < len; ++k)
+                    {
+                        col[k] = data[first+k][j]*mu[k];
+                    }
+                }
+
+                fl::scalar* col = A+(offset+numInputs)*numData+first;
+                for (std::size_t k = 0; k < len; ++k)
+                {
+                    col[k] = mu[k];
+                }
+            }
+
+            for (std::size_t j = 0; j < numOutputs; ++j)
+            {
+                fl::scalar* col = B+j*ldB+first;
+                for (std::size_t k = 0; k < len; ++k)
+                {
+                    col[k] = data[first+k][numInputs+j];
+                }
+            }
+        }
+    }
+
+    // Computes the Tagagi-Sugeno parameters by solving a linear least-squares estimation problem
+    // (the matrix of output parameters has dimension (numRules*(numInputs+1) x numOutputs))
+
+    plan.factorize();
+
+    if (ridgeParams.empty())
+    {
+        *pRidgeParam = 0;
+        plan.solve();
+    }
+    else
+    {
+        std::size_t best = 0;
+        if (ridgeParams.size() > 1)
+        {
+            const std::vector<fl::scalar> scores = plan.ridgeGcvScores(ridgeParams);
+
+            best = std::min_element(scores.begin(), scores.end())-scores.begin();
+        }
+        *pRidgeParam = ridgeParams[best];
+        plan.solveRidge(ridgeParams[best]);
+    }
+
+    return plan.storedSolution();
+}
+
+/// Same as above but solves through a plan used only for this call
+template <typename MatrixT>
+std::vector< std::vector<fl::scalar> > EstimateTakagiSugenoConsequents(const MatrixT& data,
+                                                                       std::size_t numInputs,
+                                                                       std::size_t numOutputs,
+                                                                       const std::vector< std::vector<fl::scalar> >& centers,
+                                                                       const std::vector< std::vector<fl::scalar> >& sigmas,
+                                                                       const std::vector<fl::scalar>& ridgeParams,
+                                                                       fl::scalar* pRidgeParam)
+{
+    fl::detail::LsqSolverPlan<fl::scalar> plan;
+
+    return EstimateTakagiSugenoConsequents(plan, data, numInputs, numOutputs, centers, sigmas, ridgeParams, pRidgeParam);
+}
+
+/**
+ * Makes the Takagi-Sugeno FIS with a rule for each of the given centers: the
+ * antecedent of rule \c r has a Gaussian term for each input \c i, centered
+ * at <tt>centers[r][i]</tt> with spread <tt>sigmas[r][i]</tt>, and the
+ * consequent has a linear term for each output, with the parameters of rule
+ * \c r in \a outParams (see EstimateTakagiSugenoConsequents).
+ * The ranges of the inputs followed by the outputs are given by \a mins and
+ * \a maxs.
+ */
+template <typename EngineT>
+FL_unique_ptr<EngineT> MakeTakagiSugenoEngine(std::size_t numInputs,
+                                              std::size_t numOutputs,
+                                              const std::vector<fl::scalar>& mins,
+                                              const std::vector<fl::scalar>& maxs,
+                                              const std::vector< std::vector<fl::scalar> >& centers,
+                                              const std::vector< std::vector<fl::scalar> >& sigmas,
+                                              const std::vector< std::vector<fl::scalar> >& outParams)
+{
+    const std::size_t numRules = centers.size();
+    const std::size_t numParams = numInputs+1;
+
+    FL_unique_ptr<EngineT> p_fis(new EngineT());
+
+    // Generates input variables and terms
+    for (std::size_t i = 0; i < numInputs; ++i)
+    {
+        std::ostringstream oss;
+
+        fl::InputVariable* p_iv = new fl::InputVariable();
+
+        oss << "in" << i;
+        p_iv->setEnabled(true);
+        p_iv->setName(oss.str());
+        p_iv->setRange(mins[i], maxs[i]);
+
+        for (std::size_t j = 0; j < numRules; ++j)
+        {
+            // Give a name to this term
+            oss.str("");
+            oss << p_iv->getName() << "mf" << j;
+
+            p_iv->addTerm(new fl::Gaussian(oss.str(), centers[j][i], sigmas[j][i]));
+        }
+
+        p_fis->addInputVariable(p_iv);
+    }
+
+    // Generate output variables and terms
+    for (std::size_t i = 0; i < numOutputs; ++i)
+    {
+        const std::size_t k = numInputs+i;
+
+        fl::OutputVariable* p_ov = new fl::OutputVariable();
+
+        std::ostringstream oss;
+
+        oss << "out" << i;
+        p_ov->setEnabled(true);
+        p_ov->setName(oss.str());
+        p_ov->setRange(mins[k], maxs[k]);
+        p_ov->fuzzyOutput()->setAccumulation(new fl::Maximum());
+        p_ov->setDefuzzifier(new fl::WeightedAverage());
+        p_ov->setDefaultValue(fl::nan);
+        p_ov->setPreviousValue(false);
+
+        for (std::size_t j = 0; j < numRules; ++j)
+        {
+            // Give a name to this term
+            oss.str("");
+            oss << p_ov->getName() << "mf" << j;
+
+            std::vector<fl::scalar> params(numParams);
+            for (std::size_t p = 0; p < numParams; ++p)
+            {
+                params[p] = outParams[j*numParams+p][i];
+            }
+
+            p_ov->addTerm(new fl::Linear(oss.str(), params, p_fis.get()));
+        }
+
+        p_fis->addOutputVariable(p_ov);
+    }
+
+    // Generate rules
+    fl::RuleBlock* p_rules = new fl::RuleBlock();
+    p_rules->setEnabled(true);
+    p_rules->setConjunction(new fl::AlgebraicProduct());
+    p_rules->setDisjunction(new fl::AlgebraicSum());
+    p_rules->setActivation(new fl::General());
+    p_rules->setImplication(new fl::AlgebraicProduct());
+    std::vector<std::string> ruleTexts(numRules);
+    for (std::size_t r = 0; r < numRules; ++r)
+    {
+        std::ostringstream oss;
+
+        oss << fl::Rule::ifKeyword() << " ";
+
+        for (std::size_t j = 0; j < numInputs; ++j)
+        {
+            const fl::InputVariable* p_iv = p_fis->getInputVariable(j);
+
+            oss << p_iv->getName() << " " << fl::Rule::isKeyword() << " " << p_iv->getTerm(r)->getName() << " ";
+
+            if (j < (numInputs-1))
+            {
+                oss << fl::Rule::andKeyword() << " ";
+            }
+        }
+
+        oss << fl::Rule::thenKeyword();
+
+        for (std::size_t j = 0; j < numOutputs; ++j)
+        {
+            const fl::OutputVariable* p_ov = p_fis->getOutputVariable(j);
+            oss << " " << p_ov->getName() << " " << fl::Rule::isKeyword() << " " << p_ov->getTerm(r)->getName();
+            if (j < (numOutputs-1))
+            {
+                oss << " " << fl::Rule::andKeyword() << " ";
+            }
+        }
+        ruleTexts[r] = oss.str();
+    }
+    p_fis->addRuleBlock(p_rules);
+    fl::detail::AddParsedRules(p_rules, ruleTexts, p_fis.get());
+
+    return p_fis;
+}
+
+}} // Namespace fl::detail
+
+#endif // FL_FIS_BUILDER_TAKAGI_SUGENO_H
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
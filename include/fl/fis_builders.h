@@ -25,7 +25,9 @@
 #ifndef FL_FIS_BUILDERS_H
 #define FL_FIS_BUILDERS_H
 
+#include <fl/fis_builder/fuzzy_cmeans.h>
 #include <fl/fis_builder/grid_partition.h>
+#include <fl/fis_builder/structure_search.h>
 #include <fl/fis_builder/subtractive_clustering.h>
 
 #endif // FL_FIS_BUILDERS_H
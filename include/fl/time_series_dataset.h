@@ -0,0 +1,347 @@
+/**
+ * \file fl/time_series_dataset.h
+ *
+ * \brief Lagged views of time series for forecasting models
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FL_TIME_SERIES_DATASET_H
+#define FL_TIME_SERIES_DATASET_H
+
+
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <cstddef>
+#include <fl/dataset.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl {
+
+/**
+ * A time series presented as a dataset for forecasting models.
+ *
+ * For a number of lags \f$D\f$, a delay \f$\Delta\f$ and a horizon \f$P\f$,
+ * the entry of the dataset at time \f$t\f$ has inputs
+ * \f$x(t-(D-1)\Delta), \ldots, x(t-\Delta), x(t)\f$ and output
+ * \f$x(t+P)\f$, where the horizon must be a multiple of the delay.
+ * The first entry is the one at time \f$(D-1)\Delta\f$ (i.e., the first
+ * one with a complete history), and entries follow in time order.
+ *
+ * Samples are stored only once: the dataset returned by dataSet() is a view
+ * whose (overlapping) entries point directly to the stored samples, so it
+ * takes no more memory than the series itself (plus one position per entry
+ * when the delay is greater than one).
+ * To this end, samples are stored grouped by their time modulo the delay,
+ * so that the samples of an entry are contiguous in memory.
+ * When the horizon equals the delay (the usual setting), the output of each
+ * entry immediately follows its inputs, so that the view can also be passed
+ * to the algorithms requiring fl::DataSet::matrix (e.g., FIS builders).
+ *
+ * Samples can be appended at any time, e.g., as they come from a live feed;
+ * by setting a maximum length, only (at least) the most recent samples are
+ * kept, in bounded memory.
+ * Views returned by dataSet() share the samples and keep them alive: after
+ * samples are appended or dropped, previously returned views remain valid and
+ * keep presenting the entries that were available when they were taken.
+ *
+ * \tparam ValueT Types for values stored in the time series
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ */
+template <typename ValueT = fl::scalar>
+class TimeSeriesDataSet
+{
+public:
+    /**
+     * Constructs an empty time series whose entries are made of \a numOfLags
+     * samples, \a delay time steps apart, and of the sample \a horizon time
+     * steps after the last one.
+     */
+    explicit TimeSeriesDataSet(std::size_t numOfLags = 1, std::size_t delay = 1, std::size_t horizon = 1);
+
+    /// Returns the number of lagged samples (i.e., of inputs) of each entry
+    std::size_t numOfLags() const;
+
+    /// Returns the number of time steps between two consecutive lagged samples
+    std::size_t getDelay() const;
+
+    /// Returns the number of time steps between the last lagged sample and the predicted one
+    std::size_t getHorizon() const;
+
+    /**
+     * Sets the number of most recent samples to keep (zero means no limit).
+     *
+     * Older samples are dropped in blocks while appending new ones, so the
+     * time series can temporarily hold up to about twice this number of
+     * samples.
+     */
+    void setMaxLength(std::size_t value);
+
+    /// Returns the number of most recent samples to keep (zero means no limit)
+    std::size_t getMaxLength() const;
+
+    /// Appends the sample \a x to the time series
+    void append(ValueT x);
+
+    /// Appends the samples in the range [\a first, \a last) to the time series
+    template <typename IterT>
+    void append(IterT first, IterT last);
+
+    /// Returns the number of stored samples
+    std::size_t length() const;
+
+    /// Returns the \a idx-th stored sample (where the 0-th is the oldest one)
+    ValueT getSample(std::size_t idx) const;
+
+    /// Returns the number of entries
+    std::size_t size() const;
+
+    /// Tells if there is no entry
+    bool empty() const;
+
+    /// Removes all the samples
+    void clear();
+
+    /// Returns a view of the entries as a dataset with numOfLags() inputs and one output
+    const fl::DataSet<ValueT> dataSet() const;
+
+
+private:
+    /// Moves the samples from the \a first-th one on to a new buffer of \a cap samples per delay phase
+    void reshape(std::size_t first, std::size_t cap);
+
+    /// Returns the position of the first sample of the \a idx-th entry in the buffer
+    std::size_t position(std::size_t idx) const;
+
+
+private:
+    static const std::size_t MinCapacity = 64; ///< The minimum number of samples per delay phase
+
+
+    std::size_t nlags_; ///< The number of lagged samples
+    std::size_t delay_; ///< The delay between lagged samples
+    std::size_t horizon_; ///< The horizon of the predicted sample
+    std::size_t maxLen_; ///< The number of most recent samples to keep
+    std::size_t len_; ///< The number of stored samples
+    std::size_t cap_; ///< The number of samples that can be stored per delay phase
+    boost::shared_ptr< std::vector<ValueT> > p_buf_; ///< The samples, grouped by delay phase
+    boost::shared_ptr< std::vector<std::size_t> > p_pos_; ///< The positions of entries in the buffer (null if the delay is one)
+}; // TimeSeriesDataSet
+
+
+////////////////////////
+// Template definitions
+////////////////////////
+
+
+template <typename ValueT>
+TimeSeriesDataSet<ValueT>::TimeSeriesDataSet(std::size_t numOfLags, std::size_t delay, std::size_t horizon)
+: nlags_(numOfLags),
+  delay_(delay),
+  horizon_(horizon),
+  maxLen_(0),
+  len_(0),
+  cap_(0)
+{
+    if (numOfLags == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Number of lags must be positive");
+    }
+    if (delay == 0)
+    {
+        FL_THROW2(std::invalid_argument, "Delay must be positive");
+    }
+    if (horizon == 0 || horizon % delay != 0)
+    {
+        FL_THROW2(std::invalid_argument, "Horizon must be a positive multiple of the delay");
+    }
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::numOfLags() const
+{
+    return nlags_;
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::getDelay() const
+{
+    return delay_;
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::getHorizon() const
+{
+    return horizon_;
+}
+
+template <typename ValueT>
+void TimeSeriesDataSet<ValueT>::setMaxLength(std::size_t value)
+{
+    maxLen_ = value;
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::getMaxLength() const
+{
+    return maxLen_;
+}
+
+template <typename ValueT>
+void TimeSeriesDataSet<ValueT>::append(ValueT x)
+{
+    if (len_ == cap_*delay_)
+    {
+        // The buffer is full: drop the oldest samples (in multiples of the
+        // delay, to preserve phases) and/or grow it
+        std::size_t first = 0;
+        if (maxLen_ > 0 && len_ > maxLen_)
+        {
+            first = ((len_-maxLen_)/delay_)*delay_;
+        }
+        const std::size_t used = (len_-first+delay_-1)/delay_;
+
+        this->reshape(first, std::max(2*used, static_cast<std::size_t>(MinCapacity)));
+    }
+
+    (*p_buf_)[(len_ % delay_)*cap_ + len_/delay_] = x;
+    ++len_;
+
+    if (p_pos_ && p_pos_->size() < this->size())
+    {
+        // Capacity was reserved by reshape(), so that positions never move
+        p_pos_->push_back(this->position(p_pos_->size()));
+    }
+}
+
+template <typename ValueT>
+template <typename IterT>
+void TimeSeriesDataSet<ValueT>::append(IterT first, IterT last)
+{
+    for (; first != last; ++first)
+    {
+        this->append(*first);
+    }
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::length() const
+{
+    return len_;
+}
+
+template <typename ValueT>
+ValueT TimeSeriesDataSet<ValueT>::getSample(std::size_t idx) const
+{
+    if (idx >= len_)
+    {
+        FL_THROW2(std::invalid_argument, "Sample index is out-of-range");
+    }
+
+    return (*p_buf_)[(idx % delay_)*cap_ + idx/delay_];
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::size() const
+{
+    const std::size_t span = (nlags_-1)*delay_+horizon_;
+
+    return len_ > span ? len_-span : 0;
+}
+
+template <typename ValueT>
+bool TimeSeriesDataSet<ValueT>::empty() const
+{
+    return this->size() == 0;
+}
+
+template <typename ValueT>
+void TimeSeriesDataSet<ValueT>::clear()
+{
+    // Release (rather than clear) the storage, which may be shared by views
+    p_buf_.reset();
+    p_pos_.reset();
+    len_ = 0;
+    cap_ = 0;
+}
+
+template <typename ValueT>
+const fl::DataSet<ValueT> TimeSeriesDataSet<ValueT>::dataSet() const
+{
+    const std::size_t n = this->size();
+
+    if (n == 0)
+    {
+        return fl::DataSet<ValueT>(nlags_, 1);
+    }
+
+    return fl::DataSet<ValueT>(&(*p_buf_)[0], n, nlags_, 1,
+                               nlags_-1+horizon_/delay_, 1,
+                               p_pos_, p_buf_);
+}
+
+template <typename ValueT>
+void TimeSeriesDataSet<ValueT>::reshape(std::size_t first, std::size_t cap)
+{
+    FL_DEBUG_ASSERT( first % delay_ == 0 );
+
+    boost::shared_ptr< std::vector<ValueT> > p_buf(new std::vector<ValueT>(cap*delay_));
+    for (std::size_t k = 0; k < delay_ && first+k < len_; ++k)
+    {
+        // Samples of phase k, from the (first+k)-th one on
+        const std::size_t cnt = (len_-first-k+delay_-1)/delay_;
+        const ValueT* src = &(*p_buf_)[k*cap_+first/delay_];
+
+        std::copy(src, src+cnt, p_buf->begin()+k*cap);
+    }
+    p_buf_ = p_buf;
+    cap_ = cap;
+    len_ -= first;
+
+    if (delay_ > 1)
+    {
+        boost::shared_ptr< std::vector<std::size_t> > p_pos(new std::vector<std::size_t>());
+        p_pos->reserve(cap*delay_);
+        p_pos_ = p_pos;
+        for (std::size_t i = 0,
+                         n = this->size();
+             i < n;
+             ++i)
+        {
+            p_pos_->push_back(this->position(i));
+        }
+    }
+}
+
+template <typename ValueT>
+std::size_t TimeSeriesDataSet<ValueT>::position(std::size_t idx) const
+{
+    return (idx % delay_)*cap_ + idx/delay_;
+}
+
+} // Namespace fl
+
+#endif // FL_TIME_SERIES_DATASET_H
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,868 @@
+/**
+ * \file anfis/training/evolving_ts.cpp
+ *
+ * \brief Definitions for the evolving Takagi-Sugeno (eTS) learning algorithm
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <boost/exception_ptr.hpp>
+#include <cmath>
+#include <cstddef>
+#include <fl/activation/General.h>
+#include <fl/anfis/engine.h>
+#include <fl/anfis/training/evolving_ts.h>
+#include <fl/dataset.h>
+#include <fl/defuzzifier/WeightedAverage.h>
+#include <fl/detail/math.h>
+#include <fl/detail/rules.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <fl/norm/s/AlgebraicSum.h>
+#include <fl/norm/s/Maximum.h>
+#include <fl/norm/t/AlgebraicProduct.h>
+#include <fl/Operation.h>
+#include <fl/rule/Rule.h>
+#include <fl/rule/RuleBlock.h>
+#include <fl/term/Gaussian.h>
+#include <fl/term/Linear.h>
+#include <fl/variable/InputVariable.h>
+#include <fl/variable/OutputVariable.h>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace fl { namespace anfis {
+
+EvolvingTakagiSugenoLearningAlgorithm::EvolvingTakagiSugenoLearningAlgorithm(Engine* p_anfis,
+                                                                             fl::scalar radius,
+                                                                             fl::scalar ff)
+: BaseType(p_anfis),
+  radius_(radius),
+  ff_(ff),
+  omega_(1000),
+  mergeThr_(0.8),
+  maxRules_(0),
+  initialized_(false),
+  ni_(0),
+  no_(0),
+  k_(0),
+  sumZSq_(0)
+{
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::setRadius(fl::scalar value)
+{
+    if (value <= 0)
+    {
+        FL_THROW2(std::invalid_argument, "Radius must be a positive number");
+    }
+
+    radius_ = value;
+}
+
+fl::scalar EvolvingTakagiSugenoLearningAlgorithm::getRadius() const
+{
+    return radius_;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::setForgettingFactor(fl::scalar value)
+{
+    if (value <= 0 || value > 1)
+    {
+        FL_THROW2(std::invalid_argument, "Forgetting factor must be in (0,1]");
+    }
+
+    ff_ = value;
+}
+
+fl::scalar EvolvingTakagiSugenoLearningAlgorithm::getForgettingFactor() const
+{
+    return ff_;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::setInitialCovariance(fl::scalar value)
+{
+    if (value <= 0)
+    {
+        FL_THROW2(std::invalid_argument, "Initial covariance must be a positive number");
+    }
+
+    omega_ = value;
+}
+
+fl::scalar EvolvingTakagiSugenoLearningAlgorithm::getInitialCovariance() const
+{
+    return omega_;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::setMergeThreshold(fl::scalar value)
+{
+    if (value <= 0 || value > 1)
+    {
+        FL_THROW2(std::invalid_argument, "Merge threshold must be in (0,1]");
+    }
+
+    mergeThr_ = value;
+}
+
+fl::scalar EvolvingTakagiSugenoLearningAlgorithm::getMergeThreshold() const
+{
+    return mergeThr_;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::setMaxNumberOfRules(std::size_t value)
+{
+    maxRules_ = value;
+}
+
+std::size_t EvolvingTakagiSugenoLearningAlgorithm::getMaxNumberOfRules() const
+{
+    return maxRules_;
+}
+
+std::size_t EvolvingTakagiSugenoLearningAlgorithm::numberOfRules() const
+{
+    return rules_.size();
+}
+
+std::size_t EvolvingTakagiSugenoLearningAlgorithm::numberOfSamples() const
+{
+    return k_;
+}
+
+const std::vector<fl::scalar>& EvolvingTakagiSugenoLearningAlgorithm::learn(const std::vector<fl::scalar>& inputs, const std::vector<fl::scalar>& outputs)
+{
+    return this->learn(inputs.begin(), inputs.end(), outputs.begin(), outputs.end());
+}
+
+fl::scalar EvolvingTakagiSugenoLearningAlgorithm::doTrainSingleEpoch(const fl::DataSet<fl::scalar>& trainData)
+{
+    fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) of predictions made before learning each sample
+    std::size_t numPredictions = 0;
+
+    for (typename fl::DataSet<fl::scalar>::ConstEntryIterator entryIt = trainData.entryBegin(),
+                                                              entryEndIt = trainData.entryEnd();
+         entryIt != entryEndIt;
+         ++entryIt)
+    {
+        const fl::DataSetEntry<fl::scalar>& entry = *entryIt;
+
+        const std::vector<fl::scalar>& actualOut = this->learn(entry.inputBegin(), entry.inputEnd(), entry.outputBegin(), entry.outputEnd());
+
+        if (!fl::Op::isNaN(actualOut[0]))
+        {
+            for (std::size_t i = 0,
+                             n = actualOut.size();
+                 i < n;
+                 ++i)
+            {
+                rmse += fl::detail::Sqr(entry.getOutput(i)-actualOut[i]);
+            }
+            ++numPredictions;
+        }
+    }
+
+    if (numPredictions > 0)
+    {
+        rmse = std::sqrt(rmse/numPredictions);
+    }
+
+    return rmse;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::doReset()
+{
+    // The state is lazily initialized from the ANFIS model at the next sample
+    initialized_ = false;
+    rules_.clear();
+    k_ = 0;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::check() const
+{
+    if (this->getEngine() == fl::null)
+    {
+        FL_THROW2(std::logic_error, "Invalid ANFIS engine");
+    }
+    if (this->getEngine()->numberOfInputVariables() == 0)
+    {
+        FL_THROW2(std::logic_error, "Not enough input variables to learn an eTS model");
+    }
+    if (this->getEngine()->numberOfOutputVariables() == 0)
+    {
+        FL_THROW2(std::logic_error, "Not enough output variables to learn an eTS model");
+    }
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::init()
+{
+    this->check();
+
+    Engine* p_anfis = this->getEngine();
+
+    ni_ = p_anfis->numberOfInputVariables();
+    no_ = p_anfis->numberOfOutputVariables();
+
+    const std::size_t nz = ni_+no_;
+    const std::size_t np = ni_+1;
+
+    // Scales each variable to the unit interval, provided that its range is known
+    offset_.assign(nz, 0);
+    scale_.assign(nz, 1);
+    for (std::size_t i = 0; i < nz; ++i)
+    {
+        const fl::Variable* p_var = (i < ni_)
+                                    ? static_cast<const fl::Variable*>(p_anfis->getInputVariable(i))
+                                    : static_cast<const fl::Variable*>(p_anfis->getOutputVariable(i-ni_));
+
+        const fl::scalar lo = p_var->getMinimum();
+        const fl::scalar hi = p_var->getMaximum();
+        if (!fl::Op::isInf(lo) && !fl::Op::isInf(hi) && !fl::Op::isNaN(lo) && !fl::Op::isNaN(hi) && hi > lo)
+        {
+            offset_[i] = lo;
+            scale_[i] = 1.0/(hi-lo);
+        }
+    }
+
+    // Same spread as the one used by subtractive clustering for the given radius
+    sigma_.assign(ni_, radius_/std::sqrt(8.0));
+
+    k_ = 0;
+    sumZ_.assign(nz, 0);
+    sumZSq_ = 0;
+    rules_.clear();
+
+    // Imports the rules of the model, if any
+    const fl::RuleBlock* p_rb = (p_anfis->numberOfRuleBlocks() > 0) ? p_anfis->getRuleBlock(0) : fl::null;
+    const std::size_t nr = p_rb ? static_cast<std::size_t>(p_rb->numberOfRules()) : 0;
+    if (nr > 0)
+    {
+        for (std::size_t i = 0; i < ni_; ++i)
+        {
+            if (static_cast<std::size_t>(p_anfis->getInputVariable(i)->numberOfTerms()) != nr)
+            {
+                FL_THROW2(std::invalid_argument, "Input variables must have a term for each rule");
+            }
+        }
+        for (std::size_t i = 0; i < no_; ++i)
+        {
+            if (static_cast<std::size_t>(p_anfis->getOutputVariable(i)->numberOfTerms()) != nr)
+            {
+                FL_THROW2(std::invalid_argument, "Output variables must have a term for each rule");
+            }
+        }
+
+        rules_.resize(nr);
+        for (std::size_t r = 0; r < nr; ++r)
+        {
+            RuleState& rule = rules_[r];
+
+            rule.center.resize(nz);
+            rule.potential = 1;
+            rule.support = 1;
+            rule.theta.resize(np*no_);
+            rule.cov.assign(np*np, 0);
+            for (std::size_t p = 0; p < np; ++p)
+            {
+                rule.cov[p*np+p] = omega_;
+            }
+
+            for (std::size_t i = 0; i < ni_; ++i)
+            {
+                const fl::Gaussian* p_term = dynamic_cast<const fl::Gaussian*>(p_anfis->getInputVariable(i)->getTerm(r));
+                if (p_term == fl::null)
+                {
+                    FL_THROW2(std::invalid_argument, "Input terms must be Gaussian");
+                }
+
+                rule.center[i] = (p_term->getMean()-offset_[i])*scale_[i];
+                if (r == 0 && p_term->getStandardDeviation() > 0)
+                {
+                    sigma_[i] = p_term->getStandardDeviation()*scale_[i];
+                }
+            }
+            for (std::size_t i = 0; i < no_; ++i)
+            {
+                const fl::Linear* p_term = dynamic_cast<const fl::Linear*>(p_anfis->getOutputVariable(i)->getTerm(r));
+                if (p_term == fl::null || p_term->coefficients().size() != np)
+                {
+                    FL_THROW2(std::invalid_argument, "Output terms must be linear in the inputs");
+                }
+
+                // The output part of the center is the output of the rule at the center
+                const std::vector<fl::scalar>& coeffs = p_term->coefficients();
+                fl::scalar y = coeffs[ni_];
+                for (std::size_t p = 0; p < ni_; ++p)
+                {
+                    rule.theta[i*np+p] = coeffs[p];
+                    y += coeffs[p]*(rule.center[p]/scale_[p]+offset_[p]);
+                }
+                rule.theta[i*np+ni_] = coeffs[ni_];
+                rule.center[ni_+i] = (y-offset_[ni_+i])*scale_[ni_+i];
+            }
+        }
+    }
+
+    lambda_.resize(rules_.size());
+    xe_.resize(np);
+    z_.resize(nz);
+    y_.resize(no_);
+    yhat_.resize(no_);
+    cx_.resize(np);
+
+    initialized_ = true;
+}
+
+const std::vector<fl::scalar>& EvolvingTakagiSugenoLearningAlgorithm::learnSample()
+{
+    // Scales the sample and extends the inputs with the bias term
+    for (std::size_t i = 0; i < ni_; ++i)
+    {
+        z_[i] = (xe_[i]-offset_[i])*scale_[i];
+    }
+    xe_[ni_] = 1;
+    for (std::size_t i = 0; i < no_; ++i)
+    {
+        z_[ni_+i] = (y_[i]-offset_[ni_+i])*scale_[ni_+i];
+    }
+
+    // Predicts the outputs with the current model
+    if (rules_.empty())
+    {
+        yhat_.assign(no_, fl::nan);
+    }
+    else
+    {
+        this->computeFiringStrengths(&z_[0], lambda_);
+        this->computeOutputs(xe_, lambda_, yhat_);
+    }
+
+    // Evolves the rule base and updates the consequents of each rule
+    ++k_;
+    const bool resized = this->evolve(z_);
+
+    const std::size_t best = this->computeFiringStrengths(&z_[0], lambda_);
+    ++rules_[best].support;
+    for (std::size_t r = 0,
+                     nr = rules_.size();
+         r < nr;
+         ++r)
+    {
+        this->updateConsequents(r, xe_, y_, lambda_[r]);
+    }
+
+    if (resized)
+    {
+        this->rebuildEngine();
+    }
+    else
+    {
+        this->updateEngineParameters();
+    }
+
+    return yhat_;
+}
+
+fl::scalar EvolvingTakagiSugenoLearningAlgorithm::inputDistanceSq(const fl::scalar* x, const RuleState& rule) const
+{
+    fl::scalar distSq = 0;
+    for (std::size_t i = 0; i < ni_; ++i)
+    {
+        distSq += fl::detail::Sqr((x[i]-rule.center[i])/sigma_[i]);
+    }
+
+    return distSq;
+}
+
+std::size_t EvolvingTakagiSugenoLearningAlgorithm::computeFiringStrengths(const fl::scalar* x, std::vector<fl::scalar>& lambda) const
+{
+    const std::size_t nr = rules_.size();
+
+    FL_DEBUG_ASSERT( nr > 0 );
+
+    // Product of Gaussian memberships, computed relative to the nearest rule
+    // to avoid that all of them underflow far from the centers
+    lambda.resize(nr);
+    std::size_t best = 0;
+    for (std::size_t r = 0; r < nr; ++r)
+    {
+        lambda[r] = this->inputDistanceSq(x, rules_[r]);
+        if (lambda[r] < lambda[best])
+        {
+            best = r;
+        }
+    }
+
+    const fl::scalar minDistSq = lambda[best];
+    fl::scalar sum = 0;
+    for (std::size_t r = 0; r < nr; ++r)
+    {
+        lambda[r] = std::exp(-0.5*(lambda[r]-minDistSq));
+        sum += lambda[r];
+    }
+    for (std::size_t r = 0; r < nr; ++r)
+    {
+        lambda[r] /= sum;
+    }
+
+    return best;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::computeOutputs(const std::vector<fl::scalar>& xe, const std::vector<fl::scalar>& lambda, std::vector<fl::scalar>& y) const
+{
+    const std::size_t np = ni_+1;
+
+    y.assign(no_, 0);
+    for (std::size_t r = 0,
+                     nr = rules_.size();
+         r < nr;
+         ++r)
+    {
+        const std::vector<fl::scalar>& theta = rules_[r].theta;
+        for (std::size_t i = 0; i < no_; ++i)
+        {
+            fl::scalar yr = 0;
+            for (std::size_t p = 0; p < np; ++p)
+            {
+                yr += theta[i*np+p]*xe[p];
+            }
+            y[i] += lambda[r]*yr;
+        }
+    }
+}
+
+bool EvolvingTakagiSugenoLearningAlgorithm::evolve(const std::vector<fl::scalar>& z)
+{
+    const std::size_t nz = z.size();
+
+    if (rules_.empty())
+    {
+        this->addRule(z, 1);
+
+        for (std::size_t j = 0; j < nz; ++j)
+        {
+            sumZ_[j] += z[j];
+            sumZSq_ += z[j]*z[j];
+        }
+
+        return true;
+    }
+
+    // Potential of the new sample with respect to the past ones, from running sums:
+    //  $P_k(z_k) = \frac{k-1}{(k-1)(\vartheta_k+1)+\sigma_k-2\nu_k}$
+    // where $\vartheta_k=\|z_k\|^2$, $\sigma_k=\sum_{l<k}\|z_l\|^2$ and $\nu_k=z_k^T\sum_{l<k}z_l$
+    fl::scalar potential = 1;
+    if (k_ > 1)
+    {
+        fl::scalar theta = 0;
+        fl::scalar nu = 0;
+        for (std::size_t j = 0; j < nz; ++j)
+        {
+            theta += z[j]*z[j];
+            nu += z[j]*sumZ_[j];
+        }
+        const fl::scalar km1 = k_-1;
+        potential = km1/(km1*(theta+1)+sumZSq_-2*nu);
+    }
+    for (std::size_t j = 0; j < nz; ++j)
+    {
+        sumZ_[j] += z[j];
+        sumZSq_ += z[j]*z[j];
+    }
+
+    // Revises the potentials of rule centers to account for the new sample:
+    //  $P_k(z^*) = \frac{(k-1)P_{k-1}(z^*)}{k-2+P_{k-1}(z^*)+P_{k-1}(z^*)\|z^*-z_k\|^2}$
+    // and finds the rule nearest to the new sample
+    fl::scalar maxPotential = 0;
+    fl::scalar minPotential = std::numeric_limits<fl::scalar>::infinity();
+    std::size_t nearest = 0;
+    fl::scalar nearestDistSq = std::numeric_limits<fl::scalar>::infinity();
+    for (std::size_t r = 0,
+                     nr = rules_.size();
+         r < nr;
+         ++r)
+    {
+        RuleState& rule = rules_[r];
+
+        if (k_ > 1)
+        {
+            fl::scalar distSq = 0;
+            for (std::size_t j = 0; j < nz; ++j)
+            {
+                distSq += fl::detail::Sqr(rule.center[j]-z[j]);
+            }
+            const fl::scalar p = rule.potential;
+            rule.potential = (k_-1)*p/(k_-2+p+p*distSq);
+        }
+        maxPotential = std::max(maxPotential, rule.potential);
+        minPotential = std::min(minPotential, rule.potential);
+
+        const fl::scalar distSq = this->inputDistanceSq(&z[0], rule);
+        if (distSq < nearestDistSq)
+        {
+            nearestDistSq = distSq;
+            nearest = r;
+        }
+    }
+
+    // The sample is covered by the nearest rule if its membership to each
+    // antecedent term is greater than $e^{-1}$, that is if it is within
+    // $\sqrt{2}$ spreads of the center in each input dimension
+    bool covered = true;
+    for (std::size_t i = 0; i < ni_ && covered; ++i)
+    {
+        covered = fl::detail::Sqr((z[i]-rules_[nearest].center[i])/sigma_[i]) < 2;
+    }
+    const bool full = maxRules_ > 0 && rules_.size() >= maxRules_;
+    // The eTS+ criterion for a new rule center
+    const bool candidate = potential > maxPotential || potential < minPotential;
+
+    if ((potential > maxPotential && covered) || (candidate && !covered && full))
+    {
+        // Moves the nearest rule onto the new sample (also when the sample
+        // would create a new rule but the rule base is full)
+        rules_[nearest].center = z;
+        rules_[nearest].potential = potential;
+
+        return this->mergeRule(nearest);
+    }
+    if (candidate && !covered)
+    {
+        this->addRule(z, potential);
+        this->mergeRule(rules_.size()-1);
+
+        return true;
+    }
+
+    return false;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::addRule(const std::vector<fl::scalar>& z, fl::scalar potential)
+{
+    const std::size_t np = ni_+1;
+
+    RuleState rule;
+    rule.center = z;
+    rule.potential = potential;
+    rule.support = 0;
+    rule.theta.assign(np*no_, 0);
+    rule.cov.assign(np*np, 0);
+    for (std::size_t p = 0; p < np; ++p)
+    {
+        rule.cov[p*np+p] = omega_;
+    }
+
+    // The consequent parameters of the new rule are the average of the ones
+    // of the existing rules, weighted by their firing strength
+    if (!rules_.empty())
+    {
+        this->computeFiringStrengths(&z[0], lambda_);
+        for (std::size_t r = 0,
+                         nr = rules_.size();
+             r < nr;
+             ++r)
+        {
+            for (std::size_t p = 0,
+                             n = rule.theta.size();
+                 p < n;
+                 ++p)
+            {
+                rule.theta[p] += lambda_[r]*rules_[r].theta[p];
+            }
+        }
+    }
+
+    rules_.push_back(rule);
+}
+
+bool EvolvingTakagiSugenoLearningAlgorithm::mergeRule(std::size_t r)
+{
+    bool merged = false;
+
+    std::size_t s = 0;
+    while (s < rules_.size())
+    {
+        if (s == r)
+        {
+            ++s;
+            continue;
+        }
+
+        const fl::scalar similarity = std::exp(-0.5*this->inputDistanceSq(&rules_[r].center[0], rules_[s]));
+        if (similarity <= mergeThr_)
+        {
+            ++s;
+            continue;
+        }
+
+        // Merges rule s into rule r, weighting them by their support
+        RuleState& dst = rules_[r];
+        const RuleState& src = rules_[s];
+
+        const fl::scalar wd = std::max(dst.support, std::size_t(1));
+        const fl::scalar ws = std::max(src.support, std::size_t(1));
+        for (std::size_t j = 0,
+                         nz = dst.center.size();
+             j < nz;
+             ++j)
+        {
+            dst.center[j] = (wd*dst.center[j]+ws*src.center[j])/(wd+ws);
+        }
+        for (std::size_t p = 0,
+                         n = dst.theta.size();
+             p < n;
+             ++p)
+        {
+            dst.theta[p] = (wd*dst.theta[p]+ws*src.theta[p])/(wd+ws);
+        }
+        if (ws > wd)
+        {
+            dst.cov = src.cov;
+        }
+        dst.potential = std::max(dst.potential, src.potential);
+        dst.support += src.support;
+
+        rules_.erase(rules_.begin()+s);
+        if (s < r)
+        {
+            --r;
+        }
+        merged = true;
+
+        // The merged center has moved, so the other rules must be checked again
+        s = 0;
+    }
+
+    lambda_.resize(rules_.size());
+
+    return merged;
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::updateConsequents(std::size_t r, const std::vector<fl::scalar>& xe, const std::vector<fl::scalar>& y, fl::scalar lambda)
+{
+    if (lambda <= 0)
+    {
+        return;
+    }
+
+    const std::size_t np = ni_+1;
+
+    RuleState& rule = rules_[r];
+
+    // Fuzzily weighted RLS:
+    //  $C \gets \frac{1}{\mu}\left[C-\frac{\lambda C x_e x_e^T C}{\mu+\lambda x_e^T C x_e}\right]$
+    //  $\theta \gets \theta+\frac{\lambda C x_e}{\mu+\lambda x_e^T C x_e}(y-x_e^T\theta)$
+    // where the forgetting factor $\mu$ is scaled by the firing strength, so
+    // that rules forget only as much as they are involved in the sample.
+    // Forgetting is suspended while the covariance is as large as the initial
+    // one, to prevent its wind-up in the directions that are poorly excited
+    fl::scalar trace = 0;
+    for (std::size_t p = 0; p < np; ++p)
+    {
+        trace += rule.cov[p*np+p];
+    }
+    const fl::scalar mu = (trace < np*omega_) ? 1-lambda*(1-ff_) : 1;
+
+    std::vector<fl::scalar>& cx = cx_;
+    fl::scalar xcx = 0;
+    for (std::size_t p = 0; p < np; ++p)
+    {
+        cx[p] = 0;
+        for (std::size_t q = 0; q < np; ++q)
+        {
+            cx[p] += rule.cov[p*np+q]*xe[q];
+        }
+        xcx += xe[p]*cx[p];
+    }
+
+    const fl::scalar denom = mu+lambda*xcx;
+    for (std::size_t i = 0; i < no_; ++i)
+    {
+        fl::scalar err = y[i];
+        for (std::size_t p = 0; p < np; ++p)
+        {
+            err -= rule.theta[i*np+p]*xe[p];
+        }
+        for (std::size_t p = 0; p < np; ++p)
+        {
+            rule.theta[i*np+p] += lambda*cx[p]*err/denom;
+        }
+    }
+    // Only the upper triangle is computed and then mirrored, since even tiny
+    // asymmetries due to rounding are amplified by forgetting over time
+    for (std::size_t p = 0; p < np; ++p)
+    {
+        for (std::size_t q = p; q < np; ++q)
+        {
+            rule.cov[p*np+q] = rule.cov[q*np+p] = (rule.cov[p*np+q]-lambda*cx[p]*cx[q]/denom)/mu;
+        }
+    }
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::rebuildEngine()
+{
+    Engine* p_anfis = this->getEngine();
+
+    const std::size_t nr = rules_.size();
+
+    // Regenerates the terms with the same naming scheme used by the FIS builders
+    for (std::size_t i = 0; i < ni_; ++i)
+    {
+        fl::InputVariable* p_iv = p_anfis->getInputVariable(i);
+
+        while (p_iv->numberOfTerms() > 0)
+        {
+            delete p_iv->removeTerm(0);
+        }
+        for (std::size_t r = 0; r < nr; ++r)
+        {
+            std::ostringstream oss;
+            oss << p_iv->getName() << "mf" << r;
+            p_iv->addTerm(new fl::Gaussian(oss.str(), 0, 1));
+        }
+    }
+    for (std::size_t i = 0; i < no_; ++i)
+    {
+        fl::OutputVariable* p_ov = p_anfis->getOutputVariable(i);
+
+        while (p_ov->numberOfTerms() > 0)
+        {
+            delete p_ov->removeTerm(0);
+        }
+        if (p_ov->getDefuzzifier() == fl::null)
+        {
+            p_ov->setDefuzzifier(new fl::WeightedAverage());
+        }
+        for (std::size_t r = 0; r < nr; ++r)
+        {
+            std::ostringstream oss;
+            oss << p_ov->getName() << "mf" << r;
+            p_ov->addTerm(new fl::Linear(oss.str(), std::vector<fl::scalar>(ni_+1, 0), p_anfis));
+        }
+    }
+
+    // Regenerates the rules
+    if (p_anfis->numberOfRuleBlocks() == 0)
+    {
+        fl::RuleBlock* p_rules = new fl::RuleBlock();
+        p_rules->setEnabled(true);
+        p_rules->setConjunction(new fl::AlgebraicProduct());
+        p_rules->setDisjunction(new fl::AlgebraicSum());
+        p_rules->setActivation(new fl::General());
+        p_rules->setImplication(new fl::AlgebraicProduct());
+        p_anfis->addRuleBlock(p_rules);
+    }
+    fl::RuleBlock* p_rules = p_anfis->getRuleBlock(0);
+    while (p_rules->numberOfRules() > 0)
+    {
+        delete p_rules->removeRule(0);
+    }
+    std::vector<std::string> ruleTexts;
+    for (std::size_t r = 0; r < nr; ++r)
+    {
+        std::ostringstream oss;
+
+        oss << fl::Rule::ifKeyword() << " ";
+        for (std::size_t i = 0; i < ni_; ++i)
+        {
+            const fl::InputVariable* p_iv = p_anfis->getInputVariable(i);
+
+            oss << p_iv->getName() << " " << fl::Rule::isKeyword() << " " << p_iv->getTerm(r)->getName() << " ";
+            if (i < (ni_-1))
+            {
+                oss << fl::Rule::andKeyword() << " ";
+            }
+        }
+        oss << fl::Rule::thenKeyword();
+        for (std::size_t i = 0; i < no_; ++i)
+        {
+            const fl::OutputVariable* p_ov = p_anfis->getOutputVariable(i);
+
+            oss << " " << p_ov->getName() << " " << fl::Rule::isKeyword() << " " << p_ov->getTerm(r)->getName();
+            if (i < (no_-1))
+            {
+                oss << " " << fl::Rule::andKeyword() << " ";
+            }
+        }
+        ruleTexts.push_back(oss.str());
+    }
+    fl::detail::AddParsedRules(p_rules, ruleTexts, p_anfis);
+
+    this->updateEngineParameters();
+
+    // Building goes through the fuzzylite factories too (see
+    // fl::detail::AddParsedRules), and no exception can leave a critical
+    // section, so it is rethrown outside
+    boost::exception_ptr p_err;
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (fl_fuzzylite_factories)
+#endif // FLX_CONFIG_HAVE_OPENMP
+    {
+        try
+        {
+            p_anfis->build();
+        }
+        catch (...)
+        {
+            p_err = boost::current_exception();
+        }
+    }
+    if (p_err)
+    {
+        boost::rethrow_exception(p_err);
+    }
+}
+
+void EvolvingTakagiSugenoLearningAlgorithm::updateEngineParameters()
+{
+    Engine* p_anfis = this->getEngine();
+
+    const std::size_t np = ni_+1;
+
+    std::vector<fl::scalar> coeffs(np);
+    for (std::size_t r = 0,
+                     nr = rules_.size();
+         r < nr;
+         ++r)
+    {
+        const RuleState& rule = rules_[r];
+
+        for (std::size_t i = 0; i < ni_; ++i)
+        {
+            fl::Gaussian* p_term = static_cast<fl::Gaussian*>(p_anfis->getInputVariable(i)->getTerm(r));
+            p_term->setMean(rule.center[i]/scale_[i]+offset_[i]);
+            p_term->setStandardDeviation(sigma_[i]/scale_[i]);
+        }
+        for (std::size_t i = 0; i < no_; ++i)
+        {
+            fl::Linear* p_term = static_cast<fl::Linear*>(p_anfis->getOutputVariable(i)->getTerm(r));
+            coeffs.assign(rule.theta.begin()+i*np, rule.theta.begin()+(i+1)*np);
+            p_term->setCoefficients(coeffs);
+        }
+    }
+}
+
+}} // Namespace fl::anfis
+
+/* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
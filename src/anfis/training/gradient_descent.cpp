@@ -79,18 +79,12 @@ const std::map< Node*, std::vector<fl::scalar> >& GradientDescentBackpropagation
 
 fl::scalar GradientDescentBackpropagationAlgorithm::doTrainSingleEpoch(const fl::DataSet<fl::scalar>& trainData)
 {
-    this->check();
+    // A training set in memory is trained as a single chunk
+    this->doBeginChunkedEpoch();
 
-    fl::scalar rmse = 0;
+    const fl::scalar rmse = this->doTrainChunk(trainData);
 
-    if (online_)
-    {
-        rmse = this->trainSingleEpochOnline(trainData);
-    }
-    else
-    {
-        rmse = this->trainSingleEpochOffline(trainData);
-    }
+    this->doEndChunkedEpoch(rmse);
 
     //TODO
     //this->setEpochError(rmse);
@@ -99,15 +93,41 @@ fl::scalar GradientDescentBackpropagationAlgorithm::doTrainSingleEpoch(const fl:
     return rmse;
 }
 
+void GradientDescentBackpropagationAlgorithm::doBeginChunkedEpoch()
+{
+    this->check();
+
+    this->resetSingleEpoch();
+}
+
+fl::scalar GradientDescentBackpropagationAlgorithm::doTrainChunk(const fl::DataSet<fl::scalar>& chunk)
+{
+    if (online_)
+    {
+        return this->trainEntriesOnline(chunk);
+    }
+
+    return this->trainEntriesOffline(chunk);
+}
+
+void GradientDescentBackpropagationAlgorithm::doEndChunkedEpoch(fl::scalar rmse)
+{
+    if (!online_)
+    {
+        this->setCurrentError(rmse);
+
+        // Update parameters of input terms with the error derivatives accumulated over the epoch
+        this->updateInputParameters();
+    }
+}
+
 void GradientDescentBackpropagationAlgorithm::doReset()
 {
     this->init();
 }
 
-fl::scalar GradientDescentBackpropagationAlgorithm::trainSingleEpochOffline(const fl::DataSet<fl::scalar>& trainData)
+fl::scalar GradientDescentBackpropagationAlgorithm::trainEntriesOffline(const fl::DataSet<fl::scalar>& trainData)
 {
-    this->resetSingleEpoch();
-
     fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) for this epoch
 
     // Forwards inputs from input layer to the output layer
@@ -263,18 +283,11 @@ fl::scalar GradientDescentBackpropagationAlgorithm::trainSingleEpochOffline(cons
 
     rmse = std::sqrt(rmse/trainData.size());
 
-    this->setCurrentError(rmse);
-
-    // Update parameters of input terms
-    this->updateInputParameters();
-
     return rmse;
 }
 
-fl::scalar GradientDescentBackpropagationAlgorithm::trainSingleEpochOnline(const fl::DataSet<fl::scalar>& trainData)
+fl::scalar GradientDescentBackpropagationAlgorithm::trainEntriesOnline(const fl::DataSet<fl::scalar>& trainData)
 {
-    this->resetSingleEpoch();
-
     fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) for this epoch
 
     // Forwards inputs from input layer to antecedent layer, and estimate parameters with RLS
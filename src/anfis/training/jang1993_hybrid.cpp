@@ -28,8 +28,9 @@
 #include <fl/anfis/training/jang1993_hybrid.h>
 #include <fl/dataset.h>
 #include <fl/detail/math.h>
-//#include <fl/detail/kalman.h>
+#include <fl/detail/kalman.h>
 #include <fl/detail/rls.h>
+#include <fl/detail/sparse.h>
 #include <fl/detail/terms.h>
 #include <fl/detail/traits.h>
 #include <fl/fuzzylite.h>
@@ -56,7 +57,10 @@ Jang1993HybridLearningAlgorithm::Jang1993HybridLearningAlgorithm(Engine* p_anfis
   stepSizeIncrCounter_(0),
   stepSizeDecrCounter_(0),
   online_(false),
-  rls_(0,0,0,ff)/*,
+  estimator_(RecursiveLeastSquaresEstimation),
+  rls_(0,0,0,ff),
+  kalman_(0,0,0,ff),
+  sparsityThr_(0)/*,
   minCheckRmse_(std::numeric_limits<fl::scalar>::infinity())*/
 {
     this->init();
@@ -95,6 +99,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::getStepSizeIncreaseRate() const
 void Jang1993HybridLearningAlgorithm::setForgettingFactor(fl::scalar value)
 {
     rls_.setForgettingFactor(value);
+    kalman_.setForgettingFactor(value);
 }
 
 fl::scalar Jang1993HybridLearningAlgorithm::getForgettingFactor() const
@@ -112,50 +117,79 @@ bool Jang1993HybridLearningAlgorithm::isOnline() const
     return online_;
 }
 
+void Jang1993HybridLearningAlgorithm::setEstimator(EstimatorType value)
+{
+    if (value != estimator_)
+    {
+        estimator_ = value;
+        this->resetEstimator();
+    }
+}
+
+Jang1993HybridLearningAlgorithm::EstimatorType Jang1993HybridLearningAlgorithm::getEstimator() const
+{
+    return estimator_;
+}
+
+void Jang1993HybridLearningAlgorithm::setSparsityThreshold(fl::scalar value)
+{
+    sparsityThr_ = fl::detail::FloatTraits<fl::scalar>::DefinitelyMax(value, 0);
+}
+
+fl::scalar Jang1993HybridLearningAlgorithm::getSparsityThreshold() const
+{
+    return sparsityThr_;
+}
+
 fl::scalar Jang1993HybridLearningAlgorithm::doTrainSingleEpoch(const fl::DataSet<fl::scalar>& trainData)
 {
-    this->check();
+    // A training set in memory is trained as a single chunk
+    this->doBeginChunkedEpoch();
 
-/*
-    // Update parameters of input terms
-    this->updateInputParameters();
+    const fl::scalar rmse = this->doTrainChunk(trainData);
 
-    // Update step-size
-    this->updateStepSize();
+    this->doEndChunkedEpoch(rmse);
 
-    rls_.reset();
-    dEdPs_.clear();
-    //if (rlsPhi_.size() > 0)
-    //{
-    //  // Restore the RLS regressor vector of the previous epoch
-    //  rls_.setRegressor(rlsPhi_);
-    //}
-    //stepSize_ = stepSizeInit_;
-    //stepSizeErrWindow_.clear();
-*/
+    return rmse;
+}
 
-    fl::scalar rmse = 0;
+void Jang1993HybridLearningAlgorithm::doBeginChunkedEpoch()
+{
+    this->check();
 
-    if (online_)
+    if (!online_)
     {
-        rmse = this->trainSingleEpochOnline(trainData);
+        // Update parameters of input terms with the error derivatives of the previous epoch
+        this->updateInputParameters();
+
+        // Update step-size
+        this->updateStepSize();
     }
-    else
+
+    this->resetSingleEpoch();
+}
+
+fl::scalar Jang1993HybridLearningAlgorithm::doTrainChunk(const fl::DataSet<fl::scalar>& chunk)
+{
+    if (online_)
     {
-        rmse = this->trainSingleEpochOffline(trainData);
+        return this->trainEntriesOnline(chunk);
     }
 
-/*
-    if (stepSizeErrWindow_.size() == stepSizeErrWindowLen_)
+    return this->trainEntriesOffline(chunk);
+}
+
+void Jang1993HybridLearningAlgorithm::doEndChunkedEpoch(fl::scalar rmse)
+{
+    if (!online_)
     {
-        stepSizeErrWindow_.pop_back();
-        //stepSizeErrWindow_.pop_front();
+        // Remember the last errors to use them in the step-size update strategy
+        if (stepSizeErrWindow_.size() == stepSizeErrWindowLen_)
+        {
+            stepSizeErrWindow_.pop_back();
+        }
+        stepSizeErrWindow_.push_front(rmse);
     }
-    stepSizeErrWindow_.push_front(rmse);
-    //stepSizeErrWindow_.push_back(rmse);
-*/
-
-    return rmse;
 }
 
 void Jang1993HybridLearningAlgorithm::doReset()
@@ -163,18 +197,8 @@ void Jang1993HybridLearningAlgorithm::doReset()
     this->init();
 }
 
-fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::DataSet<fl::scalar>& trainData)
+fl::scalar Jang1993HybridLearningAlgorithm::trainEntriesOffline(const fl::DataSet<fl::scalar>& trainData)
 {
-    // Update parameters of input terms
-    this->updateInputParameters();
-
-    // Update step-size
-    this->updateStepSize();
-
-    //rls_.reset();
-    //dEdPs_.clear();
-    this->resetSingleEpoch();
-
     const std::size_t numOutTermParams = this->numberOfOutputTermParameters();
 
     fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) for this epoch
@@ -242,7 +266,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::Da
 //  }
 //}[/XXX]
         // Compute input to RLS algorithm
-        std::vector<fl::scalar> rlsInputs(rls_.getInputDimension());
+        fl::detail::SparseVector<fl::scalar> rlsInputs(rls_.getInputDimension());
         {
             // Compute normalization factor
             const fl::scalar totRuleFiringStrength = fl::detail::Sum<fl::scalar>(ruleFiringStrengths.begin(), ruleFiringStrengths.end());
@@ -263,6 +287,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::Da
                 continue;
             }
 
+            std::size_t k = 0;
             for (std::size_t i = 0,
                              ni = this->getEngine()->numberOfRuleBlocks();
                  i < ni;
@@ -273,18 +298,26 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::Da
                 // check: null
                 FL_DEBUG_ASSERT( p_rb );
 
-                std::size_t k = 0;
                 for (std::size_t r = 0,
                                  nr = p_rb->numberOfRules();
                      r < nr;
                      ++r)
                 {
+                    const fl::scalar normRuleFiringStrength = ruleFiringStrengths[r]/totRuleFiringStrength;
+
+                    if (normRuleFiringStrength <= sparsityThr_)
+                    {
+                        // Negligible rule -> leave its parameters out of the regressor
+                        k += numOutTermParams;
+                        continue;
+                    }
+
                     for (std::size_t p = 1; p < numOutTermParams; ++p)
                     {
-                        rlsInputs[k] = ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength;
+                        rlsInputs.append(k, ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength);
                         ++k;
                     }
-                    rlsInputs[k] = ruleFiringStrengths[r]/totRuleFiringStrength;
+                    rlsInputs.append(k, normRuleFiringStrength);
                     ++k;
                 }
             }
@@ -293,7 +326,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::Da
 //std::cerr << "PHASE #0 - RLS Input: "; fl::detail::VectorOutput(std::cerr, rlsInputs); std::cerr << std::endl;///XXX
         // Estimate parameters
         std::vector<fl::scalar> actualOut;
-        actualOut = rls_.estimate(rlsInputs.begin(), rlsInputs.end(), targetOut.begin(), targetOut.end());
+        actualOut = this->estimate(rlsInputs, targetOut);
 //std::cerr << "PHASE #0 - Target: "; fl::detail::VectorOutput(std::cerr, targetOut); std::cerr << " - Actual: ";fl::detail::VectorOutput(std::cerr, actualOut); std::cerr << std::endl;///XXX
 
         ++numTrainings;
@@ -302,7 +335,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::Da
     // Put estimated RLS parameters in the ANFIS model
     if (numTrainings > 0)
     {
-        const std::vector< std::vector<fl::scalar> > rlsParamMatrix = rls_.getEstimatedParameters();
+        const std::vector< std::vector<fl::scalar> > rlsParamMatrix = this->estimatedParameters();
 //std::cerr << "PHASE #0 - Estimated RLS params: "; fl::detail::MatrixOutput(std::cerr, rlsParamMatrix); std::cerr << std::endl;//XXX
 
         for (std::size_t v = 0,
@@ -497,23 +530,11 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOffline(const fl::Da
     //rmse = std::sqrt(rmse/trainData.size());
     rmse = std::sqrt(rmse/numTrainings);
 
-    // Remember the last errors to use them in the step-size update strategy
-    if (stepSizeErrWindow_.size() == stepSizeErrWindowLen_)
-    {
-        stepSizeErrWindow_.pop_back();
-        //stepSizeErrWindow_.pop_front();
-    }
-    stepSizeErrWindow_.push_front(rmse);
-    //stepSizeErrWindow_.push_back(rmse);
-
     return rmse;
 }
 
-fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOnline(const fl::DataSet<fl::scalar>& trainData)
+fl::scalar Jang1993HybridLearningAlgorithm::trainEntriesOnline(const fl::DataSet<fl::scalar>& trainData)
 {
-    //rls_.reset();
-    this->resetSingleEpoch();
-
     const std::size_t numOutTermParams = this->numberOfOutputTermParameters();
 
     fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) for this epoch
@@ -551,7 +572,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOnline(const fl::Dat
         const std::vector<fl::scalar> ruleFiringStrengths = this->getEngine()->evalTo(entry.inputBegin(), entry.inputEnd(), fl::anfis::Engine::AntecedentLayer);
 
         // Compute input to RLS algorithm
-        std::vector<fl::scalar> rlsInputs(rls_.getInputDimension());
+        fl::detail::SparseVector<fl::scalar> rlsInputs(rls_.getInputDimension());
         {
             // Compute normalization factor
             const fl::scalar totRuleFiringStrength = fl::detail::Sum<fl::scalar>(ruleFiringStrengths.begin(), ruleFiringStrengths.end());
@@ -562,6 +583,7 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOnline(const fl::Dat
                 continue;
             }
 
+            std::size_t k = 0;
             for (std::size_t i = 0,
                              ni = this->getEngine()->numberOfRuleBlocks();
                  i < ni;
@@ -572,18 +594,26 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOnline(const fl::Dat
                 // check: null
                 FL_DEBUG_ASSERT( p_rb );
 
-                std::size_t k = 0;
                 for (std::size_t r = 0,
                                  nr = p_rb->numberOfRules();
                      r < nr;
                      ++r)
                 {
+                    const fl::scalar normRuleFiringStrength = ruleFiringStrengths[r]/totRuleFiringStrength;
+
+                    if (normRuleFiringStrength <= sparsityThr_)
+                    {
+                        // Negligible rule -> leave its parameters out of the regressor
+                        k += numOutTermParams;
+                        continue;
+                    }
+
                     for (std::size_t p = 1; p < numOutTermParams; ++p)
                     {
-                        rlsInputs[k] = ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength;
+                        rlsInputs.append(k, ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength);
                         ++k;
                     }
-                    rlsInputs[k] = ruleFiringStrengths[r]/totRuleFiringStrength;
+                    rlsInputs.append(k, normRuleFiringStrength);
                     ++k;
                 }
             }
@@ -591,14 +621,14 @@ fl::scalar Jang1993HybridLearningAlgorithm::trainSingleEpochOnline(const fl::Dat
 
         // Estimate parameters
         std::vector<fl::scalar> actualOut;
-        actualOut = rls_.estimate(rlsInputs.begin(), rlsInputs.end(), targetOut.begin(), targetOut.end());
+        actualOut = this->estimate(rlsInputs, targetOut);
 
         ++numTrainings;
 
         // Put estimated RLS parameters in the ANFIS model
         if (numTrainings > 0)
         {
-            const std::vector< std::vector<fl::scalar> > rlsParamMatrix = rls_.getEstimatedParameters();
+            const std::vector< std::vector<fl::scalar> > rlsParamMatrix = this->estimatedParameters();
 //std::cerr << "PHASE #0 - Estimated RLS params: "; fl::detail::MatrixOutput(std::cerr, rlsParamMatrix); std::cerr << std::endl;//XXX
 
             //std::size_t k = 0;
@@ -948,11 +978,59 @@ void Jang1993HybridLearningAlgorithm::updateStepSize()
 
 void Jang1993HybridLearningAlgorithm::resetSingleEpoch()
 {
-    rls_.reset();
+    this->resetEstimator();
     dEdPs_.clear();
     oldDeltaPs_.clear();
 }
 
+void Jang1993HybridLearningAlgorithm::resetEstimator()
+{
+    switch (estimator_)
+    {
+        case KalmanFilterEstimation:
+            kalman_.reset();
+            break;
+        case NormalEquationsEstimation:
+            normalEqs_.reset();
+            break;
+        case RecursiveLeastSquaresEstimation:
+            rls_.reset();
+            break;
+    }
+}
+
+std::vector<fl::scalar> Jang1993HybridLearningAlgorithm::estimate(const fl::detail::SparseVector<fl::scalar>& regressor, const std::vector<fl::scalar>& target)
+{
+    switch (estimator_)
+    {
+        case KalmanFilterEstimation:
+            return kalman_.estimate(regressor, &target[0]);
+        case NormalEquationsEstimation:
+            // The estimated output is only available once the equations are solved
+            normalEqs_.accumulate(regressor, &target[0]);
+            return std::vector<fl::scalar>(target.size(), fl::nan);
+        case RecursiveLeastSquaresEstimation:
+            break;
+    }
+
+    return rls_.estimate(regressor, target);
+}
+
+std::vector< std::vector<fl::scalar> > Jang1993HybridLearningAlgorithm::estimatedParameters() const
+{
+    switch (estimator_)
+    {
+        case KalmanFilterEstimation:
+            return kalman_.getEstimatedParameters();
+        case NormalEquationsEstimation:
+            return normalEqs_.solve();
+        case RecursiveLeastSquaresEstimation:
+            break;
+    }
+
+    return rls_.getEstimatedParameters();
+}
+
 void Jang1993HybridLearningAlgorithm::init()
 {
     std::size_t numParams = 0;
@@ -983,7 +1061,11 @@ void Jang1993HybridLearningAlgorithm::init()
     rls_.setModelOrder(0);
     rls_.setInputDimension(numParams);
     rls_.setOutputDimension(numOutVars);
-    rls_.reset();
+    kalman_.setModelOrder(0);
+    kalman_.setInputDimension(numParams);
+    kalman_.setOutputDimension(numOutVars);
+    normalEqs_.reshape(numParams, numOutVars);
+    this->resetEstimator();
     //rlsPhi_.clear();
 
     dEdPs_.clear();
@@ -1012,6 +1094,10 @@ void Jang1993HybridLearningAlgorithm::check() const
     {
         FL_THROW2(std::logic_error, "This learning algorithm currently works only for Takagi-Sugeno ANFIS");
     }
+    if (online_ && estimator_ == NormalEquationsEstimation)
+    {
+        FL_THROW2(std::logic_error, "Normal-equations estimation is only available in offline mode");
+    }
     if (stepSizeInit_ <= 0)
     {
         FL_THROW2(std::logic_error, "Invalid step-size");
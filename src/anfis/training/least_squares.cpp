@@ -28,8 +28,9 @@
 #include <fl/anfis/training/least_squares.h>
 #include <fl/dataset.h>
 #include <fl/detail/math.h>
-//#include <fl/detail/kalman.h>
+#include <fl/detail/kalman.h>
 #include <fl/detail/rls.h>
+#include <fl/detail/sparse.h>
 #include <fl/detail/terms.h>
 #include <fl/detail/traits.h>
 #include <fl/fuzzylite.h>
@@ -47,7 +48,10 @@ LeastSquaresLearningAlgorithm::LeastSquaresLearningAlgorithm(Engine* p_anfis,
                                                              fl::scalar ff)
 : BaseType(p_anfis),
   online_(false),
-  rls_(0,0,0,ff)/*,
+  estimator_(RecursiveLeastSquaresEstimation),
+  rls_(0,0,0,ff),
+  kalman_(0,0,0,ff),
+  sparsityThr_(0)/*,
   minCheckRmse_(std::numeric_limits<fl::scalar>::infinity())*/
 {
     this->init();
@@ -56,6 +60,7 @@ LeastSquaresLearningAlgorithm::LeastSquaresLearningAlgorithm(Engine* p_anfis,
 void LeastSquaresLearningAlgorithm::setForgettingFactor(fl::scalar value)
 {
     rls_.setForgettingFactor(value);
+    kalman_.setForgettingFactor(value);
 }
 
 fl::scalar LeastSquaresLearningAlgorithm::getForgettingFactor() const
@@ -73,22 +78,53 @@ bool LeastSquaresLearningAlgorithm::isOnline() const
     return online_;
 }
 
+void LeastSquaresLearningAlgorithm::setEstimator(EstimatorType value)
+{
+    if (value != estimator_)
+    {
+        estimator_ = value;
+        this->resetEstimator();
+    }
+}
+
+LeastSquaresLearningAlgorithm::EstimatorType LeastSquaresLearningAlgorithm::getEstimator() const
+{
+    return estimator_;
+}
+
+void LeastSquaresLearningAlgorithm::setSparsityThreshold(fl::scalar value)
+{
+    sparsityThr_ = fl::detail::FloatTraits<fl::scalar>::DefinitelyMax(value, 0);
+}
+
+fl::scalar LeastSquaresLearningAlgorithm::getSparsityThreshold() const
+{
+    return sparsityThr_;
+}
+
 fl::scalar LeastSquaresLearningAlgorithm::doTrainSingleEpoch(const fl::DataSet<fl::scalar>& trainData)
+{
+    // A training set in memory is trained as a single chunk
+    this->doBeginChunkedEpoch();
+
+    return this->doTrainChunk(trainData);
+}
+
+void LeastSquaresLearningAlgorithm::doBeginChunkedEpoch()
 {
     this->check();
 
-    fl::scalar rmse = 0;
+    this->resetSingleEpoch();
+}
 
+fl::scalar LeastSquaresLearningAlgorithm::doTrainChunk(const fl::DataSet<fl::scalar>& chunk)
+{
     if (online_)
     {
-        rmse = this->trainSingleEpochOnline(trainData);
-    }
-    else
-    {
-        rmse = this->trainSingleEpochOffline(trainData);
+        return this->trainEntriesOnline(chunk);
     }
 
-    return rmse;
+    return this->trainEntriesOffline(chunk);
 }
 
 void LeastSquaresLearningAlgorithm::doReset()
@@ -96,10 +132,8 @@ void LeastSquaresLearningAlgorithm::doReset()
     this->init();
 }
 
-fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::DataSet<fl::scalar>& trainData)
+fl::scalar LeastSquaresLearningAlgorithm::trainEntriesOffline(const fl::DataSet<fl::scalar>& trainData)
 {
-    this->resetSingleEpoch();
-
     const std::size_t numOutTermParams = this->numberOfOutputTermParameters();
 
     fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) for this epoch
@@ -127,7 +161,7 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::Data
         const std::vector<fl::scalar> ruleFiringStrengths = this->getEngine()->evalTo(entry.inputBegin(), entry.inputEnd(), fl::anfis::Engine::AntecedentLayer);
 
         // Compute input to RLS algorithm
-        std::vector<fl::scalar> rlsInputs(rls_.getInputDimension());
+        fl::detail::SparseVector<fl::scalar> rlsInputs(rls_.getInputDimension());
         {
             // Compute normalization factor
             const fl::scalar totRuleFiringStrength = fl::detail::Sum<fl::scalar>(ruleFiringStrengths.begin(), ruleFiringStrengths.end());
@@ -148,6 +182,7 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::Data
                 continue;
             }
 
+            std::size_t k = 0;
             for (std::size_t i = 0,
                              ni = this->getEngine()->numberOfRuleBlocks();
                  i < ni;
@@ -158,18 +193,26 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::Data
                 // check: null
                 FL_DEBUG_ASSERT( p_rb );
 
-                std::size_t k = 0;
                 for (std::size_t r = 0,
                                  nr = p_rb->numberOfRules();
                      r < nr;
                      ++r)
                 {
+                    const fl::scalar normRuleFiringStrength = ruleFiringStrengths[r]/totRuleFiringStrength;
+
+                    if (normRuleFiringStrength <= sparsityThr_)
+                    {
+                        // Negligible rule -> leave its parameters out of the regressor
+                        k += numOutTermParams;
+                        continue;
+                    }
+
                     for (std::size_t p = 1; p < numOutTermParams; ++p)
                     {
-                        rlsInputs[k] = ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength;
+                        rlsInputs.append(k, ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength);
                         ++k;
                     }
-                    rlsInputs[k] = ruleFiringStrengths[r]/totRuleFiringStrength;
+                    rlsInputs.append(k, normRuleFiringStrength);
                     ++k;
                 }
             }
@@ -178,7 +221,7 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::Data
 //std::cerr << "PHASE #0 - RLS Input: "; fl::detail::VectorOutput(std::cerr, rlsInputs); std::cerr << std::endl;///XXX
         // Estimate parameters
         std::vector<fl::scalar> actualOut;
-        actualOut = rls_.estimate(rlsInputs.begin(), rlsInputs.end(), targetOut.begin(), targetOut.end());
+        actualOut = this->estimate(rlsInputs, targetOut);
 //std::cerr << "PHASE #0 - Target: "; fl::detail::VectorOutput(std::cerr, targetOut); std::cerr << " - Actual: ";fl::detail::VectorOutput(std::cerr, actualOut); std::cerr << std::endl;///XXX
 
         ++numTrainings;
@@ -187,7 +230,7 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::Data
     // Put estimated RLS parameters in the ANFIS model
     if (numTrainings > 0)
     {
-        const std::vector< std::vector<fl::scalar> > rlsParamMatrix = rls_.getEstimatedParameters();
+        const std::vector< std::vector<fl::scalar> > rlsParamMatrix = this->estimatedParameters();
 //std::cerr << "PHASE #0 - Estimated RLS params: "; fl::detail::MatrixOutput(std::cerr, rlsParamMatrix); std::cerr << std::endl;//XXX
 
         for (std::size_t v = 0,
@@ -292,11 +335,8 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOffline(const fl::Data
     return rmse;
 }
 
-fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOnline(const fl::DataSet<fl::scalar>& trainData)
+fl::scalar LeastSquaresLearningAlgorithm::trainEntriesOnline(const fl::DataSet<fl::scalar>& trainData)
 {
-    //rls_.reset();
-    this->resetSingleEpoch();
-
     const std::size_t numOutTermParams = this->numberOfOutputTermParameters();
 
     fl::scalar rmse = 0; // The Root Mean Squared Error (RMSE) for this epoch
@@ -324,7 +364,7 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOnline(const fl::DataS
         const std::vector<fl::scalar> ruleFiringStrengths = this->getEngine()->evalTo(entry.inputBegin(), entry.inputEnd(), fl::anfis::Engine::AntecedentLayer);
 
         // Compute input to RLS algorithm
-        std::vector<fl::scalar> rlsInputs(rls_.getInputDimension());
+        fl::detail::SparseVector<fl::scalar> rlsInputs(rls_.getInputDimension());
         {
             // Compute normalization factor
             const fl::scalar totRuleFiringStrength = fl::detail::Sum<fl::scalar>(ruleFiringStrengths.begin(), ruleFiringStrengths.end());
@@ -335,6 +375,7 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOnline(const fl::DataS
                 continue;
             }
 
+            std::size_t k = 0;
             for (std::size_t i = 0,
                              ni = this->getEngine()->numberOfRuleBlocks();
                  i < ni;
@@ -345,18 +386,26 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOnline(const fl::DataS
                 // check: null
                 FL_DEBUG_ASSERT( p_rb );
 
-                std::size_t k = 0;
                 for (std::size_t r = 0,
                                  nr = p_rb->numberOfRules();
                      r < nr;
                      ++r)
                 {
+                    const fl::scalar normRuleFiringStrength = ruleFiringStrengths[r]/totRuleFiringStrength;
+
+                    if (normRuleFiringStrength <= sparsityThr_)
+                    {
+                        // Negligible rule -> leave its parameters out of the regressor
+                        k += numOutTermParams;
+                        continue;
+                    }
+
                     for (std::size_t p = 1; p < numOutTermParams; ++p)
                     {
-                        rlsInputs[k] = ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength;
+                        rlsInputs.append(k, ruleFiringStrengths[r]*entry.getInput(p-1)/totRuleFiringStrength);
                         ++k;
                     }
-                    rlsInputs[k] = ruleFiringStrengths[r]/totRuleFiringStrength;
+                    rlsInputs.append(k, normRuleFiringStrength);
                     ++k;
                 }
             }
@@ -364,14 +413,14 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOnline(const fl::DataS
 
         // Estimate parameters
         std::vector<fl::scalar> actualOut;
-        actualOut = rls_.estimate(rlsInputs.begin(), rlsInputs.end(), targetOut.begin(), targetOut.end());
+        actualOut = this->estimate(rlsInputs, targetOut);
 
         ++numTrainings;
 
         // Put estimated RLS parameters in the ANFIS model
         if (numTrainings > 0)
         {
-            const std::vector< std::vector<fl::scalar> > rlsParamMatrix = rls_.getEstimatedParameters();
+            const std::vector< std::vector<fl::scalar> > rlsParamMatrix = this->estimatedParameters();
 //std::cerr << "PHASE #0 - Estimated RLS params: "; fl::detail::MatrixOutput(std::cerr, rlsParamMatrix); std::cerr << std::endl;//XXX
 
             //std::size_t k = 0;
@@ -471,7 +520,55 @@ fl::scalar LeastSquaresLearningAlgorithm::trainSingleEpochOnline(const fl::DataS
 
 void LeastSquaresLearningAlgorithm::resetSingleEpoch()
 {
-    rls_.reset();
+    this->resetEstimator();
+}
+
+void LeastSquaresLearningAlgorithm::resetEstimator()
+{
+    switch (estimator_)
+    {
+        case KalmanFilterEstimation:
+            kalman_.reset();
+            break;
+        case NormalEquationsEstimation:
+            normalEqs_.reset();
+            break;
+        case RecursiveLeastSquaresEstimation:
+            rls_.reset();
+            break;
+    }
+}
+
+std::vector<fl::scalar> LeastSquaresLearningAlgorithm::estimate(const fl::detail::SparseVector<fl::scalar>& regressor, const std::vector<fl::scalar>& target)
+{
+    switch (estimator_)
+    {
+        case KalmanFilterEstimation:
+            return kalman_.estimate(regressor, &target[0]);
+        case NormalEquationsEstimation:
+            // The estimated output is only available once the equations are solved
+            normalEqs_.accumulate(regressor, &target[0]);
+            return std::vector<fl::scalar>(target.size(), fl::nan);
+        case RecursiveLeastSquaresEstimation:
+            break;
+    }
+
+    return rls_.estimate(regressor, target);
+}
+
+std::vector< std::vector<fl::scalar> > LeastSquaresLearningAlgorithm::estimatedParameters() const
+{
+    switch (estimator_)
+    {
+        case KalmanFilterEstimation:
+            return kalman_.getEstimatedParameters();
+        case NormalEquationsEstimation:
+            return normalEqs_.solve();
+        case RecursiveLeastSquaresEstimation:
+            break;
+    }
+
+    return rls_.getEstimatedParameters();
 }
 
 void LeastSquaresLearningAlgorithm::init()
@@ -504,7 +601,11 @@ void LeastSquaresLearningAlgorithm::init()
     rls_.setModelOrder(0);
     rls_.setInputDimension(numParams);
     rls_.setOutputDimension(numOutVars);
-    rls_.reset();
+    kalman_.setModelOrder(0);
+    kalman_.setInputDimension(numParams);
+    kalman_.setOutputDimension(numOutVars);
+    normalEqs_.reshape(numParams, numOutVars);
+    this->resetEstimator();
     //rlsPhi_.clear();
 }
 
@@ -518,6 +619,10 @@ void LeastSquaresLearningAlgorithm::check() const
     {
         FL_THROW2(std::logic_error, "This learning algorithm currently works only for Takagi-Sugeno ANFIS");
     }
+    if (online_ && estimator_ == NormalEquationsEstimation)
+    {
+        FL_THROW2(std::logic_error, "Normal-equations estimation is only available in offline mode");
+    }
 
     // Output terms must be homogeneous in shape
     {
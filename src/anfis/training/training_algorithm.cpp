@@ -22,18 +22,67 @@
  * limitations under the License.
  */
 
+#include <cmath>
 #include <cstddef>
 #include <fl/detail/math.h>
 #include <fl/anfis/engine.h>
 #include <fl/anfis/training/training_algorithm.h>
+#include <fl/data_source.h>
 #include <fl/dataset.h>
+#include <fl/detail/random.h>
 #include <fl/detail/traits.h>
+#include <fl/macro.h>
 
 
 namespace fl { namespace anfis {
 
+namespace detail { namespace /*<unnamed>*/ {
+
+#ifdef FL_CPP11
+typedef std::mt19937 Urng;
+#else
+typedef boost::random::mt19937 Urng;
+#endif // FL_CPP11
+
+}} // Namespace detail::<unnamed>
+
+
+class TrainingAlgorithm::ChunkTrainer
+{
+public:
+    explicit ChunkTrainer(TrainingAlgorithm* p_algo)
+    : p_algo_(p_algo),
+      sse_(0),
+      n_(0)
+    {
+    }
+
+    void operator()(const fl::DataSet<fl::scalar>& chunk)
+    {
+        const fl::scalar rmse = p_algo_->doTrainChunk(chunk);
+
+        sse_ += fl::detail::Sqr(rmse)*chunk.size();
+        n_ += chunk.size();
+    }
+
+    fl::scalar rmse() const
+    {
+        return n_ > 0 ? std::sqrt(sse_/n_) : 0;
+    }
+
+private:
+    TrainingAlgorithm* p_algo_;
+    fl::scalar sse_;
+    std::size_t n_;
+}; // ChunkTrainer
+
+
+const unsigned int TrainingAlgorithm::DefaultSeed = 5489u;
+
 TrainingAlgorithm::TrainingAlgorithm(Engine* p_anfis)
-: p_anfis_(p_anfis)
+: p_anfis_(p_anfis),
+  shuffle_(false),
+  seed_(DefaultSeed)
 {
 }
 
@@ -52,18 +101,40 @@ Engine* TrainingAlgorithm::getEngine() const
     return p_anfis_;
 }
 
+void TrainingAlgorithm::setIsShuffling(bool value)
+{
+    shuffle_ = value;
+}
+
+bool TrainingAlgorithm::isShuffling() const
+{
+    return shuffle_;
+}
+
+void TrainingAlgorithm::setSeed(unsigned int value)
+{
+    seed_ = value;
+}
+
+unsigned int TrainingAlgorithm::getSeed() const
+{
+    return seed_;
+}
+
 fl::scalar TrainingAlgorithm::train(const fl::DataSet<fl::scalar>& data,
                                     std::size_t maxEpochs,
                                     fl::scalar errorGoal)
 {
     this->reset();
 
+    detail::Urng urng(seed_);
+
     fl::scalar rmse = 0;
     for (std::size_t epoch = 0; epoch < maxEpochs; ++epoch)
     {
         FL_DEBUG_TRACE("TRAINING - EPOCH #" << epoch);
 
-        rmse = this->trainSingleEpoch(data);
+        rmse = shuffle_ ? this->trainSingleEpoch(data.shuffled(urng)) : this->trainSingleEpoch(data);
 
         FL_DEBUG_TRACE("TRAINING - EPOCH #" << epoch << " -> RMSE: " << rmse);
 
@@ -82,6 +153,8 @@ fl::scalar TrainingAlgorithm::train(const fl::DataSet<fl::scalar>& trainData,
 {
     this->reset();
 
+    detail::Urng urng(seed_);
+
     fl::scalar minCheckRmse = std::numeric_limits<fl::scalar>::infinity();
     fl::anfis::Engine bestCheckAnfis;
     fl::scalar trainRmse = 0;
@@ -90,7 +163,7 @@ fl::scalar TrainingAlgorithm::train(const fl::DataSet<fl::scalar>& trainData,
     {
         FL_DEBUG_TRACE("TRAINING - EPOCH #" << epoch);
 
-        trainRmse = this->trainSingleEpoch(trainData);
+        trainRmse = shuffle_ ? this->trainSingleEpoch(trainData.shuffled(urng)) : this->trainSingleEpoch(trainData);
 
         if (checkData.size() > 0)
         {
@@ -146,6 +219,29 @@ fl::scalar TrainingAlgorithm::train(const fl::DataSet<fl::scalar>& trainData,
     return trainRmse;
 }
 
+fl::scalar TrainingAlgorithm::train(fl::DataSource<fl::scalar>& source,
+                                    std::size_t maxEpochs,
+                                    fl::scalar errorGoal)
+{
+    this->reset();
+
+    fl::scalar rmse = 0;
+    for (std::size_t epoch = 0; epoch < maxEpochs; ++epoch)
+    {
+        FL_DEBUG_TRACE("TRAINING - EPOCH #" << epoch);
+
+        rmse = this->trainSingleEpoch(source);
+
+        FL_DEBUG_TRACE("TRAINING - EPOCH #" << epoch << " -> RMSE: " << rmse);
+
+        if (fl::detail::FloatTraits<fl::scalar>::EssentiallyLessEqual(rmse, errorGoal))
+        {
+            break;
+        }
+    }
+    return rmse;
+}
+
 fl::scalar TrainingAlgorithm::trainSingleEpoch(const fl::DataSet<fl::scalar>& data)
 {
     p_anfis_->setIsLearning(true);
@@ -159,11 +255,45 @@ fl::scalar TrainingAlgorithm::trainSingleEpoch(const fl::DataSet<fl::scalar>& da
     return rmse;
 }
 
+fl::scalar TrainingAlgorithm::trainSingleEpoch(fl::DataSource<fl::scalar>& source)
+{
+    p_anfis_->setIsLearning(true);
+
+    this->doBeginChunkedEpoch();
+
+    ChunkTrainer trainer(this);
+
+    fl::VisitChunks(source, trainer);
+
+    const fl::scalar rmse = trainer.rmse();
+
+    this->doEndChunkedEpoch(rmse);
+
+    p_anfis_->setIsLearning(false);
+
+    return rmse;
+}
+
 void TrainingAlgorithm::reset()
 {
     this->doReset();
 }
 
+void TrainingAlgorithm::doBeginChunkedEpoch()
+{
+    // empty
+}
+
+fl::scalar TrainingAlgorithm::doTrainChunk(const fl::DataSet<fl::scalar>& chunk)
+{
+    return this->doTrainSingleEpoch(chunk);
+}
+
+void TrainingAlgorithm::doEndChunkedEpoch(fl::scalar rmse)
+{
+    FL_SUPPRESS_UNUSED_VARIABLE_WARNING( rmse );
+}
+
 }} // Namespace fl::anfis
 
 /* vim: set tabstop=4 expandtab shiftwidth=4 softtabstop=4: */
@@ -0,0 +1,589 @@
+/**
+ * \file cluster/fuzzy_cmeans.cpp
+ *
+ * \brief Fuzzy c-means clustering (Bezdek, 1981)
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fl/cluster/fuzzy_cmeans.h>
+#include <fl/detail/math.h>
+#include <fl/detail/parallel.h>
+#include <fl/detail/random.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fl { namespace cluster {
+
+namespace detail { namespace /*<unnamed>*/ {
+
+#ifdef FL_CPP11
+typedef std::mt19937 Urng;
+#else
+typedef boost::random::mt19937 Urng;
+#endif // FL_CPP11
+
+/**
+ * Computes the squared distance \f$d_t = \|c-x_t\|^2\f$ for the \a n
+ * consecutive points \f$x_t\f$ starting at \a X, where \a X holds \a nc
+ * dimensions with leading dimension \a ldX.
+ */
+void squaredDistances(const fl::scalar* X,
+					  std::size_t ldX,
+					  std::size_t nc,
+					  const fl::scalar* c,
+					  std::size_t n,
+					  fl::scalar* d)
+{
+	std::fill(d, d+n, fl::scalar(0));
+	for (std::size_t j = 0; j < nc; ++j)
+	{
+		const fl::scalar* Xj = X+j*ldX;
+		const fl::scalar cj = c[j];
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+		for (std::size_t t = 0; t < n; ++t)
+		{
+			const fl::scalar diff = cj-Xj[t];
+			d[t] += diff*diff;
+		}
+	}
+}
+
+/// Returns \f$u^m\f$, avoiding the call to \c std::pow for the common case \f$m=2\f$
+inline fl::scalar weight(fl::scalar u, fl::scalar m)
+{
+	return m == 2 ? u*u : std::pow(u, m);
+}
+
+}} // Namespace detail::<unnamed>
+
+
+const fl::scalar FuzzyCMeansClustering::DefaultExponent = 2;
+
+const std::size_t FuzzyCMeansClustering::DefaultMaxIterations = 100;
+
+const fl::scalar FuzzyCMeansClustering::DefaultTolerance = 1e-5;
+
+const unsigned int FuzzyCMeansClustering::DefaultSeed = 5489u;
+
+FuzzyCMeansClustering::FuzzyCMeansClustering(std::size_t numClusters)
+: numClusters_(numClusters),
+  exponent_(DefaultExponent),
+  maxIters_(DefaultMaxIterations),
+  tol_(DefaultTolerance),
+  seed_(DefaultSeed),
+  nr_(0),
+  obj_(fl::nan),
+  numIters_(0)
+{
+	if (numClusters_ == 0)
+	{
+		FL_THROW2(std::invalid_argument, "Number of clusters must be positive");
+	}
+}
+
+void FuzzyCMeansClustering::setNumOfClusters(std::size_t value)
+{
+	if (value == 0)
+	{
+		FL_THROW2(std::invalid_argument, "Number of clusters must be positive");
+	}
+
+	numClusters_ = value;
+}
+
+std::size_t FuzzyCMeansClustering::getNumOfClusters() const
+{
+	return numClusters_;
+}
+
+void FuzzyCMeansClustering::setExponent(fl::scalar value)
+{
+	if (value <= 1)
+	{
+		FL_THROW2(std::invalid_argument, "Exponent must be greater than 1");
+	}
+
+	exponent_ = value;
+}
+
+fl::scalar FuzzyCMeansClustering::getExponent() const
+{
+	return exponent_;
+}
+
+void FuzzyCMeansClustering::setMaxIterations(std::size_t value)
+{
+	if (value == 0)
+	{
+		FL_THROW2(std::invalid_argument, "Maximum number of iterations must be positive");
+	}
+
+	maxIters_ = value;
+}
+
+std::size_t FuzzyCMeansClustering::getMaxIterations() const
+{
+	return maxIters_;
+}
+
+void FuzzyCMeansClustering::setTolerance(fl::scalar value)
+{
+	if (value < 0)
+	{
+		FL_THROW2(std::invalid_argument, "Tolerance must be non-negative");
+	}
+
+	tol_ = value;
+}
+
+fl::scalar FuzzyCMeansClustering::getTolerance() const
+{
+	return tol_;
+}
+
+void FuzzyCMeansClustering::setSeed(unsigned int value)
+{
+	seed_ = value;
+}
+
+unsigned int FuzzyCMeansClustering::getSeed() const
+{
+	return seed_;
+}
+
+void FuzzyCMeansClustering::setInitialCenters(const std::vector< std::vector<fl::scalar> >& value)
+{
+	initCenters_ = value;
+}
+
+std::vector< std::vector<fl::scalar> > FuzzyCMeansClustering::initialCenters() const
+{
+	return initCenters_;
+}
+
+void FuzzyCMeansClustering::reset()
+{
+	exponent_ = DefaultExponent;
+	maxIters_ = DefaultMaxIterations;
+	tol_ = DefaultTolerance;
+	seed_ = DefaultSeed;
+	initCenters_.clear();
+	centers_.clear();
+	spreads_.clear();
+	U_.clear();
+	nr_ = 0;
+	obj_ = fl::nan;
+	numIters_ = 0;
+}
+
+void FuzzyCMeansClustering::seedCenters(const std::vector<fl::scalar>& X, std::size_t nr, std::size_t nc, std::vector<fl::scalar>& C) const
+{
+	const std::size_t ncl = numClusters_;
+
+	detail::Urng urng(seed_);
+
+	// The first center is drawn uniformly from the data points
+	std::size_t idx = fl::detail::RandIndex(0, nr-1, urng);
+
+	// Squared distance of each data point from the nearest center chosen so far
+	std::vector<fl::scalar> minDistSq(nr, std::numeric_limits<fl::scalar>::infinity());
+
+	C.resize(ncl*nc);
+	for (std::size_t k = 0; k < ncl; ++k)
+	{
+		fl::scalar* c = &C[k*nc];
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			c[j] = X[j*nr+idx];
+		}
+
+		if (k+1 == ncl)
+		{
+			break;
+		}
+
+		const std::size_t nt = fl::detail::MaxNumOfThreads();
+		std::vector<fl::scalar> dist(nt*fl::detail::TileSize);
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+		{
+			fl::scalar* D = &dist[fl::detail::ThreadNum()*fl::detail::TileSize];
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+			for (std::size_t i0 = 0; i0 < nr; i0 += fl::detail::TileSize)
+			{
+				const std::size_t ni = std::min(fl::detail::TileSize, nr-i0);
+
+				detail::squaredDistances(&X[i0], nr, nc, c, ni, D);
+				for (std::size_t t = 0; t < ni; ++t)
+				{
+					minDistSq[i0+t] = std::min(minDistSq[i0+t], D[t]);
+				}
+			}
+		}
+
+		// The next center is drawn with probability proportional to the
+		// squared distance from the nearest center (data points already
+		// chosen have zero probability)
+		fl::scalar total = 0;
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			total += minDistSq[i];
+		}
+		if (total > 0)
+		{
+			const fl::scalar r = fl::detail::RandUnif(fl::scalar(0), total, urng);
+			fl::scalar cum = 0;
+			idx = nr;
+			for (std::size_t i = 0; i < nr && idx == nr; ++i)
+			{
+				cum += minDistSq[i];
+				if (minDistSq[i] > 0 && cum >= r)
+				{
+					idx = i;
+				}
+			}
+			if (idx == nr)
+			{
+				// Rounding errors: takes the last data point with positive probability
+				for (idx = nr-1; minDistSq[idx] <= 0; --idx)
+				{
+				}
+			}
+		}
+		else
+		{
+			// Fewer distinct data points than clusters
+			idx = fl::detail::RandIndex(0, nr-1, urng);
+		}
+	}
+}
+
+void FuzzyCMeansClustering::estimate(const std::vector<fl::scalar>& X, std::size_t nr, std::size_t nc)
+{
+	const std::size_t ncl = numClusters_;
+	if (ncl > nr)
+	{
+		FL_THROW("Number of clusters must not exceed the number of data points");
+	}
+
+	// Initial centers (one after the other)
+	std::vector<fl::scalar> C;
+	if (initCenters_.empty())
+	{
+		this->seedCenters(X, nr, nc, C);
+	}
+	else
+	{
+		if (initCenters_.size() != ncl)
+		{
+			FL_THROW("Number of initial centers does not match the number of clusters");
+		}
+
+		C.resize(ncl*nc);
+		for (std::size_t k = 0; k < ncl; ++k)
+		{
+			if (initCenters_[k].size() != nc)
+			{
+				FL_THROW("Wrong dimension for initial centers");
+			}
+			std::copy(initCenters_[k].begin(), initCenters_[k].end(), C.begin()+k*nc);
+		}
+	}
+
+	const fl::scalar m = exponent_;
+	const fl::scalar p = 1.0/(m-1); // Exponent for the ratios of squared distances
+	const std::size_t nt = fl::detail::MaxNumOfThreads();
+
+	// Per-thread buffers: squared distances of a tile of data points from each
+	// center, and partial sums for the centers and for the objective function
+	std::vector<fl::scalar> dist(nt*ncl*fl::detail::TileSize);
+	std::vector<fl::scalar> minDist(nt*fl::detail::TileSize);
+	std::vector<fl::scalar> sumRatios(nt*fl::detail::TileSize);
+	std::vector<fl::scalar> weights(nt*ncl*fl::detail::TileSize);
+	std::vector<fl::scalar> partialNum(nt*ncl*nc);
+	std::vector<fl::scalar> partialDen(nt*ncl);
+	std::vector<fl::scalar> partialObj(nt);
+
+	U_.resize(ncl*nr);
+	nr_ = nr;
+	obj_ = fl::nan;
+	numIters_ = 0;
+
+	fl::scalar prevObj = std::numeric_limits<fl::scalar>::infinity();
+	for (std::size_t it = 0; it < maxIters_; ++it)
+	{
+		std::fill(partialNum.begin(), partialNum.end(), fl::scalar(0));
+		std::fill(partialDen.begin(), partialDen.end(), fl::scalar(0));
+		std::fill(partialObj.begin(), partialObj.end(), fl::scalar(0));
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+		{
+			const std::size_t tid = fl::detail::ThreadNum();
+			fl::scalar* D = &dist[tid*ncl*fl::detail::TileSize];
+			fl::scalar* Dmin = &minDist[tid*fl::detail::TileSize];
+			fl::scalar* S = &sumRatios[tid*fl::detail::TileSize];
+			fl::scalar* W = &weights[tid*ncl*fl::detail::TileSize];
+			fl::scalar* num = &partialNum[tid*ncl*nc];
+			fl::scalar* den = &partialDen[tid*ncl];
+			fl::scalar obj = 0;
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+			for (std::size_t i0 = 0; i0 < nr; i0 += fl::detail::TileSize)
+			{
+				const std::size_t ni = std::min(fl::detail::TileSize, nr-i0);
+
+				// Squared distances from the current centers
+				std::fill(Dmin, Dmin+ni, std::numeric_limits<fl::scalar>::infinity());
+				for (std::size_t k = 0; k < ncl; ++k)
+				{
+					fl::scalar* Dk = D+k*fl::detail::TileSize;
+					detail::squaredDistances(&X[i0], nr, nc, &C[k*nc], ni, Dk);
+					for (std::size_t t = 0; t < ni; ++t)
+					{
+						Dmin[t] = std::min(Dmin[t], Dk[t]);
+					}
+				}
+
+				// Membership degrees.
+				// Distances are taken relative to the nearest center, that is
+				// u_ik = r_ik/sum_l r_il with r_ik = (d_min/d_ik)^(1/(m-1)),
+				// which is well defined also for data points lying on a center
+				// (where r_ik = 1 for the nearest centers and 0 for the others).
+				std::fill(S, S+ni, fl::scalar(0));
+				for (std::size_t k = 0; k < ncl; ++k)
+				{
+					const fl::scalar* Dk = D+k*fl::detail::TileSize;
+					fl::scalar* Uk = &U_[k*nr+i0];
+					for (std::size_t t = 0; t < ni; ++t)
+					{
+						fl::scalar r = 1;
+						if (Dk[t] > Dmin[t])
+						{
+							r = (p == 1) ? Dmin[t]/Dk[t] : std::pow(Dmin[t]/Dk[t], p);
+						}
+						Uk[t] = r;
+						S[t] += r;
+					}
+				}
+				for (std::size_t k = 0; k < ncl; ++k)
+				{
+					const fl::scalar* Dk = D+k*fl::detail::TileSize;
+					fl::scalar* Uk = &U_[k*nr+i0];
+					fl::scalar* Wk = W+k*fl::detail::TileSize;
+					fl::scalar* numk = num+k*nc;
+					for (std::size_t t = 0; t < ni; ++t)
+					{
+						Uk[t] /= S[t];
+						Wk[t] = detail::weight(Uk[t], m);
+						obj += Wk[t]*Dk[t];
+						den[k] += Wk[t];
+					}
+					for (std::size_t j = 0; j < nc; ++j)
+					{
+						const fl::scalar* Xj = &X[j*nr+i0];
+						fl::scalar sum = 0;
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd reduction(+:sum)
+#endif
+						for (std::size_t t = 0; t < ni; ++t)
+						{
+							sum += Wk[t]*Xj[t];
+						}
+						numk[j] += sum;
+					}
+				}
+			}
+
+			partialObj[tid] = obj;
+		}
+
+		// Adds the partial sums in a fixed order and updates the centers
+		fl::scalar obj = 0;
+		for (std::size_t t = 0; t < nt; ++t)
+		{
+			obj += partialObj[t];
+		}
+		for (std::size_t k = 0; k < ncl; ++k)
+		{
+			fl::scalar den = 0;
+			for (std::size_t t = 0; t < nt; ++t)
+			{
+				den += partialDen[t*ncl+k];
+			}
+			if (den > 0)
+			{
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					fl::scalar num = 0;
+					for (std::size_t t = 0; t < nt; ++t)
+					{
+						num += partialNum[(t*ncl+k)*nc+j];
+					}
+					C[k*nc+j] = num/den;
+				}
+			}
+		}
+
+		obj_ = obj;
+		numIters_ = it+1;
+
+		// The objective function (computed for the centers of the previous
+		// iteration) does not increase, so stops when its improvement is small
+		if (prevObj-obj <= tol_*obj)
+		{
+			break;
+		}
+		prevObj = obj;
+	}
+
+	// Computes the fuzzy spread of each cluster (with the final centers and
+	// membership degrees)
+	std::fill(partialNum.begin(), partialNum.end(), fl::scalar(0));
+	std::fill(partialDen.begin(), partialDen.end(), fl::scalar(0));
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+	{
+		const std::size_t tid = fl::detail::ThreadNum();
+		fl::scalar* num = &partialNum[tid*ncl*nc];
+		fl::scalar* den = &partialDen[tid*ncl];
+		fl::scalar* W = &weights[tid*ncl*fl::detail::TileSize];
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		for (std::size_t i0 = 0; i0 < nr; i0 += fl::detail::TileSize)
+		{
+			const std::size_t ni = std::min(fl::detail::TileSize, nr-i0);
+
+			for (std::size_t k = 0; k < ncl; ++k)
+			{
+				const fl::scalar* Uk = &U_[k*nr+i0];
+				for (std::size_t t = 0; t < ni; ++t)
+				{
+					W[t] = detail::weight(Uk[t], m);
+					den[k] += W[t];
+				}
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					const fl::scalar* Xj = &X[j*nr+i0];
+					const fl::scalar ckj = C[k*nc+j];
+					fl::scalar sum = 0;
+					for (std::size_t t = 0; t < ni; ++t)
+					{
+						sum += W[t]*fl::detail::Sqr(Xj[t]-ckj);
+					}
+					num[k*nc+j] += sum;
+				}
+			}
+		}
+	}
+
+	// Spreads are kept positive (e.g., for clusters made of a single data
+	// point), flooring them to a small fraction of the data range
+	std::vector<fl::scalar> minSpreads(nc);
+	for (std::size_t j = 0; j < nc; ++j)
+	{
+		const fl::scalar* Xj = &X[j*nr];
+		const fl::scalar range = *std::max_element(Xj, Xj+nr) - *std::min_element(Xj, Xj+nr);
+		minSpreads[j] = 0.0001*(range > 0 ? range : 1);
+	}
+
+	centers_.assign(ncl, std::vector<fl::scalar>(nc));
+	spreads_.assign(ncl, std::vector<fl::scalar>(nc));
+	for (std::size_t k = 0; k < ncl; ++k)
+	{
+		fl::scalar den = 0;
+		for (std::size_t t = 0; t < nt; ++t)
+		{
+			den += partialDen[t*ncl+k];
+		}
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			fl::scalar num = 0;
+			for (std::size_t t = 0; t < nt; ++t)
+			{
+				num += partialNum[(t*ncl+k)*nc+j];
+			}
+			centers_[k][j] = C[k*nc+j];
+			spreads_[k][j] = std::max(den > 0 ? std::sqrt(num/den) : fl::scalar(0), minSpreads[j]);
+		}
+	}
+}
+
+std::vector< std::vector<fl::scalar> > FuzzyCMeansClustering::centers() const
+{
+	return centers_;
+}
+
+std::size_t FuzzyCMeansClustering::numOfClusters() const
+{
+	return centers_.size();
+}
+
+std::vector< std::vector<fl::scalar> > FuzzyCMeansClustering::spreads() const
+{
+	return spreads_;
+}
+
+std::vector< std::vector<fl::scalar> > FuzzyCMeansClustering::memberships() const
+{
+	const std::size_t ncl = centers_.size();
+
+	std::vector< std::vector<fl::scalar> > res(nr_, std::vector<fl::scalar>(ncl));
+	for (std::size_t k = 0; k < ncl; ++k)
+	{
+		for (std::size_t i = 0; i < nr_; ++i)
+		{
+			res[i][k] = U_[k*nr_+i];
+		}
+	}
+
+	return res;
+}
+
+fl::scalar FuzzyCMeansClustering::objective() const
+{
+	return obj_;
+}
+
+std::size_t FuzzyCMeansClustering::numOfIterations() const
+{
+	return numIters_;
+}
+
+}} // Namespace fl::cluster
@@ -26,17 +26,390 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <fl/cluster/subtractive.h>
+#include <fl/data_source.h>
+#include <fl/dataset.h>
+#include <fl/detail/heap.h>
+#include <fl/detail/kdtree.h>
+#include <fl/detail/parallel.h>
 #include <fl/fuzzylite.h>
 #include <fl/macro.h>
+#include <limits>
+#include <map>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 
 namespace fl { namespace cluster {
 
+namespace detail { namespace /*<unnamed>*/ {
+
+/**
+ * Computes \f$k_t = e^{-s \|c-x_t\|^2}\f$ for the \a n consecutive points
+ * \f$x_t\f$ starting at \a X, where \a X holds \a nc dimensions with leading
+ * dimension \a ldX (i.e., the \f$j\f$-th component of \f$x_t\f$ is
+ * <code>X[j*ldX+t]</code>).
+ *
+ * The distances are accumulated one dimension at a time and the
+ * exponentials are taken in a separate pass, so that both loops run over
+ * contiguous memory and can be vectorized.
+ */
+void gaussianKernel(const fl::scalar* X,
+					std::size_t ldX,
+					std::size_t nc,
+					const fl::scalar* c,
+					fl::scalar s,
+					std::size_t n,
+					fl::scalar* k)
+{
+	std::fill(k, k+n, fl::scalar(0));
+	for (std::size_t j = 0; j < nc; ++j)
+	{
+		const fl::scalar* Xj = X+j*ldX;
+		const fl::scalar cj = c[j];
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+		for (std::size_t t = 0; t < n; ++t)
+		{
+			const fl::scalar d = cj-Xj[t];
+			k[t] += d*d;
+		}
+	}
+#if defined(FLX_CONFIG_HAVE_OPENMP) && _OPENMP >= 201307
+# pragma omp simd
+#endif
+	for (std::size_t t = 0; t < n; ++t)
+	{
+		k[t] = std::exp(-s*k[t]);
+	}
+}
+
+/**
+ * Computes the potential
+ * \f$P_i = \sum_{k=1}^{nr} w_k e^{-\|x_i-x_k\|^2}\f$ of each of the \a nr
+ * points in \a X (dimension-major, already scaled by the kernel width), where
+ * the weights \f$w_k\f$ are given by \a w (all ones if \a w is null).
+ *
+ * Since the kernel is symmetric, each pair is visited once and its
+ * contribution is added to both points.
+ * Rows are dealt out cyclically to threads (which balances the decreasing
+ * cost of the rows), and each thread accumulates into its own array; the
+ * arrays are then summed in a fixed order, so that, for a given number of
+ * threads, results do not depend on scheduling.
+ */
+void computePotentials(const fl::scalar* X,
+					   const fl::scalar* w,
+					   std::size_t nr,
+					   std::size_t nc,
+					   fl::scalar* potentials)
+{
+	const std::size_t nt = fl::detail::MaxNumOfThreads();
+
+	std::vector<fl::scalar> partial(nt*nr, 0);
+	std::vector<fl::scalar> kern(nt*fl::detail::TileSize);
+	std::vector<fl::scalar> point(nt*nc);
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+	{
+		const std::size_t tid = fl::detail::ThreadNum();
+		fl::scalar* P = &partial[tid*nr];
+		fl::scalar* K = &kern[tid*fl::detail::TileSize];
+		fl::scalar* c = &point[tid*nc];
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static, 1)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				c[j] = X[j*nr+i];
+			}
+
+			fl::scalar Pi = w ? w[i] : 1; // Contribution of the point itself
+			for (std::size_t k0 = i+1; k0 < nr; k0 += fl::detail::TileSize)
+			{
+				const std::size_t nk = std::min(fl::detail::TileSize, nr-k0);
+
+				gaussianKernel(X+k0, nr, nc, c, 1, nk, K);
+
+				fl::scalar* Pk = P+k0;
+				if (w)
+				{
+					const fl::scalar* wk = w+k0;
+					for (std::size_t t = 0; t < nk; ++t)
+					{
+						Pi += wk[t]*K[t];
+						Pk[t] += w[i]*K[t];
+					}
+				}
+				else
+				{
+					for (std::size_t t = 0; t < nk; ++t)
+					{
+						Pi += K[t];
+						Pk[t] += K[t];
+					}
+				}
+			}
+			P[i] += Pi;
+		}
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			fl::scalar Pi = 0;
+			for (std::size_t t = 0; t < nt; ++t)
+			{
+				Pi += partial[t*nr+i];
+			}
+			potentials[i] = Pi;
+		}
+	}
+}
+
+/**
+ * Subtracts \f$P^* e^{-s\|c-x_i\|^2}\f$ from the potential of each of the
+ * \a nr points in \a X (dimension-major, already scaled by the kernel
+ * width), clipping the result at zero.
+ *
+ * Returns the index of the first point with the highest revised potential,
+ * which is found in the same pass.
+ */
+std::size_t subtractPotential(const fl::scalar* X,
+							  std::size_t nr,
+							  std::size_t nc,
+							  const fl::scalar* c,
+							  fl::scalar s,
+							  fl::scalar maxPotential,
+							  fl::scalar* potentials)
+{
+	const std::size_t nt = fl::detail::MaxNumOfThreads();
+
+	std::vector<fl::scalar> kern(nt*fl::detail::TileSize);
+	std::vector<std::size_t> bestIdx(nt, nr);
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+	{
+		const std::size_t tid = fl::detail::ThreadNum();
+		fl::scalar* K = &kern[tid*fl::detail::TileSize];
+		std::size_t best = nr;
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(static)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		for (std::size_t i0 = 0; i0 < nr; i0 += fl::detail::TileSize)
+		{
+			const std::size_t ni = std::min(fl::detail::TileSize, nr-i0);
+
+			gaussianKernel(X+i0, nr, nc, c, s, ni, K);
+
+			fl::scalar* Pi = potentials+i0;
+			for (std::size_t t = 0; t < ni; ++t)
+			{
+				Pi[t] = std::max(Pi[t]-maxPotential*K[t], fl::scalar(0));
+			}
+			for (std::size_t t = 0; t < ni; ++t)
+			{
+				if (best == nr || Pi[t] > potentials[best])
+				{
+					best = i0+t;
+				}
+			}
+		}
+
+		bestIdx[tid] = best;
+	}
+
+	// Merges the per-thread maxima, keeping the lowest index among ties
+	std::size_t best = nr;
+	for (std::size_t t = 0; t < nt; ++t)
+	{
+		const std::size_t i = bestIdx[t];
+		if (i < nr && (best == nr || potentials[i] > potentials[best] || (potentials[i] == potentials[best] && i < best)))
+		{
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Computes the potential of each of the \a nr points in \a X (dimension-major,
+ * already scaled by the kernel width, and in the order given by \a tree),
+ * neglecting the points whose squared distance is greater than \a r2.
+ * The points are weighted by \a w (in tree order, all ones if \a w is null).
+ *
+ * Potentials are stored in the original order of points.
+ * Returns the largest total weight of the points neglected in computing a
+ * potential.
+ */
+fl::scalar computePotentialsWithCutoff(const fl::detail::KdTree<fl::scalar>& tree,
+									   const fl::scalar* X,
+									   const fl::scalar* w,
+									   std::size_t nr,
+									   std::size_t nc,
+									   fl::scalar r2,
+									   fl::scalar* potentials)
+{
+	const std::size_t nt = fl::detail::MaxNumOfThreads();
+	const std::vector<std::size_t>& perm = tree.permutation();
+
+	std::vector< std::vector<std::size_t> > leafBufs(nt);
+	for (std::size_t t = 0; t < nt; ++t)
+	{
+		leafBufs[t].reserve(tree.numOfLeaves());
+	}
+	std::vector<fl::scalar> kern(nt*fl::detail::TileSize);
+	std::vector<fl::scalar> point(nt*nc);
+	std::vector<fl::scalar> minVisited(nt, fl::inf);
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel
+#endif // FLX_CONFIG_HAVE_OPENMP
+	{
+		const std::size_t tid = fl::detail::ThreadNum();
+		std::vector<std::size_t>& leaves = leafBufs[tid];
+		fl::scalar* K = &kern[tid*fl::detail::TileSize];
+		fl::scalar* c = &point[tid*nc];
+
+		// Each potential is computed by a single thread in a fixed order, so
+		// dynamic scheduling does not affect results
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(dynamic, 64)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		for (std::size_t p = 0; p < nr; ++p)
+		{
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				c[j] = X[j*nr+p];
+			}
+
+			leaves.clear();
+			tree.findLeaves(c, r2, leaves);
+
+			fl::scalar P = 0;
+			fl::scalar visited = 0;
+			for (std::size_t l = 0,
+							 nl = leaves.size();
+				 l < nl;
+				 ++l)
+			{
+				const std::size_t end = tree.leafEnd(leaves[l]);
+				for (std::size_t b = tree.leafBegin(leaves[l]); b < end; b += fl::detail::TileSize)
+				{
+					const std::size_t nb = std::min(fl::detail::TileSize, end-b);
+
+					gaussianKernel(X+b, nr, nc, c, 1, nb, K);
+
+					if (w)
+					{
+						for (std::size_t t = 0; t < nb; ++t)
+						{
+							P += w[b+t]*K[t];
+							visited += w[b+t];
+						}
+					}
+					else
+					{
+						for (std::size_t t = 0; t < nb; ++t)
+						{
+							P += K[t];
+						}
+						visited += nb;
+					}
+				}
+			}
+			potentials[perm[p]] = P;
+			minVisited[tid] = std::min(minVisited[tid], visited);
+		}
+	}
+
+	fl::scalar total = nr;
+	if (w)
+	{
+		total = 0;
+		for (std::size_t p = 0; p < nr; ++p)
+		{
+			total += w[p];
+		}
+	}
+
+	return std::max(total-*std::min_element(minVisited.begin(), minVisited.end()), fl::scalar(0));
+}
+
+/**
+ * Subtracts \f$P^* e^{-s\|c-x_i\|^2}\f$ from the potential of each of the
+ * \a nr points in \a X (dimension-major, already scaled by the kernel width,
+ * and in the order given by \a tree) whose squared distance from \a c is not
+ * greater than \a r2, clipping the result at zero.
+ *
+ * Potentials are stored in the original order of points.
+ * The visited leaves, which contain all the revised potentials, are stored
+ * in \a leaves.
+ */
+void subtractPotentialWithCutoff(const fl::detail::KdTree<fl::scalar>& tree,
+								 const fl::scalar* X,
+								 std::size_t nr,
+								 std::size_t nc,
+								 const fl::scalar* c,
+								 fl::scalar s,
+								 fl::scalar r2,
+								 fl::scalar maxPotential,
+								 fl::scalar* potentials,
+								 std::vector<std::size_t>& leaves)
+{
+	const std::size_t nt = fl::detail::MaxNumOfThreads();
+	const std::vector<std::size_t>& perm = tree.permutation();
+
+	leaves.clear();
+	tree.findLeaves(c, r2, leaves);
+
+	std::vector<fl::scalar> kern(nt*fl::detail::TileSize);
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel if (leaves.size() > 1)
+#endif // FLX_CONFIG_HAVE_OPENMP
+	{
+		fl::scalar* K = &kern[fl::detail::ThreadNum()*fl::detail::TileSize];
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp for schedule(dynamic)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		for (std::size_t l = 0; l < leaves.size(); ++l)
+		{
+			const std::size_t end = tree.leafEnd(leaves[l]);
+			for (std::size_t b = tree.leafBegin(leaves[l]); b < end; b += fl::detail::TileSize)
+			{
+				const std::size_t nb = std::min(fl::detail::TileSize, end-b);
+
+				gaussianKernel(X+b, nr, nc, c, s, nb, K);
+
+				for (std::size_t t = 0; t < nb; ++t)
+				{
+					fl::scalar& P = potentials[perm[b+t]];
+					P = std::max(P-maxPotential*K[t], fl::scalar(0));
+				}
+			}
+		}
+	}
+}
+
+}} // Namespace detail::<unnamed>
+
+
 const fl::scalar SubtractiveClustering::DefaultRadius = 0.5;
 
 const fl::scalar SubtractiveClustering::DefaultSquashingFactor = 1.25;
@@ -45,10 +418,15 @@ const fl::scalar SubtractiveClustering::DefaultAcceptanceRatio = 0.5;
 
 const fl::scalar SubtractiveClustering::DefaultRejectionRatio = 0.15;
 
+const fl::scalar SubtractiveClustering::DefaultSummaryResolution = 0.1;
+
 SubtractiveClustering::SubtractiveClustering()
 : squashFactor_(DefaultSquashingFactor),
   acceptRatio_(DefaultAcceptanceRatio),
-  rejectRatio_(DefaultRejectionRatio)
+  rejectRatio_(DefaultRejectionRatio),
+  cutoffTol_(0),
+  cutoffErr_(0),
+  summaryRes_(DefaultSummaryResolution)
 {
 }
 
@@ -60,7 +438,10 @@ SubtractiveClustering::SubtractiveClustering(const SubtractiveClustering& other)
   lbounds_(other.lbounds_),
   ubounds_(other.ubounds_),
   centers_(other.centers_),
-  sigma_(other.sigma_)
+  sigma_(other.sigma_),
+  cutoffTol_(other.cutoffTol_),
+  cutoffErr_(other.cutoffErr_),
+  summaryRes_(other.summaryRes_)
 {
 }
 
@@ -76,6 +457,9 @@ SubtractiveClustering& SubtractiveClustering::operator=(const SubtractiveCluster
 		ubounds_ = rhs.ubounds_;
 		centers_ = rhs.centers_;
 		sigma_ = rhs.sigma_;
+		cutoffTol_ = rhs.cutoffTol_;
+		cutoffErr_ = rhs.cutoffErr_;
+		summaryRes_ = rhs.summaryRes_;
 	}
 
 	return *this;
@@ -172,6 +556,41 @@ std::vector<std::vector<fl::scalar> > SubtractiveClustering::bounds() const
 	return res;
 }
 
+void SubtractiveClustering::setCutoffTolerance(fl::scalar value)
+{
+	if (value < 0 || value >= 1)
+	{
+		FL_THROW2(std::invalid_argument, "Cutoff tolerance must be in [0,1)");
+	}
+
+	cutoffTol_ = value;
+}
+
+fl::scalar SubtractiveClustering::getCutoffTolerance() const
+{
+	return cutoffTol_;
+}
+
+fl::scalar SubtractiveClustering::cutoffErrorBound() const
+{
+	return cutoffErr_;
+}
+
+void SubtractiveClustering::setSummaryResolution(fl::scalar value)
+{
+	if (value <= 0)
+	{
+		FL_THROW2(std::invalid_argument, "Summary resolution must be positive");
+	}
+
+	summaryRes_ = value;
+}
+
+fl::scalar SubtractiveClustering::getSummaryResolution() const
+{
+	return summaryRes_;
+}
+
 void SubtractiveClustering::reset()
 {
 	lbounds_.clear();
@@ -182,6 +601,598 @@ void SubtractiveClustering::reset()
 	rejectRatio_ = DefaultRejectionRatio;
 	centers_.clear();
 	sigma_.clear();
+	cutoffTol_ = 0;
+	cutoffErr_ = 0;
+	summaryRes_ = DefaultSummaryResolution;
+}
+
+void SubtractiveClustering::adjustRadii(std::size_t nc)
+{
+	if (radii_.size() < nc)
+	{
+		// Enlarge and set default value
+		radii_.insert(radii_.end(), nc-radii_.size(), DefaultRadius);
+	}
+	else if (radii_.size() > nc)
+	{
+		// Shrink to fit current input data dimension
+		radii_.resize(nc);
+	}
+}
+
+void SubtractiveClustering::clusterStream(fl::DataSource<fl::scalar>& source, bool refine)
+{
+	// Chunks may be read-only views, so their values are only accessed
+	// through a const reference
+	fl::DataSet<fl::scalar> chunk;
+	const fl::DataSet<fl::scalar>& cchunk = chunk;
+
+	// First pass (only if bounds are not given): finds the data bounds
+	std::size_t nc = 0; // Number of data parameters
+	bool clearLBounds = false;
+	bool clearUBounds = false;
+	if (lbounds_.size() == 0 || ubounds_.size() == 0)
+	{
+		bool first = true;
+		source.rewind();
+		while (source.read(chunk))
+		{
+			if (chunk.size() == 0)
+			{
+				continue;
+			}
+			if (first)
+			{
+				nc = chunk.numOfInputs()+chunk.numOfOutputs();
+				this->initBounds(nc, clearLBounds, clearUBounds);
+				first = false;
+			}
+			this->updateBounds(cchunk.matrix(), clearLBounds, clearUBounds);
+		}
+		if (first)
+		{
+			FL_THROW("Data set must have at least one point");
+		}
+	}
+	else
+	{
+		nc = lbounds_.size();
+	}
+	this->adjustRadii(nc);
+	this->checkBounds(nc, clearLBounds, clearUBounds);
+
+	// Second pass: summarizes the data.
+	// Normalized data points are binned into a uniform grid whose cells are
+	// a fraction (the summary resolution) of the cluster radii wide, and each
+	// non-empty cell is represented by the centroid of its data points,
+	// weighted by their number.
+	// The memory needed only depends on the number of non-empty cells.
+	typedef std::map< std::vector<std::size_t>, std::size_t > CellMap;
+	CellMap cells;
+	std::vector<fl::scalar> sums; // The sum of the data points in each cell (one after the other)
+	std::vector<fl::scalar> weights; // The number of data points in each cell
+	std::vector<fl::scalar> cellWidths(nc);
+	for (std::size_t j = 0; j < nc; ++j)
+	{
+		cellWidths[j] = summaryRes_*radii_[j];
+	}
+	std::vector<fl::scalar> xn(nc);
+	std::vector<std::size_t> key(nc);
+	source.rewind();
+	while (source.read(chunk))
+	{
+		const fl::DataSet<fl::scalar>::ConstDataMatrix X = cchunk.matrix();
+		if (X.size() > 0 && X.numOfColumns() != nc)
+		{
+			FL_THROW("Data points must have the same dimension");
+		}
+
+		for (std::size_t i = 0,
+						 ni = X.size();
+			 i < ni;
+			 ++i)
+		{
+			this->normalizePoint(X[i], &xn[0], 1);
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				key[j] = static_cast<std::size_t>(xn[j]/cellWidths[j]);
+			}
+
+			CellMap::iterator it = cells.find(key);
+			if (it == cells.end())
+			{
+				it = cells.insert(std::make_pair(key, weights.size())).first;
+				weights.push_back(0);
+				sums.resize(sums.size()+nc, 0);
+			}
+
+			const std::size_t k = it->second;
+			weights[k] += 1;
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				sums[k*nc+j] += xn[j];
+			}
+		}
+	}
+
+	const std::size_t nr = weights.size(); // Number of representative data points
+	if (nr == 0)
+	{
+		FL_THROW("Data set must have at least one point");
+	}
+
+	std::vector<fl::scalar> datan(nr*nc);
+	for (std::size_t k = 0; k < nr; ++k)
+	{
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			datan[j*nr+k] = sums[k*nc+j]/weights[k];
+		}
+	}
+
+	// Clusters the weighted representatives
+	this->estimateCenters(datan, weights, nr, nc);
+
+	this->finalizeCenters(nc);
+
+	// Optional third pass: replaces each cluster center with the nearest data
+	// point of the stream (the distance being measured in units of radii), so
+	// that, as in the batch algorithm, cluster centers are actual data points
+	if (refine && centers_.size() > 0)
+	{
+		const std::size_t ncl = centers_.size();
+
+		std::vector<fl::scalar> scaledCenters(ncl*nc);
+		for (std::size_t k = 0; k < ncl; ++k)
+		{
+			this->normalizePoint(centers_[k], &scaledCenters[k*nc], 1);
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				scaledCenters[k*nc+j] /= radii_[j];
+			}
+		}
+
+		std::vector<fl::scalar> minDistSq(ncl, std::numeric_limits<fl::scalar>::infinity());
+		std::vector< std::vector<fl::scalar> > nearest(centers_);
+		source.rewind();
+		while (source.read(chunk))
+		{
+			const fl::DataSet<fl::scalar>::ConstDataMatrix X = cchunk.matrix();
+			for (std::size_t i = 0,
+							 ni = X.size();
+				 i < ni;
+				 ++i)
+			{
+				this->normalizePoint(X[i], &xn[0], 1);
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					xn[j] /= radii_[j];
+				}
+
+				for (std::size_t k = 0; k < ncl; ++k)
+				{
+					fl::scalar distSq = 0;
+					for (std::size_t j = 0; j < nc; ++j)
+					{
+						distSq += fl::detail::Sqr(xn[j]-scaledCenters[k*nc+j]);
+					}
+					if (distSq < minDistSq[k])
+					{
+						minDistSq[k] = distSq;
+						nearest[k].assign(X[i].begin(), X[i].end());
+					}
+				}
+			}
+		}
+
+		centers_ = nearest;
+	}
+}
+
+
+void SubtractiveClustering::initBounds(std::size_t nc, bool& clearLBounds, bool& clearUBounds)
+{
+	clearLBounds = false;
+	clearUBounds = false;
+	if (lbounds_.size() == 0 || ubounds_.size() == 0)
+	{
+		// No bound given => Use min and max values
+		if (lbounds_.size() == 0)
+		{
+			clearLBounds = true;
+			lbounds_.resize(nc, std::numeric_limits<fl::scalar>::max());
+		}
+		if (ubounds_.size() == 0)
+		{
+			clearUBounds = true;
+			ubounds_.resize(nc, -std::numeric_limits<fl::scalar>::max());
+		}
+	}
+}
+
+void SubtractiveClustering::checkBounds(std::size_t nc, bool clearLBounds, bool clearUBounds)
+{
+	if (clearLBounds || clearUBounds)
+	{
+		// For zero-range data, compute a small artificial range
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			if (fl::detail::FloatTraits<fl::scalar>::ApproximatelyEqual(lbounds_[j], ubounds_[j]))
+			{
+				if (clearLBounds)
+				{
+					lbounds_[j] -= 0.0001*(1+std::abs(lbounds_[j]));
+				}
+				if (clearUBounds)
+				{
+					ubounds_[j] += 0.0001*(1+std::abs(ubounds_[j]));
+				}
+			}
+		}
+	}
+	else
+	{
+		// Check size
+		if (lbounds_.size() != nc || ubounds_.size() != nc)
+		{
+			FL_THROW("Wrong dimension for data bound vectors");
+		}
+		// Check zero-range data
+		for (std::size_t i = 0; i < nc; ++i)
+		{
+			if (fl::detail::FloatTraits<fl::scalar>::ApproximatelyEqual(lbounds_[i], ubounds_[i]))
+			{
+				FL_THROW("Found zero data-range in data bound vector");
+			}
+		}
+	}
+}
+
+void SubtractiveClustering::finalizeCenters(std::size_t nc)
+{
+	// Scale the cluster centers from the normalized values back to values in
+	// the original range
+	for (std::size_t i = 0,
+					 numClusters = centers_.size();
+		 i < numClusters;
+		 ++i)
+	{
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			centers_[i][j] = centers_[i][j]*(ubounds_[j]-lbounds_[j]) + lbounds_[j];
+		}
+	}
+
+	// Compute the range of influence of the cluster centers for each data
+	// dimension
+	sigma_.resize(nc);
+	for (std::size_t i = 0; i < nc; ++i)
+	{
+		sigma_[i] = (radii_[i]*(ubounds_[i]-lbounds_[i]))/std::sqrt(8.0);
+	}
+}
+
+/// The data points scaled by the kernel width, and their index in cutoff mode
+struct SubtractiveClustering::ScaledData
+{
+	std::size_t nr; ///< The number of data points
+	std::size_t nc; ///< The number of components of data points
+	std::vector<fl::scalar> X; ///< The scaled data points (dimension-major)
+	fl::detail::KdTree<fl::scalar> tree; ///< The index of data points (cutoff mode only)
+	std::vector<fl::scalar> Xt; ///< The scaled data points in tree order (cutoff mode only)
+	std::vector<std::size_t> invPerm; ///< The position in tree order of each data point (cutoff mode only)
+	std::vector<fl::scalar> wt; ///< The weights in tree order (cutoff mode only)
+};
+
+void SubtractiveClustering::scaleData(const std::vector<fl::scalar>& datan, const std::vector<fl::scalar>& weights, std::size_t nr, std::size_t nc, ScaledData& sd) const
+{
+	sd.nr = nr;
+	sd.nc = nc;
+
+	// Scales the data so that the potential kernel becomes exp(-||x_i-x_k||^2)
+	// (i.e., each dimension is multiplied by 2/r_j)
+	sd.X.resize(nr*nc);
+	for (std::size_t j = 0; j < nc; ++j)
+	{
+		const fl::scalar a = 2.0/radii_[j];
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			sd.X[j*nr+i] = datan[j*nr+i]*a;
+		}
+	}
+
+	// In cutoff mode, the data are indexed by a k-d tree and reordered so that
+	// the data points of each leaf are contiguous.
+	if (cutoffTol_ > 0)
+	{
+		sd.tree.build(&sd.X[0], nr, nc);
+
+		const std::vector<std::size_t>& perm = sd.tree.permutation();
+		sd.Xt.resize(nr*nc);
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			for (std::size_t p = 0; p < nr; ++p)
+			{
+				sd.Xt[j*nr+p] = sd.X[j*nr+perm[p]];
+			}
+		}
+		sd.invPerm.resize(nr);
+		for (std::size_t p = 0; p < nr; ++p)
+		{
+			sd.invPerm[perm[p]] = p;
+		}
+		sd.wt.clear();
+		if (!weights.empty())
+		{
+			sd.wt.resize(nr);
+			for (std::size_t p = 0; p < nr; ++p)
+			{
+				sd.wt[p] = weights[perm[p]];
+			}
+		}
+	}
+}
+
+fl::scalar SubtractiveClustering::computeInitialPotentials(const ScaledData& sd, const std::vector<fl::scalar>& weights, std::vector<fl::scalar>& potentials) const
+{
+	potentials.assign(sd.nr, 0);
+
+	// Kernel values below the tolerance are neglected, that is potentials only
+	// account for the data points within a squared (scaled) distance of
+	// -ln(tol).
+	if (cutoffTol_ > 0)
+	{
+		const fl::scalar maxNeglected = detail::computePotentialsWithCutoff(sd.tree, &sd.Xt[0], sd.wt.empty() ? 0 : &sd.wt[0], sd.nr, sd.nc, -std::log(cutoffTol_), &potentials[0]);
+		return cutoffTol_*maxNeglected;
+	}
+
+	detail::computePotentials(&sd.X[0], weights.empty() ? 0 : &weights[0], sd.nr, sd.nc, &potentials[0]);
+	return 0;
+}
+
+void SubtractiveClustering::estimatePotentials(const std::vector<fl::scalar>& datan, std::size_t nr, std::size_t nc, std::vector<fl::scalar>& potentials) const
+{
+	const std::vector<fl::scalar> weights;
+	ScaledData sd;
+	this->scaleData(datan, weights, nr, nc, sd);
+
+	this->computeInitialPotentials(sd, weights, potentials);
+}
+
+void SubtractiveClustering::estimateCenters(const std::vector<fl::scalar>& datan, const std::vector<fl::scalar>& weights, std::size_t nr, std::size_t nc)
+{
+	ScaledData sd;
+	this->scaleData(datan, weights, nr, nc, sd);
+
+	std::vector<fl::scalar> potentials;
+	cutoffErr_ = this->computeInitialPotentials(sd, weights, potentials);
+
+	this->extractCenters(datan, sd, potentials);
+}
+
+void SubtractiveClustering::estimateCentersShared(const std::vector<fl::scalar>& datan, std::size_t nr, std::size_t nc, const std::vector<SubtractiveClustering*>& group)
+{
+	if (group.empty())
+	{
+		return;
+	}
+
+	// The initial potentials only depend on the radii and on the cutoff
+	// tolerance, which are the same for the whole group
+	const std::vector<fl::scalar> weights;
+	ScaledData sd;
+	group[0]->scaleData(datan, weights, nr, nc, sd);
+
+	std::vector<fl::scalar> initPotentials;
+	const fl::scalar initErr = group[0]->computeInitialPotentials(sd, weights, initPotentials);
+
+	// Extractions only read the shared data, so they can run concurrently
+	// (each one on its own copy of the potentials)
+	const std::size_t ng = group.size();
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp parallel for schedule(dynamic)
+#endif // FLX_CONFIG_HAVE_OPENMP
+	for (std::size_t g = 0; g < ng; ++g)
+	{
+		std::vector<fl::scalar> potentials(initPotentials);
+		group[g]->cutoffErr_ = initErr;
+		group[g]->extractCenters(datan, sd, potentials);
+	}
+}
+
+void SubtractiveClustering::extractCenters(const std::vector<fl::scalar>& datan, const ScaledData& sd, std::vector<fl::scalar>& potentials)
+{
+	const std::size_t nr = sd.nr;
+	const std::size_t nc = sd.nc;
+	const std::vector<fl::scalar>& X = sd.X;
+	const fl::detail::KdTree<fl::scalar>& tree = sd.tree;
+	const std::vector<fl::scalar>& Xt = sd.Xt;
+
+	// In the scaled space, the squashed kernel is exp(-||x_i-x_k||^2/squashFactor^2)
+	const fl::scalar squash = 1.0/fl::detail::Sqr(squashFactor_);
+
+	// In cutoff mode, subtractions neglect the data points beyond a squared
+	// (scaled) distance of squashFactor^2*(-ln(tol))
+	const bool cutoff = cutoffTol_ > 0;
+	const fl::scalar squashCutoffSq = cutoff ? -std::log(cutoffTol_)*fl::detail::Sqr(squashFactor_) : 0;
+
+	// - Finds the data point with the highest potential.
+	//   The highest potential will be used as a reference for
+	//   accepting/rejecting other data points as cluster centers.
+	//   In cutoff mode, potentials are indexed by a max-heap, so that after
+	//   each iteration only the potentials that actually changed need to be
+	//   re-keyed. Otherwise, every subtraction revises all the potentials
+	//   anyway, and the new maximum is found in the same pass.
+	centers_.clear();
+	if (nr == 0)
+	{
+		return;
+	}
+
+	fl::detail::IndexedMaxHeap<fl::scalar> heap;
+	std::size_t maxPotentialIdx = 0;
+	if (cutoff)
+	{
+		heap.assign(potentials.begin(), potentials.end());
+		maxPotentialIdx = heap.top();
+	}
+	else
+	{
+		maxPotentialIdx = std::max_element(potentials.begin(), potentials.end())-potentials.begin();
+	}
+	fl::scalar maxPotential = potentials[maxPotentialIdx];
+
+	// Start iteratively finding cluster centers and subtracting potential
+	// from neighboring data points. 
+	std::vector<fl::scalar> maxPotentialPoint(nc);
+	std::vector<fl::scalar> scaledCenters; // The cluster centers in the scaled space (one after the other)
+	std::vector<char> isCenter(cutoff ? nr : 0, 0); // Tells if a data point (in tree order) is a cluster center
+	std::vector<std::size_t> leaves;
+	bool findMore = true;
+	const fl::scalar refPotential = maxPotential;
+	while (findMore && maxPotential > 0)
+	{
+		const fl::scalar maxPotentialRatio = maxPotential/refPotential;
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			maxPotentialPoint[j] = X[j*nr+maxPotentialIdx];
+		}
+
+		bool removePoint = false;
+		findMore = false;
+		if (maxPotentialRatio > acceptRatio_)
+		{
+			// The new peak value is significant -> accept
+			findMore = true;
+		}
+		else if (maxPotentialRatio > rejectRatio_)
+		{
+			// Accept this data point only if it achieves a good balance between having a reasonable potential and being far from all existing cluster centers,
+			// that is if maxPotentialRatio+minDist >= 1, where minDist is the distance (in units of radii, i.e., half the scaled distance) to the nearest center.
+			// Thus, it is enough to find a single center closer than 1-maxPotentialRatio to reject the data point.
+			bool farFromCenters = !centers_.empty();
+
+			if (cutoff)
+			{
+				// Only the leaves within the critical distance can hold a closer center
+				leaves.clear();
+				tree.findLeaves(&maxPotentialPoint[0], 4.0*fl::detail::Sqr(1-maxPotentialRatio), leaves);
+				for (std::size_t l = 0,
+								 nl = leaves.size();
+					 l < nl && farFromCenters;
+					 ++l)
+				{
+					for (std::size_t p = tree.leafBegin(leaves[l]),
+									 np = tree.leafEnd(leaves[l]);
+						 p < np && farFromCenters;
+						 ++p)
+					{
+						if (isCenter[p])
+						{
+							fl::scalar distSq = 0;
+							for (std::size_t j = 0; j < nc; ++j)
+							{
+								distSq += fl::detail::Sqr(maxPotentialPoint[j]-Xt[j*nr+p]);
+							}
+							farFromCenters = (maxPotentialRatio+std::sqrt(distSq)/2.0) >= 1;
+						}
+					}
+				}
+			}
+			else
+			{
+				for (std::size_t i = 0,
+								 ni = centers_.size();
+					 i < ni && farFromCenters;
+					 ++i)
+				{
+					const fl::scalar* center = &scaledCenters[i*nc];
+					fl::scalar distSq = 0;
+					for (std::size_t j = 0; j < nc; ++j)
+					{
+						distSq += fl::detail::Sqr(maxPotentialPoint[j]-center[j]);
+					}
+					farFromCenters = (maxPotentialRatio+std::sqrt(distSq)/2.0) >= 1;
+				}
+			}
+
+			if (farFromCenters)
+			{
+				// Tentatively accept this data point as a cluster center
+				findMore = true;
+			}
+			else
+			{
+				// Remove this data point from further consideration and continue
+				findMore = true;
+				removePoint = true;
+			}
+		}
+
+		if (findMore)
+		{
+			if (removePoint)
+			{
+				potentials[maxPotentialIdx] = 0;
+				if (cutoff)
+				{
+					heap.update(maxPotentialIdx, 0);
+					maxPotentialIdx = heap.top();
+				}
+				else
+				{
+					maxPotentialIdx = std::max_element(potentials.begin(), potentials.end())-potentials.begin();
+				}
+			}
+			else
+			{
+				// Adds the data point to the list of cluster centers
+				std::vector<fl::scalar> center(nc);
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					center[j] = datan[j*nr+maxPotentialIdx];
+				}
+				centers_.push_back(center);
+				scaledCenters.insert(scaledCenters.end(), maxPotentialPoint.begin(), maxPotentialPoint.end());
+
+				//FL_DEBUG_TRACE("Found cluster #" << centers_.size() << ", potential = " << maxPotentialRatio);
+
+				// subtract potential from data points near the new cluster center
+				if (cutoff)
+				{
+					const std::vector<std::size_t>& perm = tree.permutation();
+
+					isCenter[sd.invPerm[maxPotentialIdx]] = 1;
+
+					detail::subtractPotentialWithCutoff(tree, &Xt[0], nr, nc, &maxPotentialPoint[0], squash, squashCutoffSq, maxPotential, &potentials[0], leaves);
+					cutoffErr_ += cutoffTol_*maxPotential;
+
+					// Re-keys the revised potentials only
+					for (std::size_t l = 0,
+									 nl = leaves.size();
+						 l < nl;
+						 ++l)
+					{
+						for (std::size_t p = tree.leafBegin(leaves[l]),
+										 np = tree.leafEnd(leaves[l]);
+							 p < np;
+							 ++p)
+						{
+							heap.update(perm[p], potentials[perm[p]]);
+						}
+					}
+					maxPotentialIdx = heap.top();
+				}
+				else
+				{
+					maxPotentialIdx = detail::subtractPotential(&X[0], nr, nc, &maxPotentialPoint[0], squash, maxPotential, &potentials[0]);
+				}
+			}
+
+			// The data point with the highest remaining potential
+			maxPotential = potentials[maxPotentialIdx];
+		}
+	}
 }
 
 std::vector< std::vector<fl::scalar> > SubtractiveClustering::centers() const
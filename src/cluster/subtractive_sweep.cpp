@@ -0,0 +1,148 @@
+/**
+ * \file cluster/subtractive_sweep.cpp
+ *
+ * \brief Subtractive clustering over a grid of parameter settings
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <fl/cluster/subtractive.h>
+#include <fl/cluster/subtractive_sweep.h>
+#include <fl/fuzzylite.h>
+#include <fl/macro.h>
+#include <vector>
+
+
+namespace fl { namespace cluster {
+
+SubtractiveClusteringSweep::SubtractiveClusteringSweep(const SubtractiveClustering& base)
+: base_(base)
+{
+}
+
+void SubtractiveClusteringSweep::setRadii(const std::vector<fl::scalar>& values)
+{
+	radii_ = values;
+}
+
+std::vector<fl::scalar> SubtractiveClusteringSweep::radii() const
+{
+	return radii_;
+}
+
+void SubtractiveClusteringSweep::setSquashingFactors(const std::vector<fl::scalar>& values)
+{
+	squashFactors_ = values;
+}
+
+std::vector<fl::scalar> SubtractiveClusteringSweep::squashingFactors() const
+{
+	return squashFactors_;
+}
+
+void SubtractiveClusteringSweep::setAcceptanceRatios(const std::vector<fl::scalar>& values)
+{
+	acceptRatios_ = values;
+}
+
+std::vector<fl::scalar> SubtractiveClusteringSweep::acceptanceRatios() const
+{
+	return acceptRatios_;
+}
+
+void SubtractiveClusteringSweep::setRejectionRatios(const std::vector<fl::scalar>& values)
+{
+	rejectRatios_ = values;
+}
+
+std::vector<fl::scalar> SubtractiveClusteringSweep::rejectionRatios() const
+{
+	return rejectRatios_;
+}
+
+std::size_t SubtractiveClusteringSweep::numOfSettings() const
+{
+	return std::max(radii_.size(), std::size_t(1))
+		   * std::max(squashFactors_.size(), std::size_t(1))
+		   * std::max(acceptRatios_.size(), std::size_t(1))
+		   * std::max(rejectRatios_.size(), std::size_t(1));
+}
+
+const std::vector<SubtractiveClustering>& SubtractiveClusteringSweep::results() const
+{
+	return results_;
+}
+
+void SubtractiveClusteringSweep::clusterNormalized(const SubtractiveClustering& ref, const std::vector<fl::scalar>& datan, std::size_t nr, std::size_t nc)
+{
+	// Missing candidates are replaced by the parameters of the reference
+	// clustering (whose radii have already been adjusted to the data)
+	const std::vector<fl::scalar> squashFactors = squashFactors_.empty() ? std::vector<fl::scalar>(1, ref.squashFactor_) : squashFactors_;
+	const std::vector<fl::scalar> acceptRatios = acceptRatios_.empty() ? std::vector<fl::scalar>(1, ref.acceptRatio_) : acceptRatios_;
+	const std::vector<fl::scalar> rejectRatios = rejectRatios_.empty() ? std::vector<fl::scalar>(1, ref.rejectRatio_) : rejectRatios_;
+	const std::size_t nrad = std::max(radii_.size(), std::size_t(1));
+	const std::size_t groupSize = squashFactors.size()*acceptRatios.size()*rejectRatios.size();
+
+	results_.assign(nrad*groupSize, ref);
+	for (std::size_t r = 0; r < nrad; ++r)
+	{
+		std::vector<SubtractiveClustering*> group;
+		group.reserve(groupSize);
+		for (std::size_t s = 0,
+						 ns = squashFactors.size();
+			 s < ns;
+			 ++s)
+		{
+			for (std::size_t a = 0,
+							 na = acceptRatios.size();
+				 a < na;
+				 ++a)
+			{
+				for (std::size_t b = 0,
+								 nb = rejectRatios.size();
+					 b < nb;
+					 ++b)
+				{
+					SubtractiveClustering& res = results_[r*groupSize+group.size()];
+					if (!radii_.empty())
+					{
+						res.setRadii(radii_[r], nc);
+					}
+					res.setSquashingFactor(squashFactors[s]);
+					res.setAcceptanceRatio(acceptRatios[a]);
+					res.setRejectionRatio(rejectRatios[b]);
+					group.push_back(&res);
+				}
+			}
+		}
+
+		// All the settings of a group share the radius, and hence the
+		// initial potentials
+		SubtractiveClustering::estimateCentersShared(datan, nr, nc, group);
+
+		for (std::size_t g = 0; g < groupSize; ++g)
+		{
+			group[g]->finalizeCenters(nc);
+		}
+	}
+}
+
+}} // Namespace fl::cluster
@@ -25,9 +25,14 @@
 #include <algorithm>
 #include <cmath>
 #include <fl/anfis.h>
+#include <fl/data_source.h>
+#include <fl/dataset.h>
+#include <fl/detail/terms.h>
+#include <fl/fis_builders.h>
 #include <fl/fuzzylite.h>
 #include <fl/Headers.h>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
@@ -458,6 +463,189 @@ bool CheckEqualEngine(const fl::anfis::Engine& eng1, const fl::anfis::Engine& en
 	return true;
 }
 
+/// Makes a training set sampling a smooth function of two inputs
+fl::DataSet<fl::scalar> MakeTrainingSet(std::size_t n)
+{
+	fl::DataSet<fl::scalar> data(2, 1);
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		const fl::scalar x[2] = {std::sin(0.37*i), std::cos(0.23*i)};
+		const fl::scalar y = x[0]*x[0]-0.5*x[1]+0.3*x[0]*x[1];
+
+		data.add(x, x+2, &y, &y+1);
+	}
+
+	return data;
+}
+
+/// Builds an ANFIS model with a grid of bell-shaped input terms and linear output terms
+FL_unique_ptr<fl::anfis::Engine> BuildAnfis(const fl::DataSet<fl::scalar>& data)
+{
+	fl::GridPartitionFisBuilder<fl::anfis::Engine> builder(3, fl::Bell().className(), fl::Linear().className());
+
+	FL_unique_ptr<fl::anfis::Engine> p_anfis = builder.build(data);
+	p_anfis->build();
+
+	return p_anfis;
+}
+
+/// Checks if the parameters of the terms of the given variables are equal within the given tolerance
+template <typename VariableT>
+bool CheckEqualParameters(const std::vector<VariableT*>& vars1, const std::vector<VariableT*>& vars2, fl::scalar tol)
+{
+	if (vars1.size() != vars2.size())
+	{
+		return false;
+	}
+	for (std::size_t i = 0; i < vars1.size(); ++i)
+	{
+		if (vars1[i]->numberOfTerms() != vars2[i]->numberOfTerms())
+		{
+			return false;
+		}
+		for (std::size_t t = 0; t < vars1[i]->numberOfTerms(); ++t)
+		{
+			const std::vector<fl::scalar> params1 = fl::detail::GetTermParameters(vars1[i]->getTerm(t));
+			const std::vector<fl::scalar> params2 = fl::detail::GetTermParameters(vars2[i]->getTerm(t));
+
+			if (params1.size() != params2.size())
+			{
+				return false;
+			}
+			for (std::size_t p = 0; p < params1.size(); ++p)
+			{
+				if (std::abs(params1[p]-params2[p]) > tol*(1+std::abs(params1[p])))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/// Checks if the parameters of the input and output terms of the given ANFIS models are equal within the given tolerance
+bool CheckEqualParameters(const fl::anfis::Engine& eng1, const fl::anfis::Engine& eng2, fl::scalar tol)
+{
+	return CheckEqualParameters(eng1.inputVariables(), eng2.inputVariables(), tol)
+		&& CheckEqualParameters(eng1.outputVariables(), eng2.outputVariables(), tol);
+}
+
+/// Trains a copy of the given ANFIS model both with a training set in memory and with a source reading it in small chunks, and checks that the trained models are the same
+template <typename AlgorithmT>
+bool CheckChunkedTraining(const fl::anfis::Engine& anfis, const fl::DataSet<fl::scalar>& data, bool online)
+{
+	const std::size_t numEpochs = 3;
+	const std::size_t chunkSize = 7;
+	const fl::scalar tol = 1e-10;
+
+	fl::anfis::Engine anfis1(anfis);
+	AlgorithmT algo1(&anfis1);
+	algo1.setIsOnline(online);
+	const fl::scalar rmse1 = algo1.train(data, numEpochs);
+
+	fl::anfis::Engine anfis2(anfis);
+	AlgorithmT algo2(&anfis2);
+	algo2.setIsOnline(online);
+	fl::DataSetSource<fl::scalar> source(data, chunkSize);
+	const fl::scalar rmse2 = algo2.train(source, numEpochs);
+
+	return CheckEqualParameters(anfis1, anfis2, tol)
+		&& std::abs(rmse1-rmse2) <= tol*(1+rmse1);
+}
+
+/// Small linear congruential generator to get the same samples everywhere
+class Lcg
+{
+public:
+	explicit Lcg(unsigned long seed)
+	: seed_(seed)
+	{
+	}
+
+	/// Returns a number in [0, 1)
+	fl::scalar next()
+	{
+		seed_ = (seed_*1103515245UL+12345UL) % 2147483648UL;
+		return static_cast<fl::scalar>(seed_ >> 8)/8388608.0;
+	}
+
+private:
+	unsigned long seed_;
+};
+
+/// Adds input and output variables ranging in [0, 1], with no term, to the given ANFIS model
+void SetupEvolvingEngine(fl::anfis::Engine* p_eng, std::size_t numInputs)
+{
+	for (std::size_t i = 0; i < numInputs; ++i)
+	{
+		std::ostringstream oss;
+		oss << "x" << i;
+		p_eng->addInputVariable(new fl::InputVariable(oss.str(), 0, 1));
+	}
+	p_eng->addOutputVariable(new fl::OutputVariable("y", 0, 1));
+}
+
+/// Returns the mean of the first input term of the given rule of an eTS model
+fl::scalar RuleCenter(const fl::anfis::Engine& eng, std::size_t r)
+{
+	return static_cast<const fl::Gaussian*>(eng.getInputVariable(0)->getTerm(r))->getMean();
+}
+
+/// Learns a linear target from the given number of samples around \a x with an eTS algorithm
+void LearnAround(fl::anfis::EvolvingTakagiSugenoLearningAlgorithm& ets, fl::scalar x, std::size_t n)
+{
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		const fl::scalar in = x+0.01*(static_cast<fl::scalar>(k % 5)-2);
+		const fl::scalar out = 0.5*in+0.2;
+
+		ets.learn(&in, &in+1, &out, &out+1);
+	}
+}
+
+/**
+ * Learns with an eTS algorithm a linear process whose slope drifts during the first windows of
+ * samples and then stays constant, and returns the RMSE of the predictions in each window.
+ */
+std::vector<fl::scalar> TrackDriftingProcess(fl::scalar forgetFactor, std::size_t numWindows, std::size_t driftWindows)
+{
+	const std::size_t windowLen = 100;
+
+	fl::anfis::Engine eng;
+	SetupEvolvingEngine(&eng, 1);
+	eng.getOutputVariable(0)->setRange(0, 3);
+
+	fl::anfis::EvolvingTakagiSugenoLearningAlgorithm ets(&eng, 0.3, forgetFactor);
+
+	Lcg rng(777);
+	std::vector<fl::scalar> rmses;
+	for (std::size_t w = 0; w < numWindows; ++w)
+	{
+		fl::scalar sse = 0;
+		std::size_t n = 0;
+		for (std::size_t k = 0; k < windowLen; ++k)
+		{
+			const fl::scalar t = std::min(static_cast<fl::scalar>(w*windowLen+k)/(driftWindows*windowLen), fl::scalar(1));
+			const fl::scalar in = rng.next();
+			const fl::scalar out = (1+t)*in+0.5;
+
+			// The prediction is made before the sample is learned
+			const std::vector<fl::scalar>& predOut = ets.learn(&in, &in+1, &out, &out+1);
+			if (!fl::Operation::isNaN(predOut[0]))
+			{
+				sse += (out-predOut[0])*(out-predOut[0]);
+				++n;
+			}
+		}
+		rmses.push_back(std::sqrt(sse/n));
+	}
+
+	return rmses;
+}
+
 } // Namespace detail
 
 
@@ -621,6 +809,187 @@ void TestFunctional()
 	}
 }
 
+/// Test training with the entries read in chunks from a data source
+void TestChunkedTraining()
+{
+	// Per-epoch state is reset once per epoch, so training chunk by chunk
+	// gives the same model as training with the whole training set
+
+	const fl::DataSet<fl::scalar> data = detail::MakeTrainingSet(60);
+	const FL_unique_ptr<fl::anfis::Engine> p_anfis = detail::BuildAnfis(data);
+
+	if (!detail::CheckChunkedTraining<fl::anfis::Jang1993HybridLearningAlgorithm>(*p_anfis, data, true))
+	{
+		throw std::runtime_error("Failed chunked training test: online hybrid learning");
+	}
+	if (!detail::CheckChunkedTraining<fl::anfis::LeastSquaresLearningAlgorithm>(*p_anfis, data, true))
+	{
+		throw std::runtime_error("Failed chunked training test: online least-squares learning");
+	}
+	if (!detail::CheckChunkedTraining<fl::anfis::Jang1993GradientDescentBackpropagationAlgorithm>(*p_anfis, data, false))
+	{
+		throw std::runtime_error("Failed chunked training test: offline gradient descent learning");
+	}
+}
+
+/// Test the evolution of the rule base of the eTS learning algorithm
+void TestEvolvingRuleBase()
+{
+	// Rules are added, moved and merged as a stream of samples visits regions of the input space
+	{
+		fl::anfis::Engine eng;
+		detail::SetupEvolvingEngine(&eng, 1);
+
+		fl::anfis::EvolvingTakagiSugenoLearningAlgorithm ets(&eng);
+
+		// The first sample becomes the center of the first rule, which then moves to the center of the data
+		detail::LearnAround(ets, 0.2, 1);
+		const fl::scalar firstCenter = detail::RuleCenter(eng, 0);
+		detail::LearnAround(ets, 0.2, 19);
+		if (ets.numberOfRules() != 1
+			|| eng.getRuleBlock(0)->numberOfRules() != 1
+			|| std::abs(detail::RuleCenter(eng, 0)-0.2) > 1e-6
+			|| std::abs(firstCenter-0.2) <= 1e-6)
+		{
+			throw std::runtime_error("Failed eTS rule-base test: move of the first rule");
+		}
+
+		// Samples far from the only rule add a new rule
+		detail::LearnAround(ets, 0.4, 20);
+		if (ets.numberOfRules() != 2 || eng.getRuleBlock(0)->numberOfRules() != 2)
+		{
+			throw std::runtime_error("Failed eTS rule-base test: addition of a rule");
+		}
+
+		// Samples between the rules move the nearest one
+		detail::LearnAround(ets, 0.3, 20);
+		if (ets.numberOfRules() != 2
+			|| (std::abs(detail::RuleCenter(eng, 0)-0.3) > 1e-6 && std::abs(detail::RuleCenter(eng, 1)-0.3) > 1e-6))
+		{
+			throw std::runtime_error("Failed eTS rule-base test: move of a rule");
+		}
+
+		// Samples that bring the centers close enough merge the rules
+		detail::LearnAround(ets, 0.34, 50);
+		if (ets.numberOfRules() != 1
+			|| eng.getRuleBlock(0)->numberOfRules() != 1
+			|| detail::RuleCenter(eng, 0) <= 0.3
+			|| detail::RuleCenter(eng, 0) >= 0.38)
+		{
+			throw std::runtime_error("Failed eTS rule-base test: merge of rules");
+		}
+	}
+
+	// The maximum number of rules bounds the rule base
+	{
+		const std::size_t maxRules = 3;
+
+		std::size_t numRules[2] = {0, 0};
+		for (std::size_t bounded = 0; bounded < 2; ++bounded)
+		{
+			fl::anfis::Engine eng;
+			detail::SetupEvolvingEngine(&eng, 2);
+
+			fl::anfis::EvolvingTakagiSugenoLearningAlgorithm ets(&eng, 0.2);
+			if (bounded)
+			{
+				ets.setMaxNumberOfRules(maxRules);
+			}
+
+			detail::Lcg rng(2024);
+			for (std::size_t k = 0; k < 300; ++k)
+			{
+				const fl::scalar in[2] = {rng.next(), rng.next()};
+				const fl::scalar out = 0.5*in[0]+0.3*in[1];
+
+				ets.learn(in, in+2, &out, &out+1);
+
+				numRules[bounded] = std::max(numRules[bounded], ets.numberOfRules());
+				if (ets.numberOfRules() != eng.getRuleBlock(0)->numberOfRules())
+				{
+					throw std::runtime_error("Failed eTS rule-base test: rules of the ANFIS model");
+				}
+			}
+		}
+		if (numRules[0] <= maxRules || numRules[1] != maxRules)
+		{
+			throw std::runtime_error("Failed eTS rule-base test: maximum number of rules");
+		}
+	}
+
+	// When the rule base is full, a far sample that would add a rule moves the nearest one instead
+	for (std::size_t bounded = 0; bounded < 2; ++bounded)
+	{
+		fl::anfis::Engine eng;
+		detail::SetupEvolvingEngine(&eng, 1);
+
+		fl::anfis::EvolvingTakagiSugenoLearningAlgorithm ets(&eng);
+		if (bounded)
+		{
+			ets.setMaxNumberOfRules(1);
+		}
+
+		// The far sample (at 0.88) has a lower potential than the center of the only rule
+		detail::LearnAround(ets, 0.2, 20);
+		detail::LearnAround(ets, 0.9, 1);
+		if (ets.numberOfRules() != 2-bounded
+			|| eng.getRuleBlock(0)->numberOfRules() != 2-bounded
+			|| std::abs(detail::RuleCenter(eng, ets.numberOfRules()-1)-0.88) > 1e-6)
+		{
+			throw std::runtime_error("Failed eTS rule-base test: far sample with a full rule base");
+		}
+	}
+}
+
+/// Test the eTS learning algorithm adapting a model identified offline and tracking a drifting process
+void TestEvolvingLearning()
+{
+	// The rules of a model built by subtractive clustering are kept
+	{
+		const fl::DataSet<fl::scalar> data = detail::MakeTrainingSet(60);
+
+		fl::SubtractiveClusteringFisBuilder<fl::anfis::Engine> builder;
+		FL_unique_ptr<fl::anfis::Engine> p_anfis = builder.build(data);
+		p_anfis->build();
+
+		const std::size_t numRules = p_anfis->getRuleBlock(0)->numberOfRules();
+
+		fl::anfis::EvolvingTakagiSugenoLearningAlgorithm ets(p_anfis.get());
+
+		const fl::DataSetEntry<fl::scalar> entry = *data.entryBegin();
+		const std::vector<fl::scalar> expectOut = p_anfis->eval(entry.inputBegin(), entry.inputEnd());
+		const std::vector<fl::scalar> actualOut = ets.learn(entry.inputBegin(), entry.inputEnd(), entry.outputBegin(), entry.outputEnd());
+
+		if (numRules == 0
+			|| ets.numberOfRules() < numRules
+			|| std::abs(actualOut[0]-expectOut[0]) > 1e-9*(1+std::abs(expectOut[0])))
+		{
+			throw std::runtime_error("Failed eTS learning test: import of a subtractive-clustering model");
+		}
+	}
+
+	// The prediction error of a model with forgetting decreases once a drifting process settles
+	{
+		const std::size_t numWindows = 10;
+		const std::size_t driftWindows = 5;
+
+		const std::vector<fl::scalar> rmses = detail::TrackDriftingProcess(0.95, numWindows, driftWindows);
+		const std::vector<fl::scalar> noForgetRmses = detail::TrackDriftingProcess(1, numWindows, driftWindows);
+
+		for (std::size_t w = driftWindows; w < numWindows; ++w)
+		{
+			if (rmses[w] >= rmses[w-1])
+			{
+				throw std::runtime_error("Failed eTS learning test: tracking of a drifting process");
+			}
+		}
+		if (rmses.back() >= rmses.front() || rmses.back() >= noForgetRmses.back())
+		{
+			throw std::runtime_error("Failed eTS learning test: forgetting of a drifting process");
+		}
+	}
+}
+
 } // Namespace <unnamed>
 
 
@@ -673,4 +1042,52 @@ int main()
 		std::cout << "KO => unexpected error";
 	}
 	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing chunked training... ";
+		TestChunkedTraining();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing eTS rule-base evolution... ";
+		TestEvolvingRuleBase();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing eTS learning... ";
+		TestEvolvingLearning();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
 }
@@ -23,6 +23,8 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <fl/fuzzylite.h>
 #include <fl/ann/activation_functions.h>
@@ -40,6 +42,8 @@
 #else // FL_CPP11
 # include <boost/random.hpp>
 #endif // FL_CPP11
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 
@@ -215,6 +219,95 @@ FL_unique_ptr< fl::ann::Network<ValueT> > MakeFeedforwardNetwork(std::size_t num
 	return MakeFeedforwardNetwork<ValueT>(numInputs, numHiddens.begin(), numHiddens.end(), numOutputs);
 }
 
+/// Throws a std::runtime_error with message \a msg if \a actual and \a expected differ by more than \a tol
+template <typename ValueT>
+void CheckEqual(ValueT actual, ValueT expected, const std::string& msg, ValueT tol = 0)
+{
+	if (!(std::abs(actual-expected) <= tol))
+	{
+		throw std::runtime_error(msg);
+	}
+}
+
+template <typename ValueT>
+void TestDenseWeights()
+{
+	const std::size_t numHiddens[] = {3, 2};
+
+	FL_unique_ptr< fl::ann::Network<ValueT> > p_nnet = MakeFeedforwardNetwork<ValueT>(2, numHiddens, numHiddens+2, 1);
+
+	// Layers connected by MakeFeedforwardNetwork are stored densely
+	for (std::size_t l = 1; l < p_nnet->numOfLayers(); ++l)
+	{
+		if (!p_nnet->getLayer(l)->isFullyConnected())
+		{
+			throw std::runtime_error("Failed dense weights test: layer not stored densely");
+		}
+	}
+
+	// Connections and biases are views of the weight matrix and of the bias vector
+	fl::ann::Layer<ValueT>* p_inLayer = p_nnet->getInputLayer();
+	fl::ann::Layer<ValueT>* p_hidLayer = p_nnet->getLayer(1);
+	for (std::size_t i = 0; i < p_hidLayer->numOfNeurons(); ++i)
+	{
+		p_hidLayer->getNeuron(i)->setBias(0.1*i);
+		for (std::size_t j = 0; j < p_inLayer->numOfNeurons(); ++j)
+		{
+			p_hidLayer->weightMatrix()[i][j] = 0.5*i-0.25*j;
+		}
+	}
+	for (std::size_t i = 0; i < p_hidLayer->numOfNeurons(); ++i)
+	{
+		CheckEqual<ValueT>(p_hidLayer->biasVector()[i], 0.1*i, "Failed dense weights test: wrong bias view");
+		for (std::size_t j = 0; j < p_inLayer->numOfNeurons(); ++j)
+		{
+			CheckEqual<ValueT>(p_nnet->getConnection(p_inLayer->getNeuron(j), p_hidLayer->getNeuron(i))->getWeight(), 0.5*i-0.25*j, "Failed dense weights test: wrong weight view");
+		}
+	}
+
+	// The matrix-vector product gives the same outputs as neuron-wise processing
+	std::vector<ValueT> input(2);
+	input[0] = 0.3;
+	input[1] = -0.7;
+	p_nnet->process(input.begin(), input.end());
+	for (std::size_t i = 0; i < p_hidLayer->numOfNeurons(); ++i)
+	{
+		fl::ann::Neuron<ValueT>* p_neuron = p_hidLayer->getNeuron(i);
+
+		const std::vector<ValueT> inputs = p_neuron->inputs();
+		const std::vector<ValueT> weights = p_neuron->weights();
+		ValueT netIn = p_neuron->getBias();
+		for (std::size_t j = 0; j < inputs.size(); ++j)
+		{
+			netIn += weights[j]*inputs[j];
+		}
+		const ValueT out = p_neuron->getActivationFunction()->eval(netIn);
+
+		CheckEqual<ValueT>(p_neuron->getOutput(), out, "Failed dense weights test: wrong matrix-vector outputs", 1e-12);
+	}
+
+	// A skip connection turns the output layer back to per-connection storage, keeping its weights
+	fl::ann::Layer<ValueT>* p_prevLayer = p_nnet->getLayer(p_nnet->numOfLayers()-2);
+	fl::ann::Layer<ValueT>* p_outLayer = p_nnet->getOutputLayer();
+	for (std::size_t j = 0; j < p_prevLayer->numOfNeurons(); ++j)
+	{
+		p_outLayer->weightMatrix()[0][j] = 1+j;
+	}
+	p_nnet->connect(p_inLayer->getNeuron(0), p_outLayer->getNeuron(0), -1);
+	if (p_outLayer->isFullyConnected() || p_outLayer->getNeuron(0)->weights().size() != p_prevLayer->numOfNeurons()+1)
+	{
+		throw std::runtime_error("Failed dense weights test: skip connection not stored per connection");
+	}
+	for (std::size_t j = 0; j < p_prevLayer->numOfNeurons(); ++j)
+	{
+		CheckEqual<ValueT>(p_nnet->getConnection(p_prevLayer->getNeuron(j), p_outLayer->getNeuron(0))->getWeight(), 1.0+j, "Failed dense weights test: weights lost by the skip connection");
+	}
+	if (!p_hidLayer->isFullyConnected())
+	{
+		throw std::runtime_error("Failed dense weights test: hidden layer no longer stored densely");
+	}
+}
+
 } // Namespace detail
 
 
@@ -228,6 +321,18 @@ int main()
     const double maxError = 0.01f;
     const std::size_t maxEpochs = 5000;
 
+	try
+	{
+		std::cout << "- Testing dense weight storage... ";
+		detail::TestDenseWeights<double>();
+		std::cout << "OK" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what() << std::endl;
+		return 1;
+	}
+
 	FL_unique_ptr< fl::ann::Network<double> > p_nnet = detail::MakeFeedforwardNetwork<double>(numInputs, numLayersHidden, numNeuronsHidden, numOutputs);
 
 	std::cout << "Neural Network" << std::endl
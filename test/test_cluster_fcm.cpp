@@ -0,0 +1,347 @@
+/**
+ * \file test/test_cluster_fcm.cpp
+ *
+ * \brief Test suite for fuzzy c-means clustering.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+#include <cstddef>
+#include <fl/cluster/fuzzy_cmeans.h>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace /*<unnnamed>*/ {
+
+namespace detail {
+
+/// Makes \a nr points of dimension \a nc, spread in 5 well-separated blobs
+std::vector< std::vector<fl::scalar> > MakeBlobData(std::size_t nr, std::size_t nc)
+{
+	std::vector< std::vector<fl::scalar> > data(nr, std::vector<fl::scalar>(nc));
+	unsigned long seed = 12345;
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			// Small linear congruential generator to get the same data everywhere
+			seed = (seed*1103515245UL+12345UL) % 2147483648UL;
+			const fl::scalar u = static_cast<fl::scalar>(seed)/2147483648.0;
+			data[i][j] = (i % 5)*(j+1) + 0.3*u;
+		}
+	}
+
+	return data;
+}
+
+/// Runs the textbook fuzzy c-means iterations from the centers \a C, one data point at a time
+void NaiveFuzzyCMeans(const std::vector< std::vector<fl::scalar> >& data,
+					  fl::scalar m,
+					  std::size_t numIters,
+					  std::vector< std::vector<fl::scalar> >& C)
+{
+	const std::size_t nr = data.size();
+	const std::size_t nc = data[0].size();
+	const std::size_t ncl = C.size();
+
+	std::vector< std::vector<fl::scalar> > U(nr, std::vector<fl::scalar>(ncl));
+	for (std::size_t it = 0; it < numIters; ++it)
+	{
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			std::vector<fl::scalar> d(ncl, 0);
+			for (std::size_t k = 0; k < ncl; ++k)
+			{
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					d[k] += (data[i][j]-C[k][j])*(data[i][j]-C[k][j]);
+				}
+			}
+			for (std::size_t k = 0; k < ncl; ++k)
+			{
+				fl::scalar s = 0;
+				for (std::size_t l = 0; l < ncl; ++l)
+				{
+					s += std::pow(d[k]/d[l], 1.0/(m-1));
+				}
+				U[i][k] = 1.0/s;
+			}
+		}
+		for (std::size_t k = 0; k < ncl; ++k)
+		{
+			fl::scalar den = 0;
+			std::vector<fl::scalar> num(nc, 0);
+			for (std::size_t i = 0; i < nr; ++i)
+			{
+				const fl::scalar w = std::pow(U[i][k], m);
+				den += w;
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					num[j] += w*data[i][j];
+				}
+			}
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				C[k][j] = num[j]/den;
+			}
+		}
+	}
+}
+
+bool CheckEqual(fl::scalar x, fl::scalar y, fl::scalar tol)
+{
+	return std::abs(x-y) <= tol*std::max(fl::scalar(1), std::max(std::abs(x), std::abs(y)));
+}
+
+bool CheckEqual(const std::vector< std::vector<fl::scalar> >& A1, const std::vector< std::vector<fl::scalar> >& A2, fl::scalar tol)
+{
+	if (A1.size() != A2.size())
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0,
+					 nr = A1.size();
+		 i < nr;
+		 ++i)
+	{
+		if (A1[i].size() != A2[i].size())
+		{
+			return false;
+		}
+
+		for (std::size_t j = 0,
+						 nc = A1[i].size();
+			 j < nc;
+			 ++j)
+		{
+			if (!CheckEqual(A1[i][j], A2[i][j], tol))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+} // Namespace detail
+
+
+/// Test construction and parameter checks
+void TestConstruction()
+{
+	fl::cluster::FuzzyCMeansClustering fcm(3);
+
+	if (fcm.getNumOfClusters() != 3
+		|| fcm.getExponent() != 2
+		|| fcm.numOfClusters() != 0
+		|| fcm.centers().size() != 0
+		|| fcm.numOfIterations() != 0)
+	{
+		throw std::runtime_error("Failed construction test: default parameters");
+	}
+
+	bool thrown = false;
+	try
+	{
+		fcm.setExponent(1);
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+	{
+		throw std::runtime_error("Failed construction test: invalid exponent accepted");
+	}
+
+	thrown = false;
+	try
+	{
+		fcm.setNumOfClusters(0);
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+	{
+		throw std::runtime_error("Failed construction test: invalid number of clusters accepted");
+	}
+}
+
+/// Test the iterations against a straightforward implementation
+void TestIterations()
+{
+	const std::vector< std::vector<fl::scalar> > data = detail::MakeBlobData(600, 3);
+
+	const fl::scalar exponents[] = {2, 1.7};
+	for (std::size_t e = 0; e < 2; ++e)
+	{
+		// Initial centers are moved off the data points, where the textbook
+		// formula for membership degrees is undefined
+		std::vector< std::vector<fl::scalar> > init;
+		for (std::size_t k = 0; k < 4; ++k)
+		{
+			init.push_back(data[k*7]);
+			init.back()[0] += 0.01;
+		}
+
+		fl::cluster::FuzzyCMeansClustering fcm(4);
+		fcm.setExponent(exponents[e]);
+		fcm.setInitialCenters(init);
+		fcm.setMaxIterations(10);
+		fcm.setTolerance(0);
+		fcm.cluster(data);
+
+		std::vector< std::vector<fl::scalar> > expect = init;
+		detail::NaiveFuzzyCMeans(data, exponents[e], 10, expect);
+
+		if (fcm.numOfIterations() != 10 || !detail::CheckEqual(fcm.centers(), expect, 1e-9))
+		{
+			throw std::runtime_error("Failed iterations test: centers differ from the straightforward implementation");
+		}
+
+		const std::vector< std::vector<fl::scalar> > U = fcm.memberships();
+		for (std::size_t i = 0; i < U.size(); ++i)
+		{
+			fl::scalar sum = 0;
+			for (std::size_t k = 0; k < U[i].size(); ++k)
+			{
+				sum += U[i][k];
+			}
+			if (!detail::CheckEqual(sum, 1, 1e-12))
+			{
+				throw std::runtime_error("Failed iterations test: memberships do not sum to one");
+			}
+		}
+	}
+}
+
+/// Test the clusters found with the k-means++ seeding
+void TestFunctional()
+{
+	const std::size_t nr = 2000;
+	const std::size_t nc = 2;
+
+	const std::vector< std::vector<fl::scalar> > data = detail::MakeBlobData(nr, nc);
+
+	fl::cluster::FuzzyCMeansClustering fcm(5);
+	fcm.cluster(data);
+
+	// Each blob (whose points are uniform in a box with side 0.3) must have a
+	// center close to its middle point
+	const std::vector< std::vector<fl::scalar> > centers = fcm.centers();
+	const std::vector< std::vector<fl::scalar> > spreads = fcm.spreads();
+	for (std::size_t b = 0; b < 5; ++b)
+	{
+		bool found = false;
+		for (std::size_t k = 0; k < centers.size() && !found; ++k)
+		{
+			found = true;
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				found = found && std::abs(centers[k][j]-(b*(j+1)+0.15)) < 0.05;
+			}
+		}
+		if (!found)
+		{
+			throw std::runtime_error("Failed functional test: blob without center");
+		}
+	}
+	for (std::size_t k = 0; k < centers.size(); ++k)
+	{
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			// The standard deviation of a uniform distribution with width 0.3 is about 0.087
+			if (spreads[k][j] <= 0 || spreads[k][j] > 0.2)
+			{
+				throw std::runtime_error("Failed functional test: wrong spread");
+			}
+		}
+	}
+
+	// The same seed gives the same clusters
+	fl::cluster::FuzzyCMeansClustering fcm2(5);
+	fcm2.cluster(data);
+	if (!detail::CheckEqual(fcm2.centers(), centers, 0))
+	{
+		throw std::runtime_error("Failed functional test: results not reproducible");
+	}
+}
+
+} // Namespace <unnamed>
+
+
+int main()
+{
+	try
+	{
+		std::cout << "- Testing construction... ";
+		TestConstruction();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing iterations... ";
+		TestIterations();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing functional behavior... ";
+		TestFunctional();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+}
@@ -23,12 +23,19 @@
  */
 
 
+#include <cmath>
 #include <cstddef>
+#include <cstdio>
 #include <fl/cluster/subtractive.h>
+#include <fl/cluster/subtractive_sweep.h>
+#include <fl/data_source.h>
+#include <fl/dataset.h>
 #include <fl/detail/traits.h>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 
@@ -38,7 +45,7 @@ namespace detail {
 
 const double DefaultTolerance = std::numeric_limits<double>::epsilon()*100.0;
 
-void Setup(fl::cluster::SubtractiveClustering& subclust)
+std::vector< std::vector<fl::scalar> > MakeTripData()
 {
 	// The Trip Generation Data as found in (Chiu, 1994)
 	double data[][6] = {{0.038, 0.032, 0.019, 11.429, 16.439, 8.460},
@@ -126,11 +133,79 @@ void Setup(fl::cluster::SubtractiveClustering& subclust)
 		dataset[i].assign(data[i], data[i]+nc);
 	}
 
+	return dataset;
+}
+
+/// Makes \a nr points of dimension \a nc, spread in 5 well-separated blobs
+std::vector< std::vector<fl::scalar> > MakeBlobData(std::size_t nr, std::size_t nc)
+{
+	std::vector< std::vector<fl::scalar> > data(nr, std::vector<fl::scalar>(nc));
+	unsigned long seed = 12345;
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			// Small linear congruential generator to get the same data everywhere
+			seed = (seed*1103515245UL+12345UL) % 2147483648UL;
+			const fl::scalar u = static_cast<fl::scalar>(seed)/2147483648.0;
+			data[i][j] = (i % 5)*(j+1) + 0.3*u;
+		}
+	}
+
+	return data;
+}
+
+/// Makes \a nr points of dimension \a nc, uniformly spread in the unit hypercube
+std::vector< std::vector<fl::scalar> > MakeUniformData(std::size_t nr, std::size_t nc, unsigned long seed)
+{
+	std::vector< std::vector<fl::scalar> > data(nr, std::vector<fl::scalar>(nc));
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		for (std::size_t j = 0; j < nc; ++j)
+		{
+			seed = (seed*1103515245UL+12345UL) % 2147483648UL;
+			data[i][j] = static_cast<fl::scalar>(seed)/2147483648.0;
+		}
+	}
+
+	return data;
+}
+
+/// Computes the potentials of the points of \a data (already in the unit hypercube) pair by pair
+std::vector<fl::scalar> ReferencePotentials(const std::vector< std::vector<fl::scalar> >& data, fl::scalar radius)
+{
+	const std::size_t nr = data.size();
+	const fl::scalar alpha = 4.0/(radius*radius);
+
+	std::vector<fl::scalar> potentials(nr, 0);
+	for (std::size_t i = 0; i < nr; ++i)
+	{
+		for (std::size_t k = 0; k < nr; ++k)
+		{
+			fl::scalar distSq = 0;
+			for (std::size_t j = 0; j < data[i].size(); ++j)
+			{
+				distSq += (data[i][j]-data[k][j])*(data[i][j]-data[k][j]);
+			}
+			potentials[i] += std::exp(-alpha*distSq);
+		}
+	}
+
+	return potentials;
+}
+
+void Configure(fl::cluster::SubtractiveClustering& subclust)
+{
 	subclust.setRadii(0.5, 6);
 	subclust.setAcceptanceRatio(0.5);
 	subclust.setRejectionRatio(0.15);
 	subclust.setSquashingFactor(1.25);
-	subclust.cluster(dataset);
+}
+
+void Setup(fl::cluster::SubtractiveClustering& subclust)
+{
+	Configure(subclust);
+	subclust.cluster(MakeTripData());
 }
 
 template <typename T>
@@ -305,6 +380,279 @@ void TestFunctional()
 	}
 }
 
+/// Test the computation of potentials against a pair-by-pair reference
+void TestPotentials()
+{
+	const std::size_t nc = 3;
+	const fl::scalar radius = 0.5;
+	const std::vector<fl::scalar> lbounds(nc, 0);
+	const std::vector<fl::scalar> ubounds(nc, 1);
+
+	// Sizes around and not multiple of the size of the kernel tiles
+	const std::size_t sizes[] = {1, 2, 255, 256, 257, 700};
+	for (std::size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+	{
+		const std::size_t nr = sizes[s];
+
+		const std::vector< std::vector<fl::scalar> > data = detail::MakeUniformData(nr, nc, 54321+s);
+		const std::vector<fl::scalar> expect = detail::ReferencePotentials(data, radius);
+
+		fl::cluster::SubtractiveClustering subclust;
+		subclust.setRadii(radius, nc);
+		subclust.setBounds(lbounds, ubounds);
+
+		if (!detail::CheckEqual(subclust.potentials(data), expect, 1e-10))
+		{
+			throw std::runtime_error("Failed potentials test: exact potentials differ from reference");
+		}
+
+		// Each potential neglects less than the tolerance for each data point
+		const fl::scalar tol = 1e-12;
+		subclust.setCutoffTolerance(tol);
+		const std::vector<fl::scalar> potentials = subclust.potentials(data);
+		if (potentials.size() != nr)
+		{
+			throw std::runtime_error("Failed potentials test: number of potentials in cutoff mode");
+		}
+		for (std::size_t i = 0; i < nr; ++i)
+		{
+			if (potentials[i] > expect[i]*(1+1e-10) || potentials[i] < expect[i]-tol*nr)
+			{
+				throw std::runtime_error("Failed potentials test: cutoff potentials differ from reference");
+			}
+		}
+	}
+}
+
+/// Test the cutoff mode
+void TestCutoff()
+{
+	// Trip data: neglected contributions are negligible
+	{
+		fl::cluster::SubtractiveClustering exact;
+		detail::Setup(exact);
+
+		fl::cluster::SubtractiveClustering subclust;
+		subclust.setCutoffTolerance(1e-12);
+		detail::Setup(subclust);
+
+		if (subclust.numOfClusters() != exact.numOfClusters()
+			|| !detail::CheckEqual(subclust.centers(), exact.centers(), 1e-10))
+		{
+			throw std::runtime_error("Failed cutoff test: cluster centers on trip data");
+		}
+		if (exact.cutoffErrorBound() != 0
+			|| subclust.cutoffErrorBound() < 0
+			|| subclust.cutoffErrorBound() > 1e-12*75*(1+subclust.numOfClusters()))
+		{
+			throw std::runtime_error("Failed cutoff test: error bound on trip data");
+		}
+	}
+
+	// Well-separated blobs with small radii: most of the pairs are neglected
+	{
+		const std::size_t nr = 2000;
+		const std::size_t nc = 2;
+
+		const std::vector< std::vector<fl::scalar> > data = detail::MakeBlobData(nr, nc);
+
+		fl::cluster::SubtractiveClustering exact;
+		exact.setRadii(0.1, nc);
+		exact.cluster(data);
+
+		fl::cluster::SubtractiveClustering subclust;
+		subclust.setRadii(0.1, nc);
+		subclust.setCutoffTolerance(1e-8);
+		subclust.cluster(data);
+
+		if (subclust.numOfClusters() != exact.numOfClusters()
+			|| !detail::CheckEqual(subclust.centers(), exact.centers(), 1e-10))
+		{
+			throw std::runtime_error("Failed cutoff test: cluster centers on blobs");
+		}
+		if (subclust.cutoffErrorBound() <= 0
+			|| subclust.cutoffErrorBound() > 1e-8*nr*(1+subclust.numOfClusters()))
+		{
+			throw std::runtime_error("Failed cutoff test: error bound on blobs");
+		}
+	}
+
+	// Invalid tolerance
+	{
+		fl::cluster::SubtractiveClustering subclust;
+
+		bool thrown = false;
+		try
+		{
+			subclust.setCutoffTolerance(-1);
+		}
+		catch (const std::invalid_argument&)
+		{
+			thrown = true;
+		}
+		if (!thrown)
+		{
+			throw std::runtime_error("Failed cutoff test: negative tolerance");
+		}
+	}
+}
+
+/// Test streaming clustering
+void TestStream()
+{
+	// With a fine enough summary, each data point is its own representative
+	{
+		const std::vector< std::vector<fl::scalar> > data = detail::MakeTripData();
+
+		fl::cluster::SubtractiveClustering batch;
+		detail::Setup(batch);
+
+		fl::DataSet<fl::scalar> dataSet(data[0].size(), 0);
+		for (std::size_t i = 0; i < data.size(); ++i)
+		{
+			dataSet.add(data[i].begin(), data[i].end(), data[i].end(), data[i].end());
+		}
+		fl::DataSetSource<fl::scalar> source(dataSet, 10);
+
+		fl::cluster::SubtractiveClustering subclust;
+		detail::Configure(subclust);
+		subclust.setSummaryResolution(1e-6);
+		subclust.clusterStream(source);
+
+		if (subclust.numOfClusters() != batch.numOfClusters()
+			|| !detail::CheckEqual(subclust.centers(), batch.centers(), 1e-10)
+			|| !detail::CheckEqual(subclust.rangeOfInfluence(), batch.rangeOfInfluence(), 1e-10))
+		{
+			throw std::runtime_error("Failed streaming test: fine summary");
+		}
+	}
+
+	// Text stream with a coarse summary and refinement: centers are data points close to the batch ones
+	{
+		const std::size_t nr = 2000;
+		const std::size_t nc = 2;
+
+		const std::vector< std::vector<fl::scalar> > data = detail::MakeBlobData(nr, nc);
+
+		fl::cluster::SubtractiveClustering batch;
+		batch.setRadii(0.1, nc);
+		batch.cluster(data);
+
+		const std::string fname = "test_cluster_subtractive.txt";
+		{
+			std::ofstream ofs(fname.c_str());
+			ofs.precision(17);
+			for (std::size_t i = 0; i < nr; ++i)
+			{
+				for (std::size_t j = 0; j < nc; ++j)
+				{
+					ofs << (j > 0 ? " " : "") << data[i][j];
+				}
+				ofs << "\n";
+			}
+		}
+
+		fl::cluster::SubtractiveClustering subclust;
+		subclust.setRadii(0.1, nc);
+		subclust.setSummaryResolution(0.1);
+		try
+		{
+			fl::TextDataSource<fl::scalar> source(fname, fl::DataSetReader(), 4096);
+			subclust.clusterStream(source, true);
+		}
+		catch (...)
+		{
+			std::remove(fname.c_str());
+			throw;
+		}
+		std::remove(fname.c_str());
+
+		if (subclust.numOfClusters() != batch.numOfClusters())
+		{
+			throw std::runtime_error("Failed streaming test: number of clusters with coarse summary");
+		}
+
+		const std::vector< std::vector<fl::scalar> > centers = subclust.centers();
+		const std::vector< std::vector<fl::scalar> > batchCenters = batch.centers();
+		const std::vector<fl::scalar> sigma = batch.rangeOfInfluence();
+		for (std::size_t k = 0; k < centers.size(); ++k)
+		{
+			bool found = false;
+			for (std::size_t i = 0; i < nr && !found; ++i)
+			{
+				found = detail::CheckEqual(centers[k], data[i], 1e-10);
+			}
+			if (!found)
+			{
+				throw std::runtime_error("Failed streaming test: refined center is not a data point");
+			}
+
+			// Sigma is sqrt(1/8) radii
+			for (std::size_t j = 0; j < nc; ++j)
+			{
+				if (std::abs(centers[k][j]-batchCenters[k][j]) > sigma[j])
+				{
+					throw std::runtime_error("Failed streaming test: refined center far from batch center");
+				}
+			}
+		}
+	}
+}
+
+/// Test the sweep over a grid of parameter settings
+void TestSweep()
+{
+	const std::size_t nr = 500;
+	const std::size_t nc = 2;
+
+	const std::vector< std::vector<fl::scalar> > data = detail::MakeBlobData(nr, nc);
+
+	std::vector<fl::scalar> radii;
+	radii.push_back(0.1);
+	radii.push_back(0.3);
+	std::vector<fl::scalar> squashFactors;
+	squashFactors.push_back(1.25);
+	squashFactors.push_back(1.5);
+	std::vector<fl::scalar> acceptRatios;
+	acceptRatios.push_back(0.5);
+	acceptRatios.push_back(0.7);
+
+	fl::cluster::SubtractiveClusteringSweep sweep;
+	sweep.setRadii(radii);
+	sweep.setSquashingFactors(squashFactors);
+	sweep.setAcceptanceRatios(acceptRatios);
+	sweep.cluster(data);
+
+	const std::vector<fl::cluster::SubtractiveClustering>& results = sweep.results();
+	if (sweep.numOfSettings() != 8 || results.size() != 8)
+	{
+		throw std::runtime_error("Failed sweep test: number of settings");
+	}
+
+	// Each result must be the same as the one of a separate clustering
+	std::size_t k = 0;
+	for (std::size_t r = 0; r < radii.size(); ++r)
+	{
+		for (std::size_t s = 0; s < squashFactors.size(); ++s)
+		{
+			for (std::size_t a = 0; a < acceptRatios.size(); ++a)
+			{
+				fl::cluster::SubtractiveClustering subclust;
+				subclust.setRadii(radii[r], nc);
+				subclust.setSquashingFactor(squashFactors[s]);
+				subclust.setAcceptanceRatio(acceptRatios[a]);
+				subclust.cluster(data);
+
+				if (!detail::CheckEqual(results[k], subclust, 1e-10))
+				{
+					throw std::runtime_error("Failed sweep test: results differ from separate clusterings");
+				}
+				++k;
+			}
+		}
+	}
+}
+
 } // Namespace <unnamed>
 
 
@@ -357,4 +705,68 @@ int main()
 		std::cout << "KO => unexpected error";
 	}
 	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing potentials... ";
+		TestPotentials();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing cutoff mode... ";
+		TestCutoff();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing streaming clustering... ";
+		TestStream();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing sweep over parameter settings... ";
+		TestSweep();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
 }
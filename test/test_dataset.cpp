@@ -0,0 +1,1084 @@
+/**
+ * \file test/test_dataset.cpp
+ *
+ * \brief Test suite for datasets.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <fl/binary_dataset.h>
+#include <fl/data_source.h>
+#include <fl/compact_dataset.h>
+#include <fl/dataset.h>
+#include <fl/dataset_statistics.h>
+#include <fl/dataset_reader.h>
+#include <fl/time_series_dataset.h>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef FL_CPP11
+# include <random>
+#else
+# include <boost/random/mersenne_twister.hpp>
+#endif // FL_CPP11
+
+
+namespace /*<unnnamed>*/ {
+
+namespace detail {
+
+#ifdef FL_CPP11
+typedef std::mt19937 Urng;
+#else
+typedef boost::random::mt19937 Urng;
+#endif // FL_CPP11
+
+/// Makes a dataset of n entries with 2 inputs [k, 10*k] and 1 output [100*k]
+fl::DataSet<double> Setup(std::size_t n)
+{
+	fl::DataSet<double> data(2, 1);
+
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		const double in[] = {double(k), 10.0*k};
+		const double out[] = {100.0*k};
+
+		data.add(fl::DataSetEntry<double>(in, in+2, out, out+1));
+	}
+
+	return data;
+}
+
+/// Collects the entries of the visited chunks
+struct ChunkCollector
+{
+	ChunkCollector()
+	: data(2, 1),
+	  numOfChunks(0)
+	{
+	}
+
+	void operator()(const fl::DataSet<double>& chunk)
+	{
+		if (chunk.empty())
+		{
+			throw std::runtime_error("Empty chunk");
+		}
+		for (std::size_t i = 0; i < chunk.size(); ++i)
+		{
+			data.add(chunk.get(i));
+		}
+		labels = chunk.labels();
+		++numOfChunks;
+	}
+
+	fl::DataSet<double> data;
+	std::vector<std::string> labels;
+	std::size_t numOfChunks;
+};
+
+/// Throws an object of type T at the given chunk
+template <typename T>
+struct ChunkThrower
+{
+	explicit ChunkThrower(std::size_t chunk)
+	: chunk(chunk),
+	  numOfChunks(0)
+	{
+	}
+
+	void operator()(const fl::DataSet<double>&)
+	{
+		if (numOfChunks++ == chunk)
+		{
+			throw T();
+		}
+	}
+
+	std::size_t chunk;
+	std::size_t numOfChunks;
+};
+
+/// An exception not derived from std::exception
+struct ChunkError
+{
+};
+
+} // Namespace detail
+
+/// Test the contiguous storage and the pointer access
+void TestStorage()
+{
+	const std::size_t n = 5;
+
+	fl::DataSet<double> data = detail::Setup(n);
+
+	if (data.size() != n || data.stride() != 3)
+	{
+		throw std::runtime_error("Failed storage test: wrong size");
+	}
+
+	const double* p = data.rawData();
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		if (p[k*3] != k || p[k*3+1] != 10.0*k || p[k*3+2] != 100.0*k)
+		{
+			throw std::runtime_error("Failed storage test: wrong raw values");
+		}
+		if (data.inputs(k) != p+k*3 || data.outputs(k) != p+k*3+2)
+		{
+			throw std::runtime_error("Failed storage test: wrong entry pointers");
+		}
+	}
+
+	// Add without intermediate entries
+	const std::vector<double> in(2, 7);
+	const std::vector<double> out(1, 8);
+	data.add(in.begin(), in.end(), out.begin(), out.end());
+	if (data.size() != n+1 || data.inputs(n)[1] != 7 || data.outputs(n)[0] != 8)
+	{
+		throw std::runtime_error("Failed storage test: wrong added entry");
+	}
+
+	bool failed = true;
+	try
+	{
+		data.add(in.begin(), in.begin()+1, out.begin(), out.end());
+	}
+	catch (const std::invalid_argument&)
+	{
+		failed = false;
+	}
+	if (failed || data.size() != n+1 || data.data().size() != n+1)
+	{
+		throw std::runtime_error("Failed storage test: wrong entry accepted");
+	}
+}
+
+/// Test the entry iterators and views
+void TestEntries()
+{
+	const std::size_t n = 5;
+
+	fl::DataSet<double> data = detail::Setup(n);
+
+	// Forward and reverse iteration
+	std::size_t k = 0;
+	for (fl::DataSet<double>::ConstEntryIterator it = data.entryBegin(),
+												 endIt = data.entryEnd();
+		 it != endIt;
+		 ++it, ++k)
+	{
+		const fl::DataSetEntry<double>& entry = *it;
+
+		if (!entry.isView() || entry.numOfInputs() != 2 || entry.numOfOutputs() != 1 || entry.getField(2) != 100.0*k)
+		{
+			throw std::runtime_error("Failed entries test: wrong entry");
+		}
+	}
+	if (k != n || (data.entryEnd()-data.entryBegin()) != static_cast<std::ptrdiff_t>(n))
+	{
+		throw std::runtime_error("Failed entries test: wrong number of iterated entries");
+	}
+	if ((*data.entryRBegin()).getInput(0) != n-1)
+	{
+		throw std::runtime_error("Failed entries test: wrong reverse iteration");
+	}
+
+	// Views write through to the dataset, while copies made with iterators do not
+	fl::DataSetEntry<double> view = data.get(1);
+	fl::DataSetEntry<double> copy(view.inputBegin(), view.inputEnd(), view.outputBegin(), view.outputEnd());
+	const double newOut[] = {-1};
+	view.setOutputs(newOut, newOut+1);
+	copy.setInputs(newOut, newOut+1);
+	if (data.outputs(1)[0] != -1 || copy.isView() || copy.numOfInputs() != 1 || copy.getOutput(0) != 100)
+	{
+		throw std::runtime_error("Failed entries test: wrong view semantics");
+	}
+
+	// Set, insert and erase, also with views of the dataset itself
+	data.set(data.get(0), 2);
+	if (data.inputs(2)[1] != 0)
+	{
+		throw std::runtime_error("Failed entries test: wrong set");
+	}
+	data.add(data.get(3));
+	data.insert(data.entryBegin(), data.get(4));
+	if (data.size() != n+2 || data.inputs(0)[0] != 4 || data.inputs(n+1)[0] != 3)
+	{
+		throw std::runtime_error("Failed entries test: wrong add or insert");
+	}
+	fl::DataSet<double>::EntryIterator it = data.erase(data.entryBegin()+1);
+	if (data.size() != n+1 || (*it).getInput(0) != 1)
+	{
+		throw std::runtime_error("Failed entries test: wrong erase");
+	}
+}
+
+/// Test the matrix views
+void TestMatrix()
+{
+	const std::size_t n = 5;
+
+	fl::DataSet<double> data = detail::Setup(n);
+
+	const std::vector< std::vector<double> > copy = data.data();
+	const fl::DataSet<double>::ConstDataMatrix A = data.matrix();
+	const fl::DataSet<double>::ConstDataMatrix X = data.inputMatrix();
+	const fl::DataSet<double>::ConstDataMatrix Y = data.outputMatrix();
+
+	if (A.size() != n || A[0].size() != 3 || X[0].size() != 2 || Y[0].size() != 1)
+	{
+		throw std::runtime_error("Failed matrix test: wrong size");
+	}
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		for (std::size_t j = 0; j < 3; ++j)
+		{
+			if (A[i][j] != copy[i][j] || (j < 2 ? X[i][j] : Y[i][j-2]) != copy[i][j])
+			{
+				throw std::runtime_error("Failed matrix test: wrong values");
+			}
+		}
+	}
+
+	// The view refers to the dataset values
+	data.matrix()[1][2] = -1;
+	if (A.data() != data.rawData() || A[1][2] != -1)
+	{
+		throw std::runtime_error("Failed matrix test: values are not shared");
+	}
+}
+
+/// Test the slices, the index views and the shuffled views
+void TestViews()
+{
+	const std::size_t n = 10;
+
+	fl::DataSet<double> data = detail::Setup(n);
+
+	// Contiguous range
+	fl::DataSet<double> range = data.slice(2, 5);
+	if (range.size() != 3 || !range.isView() || !range.isContiguous() || range.inputs(0) != data.inputs(2))
+	{
+		throw std::runtime_error("Failed views test: wrong range");
+	}
+
+	// Strided subset, and a slice of it
+	const fl::DataSet<double> strided = data.slice(1, n, 3);
+	if (strided.size() != 3 || strided.isContiguous() || strided.get(2).getInput(0) != 7)
+	{
+		throw std::runtime_error("Failed views test: wrong strided view");
+	}
+	const fl::DataSet<double> sub = strided.slice(1, 3);
+	if (sub.size() != 2 || sub.get(0).getInput(0) != 4 || sub.get(1).getOutput(0) != 700)
+	{
+		throw std::runtime_error("Failed views test: wrong slice of a strided view");
+	}
+
+	// Index view, and the matrix of an index view
+	const std::size_t idx[] = {8, 0, 8, 3};
+	const fl::DataSet<double> sel = data.select(idx, idx+4);
+	const fl::DataSet<double>::ConstDataMatrix X = sel.inputMatrix();
+	if (sel.size() != 4 || X.size() != 4 || X[0][0] != 8 || X[1][1] != 0 || X[3][1] != 30 || sel.outputMatrix()[2][0] != 800)
+	{
+		throw std::runtime_error("Failed views test: wrong index view");
+	}
+	std::size_t k = 0;
+	for (fl::DataSet<double>::ConstEntryIterator it = sel.entryBegin(),
+												 endIt = sel.entryEnd();
+		 it != endIt;
+		 ++it, ++k)
+	{
+		if ((*it).getInput(0) != idx[k])
+		{
+			throw std::runtime_error("Failed views test: wrong index view iteration");
+		}
+	}
+
+	// Views share the values of the viewed dataset
+	range.inputs(1)[0] = -3;
+	if (data.get(3).getInput(0) != -3 || sel.get(3).getInput(0) != -3)
+	{
+		throw std::runtime_error("Failed views test: values are not shared");
+	}
+
+	// Views of a const dataset are read-only: writing through a copy copies the entries first
+	const fl::DataSet<double>& cdata = data;
+	fl::DataSet<double> cslice = cdata.slice(2, 5);
+	fl::DataSet<double> csub = cslice.slice(1, 2);
+	if (static_cast<const fl::DataSet<double>&>(cslice).inputs(0) != cdata.inputs(2))
+	{
+		throw std::runtime_error("Failed views test: read-only view copied on read");
+	}
+	cslice.inputs(0)[0] = -2;
+	csub.set(data.get(0), 0);
+	if (data.get(2).getInput(0) != 2 || data.get(3).getInput(0) != -3 || cslice.isView() || cslice.get(0).getInput(0) != -2 || csub.isView())
+	{
+		throw std::runtime_error("Failed views test: const dataset written through a view");
+	}
+
+	// Shuffled views are seeded permutations
+	detail::Urng urng1(1);
+	detail::Urng urng2(1);
+	const fl::DataSet<double> shuf1 = data.shuffled(urng1);
+	const fl::DataSet<double> shuf2 = data.shuffled(urng2);
+	const fl::DataSet<double> shuf3 = data.shuffled(urng1);
+	std::vector<double> perm1;
+	std::vector<double> perm3;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (shuf1.get(i).getOutput(0) != shuf2.get(i).getOutput(0))
+		{
+			throw std::runtime_error("Failed views test: shuffling is not reproducible");
+		}
+		perm1.push_back(shuf1.get(i).getOutput(0));
+		perm3.push_back(shuf3.get(i).getOutput(0));
+	}
+	if (perm1 == perm3)
+	{
+		throw std::runtime_error("Failed views test: shuffled epochs have the same order");
+	}
+	std::sort(perm1.begin(), perm1.end());
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (perm1[i] != 100.0*i)
+		{
+			throw std::runtime_error("Failed views test: shuffled view is not a permutation");
+		}
+	}
+
+	// Adding an entry makes a view own a copy of its entries
+	fl::DataSet<double> own = data.select(idx, idx+4);
+	own.add(data.get(0));
+	if (own.isView() || !own.isContiguous() || own.size() != 5 || own.get(0).getInput(0) != 8 || own.get(3).getInput(1) != 30)
+	{
+		throw std::runtime_error("Failed views test: wrong detach");
+	}
+
+	bool thrown = false;
+	try
+	{
+		data.slice(5, n+1);
+	}
+	catch (const std::invalid_argument&)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+	{
+		throw std::runtime_error("Failed views test: out-of-range slice accepted");
+	}
+}
+
+/// Test the lagged views of time series
+void TestTimeSeries()
+{
+	const std::size_t n = 1000;
+
+	// Entry at time t: x(t-18), x(t-12), x(t-6), x(t) -> x(t+6), with x(t) = t
+	fl::TimeSeriesDataSet<double> ts(4, 6, 6);
+	for (std::size_t t = 0; t < n; ++t)
+	{
+		ts.append(double(t));
+	}
+	fl::DataSet<double> data = ts.dataSet();
+	if (ts.size() != n-24 || data.size() != n-24 || data.numOfInputs() != 4 || data.numOfOutputs() != 1 || !data.hasAdjacentOutputs())
+	{
+		throw std::runtime_error("Failed time series test: wrong size");
+	}
+	std::size_t i = 0;
+	for (fl::DataSet<double>::ConstEntryIterator it = data.entryBegin(),
+												 endIt = data.entryEnd();
+		 it != endIt;
+		 ++it, ++i)
+	{
+		const fl::DataSetEntry<double> entry = *it;
+		if (entry.getInput(0) != i || entry.getInput(3) != i+18 || entry.getOutput(0) != i+24)
+		{
+			throw std::runtime_error("Failed time series test: wrong entry");
+		}
+	}
+	const fl::DataSet<double>::ConstDataMatrix A = data.matrix();
+	if (A[n-25][1] != n-19 || A[n-25][4] != n-1)
+	{
+		throw std::runtime_error("Failed time series test: wrong matrix");
+	}
+
+	// Streaming append with bounded memory: old views remain valid
+	fl::TimeSeriesDataSet<double> live(20, 1, 3);
+	live.setMaxLength(100);
+	for (std::size_t t = 0; t < n; ++t)
+	{
+		live.append(double(t));
+	}
+	const fl::DataSet<double> snap = live.dataSet();
+	const double snapFirst = live.getSample(0);
+	for (std::size_t t = n; t < 2*n; ++t)
+	{
+		live.append(double(t));
+	}
+	if (live.length() < 100 || live.length() > 2*100 || live.getSample(live.length()-1) != 2*n-1)
+	{
+		throw std::runtime_error("Failed time series test: wrong streaming length");
+	}
+	const fl::DataSet<double> last = live.dataSet();
+	if (last.hasAdjacentOutputs() || last.get(last.size()-1).getOutput(0) != 2*n-1 || last.get(last.size()-1).getInput(19) != 2*n-4)
+	{
+		throw std::runtime_error("Failed time series test: wrong streaming entry");
+	}
+	if (snap.get(snap.size()-1).getOutput(0) != n-1 || snap.get(0).getInput(0) != snapFirst)
+	{
+		throw std::runtime_error("Failed time series test: old view changed");
+	}
+
+	// A view detaches into an owned copy of the embedding
+	fl::DataSet<double> own = last.slice(0, 2);
+	own.add(last.get(2));
+	if (own.size() != 3 || own.get(1).getOutput(0) != last.get(1).getOutput(0) || own.get(2).getInput(5) != last.get(2).getInput(5))
+	{
+		throw std::runtime_error("Failed time series test: wrong detach");
+	}
+}
+
+/// Test the binary format
+void TestBinary()
+{
+	const std::size_t n = 5;
+	const std::string fname = "test_dataset.bin";
+
+	fl::DataSet<double> data = detail::Setup(n);
+	const std::string labels[] = {"x", "y", "z"};
+	data.setLabels(labels, labels+3);
+
+	fl::BinaryDataSetWriter writer;
+	writer.write(data, fname);
+
+	fl::BinaryDataSetReader reader;
+	fl::DataSet<double> mapped;
+	reader.read(fname, mapped);
+
+	if (!mapped.isView() || mapped.size() != n || mapped.numOfInputs() != 2 || mapped.numOfOutputs() != 1 || mapped.data() != data.data())
+	{
+		std::remove(fname.c_str());
+		throw std::runtime_error("Failed binary test: wrong values");
+	}
+	if (mapped.getLabel(2) != "z")
+	{
+		std::remove(fname.c_str());
+		throw std::runtime_error("Failed binary test: wrong labels");
+	}
+
+	// Adding entries to a view makes a copy of the viewed entries
+	fl::DataSet<double> copy = mapped;
+	copy.add(mapped.get(0));
+	if (copy.isView() || copy.size() != n+1 || copy.inputs(n)[1] != 0 || copy.outputs(n-1)[0] != 100.0*(n-1))
+	{
+		std::remove(fname.c_str());
+		throw std::runtime_error("Failed binary test: wrong copy");
+	}
+
+	// Types must match
+	bool failed = true;
+	try
+	{
+		fl::DataSet<float> fdata;
+		reader.read(fname, fdata);
+	}
+	catch (const std::runtime_error&)
+	{
+		failed = false;
+	}
+	std::remove(fname.c_str());
+	if (failed)
+	{
+		throw std::runtime_error("Failed binary test: wrong type accepted");
+	}
+}
+
+/// Test the text reader
+void TestReader()
+{
+	const std::string text = "% Trips\n"
+							 "trips, x, name, y\n"
+							 "1, 10, a, 100\n"
+							 "\n"
+							 "2, 20.5e1, b, -1.5\r\n"
+							 "# Comment\n"
+							 "3, , c, 300\n"
+							 "4, 40, d\n"
+							 "5, 50, e, NaN\n"
+							 "6, 60, f, 600";
+
+	fl::DataSetReader reader;
+	reader.setHeader(true);
+	std::vector<std::size_t> inCols;
+	inCols.push_back(1);
+	inCols.push_back(3);
+	reader.setInputColumns(inCols);
+	reader.setOutputColumns(std::vector<std::size_t>(1, 0));
+
+	// Small chunks, so that lines are parsed in several chunks
+	reader.setChunkSize(8);
+
+	fl::DataSet<double> data;
+	reader.read(text.data(), text.data()+text.size(), data);
+	if (data.numOfInputs() != 2 || data.numOfOutputs() != 1 || data.size() != 6)
+	{
+		throw std::runtime_error("Failed reader test: wrong size");
+	}
+	if (data.getLabel(0) != "x" || data.getLabel(1) != "y" || data.getLabel(2) != "trips")
+	{
+		throw std::runtime_error("Failed reader test: wrong labels");
+	}
+	if (data.inputs(1)[0] != 205 || data.inputs(1)[1] != -1.5 || data.outputs(5)[0] != 6
+		|| data.inputs(2)[0] == data.inputs(2)[0] || data.inputs(3)[1] == data.inputs(3)[1])
+	{
+		throw std::runtime_error("Failed reader test: wrong values");
+	}
+
+	// Skip entries with missing values, and append them
+	reader.setMissingValuePolicy(fl::DataSetReader::SkipMissingValues);
+	reader.read(text.data(), text.data()+text.size(), data);
+	if (data.size() != 9 || data.outputs(8)[0] != 6 || data.outputs(7)[0] != 2)
+	{
+		throw std::runtime_error("Failed reader test: wrong skipped entries");
+	}
+
+	// Fail on missing values
+	reader.setMissingValuePolicy(fl::DataSetReader::FailOnMissingValues);
+	bool failed = true;
+	try
+	{
+		reader.read(text.data(), text.data()+text.size(), data);
+	}
+	catch (const std::runtime_error& e)
+	{
+		failed = std::string(e.what()).find("Line 7") == std::string::npos;
+	}
+	if (failed || data.size() != 9)
+	{
+		throw std::runtime_error("Failed reader test: missing value accepted");
+	}
+
+	// By default, the last column is the output and the other ones are inputs
+	const std::string text2 = "1 2 3\n4 5 6\n";
+	fl::DataSet<float> data2;
+	fl::DataSetReader().read(text2.data(), text2.data()+text2.size(), data2);
+	if (data2.numOfInputs() != 2 || data2.numOfOutputs() != 1 || data2.size() != 2 || data2.outputs(1)[0] != 6)
+	{
+		throw std::runtime_error("Failed reader test: wrong default columns");
+	}
+
+	// Numbers out of the exact fast path, regardless of the global locale
+	const std::string text3 = "0.12345678901234567890123 1e300\n-1e400 1e-400\n";
+	fl::DataSet<double> data3;
+	fl::DataSetReader().read(text3.data(), text3.data()+text3.size(), data3);
+	if (data3.size() != 2
+		|| std::abs(data3.inputs(0)[0]-0.12345678901234567890123) > 1e-16 || data3.outputs(0)[0] != 1e300
+		|| data3.inputs(1)[0] != -std::numeric_limits<double>::infinity() || data3.outputs(1)[0] != 0)
+	{
+		throw std::runtime_error("Failed reader test: wrong slowly converted values");
+	}
+}
+
+/// Test the data sources
+void TestSources()
+{
+	const std::size_t n = 10;
+
+	// Zero-copy chunks of a dataset, visited twice
+	const fl::DataSet<double> data = detail::Setup(n);
+	fl::DataSetSource<double> source(data, 3);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		detail::ChunkCollector collector;
+		if (fl::VisitChunks(source, collector) != n || collector.numOfChunks != 4 || collector.data.data() != data.data())
+		{
+			throw std::runtime_error("Failed sources test: wrong dataset chunks");
+		}
+	}
+
+	// Errors are rethrown with their own type, and stop the visit
+	bool failed = true;
+#ifdef FL_CPP11
+	detail::ChunkThrower<detail::ChunkError> thrower(1);
+	try
+	{
+		fl::VisitChunks(source, thrower);
+	}
+	catch (const detail::ChunkError&)
+	{
+		failed = thrower.numOfChunks != 2;
+	}
+	if (failed)
+	{
+		throw std::runtime_error("Failed sources test: wrong foreign error");
+	}
+#endif // FL_CPP11
+	detail::ChunkThrower<std::bad_alloc> badAllocThrower(0);
+	failed = true;
+	try
+	{
+		fl::VisitChunks(source, badAllocThrower);
+	}
+	catch (const std::bad_alloc&)
+	{
+		failed = false;
+	}
+	if (failed)
+	{
+		throw std::runtime_error("Failed sources test: wrong standard error");
+	}
+
+	// Blocks of a text file with a header
+	const std::string fname = "test_dataset.csv";
+	{
+		std::ofstream ofs(fname.c_str());
+		ofs << "x, y, z\n";
+		for (std::size_t k = 0; k < 200; ++k)
+		{
+			ofs << k << ", " << 10*k << ", " << 100*k << "\n";
+		}
+	}
+	fl::DataSetReader reader;
+	reader.setHeader(true);
+	fl::DataSet<double> expected;
+	reader.read(fname, expected);
+
+	detail::ChunkCollector collector;
+	try
+	{
+		fl::TextDataSource<double> text(fname, reader, 64);
+		fl::VisitChunks(text, collector);
+	}
+	catch (...)
+	{
+		std::remove(fname.c_str());
+		throw;
+	}
+	std::remove(fname.c_str());
+	if (collector.data.size() != 200 || collector.numOfChunks < 2 || collector.data.data() != expected.data())
+	{
+		throw std::runtime_error("Failed sources test: wrong text chunks");
+	}
+	if (collector.labels.size() != 3 || collector.labels[2] != "z")
+	{
+		throw std::runtime_error("Failed sources test: wrong text labels");
+	}
+}
+
+/// Test the statistics and the normalization
+void TestStatistics()
+{
+	const std::size_t n = 40000;
+	const double tol = 1e-9;
+
+	// Exact moments and approximate quantiles of k, 10*k and 100*k
+	const fl::DataSet<double> data = detail::Setup(n);
+	const fl::DataSetStatistics<double> stats(data);
+	if (stats.size() != n || stats.numOfColumns() != 3 || stats.numOfValues(2) != n)
+	{
+		throw std::runtime_error("Failed statistics test: wrong size");
+	}
+	if (stats.minimum(1) != 0 || stats.maximum(2) != 100.0*(n-1)
+		|| std::abs(stats.mean(0)-0.5*(n-1)) > tol*n
+		|| std::abs(stats.variance(0)-(double(n)*n-1)/12.0) > tol*n*n)
+	{
+		throw std::runtime_error("Failed statistics test: wrong moments");
+	}
+	if (std::abs(stats.quantile(0, 0.5)-0.5*n) > 0.02*n || std::abs(stats.quantile(1, 0.9)-9.0*n) > 0.2*n || stats.quantile(0, 1) != n-1)
+	{
+		throw std::runtime_error("Failed statistics test: wrong quantiles");
+	}
+
+	// Merged statistics of two halves and statistics of a data source
+	fl::DataSetStatistics<double> merged(data.slice(0, n/3));
+	merged.merge(fl::DataSetStatistics<double>(data.slice(n/3, n)));
+	fl::DataSetSource<double> source(data, 7000);
+	fl::DataSetStatistics<double> streamed;
+	streamed.update(source);
+	if (merged.size() != n || std::abs(merged.variance(2)-stats.variance(2)) > tol*stats.variance(2)
+		|| streamed.size() != n || std::abs(streamed.mean(1)-stats.mean(1)) > tol*n)
+	{
+		throw std::runtime_error("Failed statistics test: wrong merged statistics");
+	}
+
+	// Missing values are ignored
+	fl::DataSet<double> missing = detail::Setup(3);
+	missing.inputs(1)[0] = std::numeric_limits<double>::quiet_NaN();
+	const fl::DataSetStatistics<double> mstats(missing);
+	if (mstats.numOfValues(0) != 2 || mstats.mean(0) != 1 || mstats.maximum(0) != 2)
+	{
+		throw std::runtime_error("Failed statistics test: wrong missing values");
+	}
+
+	// Statistics are cached until entries change
+	fl::DataSet<double> cached = detail::Setup(10);
+	const boost::shared_ptr< const fl::DataSetStatistics<double> > p_stats = fl::CachedStatistics(cached);
+	if (fl::CachedStatistics(cached) != p_stats || fl::DataSet<double>(cached).statistics() != p_stats || cached.slice(0, 5).statistics())
+	{
+		throw std::runtime_error("Failed statistics test: wrong cache");
+	}
+	cached.add(cached.get(0));
+	if (cached.statistics() || fl::CachedStatistics(cached)->size() != 11)
+	{
+		throw std::runtime_error("Failed statistics test: stale cache");
+	}
+
+	// Bounds are taken from the cache, if any, and are not cached
+	std::vector<double> lower;
+	std::vector<double> upper;
+	fl::ColumnBounds(cached, lower, upper);
+	fl::DataSet<double> uncached = missing;
+	uncached.outputs(2)[0] = std::numeric_limits<double>::quiet_NaN();
+	std::vector<double> mlower;
+	std::vector<double> mupper;
+	fl::ColumnBounds(uncached, mlower, mupper);
+	if (lower != fl::CachedStatistics(cached)->lowerBounds() || upper != fl::CachedStatistics(cached)->upperBounds()
+		|| uncached.statistics() || mlower.size() != 3 || mlower[0] != 0 || mupper[0] != 2 || mupper[1] != 20 || mupper[2] != 100)
+	{
+		throw std::runtime_error("Failed statistics test: wrong bounds");
+	}
+
+	// Lazy and in-place normalization
+	const fl::DataSetNormalizer<double> normalizer(*fl::CachedStatistics(cached));
+	const fl::NormalizedMatrixView<double> view = normalizer.normalizedMatrix(cached);
+	fl::DataSet<double> normalized = cached;
+	normalizer.normalize(normalized);
+	if (view.size() != 11 || view[0].size() != 3 || view[9][1] != 1 || normalized.inputs(9)[1] != 1 || normalized.outputs(3)[0] != view[3][2] || cached.inputs(9)[1] != 90)
+	{
+		throw std::runtime_error("Failed statistics test: wrong normalization");
+	}
+	normalizer.denormalize(normalized);
+
+	// Normalizing a copy of a read-only view leaves the viewed dataset untouched
+	fl::DataSet<double> readOnly = static_cast<const fl::DataSet<double>&>(cached).slice(0, 10);
+	normalizer.normalize(readOnly);
+	if (readOnly.isView() || readOnly.inputs(9)[1] != 1 || cached.inputs(9)[1] != 90)
+	{
+		throw std::runtime_error("Failed statistics test: read-only view normalized in place");
+	}
+
+	// Changing entries through a view drops the statistics cached by the viewed dataset
+	fl::DataSet<double> parent = detail::Setup(10);
+	fl::CachedStatistics(parent);
+	fl::DataSet<double> tail = parent.slice(5, 10);
+	normalizer.normalize(tail);
+	fl::ColumnBounds(parent, lower, upper);
+	if (!tail.isView() || parent.statistics() || upper[1] != 40 || fl::CachedStatistics(parent)->upperBounds()[1] != 40)
+	{
+		throw std::runtime_error("Failed statistics test: statistics not invalidated by a view");
+	}
+	const fl::DataSetNormalizer<double> standardizer(stats, fl::DataSetNormalizer<double>::StandardNormalization);
+	if (std::abs(normalized.outputs(5)[0]-500) > tol || std::abs(standardizer.normalize(stats.mean(2)+stats.standardDeviation(2), 2)-1) > tol)
+	{
+		throw std::runtime_error("Failed statistics test: wrong denormalization");
+	}
+}
+
+/// Test the reduced-precision storage
+void TestCompact()
+{
+	typedef fl::CompactDataSet<double> CompactDataSet;
+
+	const std::size_t n = 1000;
+	fl::DataSet<double> data = detail::Setup(n);
+	data.inputs(7)[1] = std::numeric_limits<double>::quiet_NaN();
+	const char* labels[] = {"x", "y", "z"};
+	data.setLabels(labels, labels+3);
+
+	const CompactDataSet::StorageType types[] = {CompactDataSet::Float32Storage, CompactDataSet::Float16Storage, CompactDataSet::BFloat16Storage, CompactDataSet::ScaledInt16Storage};
+	const std::size_t sizes[] = {4, 2, 2, 2};
+	for (std::size_t t = 0; t < 4; ++t)
+	{
+		const CompactDataSet compact(data, types[t]);
+		if (compact.size() != n || compact.numOfInputs() != 2 || compact.numOfBytes() != n*3*sizes[t] || compact.labels() != data.labels())
+		{
+			throw std::runtime_error("Failed compact test: wrong size");
+		}
+
+		// Widened values are within the reported errors
+		const fl::DataSet<double> widened = compact.dataSet();
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			for (std::size_t j = 0; j < 3; ++j)
+			{
+				const double x = j < 2 ? data.inputs(i)[j] : data.outputs(i)[0];
+				const double y = j < 2 ? widened.inputs(i)[j] : widened.outputs(i)[0];
+				if (x != x ? y == y : std::abs(y-x) > compact.maxQuantizationError(j))
+				{
+					throw std::runtime_error("Failed compact test: wrong widened value");
+				}
+			}
+		}
+		if (compact.get(7).getInput(1) == compact.get(7).getInput(1) || compact.get(3).getOutput(0) != widened.outputs(3)[0])
+		{
+			throw std::runtime_error("Failed compact test: wrong entry");
+		}
+
+		// Reading chunks gives the same entries
+		fl::CompactDataSetSource<double> source(compact, 300);
+		detail::ChunkCollector collector;
+		if (fl::VisitChunks(source, collector) != n || collector.numOfChunks != 4 || collector.data.outputs(n-1)[0] != widened.outputs(n-1)[0])
+		{
+			throw std::runtime_error("Failed compact test: wrong chunks");
+		}
+	}
+
+	// Errors reflect the precision of each storage
+	const CompactDataSet f32(data, CompactDataSet::Float32Storage);
+	const CompactDataSet f16(data, CompactDataSet::Float16Storage);
+	const CompactDataSet bf16(data, CompactDataSet::BFloat16Storage);
+	const CompactDataSet i16(data, CompactDataSet::ScaledInt16Storage);
+	if (data.statistics())
+	{
+		throw std::runtime_error("Failed compact test: statistics cached with the source dataset");
+	}
+	if (f32.maxQuantizationError(2) != 0
+		|| f16.maxQuantizationError(0) != 0 || f16.maxQuantizationError(1) != 4 || f16.maxQuantizationError(2) != std::numeric_limits<double>::infinity()
+		|| bf16.maxQuantizationError(1) > 9990.0/256 || bf16.rmsQuantizationError(1) > bf16.maxQuantizationError(1)
+		|| i16.maxQuantizationError(2) > 0.5*99900/65534 || i16.maxQuantizationError(2) == 0)
+	{
+		throw std::runtime_error("Failed compact test: wrong errors");
+	}
+	if (i16.quantizationReport().find("z ") == std::string::npos)
+	{
+		throw std::runtime_error("Failed compact test: wrong report");
+	}
+
+	// Scaled values are clamped to the given ranges
+	CompactDataSet clamped(2, 1, CompactDataSet::ScaledInt16Storage);
+	clamped.setRanges(std::vector<double>(3, 0), std::vector<double>(3, 500));
+	fl::DataSetSource<double> source(data, 128);
+	clamped.add(source);
+	if (clamped.size() != n || clamped.get(n-1).getOutput(0) != 500 || clamped.maxQuantizationError(2) != 100.0*(n-1)-500)
+	{
+		throw std::runtime_error("Failed compact test: wrong clamping");
+	}
+}
+
+/// Test the labels
+void TestLabels()
+{
+	fl::DataSet<double> data = detail::Setup(1);
+
+	if (data.getLabel(0) != "L0" || data.labels().size() != 3)
+	{
+		throw std::runtime_error("Failed labels test: wrong default labels");
+	}
+
+	const std::string labels[] = {"x", "y"};
+	data.setLabels(labels, labels+2);
+	if (data.getLabel(1) != "y" || data.getLabel(2) != "L2")
+	{
+		throw std::runtime_error("Failed labels test: wrong labels");
+	}
+}
+
+} // Namespace <unnamed>
+
+
+int main()
+{
+	try
+	{
+		std::cout << "- Testing dataset storage... ";
+		TestStorage();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset entries... ";
+		TestEntries();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset matrix views... ";
+		TestMatrix();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset views... ";
+		TestViews();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing time series views... ";
+		TestTimeSeries();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset binary format... ";
+		TestBinary();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset text reader... ";
+		TestReader();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset sources... ";
+		TestSources();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset statistics... ";
+		TestStatistics();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing compact datasets... ";
+		TestCompact();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing dataset labels... ";
+		TestLabels();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+}
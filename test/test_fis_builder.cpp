@@ -0,0 +1,985 @@
+/**
+ * \file test/test_fis_builder.cpp
+ *
+ * \brief Test suite for the FIS builders and the search of FIS structures.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fl/anfis.h>
+#include <fl/cluster/subtractive.h>
+#include <fl/dataset.h>
+#include <fl/fis_builders.h>
+#include <fl/fuzzylite.h>
+#include <fl/Headers.h>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# include <omp.h>
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+
+namespace /*<unnnamed>*/ {
+
+namespace detail {
+
+typedef fl::FisStructureSearch<fl::anfis::Jang1993HybridLearningAlgorithm> SearchType;
+typedef SearchType::ResultType ResultType;
+
+
+/// Makes a data set with two inputs and one output, nonlinear in the inputs or not
+fl::DataSet<fl::scalar> MakeDataSet(std::size_t n, std::size_t offset, bool linear)
+{
+	fl::DataSet<fl::scalar> data(2, 1);
+
+	for (std::size_t i = offset; i < offset+n; ++i)
+	{
+		const fl::scalar x[2] = {std::sin(0.37*i), std::cos(0.23*i)};
+		const fl::scalar y = linear
+							 ? 0.6*x[0]-0.3*x[1]+0.2
+							 : x[0]*x[0]-0.5*x[1]+0.3*x[0]*x[1];
+
+		data.add(x, x+2, &y, &y+1);
+	}
+
+	return data;
+}
+
+/// Small linear congruential generator to get the same samples everywhere
+class Lcg
+{
+public:
+	explicit Lcg(unsigned long seed)
+	: seed_(seed)
+	{
+	}
+
+	/// Returns a number in [0, 1)
+	fl::scalar next()
+	{
+		seed_ = (seed_*1103515245UL+12345UL) % 2147483648UL;
+		return static_cast<fl::scalar>(seed_ >> 8)/8388608.0;
+	}
+
+private:
+	unsigned long seed_;
+};
+
+/// Makes a data set with two inputs lying in the lower-left triangle of the unit square, so that part of any grid is not covered
+fl::DataSet<fl::scalar> MakeTriangleDataSet(std::size_t n)
+{
+	fl::DataSet<fl::scalar> data(2, 1);
+
+	Lcg rng(4242);
+	while (data.size() < n)
+	{
+		const fl::scalar x[2] = {rng.next(), rng.next()};
+		if (x[0]+x[1] <= 1)
+		{
+			const fl::scalar y = x[0]-2*x[1];
+
+			data.add(x, x+2, &y, &y+1);
+		}
+	}
+
+	return data;
+}
+
+/// The statistics of a cell of the grid, collected by brute force
+struct CellStatistics
+{
+	CellStatistics()
+	: support(0),
+	  mass(0)
+	{
+	}
+
+	std::size_t support; ///< The number of data points covering the cell
+	fl::scalar mass; ///< The sum of the firing strengths of the cell over the data points covering it
+};
+
+/**
+ * Returns the statistics of the cells of the grid of input terms of \a eng
+ * covered by \a data, indexed by the antecedent of their rule (as written in
+ * the rules made by fl::GridPartitionFisBuilder).
+ */
+std::map<std::string, CellStatistics> CoveredCells(const fl::Engine& eng, const fl::DataSet<fl::scalar>& data)
+{
+	std::map<std::string, CellStatistics> cells;
+	for (fl::DataSet<fl::scalar>::ConstEntryIterator entryIt = data.entryBegin(),
+													  entryEndIt = data.entryEnd();
+		 entryIt != entryEndIt;
+		 ++entryIt)
+	{
+		std::ostringstream oss;
+		fl::scalar strength = 1;
+		for (std::size_t i = 0; i < eng.numberOfInputVariables(); ++i)
+		{
+			const fl::InputVariable* p_iv = eng.getInputVariable(i);
+
+			// The first most active term
+			std::size_t best = 0;
+			fl::scalar bestMu = -1;
+			for (std::size_t j = 0; j < p_iv->numberOfTerms(); ++j)
+			{
+				const fl::scalar mu = p_iv->getTerm(j)->membership(entryIt->getInput(i));
+				if (mu > bestMu)
+				{
+					best = j;
+					bestMu = mu;
+				}
+			}
+			if (i > 0)
+			{
+				oss << " " << fl::Rule::andKeyword() << " ";
+			}
+			oss << p_iv->getName() << " " << fl::Rule::isKeyword() << " " << p_iv->getTerm(best)->getName();
+			strength *= bestMu;
+		}
+
+		CellStatistics& cs = cells[oss.str()];
+		++cs.support;
+		cs.mass += strength;
+	}
+
+	return cells;
+}
+
+/// Returns the antecedents of the cells of \a cells satisfying the given minimum support and firing mass
+std::set<std::string> FilterCells(const std::map<std::string, CellStatistics>& cells, std::size_t minSupport, fl::scalar minMass)
+{
+	std::set<std::string> antecedents;
+	for (std::map<std::string, CellStatistics>::const_iterator it = cells.begin(),
+															   endIt = cells.end();
+		 it != endIt;
+		 ++it)
+	{
+		if (it->second.support >= minSupport && it->second.mass >= minMass)
+		{
+			antecedents.insert(it->first);
+		}
+	}
+
+	return antecedents;
+}
+
+/// Returns the antecedents of the rules of \a eng, in the order of the rules
+std::vector<std::string> OrderedRuleAntecedents(const fl::Engine& eng)
+{
+	const std::string ifPrefix = fl::Rule::ifKeyword()+" ";
+	const std::string thenInfix = " "+fl::Rule::thenKeyword()+" ";
+
+	std::vector<std::string> antecedents;
+	const fl::RuleBlock* p_rules = eng.getRuleBlock(0);
+	for (std::size_t r = 0; r < p_rules->numberOfRules(); ++r)
+	{
+		const std::string text = p_rules->getRule(r)->getText();
+		const std::size_t end = text.find(thenInfix);
+
+		// Strips the keyword and the trailing blank before the consequent
+		std::string antecedent = text.substr(ifPrefix.size(), end-ifPrefix.size());
+		antecedent.erase(antecedent.find_last_not_of(' ')+1);
+		antecedents.push_back(antecedent);
+	}
+
+	return antecedents;
+}
+
+/// Returns the antecedents of the rules of \a eng
+std::set<std::string> RuleAntecedents(const fl::Engine& eng)
+{
+	const std::vector<std::string> antecedents = OrderedRuleAntecedents(eng);
+
+	return std::set<std::string>(antecedents.begin(), antecedents.end());
+}
+
+/// Builds a grid-partitioned FIS with 4 bell-shaped terms for each input and the given rule generation and filters
+FL_unique_ptr<fl::anfis::Engine> BuildGridFis(const fl::DataSet<fl::scalar>& data,
+											 fl::GridPartitionFisBuilder<fl::anfis::Engine>::RuleGenerationType ruleGen,
+											 std::size_t minSupport,
+											 fl::scalar minMass)
+{
+	const std::vector<std::size_t> numTerms(data.numOfInputs(), 4);
+	const std::vector<std::string> termClasses(data.numOfInputs(), fl::Bell().className());
+
+	fl::GridPartitionFisBuilder<fl::anfis::Engine> builder(numTerms.begin(), numTerms.end(),
+														   termClasses.begin(), termClasses.end(),
+														   fl::Linear().className());
+	builder.setRuleGeneration(ruleGen);
+	builder.setMinRuleSupport(minSupport);
+	builder.setMinRuleFiringMass(minMass);
+
+	return builder.build(data);
+}
+
+/// A candidate structure that cannot be built
+class FailingFisStructure: public fl::FisStructure<fl::anfis::Engine>
+{
+public:
+	FL_unique_ptr<fl::anfis::Engine> build(const fl::DataSet<fl::scalar>& data) const
+	{
+		FL_SUPPRESS_UNUSED_VARIABLE_WARNING(data);
+
+		// Not an std::exception, which the search must survive as well
+		throw 1;
+	}
+
+	std::string toString() const
+	{
+		return "Failing";
+	}
+
+	FailingFisStructure* clone() const
+	{
+		return new FailingFisStructure(*this);
+	}
+}; // FailingFisStructure
+
+/**
+ * A subtractive clustering structure that records how many candidates are
+ * being built at the same time.
+ *
+ * Each build waits (up to one second) for another build to be in progress,
+ * so that builds overlap whenever the search allows them to.
+ */
+class OverlappingFisStructure: public fl::FisStructure<fl::anfis::Engine>
+{
+public:
+	explicit OverlappingFisStructure(fl::scalar radius)
+	: structure_(fl::cluster::SubtractiveClustering(), radius)
+	{
+	}
+
+	FL_unique_ptr<fl::anfis::Engine> build(const fl::DataSet<fl::scalar>& data) const
+	{
+		Enter();
+#ifdef FLX_CONFIG_HAVE_OPENMP
+		const double start = omp_get_wtime();
+		while (NumOfActive() < 2 && (omp_get_wtime()-start) < 1)
+		{
+		}
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+		FL_unique_ptr<fl::anfis::Engine> p_eng;
+		try
+		{
+			p_eng = structure_.build(data);
+		}
+		catch (...)
+		{
+			Leave();
+			throw;
+		}
+		Leave();
+
+		return p_eng;
+	}
+
+	std::string toString() const
+	{
+		return "Overlapping "+structure_.toString();
+	}
+
+	OverlappingFisStructure* clone() const
+	{
+		return new OverlappingFisStructure(*this);
+	}
+
+	/// Resets the counters
+	static void Reset()
+	{
+		active_ = 0;
+		maxActive_ = 0;
+	}
+
+	/// Returns the largest number of candidates built at the same time
+	static std::size_t MaxNumOfActive()
+	{
+		return maxActive_;
+	}
+
+private:
+	static void Enter()
+	{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (test_overlapping_structure)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		{
+			++active_;
+			maxActive_ = std::max(maxActive_, active_);
+		}
+	}
+
+	static void Leave()
+	{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (test_overlapping_structure)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		{
+			--active_;
+		}
+	}
+
+	static std::size_t NumOfActive()
+	{
+		std::size_t n = 0;
+#ifdef FLX_CONFIG_HAVE_OPENMP
+# pragma omp critical (test_overlapping_structure)
+#endif // FLX_CONFIG_HAVE_OPENMP
+		{
+			n = active_;
+		}
+		return n;
+	}
+
+	fl::SubtractiveClusteringFisStructure<fl::anfis::Engine> structure_;
+	static std::size_t active_;
+	static std::size_t maxActive_;
+}; // OverlappingFisStructure
+
+std::size_t OverlappingFisStructure::active_ = 0;
+std::size_t OverlappingFisStructure::maxActive_ = 0;
+
+/// Runs the given search evaluating one candidate at a time, in the order they were added
+std::vector<ResultType> SearchSerially(SearchType& search, const fl::DataSet<fl::scalar>& data)
+{
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	const int numThreads = omp_get_max_threads();
+	omp_set_num_threads(1);
+#endif // FLX_CONFIG_HAVE_OPENMP
+	const std::vector<ResultType> results = search.search(data);
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	omp_set_num_threads(numThreads);
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+	return results;
+}
+
+/// Tells if \a a is no worse than \a b in error, number of rules and inference cost
+bool WeaklyDominates(const ResultType& a, const ResultType& b)
+{
+	return a.checkError <= b.checkError
+		   && a.numOfRules <= b.numOfRules
+		   && a.inferenceCost <= b.inferenceCost;
+}
+
+/// Tells if the Pareto front of the given search is consistent with the outcomes of its candidates
+bool CheckParetoFront(const SearchType& search, const std::vector<ResultType>& results)
+{
+	const std::vector<ResultType> front = search.paretoFront();
+
+	std::vector<bool> inFront(results.size(), false);
+	for (std::size_t i = 0; i < front.size(); ++i)
+	{
+		const ResultType& res = front[i];
+
+		// Only models trained for all the epochs (or for as many as allowed by the time budget) are eligible
+		if (res.status != ResultType::Completed && res.status != ResultType::Truncated)
+		{
+			return false;
+		}
+		// Sorted by number of rules
+		if (i > 0 && front[i-1].numOfRules > res.numOfRules)
+		{
+			return false;
+		}
+		// No candidate of the front dominates another one
+		for (std::size_t j = 0; j < front.size(); ++j)
+		{
+			if (j != i && WeaklyDominates(front[j], res))
+			{
+				return false;
+			}
+		}
+		if (!search.model(res.structure) || inFront[res.structure])
+		{
+			return false;
+		}
+		inFront[res.structure] = true;
+	}
+
+	// Every other eligible candidate is dominated by a candidate of the front
+	for (std::size_t s = 0; s < results.size(); ++s)
+	{
+		const ResultType& res = results[s];
+
+		if (res.structure != s)
+		{
+			return false;
+		}
+		if (inFront[s])
+		{
+			continue;
+		}
+		if (search.model(s))
+		{
+			return false;
+		}
+		if (res.status == ResultType::Completed || res.status == ResultType::Truncated)
+		{
+			bool dominated = false;
+			for (std::size_t i = 0; i < front.size() && !dominated; ++i)
+			{
+				dominated = WeaklyDominates(front[i], res);
+			}
+			if (!dominated)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+} // Namespace detail
+
+
+/// Test the Pareto front of a search over grid partitioning and subtractive clustering structures
+void TestParetoFront()
+{
+	const fl::DataSet<fl::scalar> trainData = detail::MakeDataSet(80, 0, false);
+	const fl::DataSet<fl::scalar> checkData = detail::MakeDataSet(40, 80, false);
+
+	detail::SearchType search;
+	search.setNumOfEpochs(3);
+	search.addGridPartitionStructures(2,
+									  std::vector<std::size_t>(1, 2),
+									  std::vector<std::string>(1, fl::Bell().className()),
+									  fl::Linear().className());
+	search.addGridPartitionStructures(2,
+									  std::vector<std::size_t>(1, 3),
+									  std::vector<std::string>(1, fl::Gaussian().className()),
+									  fl::Constant().className());
+	const fl::scalar radii[] = {0.3, 0.5, 2.0};
+	search.addSubtractiveClusteringStructures(fl::cluster::SubtractiveClustering(), std::vector<fl::scalar>(radii, radii+3));
+
+	if (search.numOfStructures() != 5)
+	{
+		throw std::runtime_error("Failed Pareto front test: number of structures");
+	}
+
+	const std::vector<detail::ResultType> results = search.search(trainData, checkData);
+
+	if (results.size() != 5)
+	{
+		throw std::runtime_error("Failed Pareto front test: number of results");
+	}
+	for (std::size_t s = 0; s < results.size(); ++s)
+	{
+		const detail::ResultType& res = results[s];
+
+		if (res.status != detail::ResultType::Completed
+			|| res.numOfEpochs != 3
+			|| res.checkErrors.size() != 4
+			|| res.checkError != res.checkErrors.back()
+			|| res.numOfRules == 0
+			|| res.inferenceCost == 0)
+		{
+			throw std::runtime_error("Failed Pareto front test: outcome of a candidate");
+		}
+		if (res.description.find(s < 2 ? "GridPartition" : "SubtractiveClustering") != 0)
+		{
+			throw std::runtime_error("Failed Pareto front test: description of a candidate");
+		}
+	}
+	// The grid with 9 rules and the single cluster bound the number of rules
+	if (results[1].numOfRules != 9 || results[4].numOfRules != 1)
+	{
+		throw std::runtime_error("Failed Pareto front test: number of rules");
+	}
+	if (search.paretoFront().empty() || !detail::CheckParetoFront(search, results))
+	{
+		throw std::runtime_error("Failed Pareto front test: Pareto-optimal candidates");
+	}
+	// The simplest model cannot be dominated
+	if (!search.model(4))
+	{
+		throw std::runtime_error("Failed Pareto front test: simplest candidate");
+	}
+}
+
+/// Test the early abandonment of candidates clearly dominated by simpler ones
+void TestAbandonment()
+{
+	// A single rule fits a linear process exactly, unlike a grid of constant outputs
+	const fl::DataSet<fl::scalar> data = detail::MakeDataSet(60, 0, true);
+
+	detail::SearchType search;
+	search.setNumOfEpochs(5);
+	search.setAbandonRatio(2);
+	search.add(fl::SubtractiveClusteringFisStructure<fl::anfis::Engine>(fl::cluster::SubtractiveClustering(), 2.0));
+	search.addGridPartitionStructures(2,
+									  std::vector<std::size_t>(1, 3),
+									  std::vector<std::string>(1, fl::Bell().className()),
+									  fl::Constant().className());
+
+	// The simpler candidate is on the front when the other one is trained
+	const std::vector<detail::ResultType> results = detail::SearchSerially(search, data);
+
+	if (results[0].status != detail::ResultType::Completed || results[0].numOfRules != 1)
+	{
+		throw std::runtime_error("Failed abandonment test: dominating candidate");
+	}
+
+	// Abandoned after the first epoch, at which its error exceeds the ratio times the one of the simpler candidate
+	const detail::ResultType& res = results[1];
+	if (res.status != detail::ResultType::Abandoned
+		|| res.numOfEpochs != 1
+		|| res.checkErrors.size() != 2
+		|| !(res.checkError > search.getAbandonRatio()*results[0].checkErrors[1])
+		|| search.model(1))
+	{
+		throw std::runtime_error("Failed abandonment test: dominated candidate");
+	}
+
+	if (search.paretoFront().size() != 1 || !detail::CheckParetoFront(search, results))
+	{
+		throw std::runtime_error("Failed abandonment test: Pareto-optimal candidates");
+	}
+
+	// Without abandonment, the same candidate is trained for all the epochs
+	search.setAbandonRatio(0);
+	if (search.search(data)[1].status != detail::ResultType::Completed)
+	{
+		throw std::runtime_error("Failed abandonment test: disabled abandonment");
+	}
+}
+
+/// Test a search whose time budget runs out
+void TestTimeBudget()
+{
+	const fl::DataSet<fl::scalar> data = detail::MakeDataSet(60, 0, false);
+
+	detail::SearchType search;
+	search.setNumOfEpochs(50);
+	search.setTimeBudget(1e-3);
+	search.addGridPartitionStructures(2,
+									  std::vector<std::size_t>(1, 3),
+									  std::vector<std::string>(1, fl::Bell().className()),
+									  fl::Linear().className());
+	const fl::scalar radii[] = {0.3, 0.4, 0.5, 0.6, 0.8};
+	search.addSubtractiveClusteringStructures(fl::cluster::SubtractiveClustering(), std::vector<fl::scalar>(radii, radii+5));
+
+	// The budget runs out while the first candidate is trained, so that the others are skipped
+	const std::vector<detail::ResultType> results = detail::SearchSerially(search, data);
+
+	if (results[0].status != detail::ResultType::Truncated
+		|| results[0].numOfEpochs >= search.getNumOfEpochs()
+		|| results[0].checkErrors.size() != results[0].numOfEpochs+1
+		|| !search.model(0))
+	{
+		throw std::runtime_error("Failed time budget test: truncated candidate");
+	}
+	for (std::size_t s = 1; s < results.size(); ++s)
+	{
+		const detail::ResultType& res = results[s];
+
+		if (res.status != detail::ResultType::Skipped
+			|| res.numOfRules != 0
+			|| res.numOfEpochs != 0
+			|| !res.checkErrors.empty()
+			|| search.model(s))
+		{
+			throw std::runtime_error("Failed time budget test: skipped candidate");
+		}
+	}
+
+	// Candidates evaluated concurrently are either truncated or skipped
+	const std::vector<detail::ResultType> concurrentResults = search.search(data);
+	for (std::size_t s = 0; s < concurrentResults.size(); ++s)
+	{
+		const detail::ResultType& res = concurrentResults[s];
+
+		if ((res.status != detail::ResultType::Skipped && res.status != detail::ResultType::Truncated)
+			|| res.numOfEpochs >= search.getNumOfEpochs())
+		{
+			throw std::runtime_error("Failed time budget test: concurrent candidates");
+		}
+	}
+	if (!detail::CheckParetoFront(search, concurrentResults))
+	{
+		throw std::runtime_error("Failed time budget test: Pareto-optimal candidates");
+	}
+
+	// No limit
+	search.setNumOfEpochs(1);
+	search.setTimeBudget(0);
+	const std::vector<detail::ResultType> unboundedResults = search.search(data);
+	for (std::size_t s = 0; s < unboundedResults.size(); ++s)
+	{
+		if (unboundedResults[s].status != detail::ResultType::Completed)
+		{
+			throw std::runtime_error("Failed time budget test: no time budget");
+		}
+	}
+}
+
+/// Test candidates that cannot be built
+void TestFailure()
+{
+	const fl::DataSet<fl::scalar> data = detail::MakeDataSet(60, 0, false);
+
+	detail::SearchType search;
+	search.setNumOfEpochs(2);
+	search.add(detail::FailingFisStructure());
+	search.add(fl::SubtractiveClusteringFisStructure<fl::anfis::Engine>(fl::cluster::SubtractiveClustering(), 0.5));
+	search.add(detail::FailingFisStructure());
+
+	const std::vector<detail::ResultType> results = search.search(data);
+
+	for (std::size_t s = 0; s < results.size(); s += 2)
+	{
+		const detail::ResultType& res = results[s];
+
+		if (res.status != detail::ResultType::Failed
+			|| res.description != "Failing"
+			|| res.numOfRules != 0
+			|| res.numOfEpochs != 0
+			|| search.model(s))
+		{
+			throw std::runtime_error("Failed failure test: failed candidate");
+		}
+	}
+	if (results[1].status != detail::ResultType::Completed || !search.model(1))
+	{
+		throw std::runtime_error("Failed failure test: other candidates");
+	}
+	if (!detail::CheckParetoFront(search, results))
+	{
+		throw std::runtime_error("Failed failure test: Pareto-optimal candidates");
+	}
+}
+
+/// Test that candidates are built concurrently
+void TestConcurrentBuilds()
+{
+	const fl::DataSet<fl::scalar> data = detail::MakeDataSet(200, 0, false);
+
+	detail::SearchType search;
+	search.setNumOfEpochs(1);
+	const fl::scalar radii[] = {0.3, 0.4, 0.5, 0.6};
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		search.add(detail::OverlappingFisStructure(radii[i]));
+	}
+
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	const int numThreads = omp_get_max_threads();
+	omp_set_num_threads(std::max(numThreads, 2));
+#endif // FLX_CONFIG_HAVE_OPENMP
+	detail::OverlappingFisStructure::Reset();
+	const std::vector<detail::ResultType> results = search.search(data);
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	omp_set_num_threads(numThreads);
+#endif // FLX_CONFIG_HAVE_OPENMP
+
+	for (std::size_t s = 0; s < results.size(); ++s)
+	{
+		if (results[s].status != detail::ResultType::Completed)
+		{
+			throw std::runtime_error("Failed concurrent build test: outcome of a candidate");
+		}
+	}
+#ifdef FLX_CONFIG_HAVE_OPENMP
+	// Building a candidate does not wait for the others to be built
+	if (detail::OverlappingFisStructure::MaxNumOfActive() < 2)
+	{
+		throw std::runtime_error("Failed concurrent build test: candidates were built one at a time");
+	}
+#endif // FLX_CONFIG_HAVE_OPENMP
+}
+
+/// Test the generation of rules for the cells of the grid covered by the data
+void TestDataDrivenRules()
+{
+	typedef fl::GridPartitionFisBuilder<fl::anfis::Engine> BuilderType;
+
+	const fl::DataSet<fl::scalar> data = detail::MakeTriangleDataSet(400);
+
+	const FL_unique_ptr<fl::anfis::Engine> p_full = detail::BuildGridFis(data, BuilderType::FullGridRuleGeneration, 0, 0);
+	const std::map<std::string, detail::CellStatistics> cells = detail::CoveredCells(*p_full, data);
+
+	// A rule for every cell, covered or not
+	if (p_full->getRuleBlock(0)->numberOfRules() != 16 || detail::RuleAntecedents(*p_full).size() != 16)
+	{
+		throw std::runtime_error("Failed data-driven rules test: full grid");
+	}
+
+	// A rule for every covered cell, with the same terms
+	const FL_unique_ptr<fl::anfis::Engine> p_covered = detail::BuildGridFis(data, BuilderType::DataDrivenRuleGeneration, 0, 0);
+	const std::set<std::string> coveredRules = detail::RuleAntecedents(*p_covered);
+	if (cells.size() >= 16
+		|| coveredRules != detail::FilterCells(cells, 0, 0)
+		|| p_covered->getRuleBlock(0)->numberOfRules() != cells.size()
+		|| p_covered->getOutputVariable(0)->numberOfTerms() != cells.size())
+	{
+		throw std::runtime_error("Failed data-driven rules test: covered cells");
+	}
+	for (std::size_t i = 0; i < p_full->numberOfInputVariables(); ++i)
+	{
+		if (p_covered->getInputVariable(i)->numberOfTerms() != 4)
+		{
+			throw std::runtime_error("Failed data-driven rules test: input terms");
+		}
+	}
+	// Rules are generated in the order of the full grid
+	{
+		const std::vector<std::string> fullOrder = detail::OrderedRuleAntecedents(*p_full);
+		const std::vector<std::string> coveredOrder = detail::OrderedRuleAntecedents(*p_covered);
+
+		std::size_t j = 0;
+		for (std::size_t r = 0; r < fullOrder.size() && j < coveredOrder.size(); ++r)
+		{
+			if (fullOrder[r] == coveredOrder[j])
+			{
+				++j;
+			}
+		}
+		if (j != coveredOrder.size())
+		{
+			throw std::runtime_error("Failed data-driven rules test: order of rules");
+		}
+	}
+
+	// The built model is usable
+	FL_unique_ptr<fl::anfis::Engine> p_anfis(p_covered->clone());
+	p_anfis->build();
+	const fl::DataSetEntry<fl::scalar> entry = *data.entryBegin();
+	const std::vector<fl::scalar> out = p_anfis->eval(entry.inputBegin(), entry.inputEnd());
+	if (out.size() != 1 || fl::Operation::isNaN(out[0]))
+	{
+		throw std::runtime_error("Failed data-driven rules test: evaluation");
+	}
+}
+
+/// Test the minimum support and firing-mass filters of data-driven rule generation
+void TestRuleFilters()
+{
+	typedef fl::GridPartitionFisBuilder<fl::anfis::Engine> BuilderType;
+
+	const fl::DataSet<fl::scalar> data = detail::MakeTriangleDataSet(400);
+
+	const FL_unique_ptr<fl::anfis::Engine> p_full = detail::BuildGridFis(data, BuilderType::FullGridRuleGeneration, 0, 0);
+	const std::map<std::string, detail::CellStatistics> cells = detail::CoveredCells(*p_full, data);
+
+	// Thresholds halfway through the statistics of the covered cells, and
+	// between two distinct values, so that rounding cannot move a cell across
+	std::vector<std::size_t> supports;
+	std::vector<fl::scalar> masses;
+	for (std::map<std::string, detail::CellStatistics>::const_iterator it = cells.begin(),
+																	   endIt = cells.end();
+		 it != endIt;
+		 ++it)
+	{
+		supports.push_back(it->second.support);
+		masses.push_back(it->second.mass);
+	}
+	std::sort(supports.begin(), supports.end());
+	std::sort(masses.begin(), masses.end());
+	const std::size_t mid = cells.size()/2;
+	if (supports[mid-1] == supports[mid] || !(masses[mid-1] < masses[mid]))
+	{
+		throw std::runtime_error("Failed rule filters test: statistics of the cells");
+	}
+	const std::size_t minSupport = supports[mid];
+	const fl::scalar minMass = 0.5*(masses[mid-1]+masses[mid]);
+
+	// Minimum support
+	{
+		const FL_unique_ptr<fl::anfis::Engine> p_fis = detail::BuildGridFis(data, BuilderType::DataDrivenRuleGeneration, minSupport, 0);
+		const std::set<std::string> expect = detail::FilterCells(cells, minSupport, 0);
+
+		if (detail::RuleAntecedents(*p_fis) != expect
+			|| expect.size() >= cells.size()
+			|| expect.empty())
+		{
+			throw std::runtime_error("Failed rule filters test: minimum support");
+		}
+	}
+
+	// Minimum firing mass
+	{
+		const FL_unique_ptr<fl::anfis::Engine> p_fis = detail::BuildGridFis(data, BuilderType::DataDrivenRuleGeneration, 0, minMass);
+		const std::set<std::string> expect = detail::FilterCells(cells, 0, minMass);
+
+		if (detail::RuleAntecedents(*p_fis) != expect || expect.size() != cells.size()-mid)
+		{
+			throw std::runtime_error("Failed rule filters test: minimum firing mass");
+		}
+	}
+
+	// Both
+	{
+		const FL_unique_ptr<fl::anfis::Engine> p_fis = detail::BuildGridFis(data, BuilderType::DataDrivenRuleGeneration, minSupport, minMass);
+
+		if (detail::RuleAntecedents(*p_fis) != detail::FilterCells(cells, minSupport, minMass))
+		{
+			throw std::runtime_error("Failed rule filters test: minimum support and firing mass");
+		}
+	}
+
+	// The filters do not apply to the full grid
+	if (detail::BuildGridFis(data, BuilderType::FullGridRuleGeneration, minSupport, minMass)->getRuleBlock(0)->numberOfRules() != 16)
+	{
+		throw std::runtime_error("Failed rule filters test: full grid");
+	}
+
+	// No cell satisfies the filters
+	bool thrown = false;
+	try
+	{
+		detail::BuildGridFis(data, BuilderType::DataDrivenRuleGeneration, data.size()+1, 0);
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+	{
+		throw std::runtime_error("Failed rule filters test: no rule");
+	}
+}
+
+} // Namespace <unnamed>
+
+
+int main()
+{
+	try
+	{
+		std::cout << "- Testing Pareto front of the structure search... ";
+		TestParetoFront();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing early abandonment of candidates... ";
+		TestAbandonment();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing time budget of the structure search... ";
+		TestTimeBudget();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing candidates that cannot be built... ";
+		TestFailure();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing concurrent builds of candidates... ";
+		TestConcurrentBuilds();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing data-driven rule generation... ";
+		TestDataDrivenRules();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing filters of data-driven rules... ";
+		TestRuleFilters();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,297 @@
+/**
+ * \file test/test_heap.cpp
+ *
+ * \brief Test suite for the indexed max-heap.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2016 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <fl/detail/heap.h>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace /*<unnnamed>*/ {
+
+namespace detail {
+
+/// Small linear congruential generator to get the same keys everywhere
+class Lcg
+{
+public:
+	explicit Lcg(unsigned long seed)
+	: seed_(seed)
+	{
+	}
+
+	/// Returns an integer in [0, n)
+	std::size_t next(std::size_t n)
+	{
+		seed_ = (seed_*1103515245UL+12345UL) % 2147483648UL;
+		return static_cast<std::size_t>((seed_ >> 8) % n);
+	}
+
+private:
+	unsigned long seed_;
+};
+
+/// Returns the first item with the highest key, by a linear scan
+template <typename T>
+std::size_t FirstMax(const std::vector<T>& keys)
+{
+	std::size_t best = 0;
+	for (std::size_t i = 1; i < keys.size(); ++i)
+	{
+		if (keys[best] < keys[i])
+		{
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/// Tells if the heap has the same items, keys and top as the reference keys
+template <typename T>
+bool CheckHeap(const fl::detail::IndexedMaxHeap<T>& heap, const std::vector<T>& keys)
+{
+	if (heap.size() != keys.size() || heap.empty() != keys.empty())
+	{
+		return false;
+	}
+	for (std::size_t i = 0; i < keys.size(); ++i)
+	{
+		if (heap.key(i) != keys[i])
+		{
+			return false;
+		}
+	}
+	if (!keys.empty())
+	{
+		const std::size_t top = FirstMax(keys);
+		if (heap.top() != top || heap.topKey() != keys[top])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // Namespace detail
+
+/// Test construction of the heap from a set of keys
+void TestAssign()
+{
+	// Empty heap
+	{
+		fl::detail::IndexedMaxHeap<double> heap;
+		std::vector<double> keys;
+
+		if (!detail::CheckHeap(heap, keys))
+		{
+			throw std::runtime_error("Failed assign test: default construction");
+		}
+
+		heap.assign(keys.begin(), keys.end());
+		if (!detail::CheckHeap(heap, keys))
+		{
+			throw std::runtime_error("Failed assign test: no key");
+		}
+	}
+
+	// Random keys (few distinct values, so that there are many ties)
+	detail::Lcg rng(12345);
+	for (std::size_t n = 1; n <= 65; ++n)
+	{
+		std::vector<int> keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			keys[i] = static_cast<int>(rng.next(8));
+		}
+
+		fl::detail::IndexedMaxHeap<int> heap;
+		heap.assign(keys.begin(), keys.end());
+		if (!detail::CheckHeap(heap, keys))
+		{
+			throw std::runtime_error("Failed assign test: random keys");
+		}
+	}
+
+	// Reassignment replaces the previous content
+	{
+		std::vector<int> keys(10, 1);
+		fl::detail::IndexedMaxHeap<int> heap;
+		heap.assign(keys.begin(), keys.end());
+		keys.assign(3, 0);
+		keys[2] = 5;
+		heap.assign(keys.begin(), keys.end());
+		if (!detail::CheckHeap(heap, keys))
+		{
+			throw std::runtime_error("Failed assign test: reassignment");
+		}
+	}
+}
+
+/// Test key changes against a brute-force reference
+void TestUpdate()
+{
+	detail::Lcg rng(54321);
+
+	const std::size_t sizes[] = {1, 2, 3, 7, 64, 257};
+	for (std::size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+	{
+		const std::size_t n = sizes[s];
+
+		std::vector<int> keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			keys[i] = static_cast<int>(rng.next(100));
+		}
+
+		fl::detail::IndexedMaxHeap<int> heap;
+		heap.assign(keys.begin(), keys.end());
+
+		for (std::size_t t = 0; t < 20*n; ++t)
+		{
+			const std::size_t i = rng.next(n);
+			switch (rng.next(4))
+			{
+				case 0: // Increase
+					keys[i] += static_cast<int>(rng.next(50));
+					break;
+				case 1: // Decrease
+					keys[i] -= static_cast<int>(rng.next(50));
+					break;
+				case 2: // Unchanged
+					break;
+				default: // Ties with the current top
+					keys[i] = keys[detail::FirstMax(keys)];
+					break;
+			}
+			heap.update(i, keys[i]);
+
+			if (!detail::CheckHeap(heap, keys))
+			{
+				throw std::runtime_error("Failed update test: random key changes");
+			}
+		}
+	}
+}
+
+/// Test removal of the top items, as done by subtractive clustering (whose potentials drop to zero)
+void TestRemove()
+{
+	detail::Lcg rng(777);
+
+	const std::size_t n = 100;
+	const double removed = -std::numeric_limits<double>::infinity();
+
+	std::vector<double> keys(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		keys[i] = static_cast<double>(rng.next(1000))/10.0;
+	}
+
+	fl::detail::IndexedMaxHeap<double> heap;
+	heap.assign(keys.begin(), keys.end());
+
+	// Items come out in non-increasing order of keys, and in increasing order of index among ties
+	double lastKey = std::numeric_limits<double>::infinity();
+	std::size_t lastItem = 0;
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		if (!detail::CheckHeap(heap, keys))
+		{
+			throw std::runtime_error("Failed remove test: top of the heap");
+		}
+
+		const std::size_t top = heap.top();
+		if (heap.topKey() > lastKey || (k > 0 && heap.topKey() == lastKey && top < lastItem))
+		{
+			throw std::runtime_error("Failed remove test: order of removed items");
+		}
+		lastKey = heap.topKey();
+		lastItem = top;
+
+		keys[top] = removed;
+		heap.update(top, removed);
+	}
+	if (heap.topKey() != removed)
+	{
+		throw std::runtime_error("Failed remove test: all items removed");
+	}
+}
+
+} // Namespace <unnamed>
+
+
+int main()
+{
+	try
+	{
+		std::cout << "- Testing construction from keys... ";
+		TestAssign();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing key changes... ";
+		TestUpdate();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing removal of top items... ";
+		TestRemove();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,586 @@
+/**
+ * \file test/test_lsq.cpp
+ *
+ * \brief Test suite for least-squares solvers.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fl/detail/lsq.h>
+#include <fl/detail/traits.h>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+
+namespace /*<unnnamed>*/ {
+
+namespace detail {
+
+const double DefaultTolerance = 1e-8;
+
+/// Builds the overdetermined system y = 2 + 3*x1 - x2 (plus a second output y = -1 + x1 + 0.5*x2)
+void Setup(std::vector< std::vector<double> >& A, std::vector< std::vector<double> >& B)
+{
+	const double x[][2] = {{0.0, 1.0},
+						   {1.0, 0.5},
+						   {2.0, 3.0},
+						   {3.0, 2.5},
+						   {4.0, 0.0},
+						   {5.0, 4.0}};
+
+	const std::size_t n = sizeof(x)/sizeof(x[0]);
+
+	A.resize(n);
+	B.resize(n);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		A[i].resize(3);
+		A[i][0] = 1;
+		A[i][1] = x[i][0];
+		A[i][2] = x[i][1];
+
+		B[i].resize(2);
+		B[i][0] = 2 + 3*x[i][0] - x[i][1];
+		B[i][1] = -1 + x[i][0] + 0.5*x[i][1];
+	}
+}
+
+template <typename T>
+bool CheckEqual(const T& v1, const T& v2, double tol = DefaultTolerance)
+{
+	return std::abs(v1-v2) <= tol;
+}
+
+template <typename T>
+bool CheckEqual(const std::vector< std::vector<T> >& A1, const std::vector< std::vector<T> >& A2, double tol = DefaultTolerance)
+{
+	if (A1.size() != A2.size())
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0,
+					 nr = A1.size();
+		 i < nr;
+		 ++i)
+	{
+		if (A1[i].size() != A2[i].size())
+		{
+			return false;
+		}
+
+		for (std::size_t j = 0,
+						 nc = A1[i].size();
+			 j < nc;
+			 ++j)
+		{
+			if (!CheckEqual(A1[i][j], A2[i][j], tol))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/// Builds a well-conditioned m-by-n random system with nrhs right-hand sides
+template <typename T>
+void SetupRandom(std::size_t m, std::size_t n, std::size_t nrhs, std::vector< std::vector<T> >& A, std::vector< std::vector<T> >& B)
+{
+	A.assign(m, std::vector<T>(n));
+	B.assign(m, std::vector<T>(nrhs));
+
+	// Deterministic pseudo-random sequence (so that results are reproducible)
+	unsigned long seed = 12345;
+	for (std::size_t i = 0; i < m; ++i)
+	{
+		for (std::size_t j = 0; j < n; ++j)
+		{
+			seed = (seed*1103515245UL+12345UL) % 2147483648UL;
+			A[i][j] = static_cast<T>(seed/2147483648.0-0.5);
+		}
+		for (std::size_t j = 0; j < nrhs; ++j)
+		{
+			seed = (seed*1103515245UL+12345UL) % 2147483648UL;
+			B[i][j] = static_cast<T>(seed/2147483648.0-0.5);
+		}
+	}
+}
+
+/// Returns the maximum relative difference between single-precision and double-precision results
+template <typename T>
+double MaxRelativeDelta(const std::vector< std::vector<float> >& X1, const std::vector< std::vector<T> >& X2)
+{
+	double delta = 0;
+	for (std::size_t i = 0; i < X1.size(); ++i)
+	{
+		for (std::size_t j = 0; j < X1[i].size(); ++j)
+		{
+			const double d = std::abs(X1[i][j]-X2[i][j])/std::max(std::abs(static_cast<double>(X2[i][j])), 1.0);
+			delta = std::max(delta, d);
+		}
+	}
+	return delta;
+}
+
+} // Namespace detail
+
+/// Test the one-shot least-squares solvers
+void TestSolve()
+{
+	std::vector< std::vector<double> > A;
+	std::vector< std::vector<double> > B;
+
+	detail::Setup(A, B);
+
+	std::vector< std::vector<double> > Xexp(3);
+	Xexp[0].push_back( 2); Xexp[0].push_back(-1);
+	Xexp[1].push_back( 3); Xexp[1].push_back( 1);
+	Xexp[2].push_back(-1); Xexp[2].push_back(0.5);
+
+	// Multiple right-hand sides
+	{
+		const std::vector< std::vector<double> > X = fl::detail::LsqSolveMulti<double>(A, B);
+
+		if (!detail::CheckEqual(X, Xexp))
+		{
+			throw std::runtime_error("Failed solve test: multiple right-hand sides");
+		}
+	}
+
+	// Single right-hand side
+	{
+		std::vector<double> b(B.size());
+		for (std::size_t i = 0; i < B.size(); ++i)
+		{
+			b[i] = B[i][1];
+		}
+
+		const std::vector<double> x = fl::detail::LsqSolve<double>(A, b);
+
+		if (x.size() != 3
+			|| !detail::CheckEqual(x[0], Xexp[0][1])
+			|| !detail::CheckEqual(x[1], Xexp[1][1])
+			|| !detail::CheckEqual(x[2], Xexp[2][1]))
+		{
+			throw std::runtime_error("Failed solve test: single right-hand side");
+		}
+	}
+}
+
+/// Test the reuse of solver plans
+void TestPlan()
+{
+	std::vector< std::vector<double> > A;
+	std::vector< std::vector<double> > B;
+
+	detail::Setup(A, B);
+
+	const std::vector< std::vector<double> > Xexp = fl::detail::LsqSolveMulti<double>(A, B);
+
+	// Factorize once, solve for different right-hand sides
+	{
+		fl::detail::LsqSolverPlan<double> plan(A.size(), A[0].size(), B[0].size());
+
+		plan.factorize(A);
+
+		const std::vector< std::vector<double> > X1 = plan.solve(B);
+
+		std::vector< std::vector<double> > B2(B);
+		for (std::size_t i = 0; i < B2.size(); ++i)
+		{
+			std::swap(B2[i][0], B2[i][1]);
+		}
+		const std::vector< std::vector<double> > X2 = plan.solve(B2);
+
+		if (!detail::CheckEqual(X1, Xexp)
+			|| plan.rank() != 3)
+		{
+			throw std::runtime_error("Failed plan test: first solve");
+		}
+		for (std::size_t i = 0; i < X2.size(); ++i)
+		{
+			if (!detail::CheckEqual(X2[i][0], Xexp[i][1])
+				|| !detail::CheckEqual(X2[i][1], Xexp[i][0]))
+			{
+				throw std::runtime_error("Failed plan test: solve with factorization reuse");
+			}
+		}
+	}
+
+	// Reuse the same plan across several problems of the same shape
+	{
+		fl::detail::LsqSolverPlan<double> plan(A.size(), A[0].size(), B[0].size());
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const std::vector< std::vector<double> > X = plan.solve(A, B);
+
+			if (!detail::CheckEqual(X, Xexp))
+			{
+				throw std::runtime_error("Failed plan test: repeated solves");
+			}
+		}
+	}
+
+	// Rank-deficient problem (third column equals the second one)
+	{
+		std::vector< std::vector<double> > AA(A);
+		for (std::size_t i = 0; i < AA.size(); ++i)
+		{
+			AA[i][2] = AA[i][1];
+		}
+
+		fl::detail::LsqSolverPlan<double> plan(AA.size(), AA[0].size(), B[0].size());
+
+		plan.factorize(AA);
+
+		if (plan.rank() != 2)
+		{
+			throw std::runtime_error("Failed plan test: rank-deficient matrix");
+		}
+
+		// The minimum-norm solution splits the weight evenly between the two equal columns
+		const std::vector< std::vector<double> > X = plan.solve(B);
+		if (!detail::CheckEqual(X[1][0], X[2][0]))
+		{
+			throw std::runtime_error("Failed plan test: minimum-norm solution");
+		}
+	}
+}
+
+/// Test the ridge solvers and the regularization-path search
+void TestRidge()
+{
+	std::vector< std::vector<double> > A;
+	std::vector< std::vector<double> > B;
+
+	detail::Setup(A, B);
+
+	const std::size_t m = A.size();
+	const std::size_t n = A[0].size();
+	const std::size_t nrhs = B[0].size();
+
+	fl::detail::LsqSolverPlan<double> plan(m, n, nrhs);
+	plan.factorize(A);
+
+	// No regularization gives the plain least-squares solution
+	if (!detail::CheckEqual(plan.solveRidge(B, 0), fl::detail::LsqSolveMulti<double>(A, B)))
+	{
+		throw std::runtime_error("Failed ridge test: zero regularization");
+	}
+
+	// Ridge solution is the least-squares solution of the augmented system [A; sqrt(lambda)*I]*X=[B; 0]
+	const double lambda = 2.5;
+	{
+		std::vector< std::vector<double> > AA(A);
+		std::vector< std::vector<double> > BB(B);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			AA.push_back(std::vector<double>(n, 0));
+			AA.back()[i] = std::sqrt(lambda);
+			BB.push_back(std::vector<double>(nrhs, 0));
+		}
+
+		if (!detail::CheckEqual(plan.solveRidge(B, lambda), fl::detail::LsqSolveMulti<double>(AA, BB)))
+		{
+			throw std::runtime_error("Failed ridge test: augmented system");
+		}
+	}
+
+	const std::vector<double> lambdas = fl::detail::RidgeParameterGrid(1e-3, 1e+2, 6);
+	if (lambdas.size() != 6
+		|| !detail::CheckEqual(lambdas.front(), 1e-3)
+		|| !detail::CheckEqual(lambdas[1], 1e-2)
+		|| !detail::CheckEqual(lambdas.back(), 1e+2))
+	{
+		throw std::runtime_error("Failed ridge test: parameter grid");
+	}
+
+	// GCV scores agree with the brute-force ones
+	{
+		const std::vector<double> scores = plan.ridgeGcvScores(B, lambdas);
+
+		fl::detail::LsqSolverPlan<double> plan1(m, n, 1);
+		plan1.factorize(A);
+
+		for (std::size_t l = 0; l < lambdas.size(); ++l)
+		{
+			const std::vector< std::vector<double> > X = plan.solveRidge(B, lambdas[l]);
+
+			// Residual sum of squares
+			double rss = 0;
+			for (std::size_t i = 0; i < m; ++i)
+			{
+				for (std::size_t j = 0; j < nrhs; ++j)
+				{
+					double yhat = 0;
+					for (std::size_t c = 0; c < n; ++c)
+					{
+						yhat += A[i][c]*X[c][j];
+					}
+					rss += (B[i][j]-yhat)*(B[i][j]-yhat);
+				}
+			}
+
+			// Trace of the hat matrix A*inv(A'A+lambda*I)*A'
+			double dof = 0;
+			for (std::size_t i = 0; i < m; ++i)
+			{
+				std::vector< std::vector<double> > e(m, std::vector<double>(1, 0));
+				e[i][0] = 1;
+				const std::vector< std::vector<double> > h = plan1.solveRidge(e, lambdas[l]);
+				for (std::size_t c = 0; c < n; ++c)
+				{
+					dof += A[i][c]*h[c][0];
+				}
+			}
+
+			const double gcv = m*rss/((m-dof)*(m-dof));
+			if (!detail::CheckEqual(scores[l], gcv, 1e-8*std::max(1.0, gcv)))
+			{
+				throw std::runtime_error("Failed ridge test: GCV scores");
+			}
+		}
+	}
+
+	// Hold-out errors agree with the brute-force ones
+	{
+		std::vector< std::vector<double> > Av(2, std::vector<double>(n));
+		std::vector< std::vector<double> > Bv(2, std::vector<double>(nrhs));
+		Av[0][0] = 1; Av[0][1] = 1.5; Av[0][2] = 2.0;
+		Av[1][0] = 1; Av[1][1] = 4.5; Av[1][2] = 1.0;
+		for (std::size_t i = 0; i < Av.size(); ++i)
+		{
+			Bv[i][0] = 2 + 3*Av[i][1] - Av[i][2];
+			Bv[i][1] = -1 + Av[i][1] + 0.5*Av[i][2];
+		}
+
+		const std::vector<double> errs = plan.ridgeHoldOutErrors(B, lambdas, Av, Bv);
+
+		for (std::size_t l = 0; l < lambdas.size(); ++l)
+		{
+			const std::vector< std::vector<double> > X = plan.solveRidge(B, lambdas[l]);
+
+			double mse = 0;
+			for (std::size_t i = 0; i < Av.size(); ++i)
+			{
+				for (std::size_t j = 0; j < nrhs; ++j)
+				{
+					double yhat = 0;
+					for (std::size_t c = 0; c < n; ++c)
+					{
+						yhat += Av[i][c]*X[c][j];
+					}
+					mse += (Bv[i][j]-yhat)*(Bv[i][j]-yhat);
+				}
+			}
+			mse /= Av.size()*nrhs;
+
+			if (!detail::CheckEqual(errs[l], mse))
+			{
+				throw std::runtime_error("Failed ridge test: hold-out errors");
+			}
+		}
+
+		// Noise-free data: the smallest regularization is the best one
+		if (std::min_element(errs.begin(), errs.end()) != errs.begin())
+		{
+			throw std::runtime_error("Failed ridge test: hold-out selection");
+		}
+	}
+
+	// One-shot solver selects the parameter with the smallest GCV score
+	{
+		const std::vector<double> scores = plan.ridgeGcvScores(B, lambdas);
+		const std::size_t best = std::min_element(scores.begin(), scores.end())-scores.begin();
+
+		double bestLambda = -1;
+		const std::vector< std::vector<double> > X = fl::detail::LsqSolveMultiRidge(A, B, lambdas, &bestLambda);
+
+		if (bestLambda != lambdas[best]
+			|| !detail::CheckEqual(X, plan.solveRidge(B, lambdas[best])))
+		{
+			throw std::runtime_error("Failed ridge test: one-shot solver");
+		}
+
+		// The same selection through a caller-owned plan, reused for a second problem of the same shape
+		fl::detail::LsqSolverPlan<double> plan2;
+		for (std::size_t r = 0; r < 2; ++r)
+		{
+			double bestLambda2 = -1;
+			const std::vector< std::vector<double> > X2 = fl::detail::LsqSolveMultiRidge(plan2, A, B, lambdas, &bestLambda2);
+
+			if (bestLambda2 != bestLambda || !detail::CheckEqual(X2, X))
+			{
+				throw std::runtime_error("Failed ridge test: one-shot solver with plan");
+			}
+		}
+	}
+
+	// In-place solves for several parameters reuse the projection of the same right-hand sides
+	{
+		plan.factorize(A);
+		const std::vector<double> scores = plan.ridgeGcvScores(B, lambdas);
+		for (std::size_t l = 0; l < lambdas.size(); ++l)
+		{
+			plan.solveRidge(lambdas[l]);
+
+			fl::detail::LsqSolverPlan<double> plan1(A.size(), A[0].size(), B[0].size());
+			plan1.factorize(A);
+			if (!detail::CheckEqual(plan.storedSolution(), plan1.solveRidge(B, lambdas[l])))
+			{
+				throw std::runtime_error("Failed ridge test: in-place solves");
+			}
+		}
+		const std::vector<double> scores2 = plan.ridgeGcvScores(lambdas);
+		for (std::size_t l = 0; l < lambdas.size(); ++l)
+		{
+			if (!detail::CheckEqual(scores2[l], scores[l]))
+			{
+				throw std::runtime_error("Failed ridge test: scores after in-place solves");
+			}
+		}
+	}
+}
+
+/// Test single-precision solvers against their double-precision counterparts
+void TestPrecision()
+{
+	const std::size_t m = 200;
+	const std::size_t n = 20;
+	const std::size_t nrhs = 3;
+
+	std::vector< std::vector<double> > A;
+	std::vector< std::vector<double> > B;
+	std::vector< std::vector<float> > Af;
+	std::vector< std::vector<float> > Bf;
+
+	detail::SetupRandom(m, n, nrhs, A, B);
+	detail::SetupRandom(m, n, nrhs, Af, Bf);
+
+	// Single precision gives about 7 significant digits
+	const double tol = 1e-4;
+
+	// Solver plans
+	{
+		fl::detail::LsqSolverPlan<double> plan(m, n, nrhs);
+		fl::detail::LsqSolverPlan<float> planf(m, n, nrhs);
+
+		const std::vector< std::vector<double> > X = plan.solve(A, B);
+		const std::vector< std::vector<float> > Xf = planf.solve(Af, Bf);
+
+		const double delta = detail::MaxRelativeDelta(Xf, X);
+		std::cout << "(plan delta: " << delta << ") ";
+		if (delta > tol || planf.rank() != n)
+		{
+			throw std::runtime_error("Failed precision test: solver plan");
+		}
+	}
+
+	// One-shot solvers
+	{
+		const std::vector< std::vector<double> > X = fl::detail::LsqSolveMulti<double>(A, B);
+		const std::vector< std::vector<float> > Xf = fl::detail::LsqSolveMulti<float>(Af, Bf);
+
+		const double delta = detail::MaxRelativeDelta(Xf, X);
+		std::cout << "(one-shot delta: " << delta << ") ";
+		if (delta > tol)
+		{
+			throw std::runtime_error("Failed precision test: one-shot solver");
+		}
+	}
+}
+
+} // Namespace <unnamed>
+
+
+int main()
+{
+	try
+	{
+		std::cout << "- Testing one-shot solvers... ";
+		TestSolve();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing solver plans... ";
+		TestPlan();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing ridge solvers... ";
+		TestRidge();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing single-precision solvers... ";
+		TestPrecision();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,476 @@
+/**
+ * \file test/test_rls.cpp
+ *
+ * \brief Test suite for recursive estimators.
+ *
+ * \author Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * <hr/>
+ *
+ * Copyright 2015 Marco Guazzone (marco.guazzone@gmail.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fl/detail/kalman.h>
+#include <fl/detail/math.h>
+#include <fl/detail/rls.h>
+#include <fl/detail/sparse.h>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace /*<unnnamed>*/ {
+
+namespace detail {
+
+const double DefaultTolerance = 1e-6;
+
+/// Generates samples of the model [y1 y2] = [1 x1 x2]*[1 -1; 2 0.5; -3 4] (stored by rows)
+void Setup(std::size_t n, std::vector<double>& in, std::vector<double>& out)
+{
+	in.resize(n*3);
+	out.resize(n*2);
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		const double x1 = std::sin(0.1*k);
+		const double x2 = std::cos(0.37*k);
+
+		in[k*3+0] = 1;
+		in[k*3+1] = x1;
+		in[k*3+2] = x2;
+		out[k*2+0] = 1 + 2*x1 - 3*x2;
+		out[k*2+1] = -1 + 0.5*x1 + 4*x2;
+	}
+}
+
+bool CheckEqual(const std::vector< std::vector<double> >& A1, const std::vector< std::vector<double> >& A2, double tol = DefaultTolerance)
+{
+	if (A1.size() != A2.size())
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0,
+					 nr = A1.size();
+		 i < nr;
+		 ++i)
+	{
+		if (A1[i].size() != A2[i].size())
+		{
+			return false;
+		}
+
+		for (std::size_t j = 0,
+						 nc = A1[i].size();
+			 j < nc;
+			 ++j)
+		{
+			if (std::abs(A1[i][j]-A2[i][j]) > tol)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+} // Namespace detail
+
+/// Test the recursive least-squares estimator
+void TestRls()
+{
+	const std::size_t n = 50;
+
+	std::vector<double> in;
+	std::vector<double> out;
+
+	detail::Setup(n, in, out);
+
+	fl::detail::RecursiveLeastSquaresEstimator<double> rls(0, 3, 2, 1);
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		rls.estimate(in.begin()+k*3, in.begin()+(k+1)*3, out.begin()+k*2, out.begin()+(k+1)*2);
+	}
+
+	std::vector< std::vector<double> > Theta(3, std::vector<double>(2));
+	Theta[0][0] =  1; Theta[0][1] =  -1;
+	Theta[1][0] =  2; Theta[1][1] = 0.5;
+	Theta[2][0] = -3; Theta[2][1] =   4;
+
+	if (!detail::CheckEqual(rls.getEstimatedParameters(), Theta))
+	{
+		throw std::runtime_error("Failed RLS test: wrong estimated parameters");
+	}
+}
+
+/// Test the Kalman filter estimator
+void TestKalman()
+{
+	const std::size_t n = 50;
+
+	std::vector<double> in;
+	std::vector<double> out;
+
+	detail::Setup(n, in, out);
+
+	// Same estimates of RLS
+	{
+		fl::detail::RecursiveLeastSquaresEstimator<double> rls(0, 3, 2, 1);
+		fl::detail::KalmanFilter<double> kalman(0, 3, 2, 1);
+		kalman.reset();
+
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			const std::vector<double> yhat1 = rls.estimate(in.begin()+k*3, in.begin()+(k+1)*3, out.begin()+k*2, out.begin()+(k+1)*2);
+			const std::vector<double> yhat2 = kalman.estimate(in.begin()+k*3, in.begin()+(k+1)*3, out.begin()+k*2, out.begin()+(k+1)*2);
+
+			if (k > 5 && (std::abs(yhat1[0]-yhat2[0]) > detail::DefaultTolerance || std::abs(yhat1[1]-yhat2[1]) > detail::DefaultTolerance))
+			{
+				throw std::runtime_error("Failed Kalman test: estimated output differs from RLS");
+			}
+		}
+
+		if (!detail::CheckEqual(rls.getEstimatedParameters(), kalman.getEstimatedParameters()))
+		{
+			throw std::runtime_error("Failed Kalman test: estimated parameters differ from RLS");
+		}
+	}
+
+	// Batch updates are equivalent to sequential ones
+	{
+		fl::detail::KalmanFilter<double> kalman1(0, 3, 2, 0.98);
+		fl::detail::KalmanFilter<double> kalman2(0, 3, 2, 0.98);
+		kalman1.reset();
+		kalman2.reset();
+
+		std::vector<double> yhat1(n*2);
+		std::vector<double> yhat2(n*2);
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			kalman1.estimate(&in[k*3], &out[k*2], &yhat1[k*2]);
+		}
+		kalman2.estimateBatch(&in[0], &out[0], n/2, &yhat2[0]);
+		kalman2.estimateBatch(&in[(n/2)*3], &out[(n/2)*2], n-n/2, &yhat2[(n/2)*2]);
+
+		if (!detail::CheckEqual(kalman1.getEstimatedParameters(), kalman2.getEstimatedParameters(), 0)
+			|| !detail::CheckEqual(kalman1.getCovarianceInverse(), kalman2.getCovarianceInverse(), 0)
+			|| yhat1 != yhat2
+			|| kalman2.numberOfIterations() != n)
+		{
+			throw std::runtime_error("Failed Kalman test: batch update");
+		}
+	}
+
+	// Copies are independent
+	{
+		fl::detail::KalmanFilter<double> kalman1(0, 3, 2, 1);
+		kalman1.reset();
+		kalman1.estimate(&in[0], &out[0], 0);
+
+		fl::detail::KalmanFilter<double> kalman2(kalman1);
+		kalman2.estimate(&in[3], &out[2], 0);
+
+		if (kalman1.numberOfIterations() != 1
+			|| kalman2.numberOfIterations() != 2
+			|| detail::CheckEqual(kalman1.getEstimatedParameters(), kalman2.getEstimatedParameters(), 0))
+		{
+			throw std::runtime_error("Failed Kalman test: copy");
+		}
+	}
+}
+
+/// Test the estimators with sparse regressors
+void TestSparse()
+{
+	// Regressors of a Takagi-Sugeno model with 4 localized rules and 2 inputs
+	// (each sample excites at most 2 adjacent rules)
+	const std::size_t numRules = 4;
+	const std::size_t numRuleParams = 3;
+	const std::size_t nin = numRules*numRuleParams;
+	const std::size_t nout = 2;
+	const std::size_t n = 200;
+
+	std::vector<double> in(n*nin, 0);
+	std::vector<double> out(n*nout);
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		const double x1 = std::sin(0.1*k);
+		const double x2 = std::cos(0.37*k);
+		const std::size_t r = k % numRules;
+		const double w = 0.3+0.4*std::abs(x2);
+
+		for (std::size_t rr = r; rr < std::min(r+2, numRules); ++rr)
+		{
+			const double wr = (rr == r) ? w : 1-w;
+			in[k*nin+rr*numRuleParams+0] = wr*x1;
+			in[k*nin+rr*numRuleParams+1] = wr*x2;
+			in[k*nin+rr*numRuleParams+2] = wr;
+		}
+		out[k*nout+0] = 1 + 2*x1 - 3*x2 + 0.1*r;
+		out[k*nout+1] = -1 + 0.5*x1 + 4*x2*x1;
+	}
+
+	// Sparse and dense updates of the Kalman filter give the same estimates
+	{
+		fl::detail::KalmanFilter<double> kalman1(0, nin, nout, 0.98);
+		fl::detail::KalmanFilter<double> kalman2(0, nin, nout, 0.98);
+		kalman1.reset();
+		kalman2.reset();
+
+		std::vector<double> yhat1(nout);
+		std::vector<double> yhat2(nout);
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			const fl::detail::SparseVector<double> a(in.begin()+k*nin, in.begin()+(k+1)*nin);
+
+			kalman1.estimate(&in[k*nin], &out[k*nout], &yhat1[0]);
+			kalman2.estimate(a, &out[k*nout], &yhat2[0]);
+
+			if (a.numOfNonZeros() > 2*numRuleParams
+				|| std::abs(yhat1[0]-yhat2[0]) > detail::DefaultTolerance
+				|| std::abs(yhat1[1]-yhat2[1]) > detail::DefaultTolerance)
+			{
+				throw std::runtime_error("Failed sparse test: estimated output differs from the dense Kalman filter");
+			}
+		}
+
+		if (!detail::CheckEqual(kalman1.getEstimatedParameters(), kalman2.getEstimatedParameters())
+			|| !detail::CheckEqual(kalman1.getCovarianceInverse(), kalman2.getCovarianceInverse())
+			|| kalman1.getRegressor() != kalman2.getRegressor())
+		{
+			throw std::runtime_error("Failed sparse test: estimated parameters differ from the dense Kalman filter");
+		}
+	}
+
+	// Sparse and dense updates of the RLS estimator give the same estimates
+	// (also for a model with past inputs, and when both updates are mixed)
+	for (std::size_t order = 0; order < 2; ++order)
+	{
+		fl::detail::RecursiveLeastSquaresEstimator<double> rls1(order, nin, nout, 0.98);
+		fl::detail::RecursiveLeastSquaresEstimator<double> rls2(order, nin, nout, 0.98);
+		fl::detail::RecursiveLeastSquaresEstimator<double> rls3(order, nin, nout, 0.98);
+
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			const std::vector<double> u(in.begin()+k*nin, in.begin()+(k+1)*nin);
+			const std::vector<double> y(out.begin()+k*nout, out.begin()+(k+1)*nout);
+			const fl::detail::SparseVector<double> a(u.begin(), u.end());
+
+			const std::vector<double> yhat1 = rls1.estimate(u, y);
+			const std::vector<double> yhat2 = rls2.estimate(a, y);
+			const std::vector<double> yhat3 = (k % 3 == 0) ? rls3.estimate(u, y) : rls3.estimate(a, y);
+
+			for (std::size_t j = 0; j < nout; ++j)
+			{
+				// Before enough samples have been seen, estimates are NaN
+				if (k >= order
+					&& (std::abs(yhat1[j]-yhat2[j]) > detail::DefaultTolerance
+						|| std::abs(yhat1[j]-yhat3[j]) > detail::DefaultTolerance))
+				{
+					throw std::runtime_error("Failed sparse test: estimated output differs from the dense RLS estimator");
+				}
+			}
+		}
+
+		if (!detail::CheckEqual(rls1.getEstimatedParameters(), rls2.getEstimatedParameters())
+			|| !detail::CheckEqual(rls1.getEstimatedParameters(), rls3.getEstimatedParameters())
+			|| !detail::CheckEqual(rls1.getCovarianceInverse(), rls2.getCovarianceInverse())
+			|| !detail::CheckEqual(rls1.getCovarianceInverse(), rls3.getCovarianceInverse())
+			|| rls1.getRegressor() != rls2.getRegressor())
+		{
+			throw std::runtime_error("Failed sparse test: estimated parameters differ from the dense RLS estimator");
+		}
+	}
+
+	// Sparse normal equations give the least-squares solution
+	{
+		std::vector< std::vector<double> > A(n, std::vector<double>(nin));
+		std::vector< std::vector<double> > B(n, std::vector<double>(nout));
+		fl::detail::SparseNormalEquations<double> neq(nin, nout);
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			A[k].assign(in.begin()+k*nin, in.begin()+(k+1)*nin);
+			B[k].assign(out.begin()+k*nout, out.begin()+(k+1)*nout);
+
+			neq.accumulate(fl::detail::SparseVector<double>(A[k].begin(), A[k].end()), &B[k][0]);
+		}
+
+		if (neq.numOfRows() != n
+			|| !detail::CheckEqual(neq.solve(), fl::detail::LsqSolveMulti<double>(A, B)))
+		{
+			throw std::runtime_error("Failed sparse test: normal equations");
+		}
+
+		// Ridge solution through the Cholesky factorization
+		const double lambda = 0.5;
+		if (!detail::CheckEqual(neq.solve(lambda), fl::detail::LsqSolveMultiRidge(A, B, std::vector<double>(1, lambda))))
+		{
+			throw std::runtime_error("Failed sparse test: ridge normal equations");
+		}
+	}
+
+	// An unknown that is never excited makes the normal equations singular:
+	// the SVD fallback gives the minimum-norm solution
+	{
+		std::vector< std::vector<double> > A(n, std::vector<double>(nin+1, 0));
+		std::vector< std::vector<double> > B(n, std::vector<double>(nout));
+		fl::detail::SparseNormalEquations<double> neq(nin+1, nout);
+		for (std::size_t k = 0; k < n; ++k)
+		{
+			std::copy(in.begin()+k*nin, in.begin()+(k+1)*nin, A[k].begin());
+			B[k].assign(out.begin()+k*nout, out.begin()+(k+1)*nout);
+
+			neq.accumulate(fl::detail::SparseVector<double>(A[k].begin(), A[k].end()), &B[k][0]);
+		}
+
+		const std::vector< std::vector<double> > X = neq.solve();
+		if (!detail::CheckEqual(X, fl::detail::LsqSolveMulti<double>(A, B)))
+		{
+			throw std::runtime_error("Failed sparse test: singular normal equations");
+		}
+		for (std::size_t j = 0; j < nout; ++j)
+		{
+			if (X[nin][j] != X[nin][j] || std::abs(X[nin][j]) > detail::DefaultTolerance)
+			{
+				throw std::runtime_error("Failed sparse test: singular normal equations");
+			}
+		}
+	}
+}
+
+/// Test single-precision estimators against their double-precision counterparts
+void TestPrecision()
+{
+	const std::size_t n = 50;
+
+	std::vector<double> in;
+	std::vector<double> out;
+
+	detail::Setup(n, in, out);
+
+	const std::vector<float> inf(in.begin(), in.end());
+	const std::vector<float> outf(out.begin(), out.end());
+
+	fl::detail::RecursiveLeastSquaresEstimator<double> rls(0, 3, 2, 0.98);
+	fl::detail::RecursiveLeastSquaresEstimator<float> rlsf(0, 3, 2, 0.98f);
+	fl::detail::KalmanFilter<double> kalman(0, 3, 2, 0.98);
+	fl::detail::KalmanFilter<float> kalmanf(0, 3, 2, 0.98f);
+	kalman.reset();
+	kalmanf.reset();
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		rls.estimate(in.begin()+k*3, in.begin()+(k+1)*3, out.begin()+k*2, out.begin()+(k+1)*2);
+		rlsf.estimate(inf.begin()+k*3, inf.begin()+(k+1)*3, outf.begin()+k*2, outf.begin()+(k+1)*2);
+		kalman.estimate(&in[k*3], &out[k*2], 0);
+		kalmanf.estimate(&inf[k*3], &outf[k*2], 0);
+	}
+
+	const std::vector< std::vector<double> > Theta = rls.getEstimatedParameters();
+	const std::vector< std::vector<float> > Thetaf = rlsf.getEstimatedParameters();
+	const std::vector< std::vector<double> > ThetaK = kalman.getEstimatedParameters();
+	const std::vector< std::vector<float> > ThetaKf = kalmanf.getEstimatedParameters();
+
+	double delta = 0;
+	double deltaK = 0;
+	for (std::size_t i = 0; i < Theta.size(); ++i)
+	{
+		for (std::size_t j = 0; j < Theta[i].size(); ++j)
+		{
+			delta = std::max(delta, std::abs(Thetaf[i][j]-Theta[i][j]));
+			deltaK = std::max(deltaK, std::abs(ThetaKf[i][j]-ThetaK[i][j]));
+		}
+	}
+
+	std::cout << "(RLS delta: " << delta << ", Kalman delta: " << deltaK << ") ";
+	if (delta > 1e-3 || deltaK > 1e-3)
+	{
+		throw std::runtime_error("Failed precision test: single-precision estimates differ from double-precision ones");
+	}
+}
+
+} // Namespace <unnamed>
+
+
+int main()
+{
+	try
+	{
+		std::cout << "- Testing recursive least-squares... ";
+		TestRls();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing Kalman filter... ";
+		TestKalman();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing sparse estimators... ";
+		TestSparse();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+
+	try
+	{
+		std::cout << "- Testing single-precision estimators... ";
+		TestPrecision();
+		std::cout << "OK";
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "KO => " << e.what();
+	}
+	catch (...)
+	{
+		std::cout << "KO => unexpected error";
+	}
+	std::cout << std::endl;
+}